@@ -0,0 +1,297 @@
+#include <benchmark/benchmark.h>
+#include "message.hpp"
+#include "spsc_queue.hpp"
+#include "cpu_affinity.hpp"
+#include <nlohmann/json.hpp>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <string>
+#include <thread>
+#include <vector>
+#include <pthread.h>
+#include <sched.h>
+
+/**
+ * Матрица передачи сообщений между ядрами через SPSCQueue<Message>
+ *
+ * Для каждой пары ядер (a, b) поток на ядре a отправляет сообщение, поток на ядре b
+ * возвращает его (ping-pong): задержка в одну сторону = round trip / 2. Затем поток a
+ * передает поток сообщений без ответа - устойчивая пропускная способность a -> b.
+ * Пары классифицируются по топологии: SMT-соседи, общий L3 (CCX), сокет, разные сокеты.
+ *
+ * Дополнительные аргументы (остальные передаются Google Benchmark):
+ *   --cores=0,2,4           ядра (по умолчанию все доступные процессу)
+ *   --ordered               измерять оба направления пары (по умолчанию a < b, матрица симметрична)
+ *   --rounds=N              round trip на пару (по умолчанию 100000)
+ *   --stream=N              сообщений в замере пропускной способности (по умолчанию 1048576)
+ *   --matrix_out=<path>     JSON с матрицами (по умолчанию results/core_matrix.json)
+ */
+
+using json = nlohmann::json;
+
+constexpr size_t CORE_MATRIX_QUEUE_SIZE = 1024;
+using HandoffQueue = SPSCQueue<Message, CORE_MATRIX_QUEUE_SIZE>;
+
+struct CoreMatrixOptions {
+    std::vector<uint32_t> cores;
+    bool ordered = false;
+    uint64_t rounds = 100000;
+    uint64_t stream = 1 << 20;
+    std::string matrix_out = "results/core_matrix.json";
+};
+
+struct PairResult {
+    double one_way_ns;
+    double msgs_per_sec;
+};
+
+static std::map<std::pair<uint32_t, uint32_t>, PairResult> g_pairs;
+
+// Замер одной пары: поток бенчмарка на ядре a, ответчик на ядре b
+static void run_pair(benchmark::State& state, uint32_t a, uint32_t b, uint64_t stream) {
+    auto ping = std::make_shared<HandoffQueue>();
+    auto pong = std::make_shared<HandoffQueue>();
+    std::atomic<bool> running{true};
+    std::atomic<bool> sink{false};
+    std::atomic<uint64_t> sunk{0};
+
+    std::thread responder([&]() {
+        pin_current_thread(b);
+        Message msg;
+        uint64_t received = 0;
+        while (running.load(std::memory_order_relaxed)) {
+            if (!ping->try_pop(msg)) {
+                __builtin_ia32_pause();
+                continue;
+            }
+            if (sink.load(std::memory_order_relaxed)) {
+                sunk.store(++received, std::memory_order_release);
+            } else {
+                while (!pong->try_push(msg)) {
+                    __builtin_ia32_pause();
+                }
+            }
+        }
+    });
+
+    // Поток бенчмарка временно привязывается к ядру a
+    cpu_set_t saved;
+    pthread_getaffinity_np(pthread_self(), sizeof(saved), &saved);
+    pin_current_thread(a);
+
+    auto round_trip = [&](Message& msg) {
+        while (!ping->try_push(msg)) {
+            __builtin_ia32_pause();
+        }
+        while (!pong->try_pop(msg)) {
+            __builtin_ia32_pause();
+        }
+    };
+
+    // Прогрев: линии кэша очередей переходят между ядрами
+    Message msg = Message::create(0, 0, 0);
+    for (int i = 0; i < 1000; ++i) {
+        round_trip(msg);
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+    for (auto _ : state) {
+        round_trip(msg);
+    }
+    const double elapsed_ns = std::chrono::duration<double, std::nano>(
+        std::chrono::steady_clock::now() - start).count();
+    const double one_way_ns = elapsed_ns / static_cast<double>(state.iterations()) / 2.0;
+
+    // Пропускная способность a -> b без ответов
+    sink.store(true, std::memory_order_relaxed);
+    const auto stream_start = std::chrono::steady_clock::now();
+    for (uint64_t i = 0; i < stream; ++i) {
+        msg.sequence_number = i;
+        while (!ping->try_push(msg)) {
+            __builtin_ia32_pause();
+        }
+    }
+    while (sunk.load(std::memory_order_acquire) < stream) {
+        __builtin_ia32_pause();
+    }
+    const double stream_secs = std::chrono::duration<double>(
+        std::chrono::steady_clock::now() - stream_start).count();
+    const double msgs_per_sec = static_cast<double>(stream) / stream_secs;
+
+    running.store(false, std::memory_order_relaxed);
+    responder.join();
+    pthread_setaffinity_np(pthread_self(), sizeof(saved), &saved);
+
+    state.counters["one_way_ns"] = one_way_ns;
+    state.counters["msgs_per_sec"] = msgs_per_sec;
+    state.SetLabel(core_relation_name(core_relation(a, b)));
+
+    g_pairs[{a, b}] = {one_way_ns, msgs_per_sec};
+}
+
+static double median(std::vector<double> values) {
+    if (values.empty()) return 0.0;
+    std::sort(values.begin(), values.end());
+    return values[values.size() / 2];
+}
+
+/**
+ * Матрицы в JSON и сводка по уровням топологии
+ */
+static void write_matrix(const CoreMatrixOptions& options) {
+    const size_t n = options.cores.size();
+    json one_way = json::array();
+    json throughput = json::array();
+    json relation = json::array();
+    std::map<CoreRelation, std::vector<std::pair<double, double>>> by_level;
+
+    for (size_t i = 0; i < n; ++i) {
+        json one_way_row = json::array();
+        json throughput_row = json::array();
+        json relation_row = json::array();
+        for (size_t j = 0; j < n; ++j) {
+            const uint32_t a = options.cores[i];
+            const uint32_t b = options.cores[j];
+            const CoreRelation level = core_relation(a, b);
+            relation_row.push_back(core_relation_name(level));
+
+            // Без --ordered матрица заполняется симметрично
+            auto it = g_pairs.find({a, b});
+            if (it == g_pairs.end() && !options.ordered) {
+                it = g_pairs.find({b, a});
+            }
+            if (it == g_pairs.end()) {
+                one_way_row.push_back(nullptr);
+                throughput_row.push_back(nullptr);
+                continue;
+            }
+            one_way_row.push_back(it->second.one_way_ns);
+            throughput_row.push_back(it->second.msgs_per_sec);
+            if (options.ordered || a < b) {
+                by_level[level].push_back({it->second.one_way_ns, it->second.msgs_per_sec});
+            }
+        }
+        one_way.push_back(one_way_row);
+        throughput.push_back(throughput_row);
+        relation.push_back(relation_row);
+    }
+
+    json summary = json::object();
+    std::cout << std::endl << "Сводка по уровням топологии:" << std::endl;
+    std::cout << "  Уровень        пар   one-way min/median/max (нс)     msgs/s median" << std::endl;
+    for (const auto& [level, samples] : by_level) {
+        std::vector<double> latencies;
+        std::vector<double> rates;
+        for (const auto& [latency, rate] : samples) {
+            latencies.push_back(latency);
+            rates.push_back(rate);
+        }
+        const double min_ns = *std::min_element(latencies.begin(), latencies.end());
+        const double max_ns = *std::max_element(latencies.begin(), latencies.end());
+
+        std::cout << "  " << std::left << std::setw(14) << core_relation_name(level) << std::right
+                  << std::setw(4) << samples.size() << std::fixed << std::setprecision(1)
+                  << std::setw(10) << min_ns << " / " << std::setw(7) << median(latencies)
+                  << " / " << std::setw(7) << max_ns
+                  << std::setprecision(0) << std::setw(16) << median(rates) << std::endl;
+
+        summary[core_relation_name(level)] = {
+            {"pairs", samples.size()},
+            {"one_way_ns_min", min_ns},
+            {"one_way_ns_median", median(latencies)},
+            {"one_way_ns_max", max_ns},
+            {"msgs_per_sec_median", median(rates)}
+        };
+    }
+
+    json out = {
+        {"cores", options.cores},
+        {"ordered", options.ordered},
+        {"relation", relation},
+        {"one_way_ns", one_way},
+        {"msgs_per_sec", throughput},
+        {"summary", summary}
+    };
+
+    const auto parent = std::filesystem::path(options.matrix_out).parent_path();
+    if (!parent.empty()) {
+        std::filesystem::create_directories(parent);
+    }
+    std::ofstream file(options.matrix_out);
+    file << out.dump(2) << std::endl;
+    std::cout << "Матрица записана в " << options.matrix_out << std::endl;
+}
+
+int main(int argc, char** argv) {
+    CoreMatrixOptions options;
+    std::vector<char*> benchmark_args{argv[0]};
+
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        auto value_of = [&arg](const std::string& flag) -> const char* {
+            return arg.rfind(flag, 0) == 0 ? arg.c_str() + flag.size() : nullptr;
+        };
+
+        if (const char* v = value_of("--cores=")) {
+            std::string list = v;
+            size_t begin = 0;
+            while (begin < list.size()) {
+                size_t end = list.find(',', begin);
+                if (end == std::string::npos) {
+                    end = list.size();
+                }
+                options.cores.push_back(static_cast<uint32_t>(std::stoul(list.substr(begin, end - begin))));
+                begin = end + 1;
+            }
+        } else if (arg == "--ordered") {
+            options.ordered = true;
+        } else if (const char* v = value_of("--rounds=")) {
+            options.rounds = std::max<uint64_t>(1, std::stoull(v));
+        } else if (const char* v = value_of("--stream=")) {
+            options.stream = std::max<uint64_t>(1, std::stoull(v));
+        } else if (const char* v = value_of("--matrix_out=")) {
+            options.matrix_out = v;
+        } else {
+            benchmark_args.push_back(argv[i]);
+        }
+    }
+
+    if (options.cores.empty()) {
+        options.cores = allowed_cores();
+    }
+    if (options.cores.size() < 2) {
+        std::cerr << "Для матрицы нужно минимум 2 ядра (доступно " << options.cores.size() << ")" << std::endl;
+        return 1;
+    }
+
+    for (uint32_t a : options.cores) {
+        for (uint32_t b : options.cores) {
+            if (a == b || (!options.ordered && a > b)) {
+                continue;
+            }
+            const std::string name = "BM_CoreToCore/" + std::to_string(a) + "/" + std::to_string(b);
+            benchmark::RegisterBenchmark(name.c_str(), [a, b, &options](benchmark::State& state) {
+                run_pair(state, a, b, options.stream);
+            })
+                ->Iterations(static_cast<benchmark::IterationCount>(options.rounds))
+                ->UseRealTime();
+        }
+    }
+
+    int benchmark_argc = static_cast<int>(benchmark_args.size());
+    benchmark::Initialize(&benchmark_argc, benchmark_args.data());
+    if (benchmark::ReportUnrecognizedArguments(benchmark_argc, benchmark_args.data())) {
+        return 1;
+    }
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+
+    write_matrix(options);
+    return 0;
+}
@@ -1,8 +1,15 @@
 #include <benchmark/benchmark.h>
 #include "spsc_queue.hpp"
 #include "message.hpp"
+#include "journal.hpp"
+#include "flight_recorder.hpp"
+#include "perf_counters.hpp"
+#include <atomic>
+#include <filesystem>
+#include <thread>
 #include <vector>
 #include <memory>
+#include <string>
 
 // Бенчмарк: выделение памяти для очередей
 static void BM_QueueAllocation(benchmark::State& state) {
@@ -65,6 +72,11 @@ static void BM_CacheMisses(benchmark::State& state) {
         buffer.push_back(msg);
     }
 
+    // Промахи считаются счетчиками perf потока бенчмарка (если доступны)
+    PerfCounterGroup perf;
+    perf.open();
+    const PerfCounts before = perf.read();
+
     for (auto _ : state) {
         // Доступ с заданным шагом (stride) для имитации cache misses
         uint64_t sum = 0;
@@ -73,6 +85,16 @@ static void BM_CacheMisses(benchmark::State& state) {
         }
         benchmark::DoNotOptimize(sum);
     }
+
+    const PerfCounts misses = perf.read() - before;
+    const double accesses = static_cast<double>(state.iterations())
+                          * static_cast<double>((buffer.size() + stride - 1) / stride);
+    for (PerfEvent event : {PERF_L1D_MISSES, PERF_LLC_MISSES}) {
+        if (misses.valid[event] && accesses > 0) {
+            state.counters[std::string(perf_event_name(event)) + "_per_access"] =
+                static_cast<double>(misses.values[event]) / accesses;
+        }
+    }
 }
 BENCHMARK(BM_CacheMisses)->Arg(1)->Arg(8)->Arg(64)->Arg(256);
 
@@ -112,4 +134,68 @@ BENCHMARK(BM_QueueSizeImpact)
     ->Arg(16384)
     ->Arg(65536);
 
+// Бенчмарк: накладные расходы журнала при разных политиках синхронизации
+// Arg: 0 - без журнала (базовая линия), 1 - none, 2 - interval (10ms), 3 - every_n (65536)
+static void BM_JournalAppend(benchmark::State& state) {
+    const int mode = static_cast<int>(state.range(0));
+    Message msg = Message::create(0, 0, 0);
+
+    if (mode == 0) {
+        Message sink;
+        for (auto _ : state) {
+            sink = msg;
+            ++msg.sequence_number;
+            benchmark::DoNotOptimize(sink);
+        }
+        state.SetItemsProcessed(state.iterations());
+        state.SetLabel("no journal");
+        return;
+    }
+
+    JournalConfig config;
+    config.enabled = true;
+    config.directory = (std::filesystem::temp_directory_path() / "router_journal_bench").string();
+    config.segment_records = 1 << 18;
+    config.sync_policy = mode == 1 ? JournalSyncPolicy::None
+                       : mode == 2 ? JournalSyncPolicy::Interval
+                       : JournalSyncPolicy::EveryN;
+
+    {
+        JournalWriter journal(config);
+        std::atomic<bool> running{true};
+        std::thread journal_thread([&]() { journal.run(running); });
+
+        for (auto _ : state) {
+            journal.append(msg, 0);
+            ++msg.sequence_number;
+        }
+
+        running.store(false, std::memory_order_release);
+        journal_thread.join();
+    }
+
+    std::filesystem::remove_all(config.directory);
+    state.SetItemsProcessed(state.iterations());
+    state.SetBytesProcessed(state.iterations() * sizeof(JournalRecord));
+    state.SetLabel(mode == 1 ? "none" : mode == 2 ? "interval" : "every_n");
+}
+BENCHMARK(BM_JournalAppend)->Arg(0)->Arg(1)->Arg(2)->Arg(3)->UseRealTime();
+
+// Бенчмарк: стоимость записи события бортового самописца
+// Arg: размер кольца событий; запись вызывается напрямую, без макроса,
+// поэтому не зависит от ROUTER_FLIGHT_RECORDER
+static void BM_FlightRecorderEvent(benchmark::State& state) {
+    const std::atomic<bool> frozen{false};
+    ThreadRecorder recorder("bench", static_cast<size_t>(state.range(0)), frozen);
+    uint32_t arg = 0;
+
+    for (auto _ : state) {
+        recorder.record(TraceEvent::Pop, 1, arg++);
+    }
+
+    benchmark::DoNotOptimize(recorder.head());
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_FlightRecorderEvent)->Arg(1024)->Arg(65536);
+
 BENCHMARK_MAIN();
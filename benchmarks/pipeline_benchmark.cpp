@@ -0,0 +1,702 @@
+#include <benchmark/benchmark.h>
+#include "config.hpp"
+#include "pipeline.hpp"
+#include <nlohmann/json.hpp>
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <set>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * Бенчмарк полного конвейера на настоящих классах (Pipeline: Producer, Stage1Router,
+ * Processor, Stage2Router, Strategy) по JSON-конфигурациям из configs или по сетке
+ * producers x processors x strategies.
+ *
+ * Каждый прогон: прогрев warmup_ms, затем windows измеряемых окон по window_ms.
+ * Счетчики: msgs_per_sec (доставлено стратегиям за окна), p50/p99/p999 задержки
+ * от создания до получения стратегией, drained - дренировались ли очереди после остановки.
+ * Счетчики perf всех потоков за окна, на сообщение: cycles_per_msg, instructions_per_msg,
+ * ipc, l1d_misses_per_msg, llc_misses_per_msg, branch_misses_per_msg, context_switches
+ * (только события, доступные на машине).
+ * transport_bytes_per_msg - байт, копируемых транспортом на сообщение.
+ *
+ * Каждая конфигурация прогоняется в схемах --layout: queues - цепочка очередей с потоками
+ * роутеров (имя BM_Pipeline/<config>), shared_ring - общее кольцо (BM_Pipeline/<config>/shared_ring),
+ * fused - маршрутизация в производителях и процессорах (BM_Pipeline/<config>/fused).
+ * Конфигурации, несовместимые со схемой (coroutines, elastic, shm, replay, multicast), в ней
+ * пропускаются. В конце печатается сравнение схем с queues: пропускная способность,
+ * p50/p99 и промахи кешей на сообщение.
+ *
+ * Дополнительные аргументы (остальные передаются Google Benchmark):
+ *   --config=<path>        конфигурация (можно несколько раз)
+ *   --configs_dir=<dir>    все *.json каталога (по умолчанию configs, если нет --config/--sweep)
+ *   --sweep=1,2,4          сетка producers x processors x strategies на основе первой конфигурации
+ *   --warmup_ms=N --window_ms=N --windows=N
+ *   --baseline=<json>      сравнение с сохраненным --benchmark_out=... --benchmark_out_format=json
+ *   --threshold=0.10       допустимое ухудшение msgs_per_sec и p99 (доля)
+ *   --perf=0               не открывать счетчики perf (по умолчанию открываются)
+ *   --layout=queues,shared_ring,fused  сравниваемые схемы конвейера (по умолчанию все)
+ *   --load=10,50,100,120   кривая нагрузки: доли (%) пропускной способности конфигурации,
+ *                          каждая с фиксированными и адаптивными пакетами (batching)
+ *                          (BM_Pipeline/<config>/load<N>/fixed|adaptive, схема queues)
+ *   --capacity=N           пропускная способность для --load, msgs/s (по умолчанию измеряется
+ *                          прогоном с производителями без пауз)
+ *   --queue_memory=heap,mmap,thp,hugetlb,thp+prefault
+ *                          размещение очередей (queue_memory, схема queues): время создания
+ *                          конвейера, прирост RSS после создания и после первой секунды, задержки
+ *                          первой секунды без прогрева (BM_Pipeline/<config>/mem_<вариант>)
+ */
+
+using json = nlohmann::json;
+
+struct PipelineBenchOptions {
+    std::vector<std::string> configs;
+    std::string configs_dir = "configs";
+    std::vector<uint32_t> sweep;
+    uint64_t warmup_ms = 500;
+    uint64_t window_ms = 1000;
+    uint64_t windows = 3;
+    uint64_t drain_timeout_ms = 30000;
+    std::string baseline;
+    double threshold = 0.10;
+    bool perf = true;
+    std::vector<std::string> layouts{"queues", "shared_ring", "fused"};
+    std::vector<uint32_t> loads;
+    double capacity = 0.0;
+    std::vector<std::string> queue_memory;
+};
+
+struct PipelineBenchResult {
+    std::string name;
+    std::string config;                 // Имя конфигурации без суффикса схемы
+    std::string layout;
+    double msgs_per_sec;
+    double p50_us;
+    double p99_us;
+    double llc_misses_per_msg;          // < 0 - событие недоступно
+    double l1d_misses_per_msg;
+    uint32_t load_percent = 0;          // Точка кривой нагрузки (--load), 0 - не кривая
+    double offered_per_sec = 0.0;
+};
+
+static std::vector<PipelineBenchResult> g_results;
+
+struct QueueMemoryResult {
+    std::string config;
+    std::string variant;
+    double startup_ms;                  // Конструирование Pipeline
+    double queue_setup_ms;              // В том числе создание очередей и prefault
+    double rss_start_mb;                // Прирост RSS после создания
+    double rss_first_second_mb;         // Прирост RSS после первой секунды работы
+    double p50_us;
+    double p99_us;
+    double p999_us;
+};
+
+static std::vector<QueueMemoryResult> g_memory_results;
+
+// Счетчики perf за окна в пересчете на доставленное сообщение
+static void set_perf_counters(benchmark::State& state, const PerfCounts& counts, uint64_t messages) {
+    if (messages == 0) {
+        return;
+    }
+    const double per_msg = 1.0 / static_cast<double>(messages);
+    for (PerfEvent event : {PERF_CYCLES, PERF_INSTRUCTIONS, PERF_L1D_MISSES,
+                            PERF_LLC_MISSES, PERF_BRANCH_MISSES}) {
+        if (counts.valid[event]) {
+            state.counters[std::string(perf_event_name(event)) + "_per_msg"] =
+                static_cast<double>(counts.values[event]) * per_msg;
+        }
+    }
+    if (counts.valid[PERF_CYCLES] && counts.valid[PERF_INSTRUCTIONS] && counts.values[PERF_CYCLES] > 0) {
+        state.counters["ipc"] = static_cast<double>(counts.values[PERF_INSTRUCTIONS])
+                              / static_cast<double>(counts.values[PERF_CYCLES]);
+    }
+    if (counts.valid[PERF_CONTEXT_SWITCHES]) {
+        state.counters["context_switches"] = static_cast<double>(counts.values[PERF_CONTEXT_SWITCHES]);
+    }
+}
+
+// Прогон конвейера: прогрев, измеряемые окна, остановка с дренированием
+static void run_pipeline(benchmark::State& state, const std::string& name, const std::string& config_name,
+                         const std::string& layout, SystemConfig config, const PipelineBenchOptions& options) {
+    // Производители работают до явной остановки, а не duration_secs
+    config.duration_secs = 24 * 3600;
+    config.perf_counters.enabled = config.perf_counters.enabled || options.perf;
+
+    Pipeline pipeline(config);
+    SystemStatistics& stats = pipeline.stats();
+    pipeline.start();
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(options.warmup_ms));
+    stats.clear_latencies();
+
+    const PerfStageCounters* perf = pipeline.perf_counters();
+    const PerfCounts perf_before = perf ? perf->total() : PerfCounts{};
+
+    uint64_t delivered_total = 0;
+    double seconds_total = 0.0;
+
+    for (auto _ : state) {
+        const uint64_t before = stats.counters()[StatsField::Delivered];
+        const auto start = std::chrono::steady_clock::now();
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(options.window_ms));
+
+        const double elapsed = std::chrono::duration<double>(
+            std::chrono::steady_clock::now() - start).count();
+        delivered_total += stats.counters()[StatsField::Delivered] - before;
+        seconds_total += elapsed;
+        state.SetIterationTime(elapsed);
+    }
+
+    const PerfCounts perf_windows = perf ? perf->total() - perf_before : PerfCounts{};
+
+    // Задержки только за измеряемые окна
+    double p50 = 0.0, p99 = 0.0, p999 = 0.0;
+    {
+        std::lock_guard<std::mutex> lock(stats.latency_mutex);
+        p50 = stats.delivered_latencies.p50();
+        p99 = stats.delivered_latencies.p99();
+        p999 = stats.delivered_latencies.p999();
+    }
+
+    pipeline.stop_producers();
+    const bool drained = pipeline.drain(std::chrono::milliseconds(options.drain_timeout_ms));
+    pipeline.stop();
+
+    const double msgs_per_sec = seconds_total > 0.0 ? static_cast<double>(delivered_total) / seconds_total : 0.0;
+    state.counters["msgs_per_sec"] = msgs_per_sec;
+    state.counters["p50_us"] = p50;
+    state.counters["p99_us"] = p99;
+    state.counters["p999_us"] = p999;
+    state.counters["drained"] = drained ? 1 : 0;
+    state.counters["order_violations"] = static_cast<double>(stats.total_order_violations());
+    state.counters["transport_bytes_per_msg"] = static_cast<double>(pipeline.transport_bytes_per_message());
+    state.SetItemsProcessed(static_cast<int64_t>(delivered_total));
+    set_perf_counters(state, perf_windows, delivered_total);
+
+    auto per_msg = [&](PerfEvent event) {
+        return perf_windows.valid[event] && delivered_total > 0
+            ? static_cast<double>(perf_windows.values[event]) / static_cast<double>(delivered_total) : -1.0;
+    };
+    g_results.push_back({name, config_name, layout, msgs_per_sec, p50, p99,
+                         per_msg(PERF_LLC_MISSES), per_msg(PERF_L1D_MISSES)});
+}
+
+/**
+ * Пропускная способность конфигурации: производители без пауз, доставлено за одно окно
+ */
+static double measure_capacity(SystemConfig config, const PipelineBenchOptions& options) {
+    config.duration_secs = 24 * 3600;
+    config.producers.messages_per_sec = 1'000'000'000;   // Интервал 1 нс - отправка без пауз
+
+    Pipeline pipeline(config);
+    SystemStatistics& stats = pipeline.stats();
+    pipeline.start();
+    std::this_thread::sleep_for(std::chrono::milliseconds(options.warmup_ms));
+
+    const uint64_t before = stats.counters()[StatsField::Delivered];
+    const auto start = std::chrono::steady_clock::now();
+    std::this_thread::sleep_for(std::chrono::milliseconds(options.window_ms));
+    const double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    const uint64_t delivered = stats.counters()[StatsField::Delivered] - before;
+
+    pipeline.stop_producers();
+    pipeline.drain(std::chrono::milliseconds(options.drain_timeout_ms));
+    pipeline.stop();
+    return static_cast<double>(delivered) / elapsed;
+}
+
+/**
+ * Кривая нагрузки: каждая доля пропускной способности с фиксированными и адаптивными пакетами
+ */
+static void register_load_curve(const std::string& name, const SystemConfig& base,
+                                const PipelineBenchOptions& options) {
+    const double capacity = options.capacity > 0.0 ? options.capacity : measure_capacity(base, options);
+    std::cout << name << ": пропускная способность " << std::fixed << std::setprecision(0)
+              << capacity << " msgs/s" << std::endl;
+
+    for (uint32_t load : options.loads) {
+        const double offered = capacity * load / 100.0;
+        for (bool adaptive : {false, true}) {
+            SystemConfig config = base;
+            config.runtime.transport = PipelineTransport::Queues;
+            config.runtime.topology = PipelineTopology::Staged;
+            config.producers.messages_per_sec = std::max<uint64_t>(
+                1, static_cast<uint64_t>(offered / config.producers.count));
+            config.batching.enabled = adaptive;
+            if (!config.validate()) {
+                continue;
+            }
+
+            const std::string config_name = name + "/load" + std::to_string(load);
+            const std::string mode = adaptive ? "adaptive" : "fixed";
+            const std::string full_name = config_name + "/" + mode;
+            benchmark::RegisterBenchmark(full_name.c_str(), [=, &options](benchmark::State& state) {
+                run_pipeline(state, full_name, config_name, mode, config, options);
+                g_results.back().load_percent = load;
+                g_results.back().offered_per_sec = offered;
+                state.counters["offered_per_sec"] = offered;
+            })
+                ->UseManualTime()
+                ->Iterations(static_cast<benchmark::IterationCount>(options.windows))
+                ->Unit(benchmark::kMillisecond);
+        }
+    }
+}
+
+/**
+ * Таблица кривой нагрузки: фиксированные против адаптивных пакетов на каждой доле
+ */
+static void print_load_curve() {
+    bool header = false;
+    for (const auto& fixed : g_results) {
+        if (fixed.load_percent == 0 || fixed.layout != "fixed") {
+            continue;
+        }
+        for (const auto& adaptive : g_results) {
+            if (adaptive.config != fixed.config || adaptive.layout != "adaptive") {
+                continue;
+            }
+
+            if (!header) {
+                std::cout << std::endl << "Кривая нагрузки (fixed -> adaptive):" << std::endl;
+                std::cout << "  " << std::left << std::setw(34) << "Config" << std::right
+                          << std::setw(12) << "offered/s" << std::setw(25) << "msgs/s"
+                          << std::setw(23) << "p50 us" << std::setw(23) << "p99 us" << std::endl;
+                header = true;
+            }
+            std::cout << "  " << std::left << std::setw(34) << fixed.config << std::right
+                      << std::fixed << std::setprecision(0) << std::setw(12) << fixed.offered_per_sec
+                      << std::setw(12) << fixed.msgs_per_sec << " -> " << std::setw(9) << adaptive.msgs_per_sec
+                      << std::setprecision(1)
+                      << std::setw(10) << fixed.p50_us << " -> " << std::setw(9) << adaptive.p50_us
+                      << std::setw(10) << fixed.p99_us << " -> " << std::setw(9) << adaptive.p99_us
+                      << std::endl;
+        }
+    }
+}
+
+/**
+ * Запуск с нуля: время создания конвейера, RSS и задержки первой секунды (без прогрева)
+ */
+static void run_queue_memory(benchmark::State& state, const std::string& config_name,
+                             const std::string& variant, SystemConfig config, const PipelineBenchOptions& options) {
+    config.duration_secs = 24 * 3600;
+    auto to_mb = [](size_t after, size_t before) {
+        return after > before ? static_cast<double>(after - before) / (1024.0 * 1024.0) : 0.0;
+    };
+
+    for (auto _ : state) {
+        const size_t rss_before = resident_set_bytes();
+        const auto start = std::chrono::steady_clock::now();
+        Pipeline pipeline(config);
+        const double startup = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        const size_t rss_start = resident_set_bytes();
+
+        SystemStatistics& stats = pipeline.stats();
+        pipeline.start();
+        std::this_thread::sleep_for(std::chrono::seconds(1));
+        const size_t rss_first_second = resident_set_bytes();
+
+        QueueMemoryResult result{config_name, variant, startup * 1e3,
+                                 static_cast<double>(pipeline.queue_setup_ns()) / 1e6,
+                                 to_mb(rss_start, rss_before), to_mb(rss_first_second, rss_before), 0.0, 0.0, 0.0};
+        {
+            std::lock_guard<std::mutex> lock(stats.latency_mutex);
+            result.p50_us = stats.delivered_latencies.p50();
+            result.p99_us = stats.delivered_latencies.p99();
+            result.p999_us = stats.delivered_latencies.p999();
+        }
+
+        pipeline.stop_producers();
+        pipeline.drain(std::chrono::milliseconds(options.drain_timeout_ms));
+        pipeline.stop();
+
+        state.SetIterationTime(startup);
+        state.counters["startup_ms"] = result.startup_ms;
+        state.counters["queue_setup_ms"] = result.queue_setup_ms;
+        state.counters["rss_start_mb"] = result.rss_start_mb;
+        state.counters["rss_1s_mb"] = result.rss_first_second_mb;
+        state.counters["p50_us"] = result.p50_us;
+        state.counters["p99_us"] = result.p99_us;
+        state.counters["p999_us"] = result.p999_us;
+        g_memory_results.push_back(result);
+    }
+}
+
+/**
+ * Варианты размещения очередей: "<backing>" или "<backing>+prefault"
+ */
+static void register_queue_memory(const std::string& name, const SystemConfig& base,
+                                  const PipelineBenchOptions& options) {
+    for (const std::string& variant : options.queue_memory) {
+        const size_t plus = variant.find('+');
+        SystemConfig config = base;
+        config.runtime.transport = PipelineTransport::Queues;
+        config.runtime.topology = PipelineTopology::Staged;
+        config.queue_memory.backing = queue_backing_from_name(variant.substr(0, plus));
+        config.queue_memory.prefault = plus != std::string::npos;
+        if (config.queue_memory.prefault && variant.substr(plus + 1) != "prefault") {
+            throw std::runtime_error("Неизвестный вариант --queue_memory: " + variant);
+        }
+        if (!config.validate()) {
+            std::cerr << "Пропуск " << name << " для --queue_memory=" << variant << std::endl;
+            continue;
+        }
+
+        const std::string full_name = name + "/mem_" + variant;
+        benchmark::RegisterBenchmark(full_name.c_str(), [=, &options](benchmark::State& state) {
+            run_queue_memory(state, name, variant, config, options);
+        })
+            ->UseManualTime()
+            ->Iterations(1)
+            ->Unit(benchmark::kMillisecond);
+    }
+}
+
+/**
+ * Таблица вариантов размещения очередей
+ */
+static void print_queue_memory() {
+    if (g_memory_results.empty()) {
+        return;
+    }
+    std::cout << std::endl << "Размещение очередей (запуск и первая секунда):" << std::endl;
+    std::cout << "  " << std::left << std::setw(34) << "Config" << std::setw(18) << "Variant" << std::right
+              << std::setw(12) << "startup ms" << std::setw(12) << "queues ms"
+              << std::setw(12) << "RSS0 MB" << std::setw(12) << "RSS1s MB"
+              << std::setw(12) << "p50 us" << std::setw(12) << "p99 us" << std::setw(12) << "p99.9 us" << std::endl;
+    for (const auto& result : g_memory_results) {
+        std::cout << "  " << std::left << std::setw(34) << result.config << std::setw(18) << result.variant
+                  << std::right << std::fixed << std::setprecision(1)
+                  << std::setw(12) << result.startup_ms << std::setw(12) << result.queue_setup_ms
+                  << std::setw(12) << result.rss_start_mb << std::setw(12) << result.rss_first_second_mb
+                  << std::setw(12) << result.p50_us << std::setw(12) << result.p99_us
+                  << std::setw(12) << result.p999_us << std::endl;
+    }
+}
+
+/**
+ * Конфигурация сетки: типы сообщений шаблона распределяются по процессорам
+ * и стратегиям round-robin, порядок требуется для всех типов
+ */
+static SystemConfig make_sweep_config(const SystemConfig& base, uint32_t producers,
+                                      uint32_t processors, uint32_t strategies) {
+    SystemConfig config = base;
+    config.scenario = "sweep";
+    config.producers.count = producers;
+    config.processors.count = processors;
+    config.elastic.enabled = false;
+
+    const uint64_t strategy_ns = base.strategies.processing_times_ns.count(0)
+        ? base.strategies.processing_times_ns.at(0) : 100;
+    config.strategies.count = strategies;
+    config.strategies.processing_times_ns.clear();
+    for (uint32_t i = 0; i < strategies; ++i) {
+        config.strategies.processing_times_ns[static_cast<uint8_t>(i)] = strategy_ns;
+    }
+
+    std::set<uint8_t> types;
+    for (const auto& [type, weight] : base.producers.distribution) {
+        types.insert(type);
+    }
+
+    config.stage1_rules.clear();
+    config.stage2_rules.clear();
+    size_t index = 0;
+    for (uint8_t type : types) {
+        config.stage1_rules.push_back({type, {static_cast<uint8_t>(index % processors)}});
+        config.stage2_rules.push_back({type, static_cast<uint8_t>(index % strategies), true, {}});
+        ++index;
+    }
+    return config;
+}
+
+/**
+ * Схема конвейера по имени --layout
+ * @return false если имя неизвестно
+ */
+static bool apply_layout(const std::string& layout, SystemConfig& config) {
+    if (layout == "queues") {
+        config.runtime.transport = PipelineTransport::Queues;
+        config.runtime.topology = PipelineTopology::Staged;
+    } else if (layout == "shared_ring") {
+        config.runtime.transport = PipelineTransport::SharedRing;
+        config.runtime.topology = PipelineTopology::Staged;
+    } else if (layout == "fused") {
+        config.runtime.transport = PipelineTransport::Queues;
+        config.runtime.topology = PipelineTopology::Fused;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Регистрация конфигурации во всех выбранных схемах
+ * Схема queues оставляет конфигурацию как есть (имена совпадают с прежними базовыми линиями)
+ */
+static void register_pipeline(const std::string& name, const SystemConfig& base,
+                              const PipelineBenchOptions& options) {
+    for (const std::string& layout : options.layouts) {
+        SystemConfig config = base;
+        std::string full_name = name;
+        if (layout != "queues") {
+            apply_layout(layout, config);
+            full_name += "/" + layout;
+            if (!config.validate()) {
+                std::cerr << "Пропуск " << full_name << ": конфигурация несовместима со схемой" << std::endl;
+                continue;
+            }
+        }
+
+        benchmark::RegisterBenchmark(full_name.c_str(), [full_name, name, layout, config, &options](benchmark::State& state) {
+            run_pipeline(state, full_name, name, layout, config, options);
+        })
+            ->UseManualTime()
+            ->Iterations(static_cast<benchmark::IterationCount>(options.windows))
+            ->Unit(benchmark::kMillisecond);
+    }
+}
+
+/**
+ * Сравнение каждой схемы со схемой queues на той же конфигурации
+ */
+static void print_layout_comparison() {
+    auto print_pair = [](double base, double value, int precision) {
+        if (base < 0.0 || value < 0.0) {
+            std::cout << std::setw(23) << "n/a";
+        } else {
+            std::cout << std::setprecision(precision) << std::setw(10) << base << " -> " << std::setw(9) << value;
+        }
+    };
+
+    bool header = false;
+    for (const auto& base : g_results) {
+        if (base.layout != "queues") {
+            continue;
+        }
+        for (const auto& result : g_results) {
+            if (result.config != base.config || result.layout == "queues") {
+                continue;
+            }
+
+            if (!header) {
+                std::cout << std::endl << "Сравнение схем с queues (значения queues -> схема):" << std::endl;
+                std::cout << "  " << std::left << std::setw(28) << "Config" << std::setw(13) << "Layout"
+                          << std::right << std::setw(10) << "msgs/s" << std::setw(23) << "p50 us"
+                          << std::setw(23) << "p99 us" << std::setw(23) << "LLC miss/msg"
+                          << std::setw(23) << "L1D miss/msg" << std::endl;
+                header = true;
+            }
+
+            const double rate_change = base.msgs_per_sec > 0.0 ? result.msgs_per_sec / base.msgs_per_sec - 1.0 : 0.0;
+            std::cout << "  " << std::left << std::setw(28) << base.config << std::setw(13) << result.layout
+                      << std::right << std::fixed << std::setprecision(1) << std::showpos
+                      << std::setw(9) << rate_change * 100.0 << "%" << std::noshowpos;
+            print_pair(base.p50_us, result.p50_us, 1);
+            print_pair(base.p99_us, result.p99_us, 1);
+            print_pair(base.llc_misses_per_msg, result.llc_misses_per_msg, 2);
+            print_pair(base.l1d_misses_per_msg, result.l1d_misses_per_msg, 2);
+            std::cout << std::endl;
+        }
+    }
+    if (header) {
+        std::cout << "  Байт транспорта на сообщение: queues " << 4 * 2 * sizeof(Message)
+                  << ", shared_ring " << RingPipeline::transport_bytes_per_message()
+                  << ", fused " << FusedPipeline::transport_bytes_per_message() << std::endl;
+    }
+}
+
+/**
+ * Сравнение с сохраненным JSON Google Benchmark
+ * @return количество регрессий
+ */
+static size_t compare_with_baseline(const PipelineBenchOptions& options) {
+    std::ifstream file(options.baseline);
+    if (!file.is_open()) {
+        std::cerr << "Не удалось открыть базовую линию: " << options.baseline << std::endl;
+        return 1;
+    }
+    json baseline = json::parse(file);
+
+    // Имена в JSON дополнены суффиксами (/iterations:N/manual_time)
+    auto find_baseline = [&baseline](const std::string& name) -> const json* {
+        for (const auto& entry : baseline["benchmarks"]) {
+            const std::string entry_name = entry.value("name", "");
+            if (entry_name == name || entry_name.rfind(name + "/", 0) == 0) {
+                return &entry;
+            }
+        }
+        return nullptr;
+    };
+
+    std::cout << std::endl << "Сравнение с базовой линией " << options.baseline
+              << " (порог " << options.threshold * 100.0 << "%):" << std::endl;
+
+    size_t regressions = 0;
+    for (const auto& result : g_results) {
+        const json* entry = find_baseline(result.name);
+        if (!entry || !entry->contains("msgs_per_sec")) {
+            std::cout << "  " << result.name << ": нет в базовой линии" << std::endl;
+            continue;
+        }
+
+        const double base_rate = (*entry)["msgs_per_sec"].get<double>();
+        const double base_p99 = entry->value("p99_us", 0.0);
+        const double rate_change = base_rate > 0.0 ? result.msgs_per_sec / base_rate - 1.0 : 0.0;
+        const double p99_change = base_p99 > 0.0 ? result.p99_us / base_p99 - 1.0 : 0.0;
+        const bool regressed = rate_change < -options.threshold || p99_change > options.threshold;
+        regressions += regressed ? 1 : 0;
+
+        std::cout << "  " << result.name << std::fixed << std::setprecision(1)
+                  << ": msgs/s " << std::showpos << rate_change * 100.0 << "%"
+                  << ", p99 " << p99_change * 100.0 << "%" << std::noshowpos
+                  << (regressed ? "  РЕГРЕССИЯ" : "") << std::endl;
+    }
+    return regressions;
+}
+
+static std::vector<uint32_t> parse_list(const std::string& value) {
+    std::vector<uint32_t> result;
+    size_t begin = 0;
+    while (begin < value.size()) {
+        size_t end = value.find(',', begin);
+        if (end == std::string::npos) {
+            end = value.size();
+        }
+        result.push_back(static_cast<uint32_t>(std::stoul(value.substr(begin, end - begin))));
+        begin = end + 1;
+    }
+    return result;
+}
+
+int main(int argc, char** argv) {
+    PipelineBenchOptions options;
+    std::vector<char*> benchmark_args{argv[0]};
+
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        auto value_of = [&arg](const std::string& flag) -> const char* {
+            return arg.rfind(flag, 0) == 0 ? arg.c_str() + flag.size() : nullptr;
+        };
+
+        if (const char* v = value_of("--config=")) {
+            options.configs.push_back(v);
+        } else if (const char* v = value_of("--configs_dir=")) {
+            options.configs_dir = v;
+        } else if (const char* v = value_of("--sweep=")) {
+            options.sweep = parse_list(v);
+        } else if (const char* v = value_of("--warmup_ms=")) {
+            options.warmup_ms = std::stoull(v);
+        } else if (const char* v = value_of("--window_ms=")) {
+            options.window_ms = std::stoull(v);
+        } else if (const char* v = value_of("--windows=")) {
+            options.windows = std::max<uint64_t>(1, std::stoull(v));
+        } else if (const char* v = value_of("--baseline=")) {
+            options.baseline = v;
+        } else if (const char* v = value_of("--threshold=")) {
+            options.threshold = std::stod(v);
+        } else if (const char* v = value_of("--perf=")) {
+            options.perf = std::string(v) != "0";
+        } else if (const char* v = value_of("--load=")) {
+            options.loads = parse_list(v);
+        } else if (const char* v = value_of("--capacity=")) {
+            options.capacity = std::stod(v);
+        } else if (const char* v = value_of("--queue_memory=")) {
+            std::stringstream list(v);
+            for (std::string variant; std::getline(list, variant, ',');) {
+                options.queue_memory.push_back(variant);
+            }
+        } else if (const char* v = value_of("--layout=")) {
+            options.layouts.clear();
+            std::stringstream list(v);
+            SystemConfig probe;
+            for (std::string layout; std::getline(list, layout, ',');) {
+                if (!apply_layout(layout, probe)) {
+                    std::cerr << "Неизвестная схема --layout: " << layout << std::endl;
+                    return 1;
+                }
+                options.layouts.push_back(layout);
+            }
+        } else {
+            benchmark_args.push_back(argv[i]);
+        }
+    }
+
+    // По умолчанию - все конфигурации каталога
+    if (options.configs.empty()) {
+        std::vector<std::string> paths;
+        for (const auto& entry : std::filesystem::directory_iterator(options.configs_dir)) {
+            if (entry.path().extension() == ".json") {
+                paths.push_back(entry.path().string());
+            }
+        }
+        std::sort(paths.begin(), paths.end());
+        options.configs = paths;
+    }
+
+    try {
+        if (!options.queue_memory.empty()) {
+            for (const auto& path : options.configs) {
+                register_queue_memory("BM_Pipeline/" + std::filesystem::path(path).stem().string(),
+                                      SystemConfig::load_from_file(path), options);
+            }
+        } else if (!options.loads.empty()) {
+            for (const auto& path : options.configs) {
+                register_load_curve("BM_Pipeline/" + std::filesystem::path(path).stem().string(),
+                                    SystemConfig::load_from_file(path), options);
+            }
+        } else if (options.sweep.empty()) {
+            for (const auto& path : options.configs) {
+                SystemConfig config = SystemConfig::load_from_file(path);
+                register_pipeline("BM_Pipeline/" + std::filesystem::path(path).stem().string(),
+                                  config, options);
+            }
+        } else {
+            // Сетка строится на основе первой конфигурации (нагрузка и время обработки)
+            const SystemConfig base = SystemConfig::load_from_file(options.configs.front());
+            for (uint32_t producers : options.sweep) {
+                for (uint32_t processors : options.sweep) {
+                    for (uint32_t strategies : options.sweep) {
+                        SystemConfig config = make_sweep_config(base, producers, processors, strategies);
+                        if (!config.validate()) {
+                            continue;
+                        }
+                        register_pipeline("BM_Pipeline/sweep/p" + std::to_string(producers) +
+                                          "_c" + std::to_string(processors) +
+                                          "_s" + std::to_string(strategies), config, options);
+                    }
+                }
+            }
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Ошибка: " << e.what() << std::endl;
+        return 1;
+    }
+
+    int benchmark_argc = static_cast<int>(benchmark_args.size());
+    benchmark::Initialize(&benchmark_argc, benchmark_args.data());
+    if (benchmark::ReportUnrecognizedArguments(benchmark_argc, benchmark_args.data())) {
+        return 1;
+    }
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+    print_layout_comparison();
+    print_load_curve();
+    print_queue_memory();
+
+    if (!options.baseline.empty() && compare_with_baseline(options) > 0) {
+        return 1;
+    }
+    return 0;
+}
@@ -1,8 +1,22 @@
 #include <benchmark/benchmark.h>
 #include "spsc_queue.hpp"
+#include "mpsc_queue.hpp"
+#include "shm_queue.hpp"
+#include "broadcast_ring.hpp"
+#include "timestamp_merge.hpp"
 #include "message.hpp"
+#include "producer.hpp"
+#include "statistics.hpp"
 #include <thread>
 #include <atomic>
+#include <algorithm>
+#include <chrono>
+#include <limits>
+#include <memory>
+#include <vector>
+#include <signal.h>
+#include <sys/wait.h>
+#include <unistd.h>
 
 // Бенчмарк: производительность SPSC очереди (single-threaded push/pop)
 static void BM_SPSC_PushPop(benchmark::State& state) {
@@ -103,5 +117,546 @@ static void BM_SPSC_Fill(benchmark::State& state) {
 }
 BENCHMARK(BM_SPSC_Fill)->Arg(1000)->Arg(10000)->Arg(50000);
 
+// Бенчмарк: ограниченная MPSC очередь (single-threaded push/pop)
+static void BM_BoundedMPSC_PushPop(benchmark::State& state) {
+    auto queue = std::make_unique<BoundedMPSCQueue<Message, 65536>>();
+    Message msg = Message::create(0, 0, 0);
+
+    for (auto _ : state) {
+        queue->try_push(msg);
+        Message out;
+        queue->try_pop(out);
+        benchmark::DoNotOptimize(out);
+    }
+
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_BoundedMPSC_PushPop);
+
+// Round trip (ping-pong) через пару SPSC очередей
+using RoundTripQueue = SPSCQueue<Message, 1024>;
+constexpr uint64_t ROUND_TRIP_STOP = std::numeric_limits<uint64_t>::max();
+
+// Эхо-сторона: возвращает каждое сообщение до получения стоп-сообщения
+static void round_trip_echo(RoundTripQueue& ping, RoundTripQueue& pong) {
+    Message msg;
+    while (true) {
+        if (ping.try_pop(msg)) {
+            if (msg.sequence_number == ROUND_TRIP_STOP) {
+                return;
+            }
+            while (!pong.try_push(msg)) {
+                __builtin_ia32_pause();
+            }
+        } else {
+            __builtin_ia32_pause();
+        }
+    }
+}
+
+// Инициатор: одна итерация = отправка и ожидание ответа
+static void round_trip_drive(benchmark::State& state, RoundTripQueue& ping, RoundTripQueue& pong) {
+    Message msg = Message::create(0, 0, 0);
+    Message reply;
+
+    for (auto _ : state) {
+        while (!ping.try_push(msg)) {
+            __builtin_ia32_pause();
+        }
+        while (!pong.try_pop(reply)) {
+            __builtin_ia32_pause();
+        }
+        ++msg.sequence_number;
+    }
+
+    msg.sequence_number = ROUND_TRIP_STOP;
+    while (!ping.try_push(msg)) {
+        __builtin_ia32_pause();
+    }
+
+    state.SetItemsProcessed(state.iterations());
+}
+
+// Бенчмарк: round trip между двумя потоками одного процесса
+static void BM_SPSC_RoundTrip_InProcess(benchmark::State& state) {
+    auto ping = std::make_unique<RoundTripQueue>();
+    auto pong = std::make_unique<RoundTripQueue>();
+
+    std::thread echo([&]() { round_trip_echo(*ping, *pong); });
+    round_trip_drive(state, *ping, *pong);
+    echo.join();
+}
+BENCHMARK(BM_SPSC_RoundTrip_InProcess)->UseRealTime();
+
+// Бенчмарк: round trip между двумя процессами через очереди в разделяемой памяти
+static void BM_SPSC_RoundTrip_CrossProcess(benchmark::State& state) {
+    auto shm_queues = ShmQueueSet<RoundTripQueue>::create("", 2);
+
+    pid_t child = fork();
+    if (child < 0) {
+        state.SkipWithError("fork() не удался");
+        return;
+    }
+    if (child == 0) {
+        round_trip_echo(shm_queues->queue(0), shm_queues->queue(1));
+        _exit(0);
+    }
+
+    round_trip_drive(state, shm_queues->queue(0), shm_queues->queue(1));
+    waitpid(child, nullptr, 0);
+}
+BENCHMARK(BM_SPSC_RoundTrip_CrossProcess)->UseRealTime();
+
+// Round trip нескольких производителей через общую BoundedMPSCQueue в shm:
+// очередь 0 - общий вход (пишут все производители), очереди 1..N - ответы производителям
+using MPSCRoundTripQueue = BoundedMPSCQueue<Message, 1024>;
+
+// Производитель: ping во вход, ожидание ответа в своей очереди до стоп-сообщения
+static void mpsc_round_trip_client(MPSCRoundTripQueue& ingress, MPSCRoundTripQueue& reply, uint8_t producer_id) {
+    Message msg = Message::create(0, producer_id, 0);
+    Message answer;
+
+    while (true) {
+        while (!ingress.try_push(msg)) {
+            __builtin_ia32_pause();
+        }
+        while (!reply.try_pop(answer)) {
+            __builtin_ia32_pause();
+        }
+        if (answer.sequence_number == ROUND_TRIP_STOP) {
+            return;
+        }
+        ++msg.sequence_number;
+    }
+}
+
+// Потребитель (поток бенчмарка): итерация = ответ на один ping любого производителя
+static void mpsc_round_trip_serve(benchmark::State& state, ShmQueueSet<MPSCRoundTripQueue>& queues,
+                                  uint32_t producers) {
+    MPSCRoundTripQueue& ingress = queues.queue(0);
+    Message msg;
+
+    for (auto _ : state) {
+        while (!ingress.try_pop(msg)) {
+            __builtin_ia32_pause();
+        }
+        while (!queues.queue(1 + msg.producer_id).try_push(msg)) {
+            __builtin_ia32_pause();
+        }
+    }
+
+    // У каждого производителя ровно один ping в полете: отвечаем на него стоп-сообщением
+    for (uint32_t stopped = 0; stopped < producers; ++stopped) {
+        while (!ingress.try_pop(msg)) {
+            __builtin_ia32_pause();
+        }
+        msg.sequence_number = ROUND_TRIP_STOP;
+        while (!queues.queue(1 + msg.producer_id).try_push(msg)) {
+            __builtin_ia32_pause();
+        }
+    }
+
+    state.SetItemsProcessed(state.iterations());
+}
+
+// Бенчмарк: производители - потоки одного процесса, очереди в shm
+static void BM_BoundedMPSC_RoundTrip_Threads(benchmark::State& state) {
+    const auto producers = static_cast<uint32_t>(state.range(0));
+    auto shm_queues = ShmQueueSet<MPSCRoundTripQueue>::create("", 1 + producers);
+
+    std::vector<std::thread> clients;
+    for (uint32_t p = 0; p < producers; ++p) {
+        clients.emplace_back([&, p]() {
+            mpsc_round_trip_client(shm_queues->queue(0), shm_queues->queue(1 + p), static_cast<uint8_t>(p));
+        });
+    }
+
+    mpsc_round_trip_serve(state, *shm_queues, producers);
+    for (auto& client : clients) {
+        client.join();
+    }
+}
+BENCHMARK(BM_BoundedMPSC_RoundTrip_Threads)->Arg(1)->Arg(2)->Arg(4)->UseRealTime();
+
+// Бенчмарк: производители - отдельные процессы, пишущие в общую очередь в shm
+static void BM_BoundedMPSC_RoundTrip_CrossProcess(benchmark::State& state) {
+    const auto producers = static_cast<uint32_t>(state.range(0));
+    auto shm_queues = ShmQueueSet<MPSCRoundTripQueue>::create("", 1 + producers);
+
+    std::vector<pid_t> children;
+    for (uint32_t p = 0; p < producers; ++p) {
+        pid_t child = fork();
+        if (child < 0) {
+            break;
+        }
+        if (child == 0) {
+            mpsc_round_trip_client(shm_queues->queue(0), shm_queues->queue(1 + p), static_cast<uint8_t>(p));
+            _exit(0);
+        }
+        children.push_back(child);
+    }
+
+    if (children.size() != producers) {
+        state.SkipWithError("fork() не удался");
+        for (pid_t child : children) {
+            kill(child, SIGKILL);
+            waitpid(child, nullptr, 0);
+        }
+        return;
+    }
+
+    mpsc_round_trip_serve(state, *shm_queues, producers);
+    for (pid_t child : children) {
+        waitpid(child, nullptr, 0);
+    }
+}
+BENCHMARK(BM_BoundedMPSC_RoundTrip_CrossProcess)->Arg(1)->Arg(2)->Arg(4)->UseRealTime();
+
+// Fan-out: одно сообщение N читателям через BroadcastRing или копию в N SPSC очередей
+constexpr size_t FANOUT_QUEUE_SIZE = 4096;
+constexpr uint64_t FANOUT_BATCH = 2048;
+constexpr size_t FANOUT_READ_BATCH = 256;
+
+struct alignas(CACHE_LINE_SIZE) FanoutCounter {
+    std::atomic<uint64_t> value{0};
+};
+
+// Читатели в отдельных потоках, писатель - поток бенчмарка; итерация - FANOUT_BATCH
+// сообщений, прочитанных всеми читателями. Пустой читатель уступает ядро (yield),
+// чтобы прогон на малом числе ядер не упирался в планировщик ОС.
+template<typename Publish, typename Read>
+static void run_fanout(benchmark::State& state, size_t fanout, Publish publish, Read read) {
+    std::atomic<bool> running{true};
+    std::vector<FanoutCounter> consumed(fanout);
+    std::vector<std::thread> readers;
+
+    for (size_t r = 0; r < fanout; ++r) {
+        readers.emplace_back([&, r]() {
+            uint64_t total = 0;
+            while (running.load(std::memory_order_relaxed)) {
+                const size_t count = read(r);
+                if (count == 0) {
+                    std::this_thread::yield();
+                    continue;
+                }
+                total += count;
+                consumed[r].value.store(total, std::memory_order_release);
+            }
+        });
+    }
+
+    Message msg = Message::create(0, 0, 0);
+    uint64_t published = 0;
+    for (auto _ : state) {
+        for (uint64_t i = 0; i < FANOUT_BATCH; ++i) {
+            msg.sequence_number = published + i;
+            publish(msg);
+        }
+        published += FANOUT_BATCH;
+
+        for (auto& counter : consumed) {
+            while (counter.value.load(std::memory_order_acquire) < published) {
+                std::this_thread::yield();
+            }
+        }
+    }
+
+    running.store(false, std::memory_order_relaxed);
+    for (auto& reader : readers) {
+        reader.join();
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(published * fanout));
+}
+
+// Чтение участка на месте: сумма полей, чтобы чтение не было удалено компилятором
+static size_t consume_span(std::span<const Message> batch) {
+    uint64_t sum = 0;
+    for (const Message& msg : batch) {
+        sum += msg.sequence_number;
+    }
+    benchmark::DoNotOptimize(sum);
+    return batch.size();
+}
+
+// Бенчмарк: multicast через BroadcastRing - одна запись, N курсоров
+static void BM_Fanout_BroadcastRing(benchmark::State& state) {
+    const size_t fanout = static_cast<size_t>(state.range(0));
+    auto ring = std::make_unique<BroadcastRing<Message, FANOUT_QUEUE_SIZE>>(fanout);
+
+    run_fanout(state, fanout,
+        [&](const Message& msg) {
+            while (!ring->try_push(msg)) {
+                std::this_thread::yield();
+            }
+        },
+        [&](size_t reader) {
+            const size_t count = consume_span(ring->peek(reader, FANOUT_READ_BATCH));
+            ring->release(reader, count);
+            return count;
+        });
+    state.counters["writer_bytes_per_msg"] = static_cast<double>(sizeof(Message));
+}
+BENCHMARK(BM_Fanout_BroadcastRing)->Arg(1)->Arg(2)->Arg(4)->Arg(8)->UseRealTime();
+
+// Бенчмарк: multicast копией в отдельную SPSC очередь каждого читателя
+static void BM_Fanout_CopyPerQueue(benchmark::State& state) {
+    const size_t fanout = static_cast<size_t>(state.range(0));
+    std::vector<std::unique_ptr<SPSCQueue<Message, FANOUT_QUEUE_SIZE>>> queues;
+    for (size_t i = 0; i < fanout; ++i) {
+        queues.push_back(std::make_unique<SPSCQueue<Message, FANOUT_QUEUE_SIZE>>());
+    }
+
+    run_fanout(state, fanout,
+        [&](const Message& msg) {
+            for (auto& queue : queues) {
+                while (!queue->try_push(msg)) {
+                    std::this_thread::yield();
+                }
+            }
+        },
+        [&](size_t reader) {
+            const size_t count = consume_span(queues[reader]->peek(FANOUT_READ_BATCH));
+            queues[reader]->release(count);
+            return count;
+        });
+    state.counters["writer_bytes_per_msg"] = static_cast<double>(sizeof(Message) * fanout);
+}
+BENCHMARK(BM_Fanout_CopyPerQueue)->Arg(1)->Arg(2)->Arg(4)->Arg(8)->UseRealTime();
+
+// Слияние по timestamp_ns: k полос, в каждой MERGE_LANE_FILL сообщений с чередующимся временем
+constexpr size_t MERGE_LANE_SIZE = 4096;
+constexpr size_t MERGE_LANE_FILL = 256;
+using MergeLane = SPSCQueue<Message, MERGE_LANE_SIZE>;
+
+static void fill_merge_lanes(std::vector<std::unique_ptr<MergeLane>>& lanes) {
+    const size_t k = lanes.size();
+    for (size_t i = 0; i < MERGE_LANE_FILL; ++i) {
+        for (size_t lane = 0; lane < k; ++lane) {
+            Message msg = Message::create(0, static_cast<uint8_t>(lane), i);
+            msg.timestamp_ns = i * k + lane;
+            lanes[lane]->try_push(msg);
+        }
+    }
+}
+
+// Бенчмарк: стоимость слияния на сообщение (дерево проигравших, один поток)
+static void BM_TimestampMerge(benchmark::State& state) {
+    const size_t k = static_cast<size_t>(state.range(0));
+    std::vector<std::unique_ptr<MergeLane>> lanes;
+    for (size_t i = 0; i < k; ++i) {
+        lanes.push_back(std::make_unique<MergeLane>());
+    }
+    // Данные в полосах окончательные - источники закрыты
+    std::vector<Watermark> watermarks(k);
+    for (auto& watermark : watermarks) {
+        watermark.close();
+    }
+
+    uint64_t merged = 0;
+    for (auto _ : state) {
+        state.PauseTiming();
+        fill_merge_lanes(lanes);
+        TimestampMerge<MergeLane> merge;
+        for (size_t i = 0; i < k; ++i) {
+            merge.add_input(lanes[i].get(), &watermarks[i]);
+        }
+        state.ResumeTiming();
+
+        uint64_t sum = 0;
+        merged += merge.merge(std::numeric_limits<size_t>::max(), [&sum](const Message& msg) {
+            sum += msg.timestamp_ns;
+        });
+        benchmark::DoNotOptimize(sum);
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(merged));
+}
+BENCHMARK(BM_TimestampMerge)->Arg(4)->Arg(8)->Arg(16);
+
+// Бенчмарк: тот же объем полос по очереди без упорядочивания (база для BM_TimestampMerge)
+static void BM_LaneRoundRobin(benchmark::State& state) {
+    const size_t k = static_cast<size_t>(state.range(0));
+    std::vector<std::unique_ptr<MergeLane>> lanes;
+    for (size_t i = 0; i < k; ++i) {
+        lanes.push_back(std::make_unique<MergeLane>());
+    }
+
+    uint64_t drained = 0;
+    for (auto _ : state) {
+        state.PauseTiming();
+        fill_merge_lanes(lanes);
+        state.ResumeTiming();
+
+        uint64_t sum = 0;
+        for (auto& lane : lanes) {
+            std::span<Message> batch = lane->peek(MERGE_LANE_FILL);
+            for (const Message& msg : batch) {
+                sum += msg.timestamp_ns;
+            }
+            lane->release(batch.size());
+            drained += batch.size();
+        }
+        benchmark::DoNotOptimize(sum);
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(drained));
+}
+BENCHMARK(BM_LaneRoundRobin)->Arg(4)->Arg(8)->Arg(16);
+
+// Бенчмарк: задержка от создания до извлечения со слиянием (merge = 1) и без (merge = 0).
+// Писатели полос работают с разным темпом (полоса i - пауза (i + 1) * 10 мкс), поэтому
+// слияние ждет водяного знака самой медленной полосы - это и есть добавленная задержка.
+static void BM_MergeLatency(benchmark::State& state) {
+    const size_t k = static_cast<size_t>(state.range(0));
+    const bool ordered = state.range(1) != 0;
+
+    std::vector<std::unique_ptr<MergeLane>> lanes;
+    for (size_t i = 0; i < k; ++i) {
+        lanes.push_back(std::make_unique<MergeLane>());
+    }
+    std::vector<Watermark> watermarks(k);
+    TimestampMerge<MergeLane> merge;
+    for (size_t i = 0; i < k; ++i) {
+        merge.add_input(lanes[i].get(), &watermarks[i]);
+    }
+
+    std::atomic<bool> running{true};
+    std::vector<std::thread> writers;
+    for (size_t w = 0; w < k; ++w) {
+        writers.emplace_back([&, w]() {
+            const auto pause = std::chrono::microseconds(10 * (w + 1));
+            uint64_t seq = 0;
+            while (running.load(std::memory_order_relaxed)) {
+                Message msg = Message::create(0, static_cast<uint8_t>(w), seq);
+                while (!lanes[w]->try_push(msg)) {
+                    if (!running.load(std::memory_order_relaxed)) {
+                        return;
+                    }
+                    std::this_thread::yield();
+                }
+                watermarks[w].advance(msg.timestamp_ns);
+                ++seq;
+                std::this_thread::sleep_for(pause);
+            }
+        });
+    }
+
+    std::vector<uint64_t> latencies;
+    latencies.reserve(1 << 20);
+    auto record = [&latencies](const Message& msg) {
+        latencies.push_back(Message::get_timestamp_ns() - msg.timestamp_ns);
+    };
+
+    for (auto _ : state) {
+        size_t count = 0;
+        if (ordered) {
+            count = merge.merge(MERGE_LANE_FILL, record);
+        } else {
+            for (auto& lane : lanes) {
+                std::span<Message> batch = lane->peek(MERGE_LANE_FILL);
+                for (const Message& msg : batch) {
+                    record(msg);
+                }
+                lane->release(batch.size());
+                count += batch.size();
+            }
+        }
+        if (count == 0) {
+            std::this_thread::yield();
+        }
+    }
+
+    running.store(false, std::memory_order_relaxed);
+    for (auto& writer : writers) {
+        writer.join();
+    }
+
+    state.SetItemsProcessed(static_cast<int64_t>(latencies.size()));
+    if (!latencies.empty()) {
+        std::sort(latencies.begin(), latencies.end());
+        state.counters["p50_us"] = latencies[latencies.size() / 2] / 1000.0;
+        state.counters["p99_us"] = latencies[latencies.size() * 99 / 100] / 1000.0;
+    }
+    if (ordered) {
+        state.counters["blocked"] = static_cast<double>(merge.blocked());
+    }
+}
+BENCHMARK(BM_MergeLatency)
+    ->ArgsProduct({{4, 8, 16}, {0, 1}})
+    ->ArgNames({"lanes", "merge"})
+    ->UseRealTime()
+    ->MinTime(0.5);
+
+// Бенчмарк: слияние полос настоящих Producer, один из которых простаивает (1 msg/s).
+// heartbeat = 1 - простаивающий производитель продвигает водяной знак в ожидании отправки
+// (как в FusedPipeline), heartbeat = 0 - только после отправок: слияние стоит до его
+// следующего сообщения, и сообщения активного производителя копятся в полосе.
+static void BM_MergeIdleProducer(benchmark::State& state) {
+    const bool heartbeat = state.range(0) != 0;
+    constexpr size_t k = 2;
+    const uint64_t rates[k] = {100'000, 1};
+
+    SystemStatistics stats(k, 0, 0);
+    std::vector<std::unique_ptr<MergeLane>> lanes;
+    std::vector<std::unique_ptr<Producer>> producers;
+    std::vector<Watermark> watermarks(k);
+    TimestampMerge<MergeLane> merge;
+    for (size_t i = 0; i < k; ++i) {
+        lanes.push_back(std::make_unique<MergeLane>());
+        ProducerConfig config{1, rates[i], {{0, 1.0}}};
+        producers.push_back(std::make_unique<Producer>(static_cast<uint8_t>(i), config, nullptr, stats));
+        merge.add_input(lanes[i].get(), &watermarks[i]);
+    }
+
+    std::atomic<bool> running{true};
+    std::vector<std::thread> writers;
+    for (size_t w = 0; w < k; ++w) {
+        writers.emplace_back([&, w]() {
+            MergeLane& lane = *lanes[w];
+            Watermark& watermark = watermarks[w];
+            producers[w]->run_with(running, 3600, [](Message&) {}, [&](Message& msg) {
+                if (!lane.try_push(msg)) {
+                    return false;
+                }
+                watermark.advance(msg.timestamp_ns);
+                return true;
+            }, [&](uint64_t timestamp_ns) {
+                if (heartbeat) {
+                    watermark.advance(timestamp_ns);
+                }
+            });
+        });
+    }
+
+    std::vector<uint64_t> latencies;
+    latencies.reserve(1 << 20);
+    auto record = [&latencies](const Message& msg) {
+        latencies.push_back(Message::get_timestamp_ns() - msg.timestamp_ns);
+    };
+
+    for (auto _ : state) {
+        if (merge.merge(MERGE_LANE_FILL, record) == 0) {
+            std::this_thread::yield();
+        }
+    }
+
+    running.store(false, std::memory_order_relaxed);
+    for (auto& writer : writers) {
+        writer.join();
+    }
+
+    state.SetItemsProcessed(static_cast<int64_t>(latencies.size()));
+    state.counters["merged"] = static_cast<double>(latencies.size());
+    state.counters["blocked"] = static_cast<double>(merge.blocked());
+    if (!latencies.empty()) {
+        std::sort(latencies.begin(), latencies.end());
+        state.counters["p50_us"] = latencies[latencies.size() / 2] / 1000.0;
+        state.counters["p99_us"] = latencies[latencies.size() * 99 / 100] / 1000.0;
+    }
+}
+BENCHMARK(BM_MergeIdleProducer)
+    ->Arg(0)->Arg(1)
+    ->ArgNames({"heartbeat"})
+    ->UseRealTime()
+    ->MinTime(0.5);
+
 // Главная функция для бенчмарков
 BENCHMARK_MAIN();
@@ -3,7 +3,13 @@
 #include "router.hpp"
 #include "config.hpp"
 #include "spsc_queue.hpp"
+#include "handlers.hpp"
+#include "key_routes.hpp"
+#include <algorithm>
+#include <functional>
 #include <memory>
+#include <random>
+#include <unordered_map>
 #include <vector>
 
 // Бенчмарк: накладные расходы на маршрутизацию
@@ -135,4 +141,268 @@ static void BM_RoutingLatency(benchmark::State& state) {
 }
 BENCHMARK(BM_RoutingLatency)->UseManualTime();
 
+// ========== Диспетчеризация обработчиков ==========
+// Все варианты выполняют одну и ту же работу decode -> enrich -> validate;
+// накладные расходы диспетчеризации = ns_per_msg варианта - ns_per_msg BM_HandlerDirect
+
+constexpr size_t HANDLER_MESSAGES = 1024;
+
+struct DecodeStep {
+    void operator()(Message& msg) const noexcept {
+        msg.processing_ts_ns = msg.timestamp_ns ^ msg.sequence_number;
+    }
+};
+
+struct EnrichStep {
+    void operator()(Message& msg) const noexcept {
+        msg.processor_id = static_cast<uint8_t>(msg.msg_type & 3);
+    }
+};
+
+struct ValidateStep {
+    bool operator()(const Message& msg) const noexcept {
+        return msg.msg_type < 8;
+    }
+};
+
+static std::vector<Message> make_handler_messages() {
+    std::vector<Message> messages(HANDLER_MESSAGES);
+    for (size_t i = 0; i < messages.size(); ++i) {
+        messages[i] = Message::create(static_cast<uint8_t>(i % 8), 0, i);
+    }
+    return messages;
+}
+
+static void set_handler_counters(benchmark::State& state) {
+    state.SetItemsProcessed(state.iterations() * HANDLER_MESSAGES);
+    state.counters["ns_per_msg"] = benchmark::Counter(
+        static_cast<double>(state.iterations() * HANDLER_MESSAGES),
+        benchmark::Counter::kIsRate | benchmark::Counter::kInvert);
+}
+
+// Базовая линия: та же работа, написанная прямо в цикле
+static void BM_HandlerDirect(benchmark::State& state) {
+    auto messages = make_handler_messages();
+    for (auto _ : state) {
+        size_t kept = 0;
+        for (auto& msg : messages) {
+            msg.processing_ts_ns = msg.timestamp_ns ^ msg.sequence_number;
+            msg.processor_id = static_cast<uint8_t>(msg.msg_type & 3);
+            kept += msg.msg_type < 8;
+        }
+        benchmark::DoNotOptimize(kept);
+        benchmark::ClobberMemory();
+    }
+    set_handler_counters(state);
+}
+BENCHMARK(BM_HandlerDirect);
+
+// Цепочка, собранная на этапе компиляции, поштучный вызов
+static void BM_HandlerChain(benchmark::State& state) {
+    auto messages = make_handler_messages();
+    auto chain = make_chain(DecodeStep{}, EnrichStep{}, ValidateStep{});
+    for (auto _ : state) {
+        size_t kept = 0;
+        for (auto& msg : messages) {
+            kept += invoke_handler(chain, msg);
+        }
+        benchmark::DoNotOptimize(kept);
+        benchmark::ClobberMemory();
+    }
+    set_handler_counters(state);
+}
+BENCHMARK(BM_HandlerChain);
+
+// Та же цепочка, пакеты по HANDLER_BATCH_SIZE сообщений
+static void BM_HandlerChainBatch(benchmark::State& state) {
+    auto messages = make_handler_messages();
+    auto chain = make_chain(DecodeStep{}, EnrichStep{}, ValidateStep{});
+    for (auto _ : state) {
+        size_t kept = 0;
+        for (size_t i = 0; i < messages.size(); i += HANDLER_BATCH_SIZE) {
+            kept += invoke_handler_batch(chain, std::span<Message>(messages.data() + i, HANDLER_BATCH_SIZE));
+        }
+        benchmark::DoNotOptimize(kept);
+        benchmark::ClobberMemory();
+    }
+    set_handler_counters(state);
+}
+BENCHMARK(BM_HandlerChainBatch);
+
+// Отдельная цепочка на каждый тип, выбор по msg_type параметрами шаблона
+static void BM_HandlerTypeDispatch(benchmark::State& state) {
+    auto messages = make_handler_messages();
+    auto chain = make_chain(DecodeStep{}, EnrichStep{}, ValidateStep{});
+    auto dispatch = dispatch_by_type(PassThrough{},
+        on_type<0>(chain), on_type<1>(chain), on_type<2>(chain), on_type<3>(chain),
+        on_type<4>(chain), on_type<5>(chain), on_type<6>(chain), on_type<7>(chain));
+    for (auto _ : state) {
+        size_t kept = 0;
+        for (auto& msg : messages) {
+            kept += invoke_handler(dispatch, msg);
+        }
+        benchmark::DoNotOptimize(kept);
+        benchmark::ClobberMemory();
+    }
+    set_handler_counters(state);
+}
+BENCHMARK(BM_HandlerTypeDispatch);
+
+// Таблица std::variant, назначение типам во время выполнения
+static void BM_HandlerVariantTable(benchmark::State& state) {
+    auto messages = make_handler_messages();
+    using Chain = HandlerChain<DecodeStep, EnrichStep, ValidateStep>;
+    HandlerTable<Chain> table;
+    for (uint8_t type = 0; type < 8; ++type) {
+        table.set(type, Chain{});
+    }
+    for (auto _ : state) {
+        size_t kept = 0;
+        for (auto& msg : messages) {
+            kept += invoke_handler(table, msg);
+        }
+        benchmark::DoNotOptimize(kept);
+        benchmark::ClobberMemory();
+    }
+    set_handler_counters(state);
+}
+BENCHMARK(BM_HandlerVariantTable);
+
+// Для сравнения: виртуальный вызов на сообщение
+struct VirtualHandler {
+    virtual ~VirtualHandler() = default;
+    virtual bool handle(Message& msg) = 0;
+};
+
+struct VirtualChain : VirtualHandler {
+    bool handle(Message& msg) override {
+        DecodeStep{}(msg);
+        EnrichStep{}(msg);
+        return ValidateStep{}(msg);
+    }
+};
+
+static void BM_HandlerVirtual(benchmark::State& state) {
+    auto messages = make_handler_messages();
+    std::vector<std::unique_ptr<VirtualHandler>> handlers;
+    for (int i = 0; i < 8; ++i) {
+        handlers.push_back(std::make_unique<VirtualChain>());
+    }
+    for (auto _ : state) {
+        size_t kept = 0;
+        for (auto& msg : messages) {
+            VirtualHandler* handler = handlers[msg.msg_type].get();
+            benchmark::DoNotOptimize(handler);
+            kept += handler->handle(msg);
+        }
+        benchmark::DoNotOptimize(kept);
+        benchmark::ClobberMemory();
+    }
+    set_handler_counters(state);
+}
+BENCHMARK(BM_HandlerVirtual);
+
+// Для сравнения: std::function на сообщение
+static void BM_HandlerStdFunction(benchmark::State& state) {
+    auto messages = make_handler_messages();
+    std::vector<std::function<bool(Message&)>> handlers;
+    for (int i = 0; i < 8; ++i) {
+        handlers.push_back(make_chain(DecodeStep{}, EnrichStep{}, ValidateStep{}));
+    }
+    for (auto _ : state) {
+        size_t kept = 0;
+        for (auto& msg : messages) {
+            kept += handlers[msg.msg_type](msg);
+        }
+        benchmark::DoNotOptimize(kept);
+        benchmark::ClobberMemory();
+    }
+    set_handler_counters(state);
+}
+BENCHMARK(BM_HandlerStdFunction);
+
+// ========== Маршрутизация по routing_key ==========
+// Поиск получателя для KEY_LOOKUPS случайных ключей из правил: плотный массив (ключи 0..N-1),
+// perfect hash (N разреженных 32-битных ключей) и std::unordered_map как база
+
+constexpr size_t KEY_LOOKUPS = 4096;
+
+// N ключей правил и последовательность поиска по ним; sparse - ключи по всему 32-битному пространству
+static std::vector<uint32_t> make_rule_keys(size_t count, bool sparse) {
+    std::vector<uint32_t> keys(count);
+    std::mt19937 rng(42);
+    for (size_t i = 0; i < count; ++i) {
+        keys[i] = sparse ? rng() : static_cast<uint32_t>(i);
+    }
+    std::sort(keys.begin(), keys.end());
+    keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+    return keys;
+}
+
+static std::vector<uint32_t> make_lookup_keys(const std::vector<uint32_t>& keys) {
+    std::vector<uint32_t> lookups(KEY_LOOKUPS);
+    std::mt19937 rng(7);
+    std::uniform_int_distribution<size_t> index(0, keys.size() - 1);
+    for (auto& key : lookups) {
+        key = keys[index(rng)];
+    }
+    return lookups;
+}
+
+static void set_key_counters(benchmark::State& state, size_t memory_bytes) {
+    state.SetItemsProcessed(state.iterations() * KEY_LOOKUPS);
+    state.counters["ns_per_msg"] = benchmark::Counter(
+        static_cast<double>(state.iterations() * KEY_LOOKUPS),
+        benchmark::Counter::kIsRate | benchmark::Counter::kInvert);
+    state.counters["bytes_per_key"] = static_cast<double>(memory_bytes) / static_cast<double>(state.range(0));
+}
+
+template<bool Sparse>
+static void BM_KeyRouteLookup(benchmark::State& state) {
+    const auto keys = make_rule_keys(static_cast<size_t>(state.range(0)), Sparse);
+
+    // Одно правило set на 8 процессоров: получатель - hash ключа
+    KeyRule rule;
+    rule.match = KeyMatch::Set;
+    rule.keys = keys;
+    rule.targets = {0, 1, 2, 3, 4, 5, 6, 7};
+    const KeyRouteMap routes({rule}, 8);
+    const auto lookups = make_lookup_keys(keys);
+
+    for (auto _ : state) {
+        uint32_t sum = 0;
+        for (uint32_t key : lookups) {
+            sum += routes.lookup(key);
+        }
+        benchmark::DoNotOptimize(sum);
+    }
+    set_key_counters(state, routes.memory_bytes());
+    state.SetLabel(routes.dense() ? "dense" : "perfect_hash");
+}
+BENCHMARK_TEMPLATE(BM_KeyRouteLookup, false)->Name("BM_KeyRouteLookup_Dense")
+    ->Arg(1 << 10)->Arg(1 << 16)->Arg(1 << 20);
+BENCHMARK_TEMPLATE(BM_KeyRouteLookup, true)->Name("BM_KeyRouteLookup_PerfectHash")
+    ->Arg(1 << 10)->Arg(1 << 16)->Arg(1 << 20);
+
+// База: те же разреженные ключи в std::unordered_map
+static void BM_KeyRouteUnorderedMap(benchmark::State& state) {
+    const auto keys = make_rule_keys(static_cast<size_t>(state.range(0)), true);
+    std::unordered_map<uint32_t, uint8_t> routes;
+    for (uint32_t key : keys) {
+        routes.emplace(key, static_cast<uint8_t>(key & 7));
+    }
+    const auto lookups = make_lookup_keys(keys);
+
+    for (auto _ : state) {
+        uint32_t sum = 0;
+        for (uint32_t key : lookups) {
+            sum += routes.find(key)->second;
+        }
+        benchmark::DoNotOptimize(sum);
+    }
+    // Оценка: узел (ключ, значение, указатель) плюс корзина
+    set_key_counters(state, routes.size() * (2 * sizeof(void*) + 8) + routes.bucket_count() * sizeof(void*));
+}
+BENCHMARK(BM_KeyRouteUnorderedMap)->Arg(1 << 10)->Arg(1 << 16)->Arg(1 << 20);
+
 BENCHMARK_MAIN();
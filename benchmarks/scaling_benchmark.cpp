@@ -1,6 +1,10 @@
 #include <benchmark/benchmark.h>
 #include "message.hpp"
 #include "spsc_queue.hpp"
+#include "strategy.hpp"
+#include "coro_runtime.hpp"
+#include "cpu_affinity.hpp"
+#include <algorithm>
 #include <thread>
 #include <vector>
 #include <atomic>
@@ -193,4 +197,132 @@ BENCHMARK(BM_FullPipelineScaling)
     ->Arg(8)
     ->UseRealTime();
 
+// Бенчмарк: 32 стратегии в режиме поток-на-стратегию и на кооперативных планировщиках
+// Arg: 0 - потоки, N > 0 - корутины на N планировщиках
+// Подача ограничена окном сообщений в полете, чтобы p99 отражал планирование, а не очередь
+static void BM_StrategyRuntime(benchmark::State& state) {
+    constexpr size_t NUM_STRATEGIES = 32;
+    constexpr uint64_t MESSAGES = NUM_STRATEGIES * 2000;
+    constexpr uint64_t IN_FLIGHT = NUM_STRATEGIES * 4;
+    const uint32_t num_schedulers = static_cast<uint32_t>(state.range(0));
+
+    StrategyConfig config{static_cast<uint32_t>(NUM_STRATEGIES), {}};
+    LatencyStats delivery;
+
+    // Ядро 0 занято подающим потоком, планировщики привязываются к следующим
+    const uint32_t cores = available_cores();
+    const uint32_t cores_used = num_schedulers == 0
+        ? std::min<uint32_t>(NUM_STRATEGIES, cores > 1 ? cores - 1 : 1)
+        : num_schedulers;
+
+    for (auto _ : state) {
+        SystemStatistics stats(1, 0, NUM_STRATEGIES);
+        std::vector<std::shared_ptr<Strategy::InputQueue>> queues;
+        std::vector<std::unique_ptr<Strategy>> strategies;
+        std::vector<std::unique_ptr<CoroScheduler>> schedulers;
+        std::vector<std::thread> threads;
+        std::atomic<bool> running{true};
+
+        for (size_t i = 0; i < NUM_STRATEGIES; ++i) {
+            queues.push_back(std::make_shared<Strategy::InputQueue>());
+            strategies.push_back(std::make_unique<Strategy>(static_cast<uint8_t>(i), config, queues[i], stats));
+        }
+
+        if (num_schedulers == 0) {
+            for (auto& strategy : strategies) {
+                threads.emplace_back([&strategy, &running]() { strategy->run(running); });
+            }
+        } else {
+            for (uint32_t i = 0; i < num_schedulers; ++i) {
+                int core = cores > i + 1 ? static_cast<int>(i + 1) : -1;
+                schedulers.push_back(std::make_unique<CoroScheduler>(i, core, 64));
+            }
+            for (size_t i = 0; i < NUM_STRATEGIES; ++i) {
+                CoroScheduler& scheduler = *schedulers[i % num_schedulers];
+                scheduler.spawn(strategies[i]->run_coro(scheduler, running));
+            }
+            for (auto& scheduler : schedulers) {
+                threads.emplace_back([&scheduler, &running]() { scheduler->run(running); });
+            }
+        }
+
+        // Подающий поток играет роль Stage2: отметка stage2_exit_ns при отправке
+        for (uint64_t seq = 0; seq < MESSAGES; ++seq) {
+            while (seq - stats.counters()[StatsField::Delivered] >= IN_FLIGHT) {
+                __builtin_ia32_pause();
+            }
+            Message msg = Message::create(0, 0, seq);
+            msg.stage2_exit_ns = Message::get_timestamp_ns();
+            while (!queues[seq % NUM_STRATEGIES]->try_push(msg)) {
+                __builtin_ia32_pause();
+            }
+        }
+        while (stats.counters()[StatsField::Delivered] < MESSAGES) {
+            __builtin_ia32_pause();
+        }
+
+        running.store(false, std::memory_order_release);
+        for (auto& t : threads) {
+            t.join();
+        }
+
+        for (double latency : stats.delivery_latencies.latencies) {
+            delivery.add(latency);
+        }
+    }
+
+    state.SetItemsProcessed(state.iterations() * MESSAGES);
+    state.counters["cores"] = cores_used;
+    state.counters["msgs_per_core"] = benchmark::Counter(
+        static_cast<double>(state.iterations() * MESSAGES) / cores_used,
+        benchmark::Counter::kIsRate);
+    state.counters["p99_us"] = delivery.p99();
+}
+BENCHMARK(BM_StrategyRuntime)
+    ->Arg(0)
+    ->Arg(1)
+    ->Arg(2)
+    ->Arg(4)
+    ->UseRealTime();
+
+// Бенчмарк: пакетная доставка стратегии (как быстрые стратегии strategy_bottleneck)
+// Arg0 - strategies.max_batch (1 - поштучная доставка), Arg1 - время обработки (ns)
+static void BM_StrategyBatchDelivery(benchmark::State& state) {
+    constexpr uint64_t MESSAGES = 60000;
+    const uint32_t max_batch = static_cast<uint32_t>(state.range(0));
+    const uint64_t processing_ns = static_cast<uint64_t>(state.range(1));
+
+    StrategyConfig config{1, {{0, processing_ns}}, max_batch};
+
+    for (auto _ : state) {
+        SystemStatistics stats(4, 0, 1);
+        auto queue = std::make_shared<Strategy::InputQueue>();
+        Strategy strategy(0, config, queue, stats);
+        std::atomic<bool> running{true};
+
+        // Очередь заполняется заранее: измеряется только сторона стратегии
+        state.PauseTiming();
+        for (uint64_t seq = 0; seq < MESSAGES; ++seq) {
+            queue->try_push(Message::create(static_cast<uint8_t>(seq % 4), static_cast<uint8_t>(seq % 4), seq));
+        }
+        state.ResumeTiming();
+
+        std::thread consumer([&]() { strategy.run(running); });
+        while (stats.counters()[StatsField::Delivered] < MESSAGES) {
+            std::this_thread::yield();
+        }
+        running.store(false, std::memory_order_release);
+        consumer.join();
+    }
+
+    state.SetItemsProcessed(state.iterations() * MESSAGES);
+}
+BENCHMARK(BM_StrategyBatchDelivery)
+    ->Args({1, 0})
+    ->Args({16, 0})
+    ->Args({256, 0})
+    ->Args({1, 50})
+    ->Args({256, 50})
+    ->UseRealTime();
+
 BENCHMARK_MAIN();
@@ -0,0 +1,104 @@
+#pragma once
+
+#include "config.hpp"
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * AdaptiveBatch - размер пакета извлечения и отправки по глубине очереди и цели задержки
+ *
+ * Сообщения пакета уходят дальше после обработки всего пакета, поэтому пакет из b
+ * сообщений задерживает первое на (b - 1) * cost, где cost - сглаженное время на сообщение.
+ * Предел по цели: cap = target / cost.
+ * - очередь не глубже cap: пакет - все накопленное (при малой нагрузке 1-2 сообщения,
+ *   добавка к задержке не больше цели);
+ * - очередь глубже cap (ожидание в очереди уже больше цели): пакет удваивается с каждым
+ *   таким извлечением до max_batch - амортизация растет, пока копится отставание, и
+ *   сбрасывается к cap, как только очередь снова укладывается в цель.
+ * Состояние принадлежит одному потоку (у компонента свой контроллер на входную очередь).
+ * Без batching.enabled возвращается фиксированный размер компонента.
+ */
+class AdaptiveBatch {
+public:
+    AdaptiveBatch() = default;
+
+    AdaptiveBatch(const BatchingConfig& config, uint32_t fixed_batch)
+        : enabled_(config.enabled)
+        , fixed_(fixed_batch)
+        , min_(config.min_batch)
+        , max_(config.enabled ? config.max_batch : fixed_batch)
+        , target_ns_(static_cast<double>(config.target_latency_us) * 1000.0)
+        , boost_(config.min_batch)
+    {}
+
+    /**
+     * Размер следующего пакета для очереди глубиной depth
+     */
+    uint32_t limit(size_t depth) noexcept {
+        if (!enabled_) {
+            return fixed_;
+        }
+
+        const double cap_messages = target_ns_ / std::max(cost_ns_, 1.0);
+        const uint32_t cap = static_cast<uint32_t>(std::clamp(cap_messages, static_cast<double>(min_),
+                                                              static_cast<double>(max_)));
+        if (depth <= cap) {
+            boost_ = cap;
+            return std::max(static_cast<uint32_t>(depth), min_);
+        }
+
+        boost_ = std::min(std::max(boost_, cap) * 2, max_);
+        ++boosted_;
+        return boost_;
+    }
+
+    /**
+     * Учет выполненного пакета: count сообщений за elapsed_ns (извлечение, обработка, отправка)
+     */
+    void complete(size_t count, uint64_t elapsed_ns) noexcept {
+        if (count == 0) {
+            return;
+        }
+        ++batches_;
+        messages_ += count;
+        largest_ = std::max(largest_, static_cast<uint32_t>(count));
+
+        // Сглаживание 1/8: контроллер следует за изменением стоимости за десяток пакетов
+        const double sample = static_cast<double>(elapsed_ns) / static_cast<double>(count);
+        cost_ns_ = batches_ == 1 ? sample : cost_ns_ + (sample - cost_ns_) * 0.125;
+    }
+
+    bool enabled() const noexcept { return enabled_; }
+    uint32_t max_batch() const noexcept { return max_; }
+
+    // Счетчики (пишет поток-владелец, читаются после остановки)
+    uint64_t batches() const noexcept { return batches_; }
+    uint64_t messages() const noexcept { return messages_; }
+    uint64_t boosted() const noexcept { return boosted_; }
+    uint32_t largest() const noexcept { return largest_; }
+    double cost_ns() const noexcept { return cost_ns_; }
+
+    /**
+     * Заголовок и строка отчета по контроллерам одного компонента (суммарно по его входным очередям)
+     */
+    static void print_header();
+    static void print_row(const std::string& name, const std::vector<const AdaptiveBatch*>& controllers);
+
+private:
+    bool enabled_ = false;
+    uint32_t fixed_ = 1;
+    uint32_t min_ = 1;
+    uint32_t max_ = 1;
+    double target_ns_ = 0.0;
+
+    double cost_ns_ = 0.0;      // Сглаженное время на сообщение
+    uint32_t boost_ = 1;        // Текущий размер при отставании
+
+    uint64_t batches_ = 0;
+    uint64_t messages_ = 0;
+    uint64_t boosted_ = 0;      // Пакетов, увеличенных из-за отставания
+    uint32_t largest_ = 0;
+};
@@ -0,0 +1,169 @@
+#pragma once
+
+#include "config.hpp"
+#include "message.hpp"
+#include "statistics.hpp"
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+/**
+ * Решение контроля допуска для головы очереди производителя
+ */
+enum class AdmissionDecision : uint8_t {
+    Admit,      // Токены взяты, обычная маршрутизация
+    Delay,      // Токена нет, сообщение остается в очереди
+    Drop,       // Токена нет, сообщение сбрасывается
+    Divert      // Токена нет, сообщение уходит в процессор низкого приоритета
+};
+
+/**
+ * TokenBucket - ведро токенов в фиксированной точке (токен = TOKEN_UNIT единиц)
+ *
+ * Пополнение ленивое и не чаще одного раза за проход Stage1: время прохода
+ * читается один раз (AdmissionControl::begin_pass), на сообщение остаются
+ * сравнение и вычитание. Используется только потоком Stage1.
+ */
+class TokenBucket {
+public:
+    static constexpr uint64_t TOKEN_UNIT = 1'000'000'000;
+
+    TokenBucket(std::string name, const AdmissionBucketConfig& config, uint64_t now_ns)
+        : name_(std::move(name))
+        , rate_(config.rate)
+        , capacity_(config.burst * TOKEN_UNIT)
+        , full_refill_ns_(capacity_ / config.rate)
+        , credit_(capacity_)
+        , last_ns_(now_ns)
+        , overflow_(config.overflow)
+    {}
+
+    /**
+     * Есть ли токен к моменту now_ns (пополнение за прошедшее время)
+     */
+    bool available(uint64_t now_ns) noexcept {
+        if (now_ns > last_ns_) {
+            const uint64_t elapsed = now_ns - last_ns_;
+            // За full_refill_ns_ ведро наполняется целиком - без переполнения произведения
+            credit_ = elapsed >= full_refill_ns_ ? capacity_ : std::min(capacity_, credit_ + elapsed * rate_);
+            last_ns_ = now_ns;
+        }
+        return credit_ >= TOKEN_UNIT;
+    }
+
+    void take() noexcept {
+        credit_ -= TOKEN_UNIT;
+        ++admitted;
+    }
+
+    AdmissionOverflow overflow() const noexcept { return overflow_; }
+
+    // Счетчики решений (пишет поток Stage1, читаются после остановки)
+    uint64_t admitted = 0;
+    uint64_t delayed = 0;      // Сообщений, ждавших токена хотя бы один проход
+    uint64_t dropped = 0;
+    uint64_t diverted = 0;
+
+    const std::string& name() const noexcept { return name_; }
+    uint64_t rate() const noexcept { return rate_; }
+    uint64_t burst() const noexcept { return capacity_ / TOKEN_UNIT; }
+
+private:
+    std::string name_;
+    uint64_t rate_;
+    uint64_t capacity_;
+    uint64_t full_refill_ns_;
+    uint64_t credit_;
+    uint64_t last_ns_;
+    AdmissionOverflow overflow_;
+};
+
+/**
+ * AdmissionControl - контроль допуска Stage1 по ведрам типов и производителей
+ *
+ * Сообщение допускается, если токен есть и в ведре его типа, и в ведре его
+ * производителя; токены берутся из обоих ведер одновременно. Иначе действует
+ * overflow ведра без токена: delay оставляет голову в очереди производителя
+ * (обратное давление только на эту очередь), drop сбрасывает сообщение
+ * (StatsField::Shed), divert отправляет его в divert_processor.
+ */
+class AdmissionControl {
+public:
+    AdmissionControl(const AdmissionConfig& config, SystemStatistics& stats);
+
+    AdmissionControl(const AdmissionControl&) = delete;
+    AdmissionControl& operator=(const AdmissionControl&) = delete;
+
+    /**
+     * Начало прохода Stage1 по очередям: одно чтение времени на все решения прохода
+     */
+    void begin_pass() noexcept {
+        now_ns_ = Message::get_timestamp_ns();
+    }
+
+    /**
+     * Решение для головы очереди (при Admit токены уже взяты)
+     */
+    AdmissionDecision admit(const Message& msg) noexcept {
+        TokenBucket* type = type_buckets_[msg.msg_type];
+        TokenBucket* producer = producer_buckets_[msg.producer_id];
+
+        TokenBucket* limited = nullptr;
+        if (type && !type->available(now_ns_)) {
+            limited = type;
+        } else if (producer && !producer->available(now_ns_)) {
+            limited = producer;
+        }
+
+        if (!limited) {
+            if (type) {
+                type->take();
+            }
+            if (producer) {
+                producer->take();
+            }
+            waiting_[msg.producer_id] = false;
+            return AdmissionDecision::Admit;
+        }
+
+        switch (limited->overflow()) {
+            case AdmissionOverflow::Delay:
+                // Ожидание головы считается один раз, а не на каждом проходе
+                if (!waiting_[msg.producer_id]) {
+                    waiting_[msg.producer_id] = true;
+                    ++limited->delayed;
+                }
+                return AdmissionDecision::Delay;
+            case AdmissionOverflow::Drop:
+                ++limited->dropped;
+                stats_.count(StatsField::Shed, 1);
+                return AdmissionDecision::Drop;
+            case AdmissionOverflow::Divert:
+                ++limited->diverted;
+                return AdmissionDecision::Divert;
+        }
+        return AdmissionDecision::Admit;
+    }
+
+    uint8_t divert_processor() const noexcept { return divert_processor_; }
+
+    /**
+     * Отчет по ведрам: допущено, задержано, сброшено, перенаправлено
+     */
+    void print_report() const;
+
+private:
+    SystemStatistics& stats_;
+    uint64_t now_ns_ = 0;
+    uint8_t divert_processor_ = 0;
+
+    std::vector<std::unique_ptr<TokenBucket>> buckets_;
+    std::array<TokenBucket*, 256> type_buckets_{};
+    std::array<TokenBucket*, 256> producer_buckets_{};
+
+    // Голова очереди производителя уже ждет токена (для учета delayed)
+    std::array<bool, 256> waiting_{};
+};
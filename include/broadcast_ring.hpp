@@ -0,0 +1,182 @@
+#pragma once
+
+#include "spsc_queue.hpp"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <stdexcept>
+#include <type_traits>
+
+// Размер кольца multicast Stage2 -> стратегии
+constexpr size_t MULTICAST_RING_SIZE = 65536; // Должно быть степенью 2
+
+// Максимум читателей одного кольца (подписчиков multicast-группы)
+constexpr size_t BROADCAST_MAX_READERS = 16;
+
+/**
+ * Lock-free кольцо один писатель - несколько читателей (multicast, в духе Disruptor)
+ *
+ * Писатель записывает элемент один раз, каждый читатель читает его на месте
+ * через собственный курсор. Слот переиспользуется, только когда его прочитали
+ * все читатели: писатель ограничен самым медленным курсором.
+ *
+ * Особенности:
+ * - Курсоры - монотонные 64-битные номера, индекс слота = номер & (Capacity - 1);
+ *   в отличие от SPSCQueue используются все Capacity слотов
+ * - Каждый курсор читателя в собственной cache line; писатель кеширует минимум
+ *   курсоров и перечитывает их, только когда кеш говорит, что кольцо заполнено
+ * - Читатели получают const-участки буфера (peek/release), копирования нет
+ * - Максимум заполнения и эпизоды переполнения ведет писатель (как в SPSCQueue)
+ */
+template<typename T, size_t Capacity, size_t MaxReaders = BROADCAST_MAX_READERS>
+class BroadcastRing {
+    static_assert((Capacity & (Capacity - 1)) == 0,
+                  "Capacity должна быть степенью двойки");
+    static_assert(std::is_trivially_copyable_v<T>,
+                  "T должен быть trivially copyable");
+
+public:
+    /**
+     * @param readers количество читателей (фиксируется при создании, 1..MaxReaders)
+     */
+    explicit BroadcastRing(size_t readers) : readers_(readers) {
+        if (readers == 0 || readers > MaxReaders) {
+            throw std::runtime_error("BroadcastRing: недопустимое количество читателей");
+        }
+    }
+
+    BroadcastRing(const BroadcastRing&) = delete;
+    BroadcastRing& operator=(const BroadcastRing&) = delete;
+
+    /**
+     * Попытка опубликовать элемент (writer side)
+     *
+     * Memory ordering:
+     * - cursor.load: acquire - синхронизация с release читателя, освободившего слот
+     * - write_cursor_.store: release - публикация элемента для всех читателей
+     *
+     * @return true если опубликован, false если самый медленный читатель отстал на Capacity
+     */
+    bool try_push(const T& item) noexcept {
+        const uint64_t sequence = write_cursor_.load(std::memory_order_relaxed);
+
+        if (sequence - gating_cursor_ >= Capacity) {
+            gating_cursor_ = min_reader_cursor();
+            if (sequence - gating_cursor_ >= Capacity) {
+                // Эпизод переполнения считается один раз до следующей успешной публикации
+                if (!full_) {
+                    full_ = true;
+                    full_events_.store(full_events_.load(std::memory_order_relaxed) + 1,
+                                       std::memory_order_relaxed);
+                }
+                return false;
+            }
+        }
+
+        buffer_[sequence & (Capacity - 1)] = item;
+        write_cursor_.store(sequence + 1, std::memory_order_release);
+
+        // Глубина по кешированному минимуму - оценка сверху, без чтения курсоров
+        const size_t depth = static_cast<size_t>(sequence + 1 - gating_cursor_);
+        if (depth > high_watermark_.load(std::memory_order_relaxed)) {
+            high_watermark_.store(depth, std::memory_order_relaxed);
+        }
+        full_ = false;
+        return true;
+    }
+
+    /**
+     * Непрерывный участок непрочитанных элементов читателя (reader side)
+     * Элементы остаются в кольце до release() и не должны изменяться.
+     * Участок не пересекает границу кольца: остаток доступен следующим вызовом.
+     *
+     * @param reader номер читателя
+     * @param max_count максимальная длина участка
+     */
+    std::span<const T> peek(size_t reader, size_t max_count) const noexcept {
+        const uint64_t next = cursors_[reader].next.load(std::memory_order_relaxed);
+        const uint64_t published = write_cursor_.load(std::memory_order_acquire);
+
+        const size_t index = static_cast<size_t>(next & (Capacity - 1));
+        const size_t available = std::min<uint64_t>(published - next, Capacity - index);
+        return std::span<const T>(&buffer_[index], std::min(available, max_count));
+    }
+
+    /**
+     * Освобождение count элементов, полученных через peek() (reader side)
+     */
+    void release(size_t reader, size_t count) noexcept {
+        const uint64_t next = cursors_[reader].next.load(std::memory_order_relaxed);
+        cursors_[reader].next.store(next + count, std::memory_order_release);
+    }
+
+    /**
+     * Есть ли непрочитанные элементы у читателя
+     */
+    bool readable(size_t reader) const noexcept {
+        return cursors_[reader].next.load(std::memory_order_relaxed) !=
+               write_cursor_.load(std::memory_order_acquire);
+    }
+
+    /**
+     * Все читатели дочитали кольцо
+     * Внимание: результат может быть неактуальным в многопоточной среде
+     */
+    bool empty() const noexcept {
+        return size() == 0;
+    }
+
+    /**
+     * Количество элементов, еще не прочитанных самым медленным читателем
+     */
+    size_t size() const noexcept {
+        const uint64_t slowest = min_reader_cursor();
+        return static_cast<size_t>(write_cursor_.load(std::memory_order_acquire) - slowest);
+    }
+
+    /**
+     * Максимальное заполнение, наблюдавшееся писателем после публикации
+     */
+    size_t high_watermark() const noexcept {
+        return high_watermark_.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * Количество эпизодов переполнения (серия неудачных try_push считается одним)
+     */
+    uint64_t full_events() const noexcept {
+        return full_events_.load(std::memory_order_relaxed);
+    }
+
+    size_t readers() const noexcept { return readers_; }
+
+    static constexpr size_t capacity() noexcept { return Capacity; }
+
+private:
+    struct alignas(CACHE_LINE_SIZE) ReaderCursor {
+        std::atomic<uint64_t> next{0};
+    };
+
+    uint64_t min_reader_cursor() const noexcept {
+        uint64_t slowest = cursors_[0].next.load(std::memory_order_acquire);
+        for (size_t i = 1; i < readers_; ++i) {
+            slowest = std::min(slowest, cursors_[i].next.load(std::memory_order_acquire));
+        }
+        return slowest;
+    }
+
+    const size_t readers_;
+
+    // Курсор писателя и его локальное состояние в одной cache line
+    alignas(CACHE_LINE_SIZE) std::atomic<uint64_t> write_cursor_{0};
+    uint64_t gating_cursor_ = 0;        // Кеш минимума курсоров читателей (только писатель)
+    std::atomic<size_t> high_watermark_{0};
+    std::atomic<uint64_t> full_events_{0};
+    bool full_ = false;
+
+    std::array<ReaderCursor, MaxReaders> cursors_;
+    alignas(CACHE_LINE_SIZE) T buffer_[Capacity];
+};
@@ -0,0 +1,139 @@
+#pragma once
+
+#include "config.hpp"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * Параметры планирования (router_test --plan)
+ */
+struct PlanOptions {
+    uint64_t router_ns = 50;            // Оценка времени роутера на сообщение (не задается конфигурацией)
+    uint32_t simulate_ms = 0;           // Длительность симуляции в модельном времени (0 - без симуляции)
+    uint32_t cores = 0;                 // Ядер целевой машины (0 - доступные этому процессу)
+    double warn_utilization = 0.8;      // Загрузка, с которой компонент считается близким к насыщению
+    uint64_t seed = 1;                  // Зерно генераторов симуляции
+};
+
+/**
+ * Загрузка одного однопоточного компонента (сервера очереди)
+ * Время в наносекундах, интенсивность - сообщений в наносекунду
+ */
+struct ServerLoad {
+    std::string name;
+    double arrival_rate = 0.0;          // Интенсивность входящего потока
+    double service_ns = 0.0;            // Среднее время обслуживания
+    double service_sq_ns = 0.0;         // Второй момент времени обслуживания
+    double utilization = 0.0;           // rho = arrival_rate * service_ns
+    double wait_ns = 0.0;               // Среднее ожидание в очереди (Поллачек-Хинчин), inf при rho >= 1
+};
+
+/**
+ * Результат симуляции одного компонента
+ */
+struct SimulatedServer {
+    std::string name;
+    uint64_t messages = 0;
+    double utilization = 0.0;           // Доля модельного времени в обслуживании
+    double wait_mean_ns = 0.0;
+    double wait_p99_ns = 0.0;
+    size_t max_depth = 0;               // Наибольшее число сообщений в очереди и в обслуживании
+    bool growing = false;               // Очередь в последней четверти глубже, чем в первой
+};
+
+/**
+ * Результат симуляции конвейера
+ */
+struct SimulationResult {
+    std::vector<SimulatedServer> servers;   // В порядке конвейера
+    std::vector<uint64_t> delivered_ns;     // От создания до получения стратегией
+    uint64_t generated = 0;
+    uint64_t dropped = 0;                   // Контроль допуска: сброшено
+    uint64_t delayed = 0;                   // Ждали токена
+    uint64_t diverted = 0;                  // Ушли в divert_processor
+};
+
+/**
+ * CapacityPlanner - оценка загрузки компонентов по конфигурации без запуска конвейера
+ *
+ * Скорости производителей, распределение типов, правила Stage1/Stage2 и времена
+ * обработки задают интенсивность потока на каждый процессор и стратегию. Каждый
+ * однопоточный компонент (роутеры, процессоры, стратегии) моделируется очередью
+ * M/G/1 с детерминированным временем обслуживания по типу: загрузка rho = lambda*E[S],
+ * ожидание по формуле Поллачека-Хинчина W = lambda*E[S^2] / (2*(1 - rho)). Пуассоновский
+ * поток - консервативное допущение для равномерного темпа производителей.
+ *
+ * simulate() прогоняет тот же конвейер в модельном времени в одном потоке:
+ * производители с равномерным темпом и случайным типом, маршрутизация через
+ * RouteTable (правила и ключи как в рабочем конвейере), ведра допуска TokenBucket,
+ * FIFO-серверы с детерминированным обслуживанием. Конвейер без обратных связей, поэтому стадии
+ * обсчитываются по очереди: момент выхода = max(приход, выход предыдущего) + время.
+ *
+ * Не моделируются: пакеты и опрос очередей роутерами, стоимость генерации у
+ * производителей, ограниченные очереди (обратное давление), эластичные резервы и
+ * делящие ядро потоки - о них report() выводит предупреждения.
+ */
+class CapacityPlanner {
+public:
+    CapacityPlanner(const SystemConfig& config, const PlanOptions& options);
+
+    /**
+     * Аналитическая загрузка компонентов в порядке конвейера
+     */
+    const std::vector<ServerLoad>& servers() const { return servers_; }
+
+    /**
+     * Наибольшая загрузка (узкое место)
+     */
+    const ServerLoad& bottleneck() const;
+
+    /**
+     * Симуляция options.simulate_ms модельного времени
+     */
+    SimulationResult simulate() const;
+
+    /**
+     * Отчет: таблица загрузки, узкое место, предельный темп, предупреждения, симуляция
+     * @return true если все компоненты успевают (rho < 1 и в модели, и в симуляции)
+     */
+    bool report() const;
+
+private:
+    /**
+     * Поток сообщений одного типа на пару (процессор, стратегия)
+     */
+    struct Flow {
+        uint8_t type;
+        uint8_t processor;
+        std::vector<uint8_t> strategies;    // Первый - основной получатель (multicast - все)
+        double rate;                        // Сообщений в наносекунду
+    };
+
+    SystemConfig config_;
+    PlanOptions options_;
+    bool routers_;                          // Отдельные потоки роутеров (нет в fused)
+
+    std::vector<double> type_rates_;        // Интенсивность по типам после допуска
+    double offered_rate_ = 0.0;             // Произведено до допуска
+    double shed_rate_ = 0.0;                // Сброшено или задержано допуском
+    std::vector<Flow> flows_;
+    std::vector<ServerLoad> servers_;
+    std::vector<std::string> notes_;        // Допущения модели для данной конфигурации
+
+    uint64_t processor_time_ns(uint8_t type) const;
+    uint64_t strategy_time_ns(uint8_t strategy) const;
+
+    void build_flows();
+    void build_servers();
+
+    /**
+     * Средняя задержка до получения стратегией по потокам модели, нс
+     */
+    double mean_delivered_ns() const;
+
+    /**
+     * Число активно ожидающих потоков конвейера (каждому нужно свое ядро)
+     */
+    uint32_t spinning_threads() const;
+};
@@ -12,6 +12,7 @@ struct ProducerConfig {
     uint32_t count;                             // Количество производителей
     uint64_t messages_per_sec;                  // Сообщений в секунду на производителя
     std::unordered_map<uint8_t, double> distribution; // Распределение типов сообщений
+    uint32_t keys = 0;                          // Пространство routing_key: равномерно из [0, keys), 0 - ключ = тип
 };
 
 /**
@@ -28,6 +29,8 @@ struct ProcessorConfig {
 struct StrategyConfig {
     uint32_t count;                             // Количество стратегий
     std::unordered_map<uint8_t, uint64_t> processing_times_ns; // Время обработки по стратегиям
+    uint32_t max_batch = 256;                   // Максимум сообщений за одну доставку
+    bool ordered_merge = false;                 // Доставка в порядке timestamp_ns (слияние полос, fused)
 };
 
 /**
@@ -43,8 +46,249 @@ struct Stage1Rule {
  */
 struct Stage2Rule {
     uint8_t msg_type;                          // Тип сообщения
-    uint8_t strategy;                          // ID стратегии
+    uint8_t strategy;                          // ID стратегии (при multicast - первый получатель)
     bool ordering_required;                    // Требуется ли сохранение порядка
+    std::vector<uint8_t> multicast;            // Все получатели multicast (пусто - только strategy)
+};
+
+/**
+ * Способ сопоставления ключа маршрутизации с правилом
+ */
+enum class KeyMatch {
+    Range,      // first <= routing_key <= last
+    Set,        // routing_key из списка keys
+    Hash        // hash(routing_key) % modulus входит в residues
+};
+
+/**
+ * Правило маршрутизации по 32-битному routing_key (stage1_key_rules / stage2_key_rules)
+ * Получатель внутри правила - targets[hash(routing_key) % targets.size()], поэтому
+ * все сообщения ключа идут одному получателю и порядок по ключу сохраняется
+ */
+struct KeyRule {
+    KeyMatch match = KeyMatch::Range;
+    uint32_t first = 0;                        // Range: первый ключ
+    uint32_t last = 0;                         // Range: последний ключ (включительно)
+    std::vector<uint32_t> keys;                // Set: ключи
+    uint32_t modulus = 0;                      // Hash: число разделов
+    std::vector<uint32_t> residues;            // Hash: разделы правила
+    std::vector<uint8_t> targets;              // Процессоры (Stage1) или стратегии (Stage2)
+};
+
+/**
+ * Группы получателей multicast: различные наборы стратегий в порядке правил Stage2
+ * Правила с одинаковым набором получателей разделяют одно кольцо
+ */
+std::vector<std::vector<uint8_t>> multicast_groups(const std::vector<Stage2Rule>& rules);
+
+/**
+ * Действие Stage1 при исчерпании токенов ведра допуска
+ */
+enum class AdmissionOverflow {
+    Delay,      // Сообщение ждет токена в очереди производителя (обратное давление)
+    Drop,       // Сообщение сбрасывается (учитывается в счетчике Shed)
+    Divert      // Сообщение уходит в низкоприоритетный процессор admission.divert_processor
+};
+
+/**
+ * Ведро токенов допуска: скорость пополнения и емкость (допустимый всплеск)
+ */
+struct AdmissionBucketConfig {
+    uint8_t id;                                // Тип сообщения или ID производителя
+    uint64_t rate;                             // Токенов (сообщений) в секунду
+    uint64_t burst;                            // Емкость ведра в токенах
+    AdmissionOverflow overflow = AdmissionOverflow::Delay;
+};
+
+/**
+ * Конфигурация контроля допуска в Stage1
+ * Сообщение допускается, если есть токен в ведре его типа и в ведре его производителя
+ * (если такие ведра заданы); иначе действует overflow ведра, в котором токена нет
+ */
+struct AdmissionConfig {
+    bool enabled = false;                      // Включен ли контроль допуска
+    std::vector<AdmissionBucketConfig> types;      // Ведра по типам (общие для всех производителей)
+    std::vector<AdmissionBucketConfig> producers;  // Ведра по производителям (все типы)
+    int divert_processor = -1;                 // Процессор низкого приоритета для политики divert
+};
+
+/**
+ * Конфигурация адаптивных пакетов роутеров и процессоров (adaptive_batch.hpp)
+ */
+struct BatchingConfig {
+    bool enabled = false;                      // Размер пакета по глубине очереди (иначе фиксированный)
+    uint64_t target_latency_us = 20;           // Цель добавки задержки от накопления пакета
+    uint32_t min_batch = 1;                    // Границы размера пакета
+    uint32_t max_batch = 256;
+};
+
+/**
+ * Конфигурация сторожа остановок процессоров (stall_watchdog.hpp)
+ * Процессор считается остановленным, если его входная очередь не пуста, а счетчик
+ * обработанных сообщений не меняется дольше stall_threshold_us
+ */
+struct WatchdogConfig {
+    bool enabled = false;                      // Включен ли сторож
+    uint64_t check_interval_us = 200;          // Период опроса счетчиков (микросекунды)
+    uint64_t stall_threshold_us = 2000;        // Время без прогресса при непустой очереди
+    size_t restore_depth = 64;                 // Глубина очереди для возврата в балансировку
+
+    // Имитация остановки (проверка сторожа): процессор inject_processor засыпает
+    // на inject_pause_us каждые inject_every_ms (-1 - без имитации)
+    int inject_processor = -1;
+    uint64_t inject_every_ms = 1000;
+    uint64_t inject_pause_us = 20000;
+};
+
+/**
+ * Конфигурация эластичного масштабирования процессоров
+ * Резервные процессоры создаются сверх processors.count и подключаются
+ * к балансировке Stage1 только для типов без требования порядка
+ */
+struct ElasticConfig {
+    bool enabled = false;                      // Включен ли контроллер
+    uint32_t standby_count = 0;                // Количество резервных процессоров
+    uint64_t check_interval_us = 100;          // Период опроса очередей (микросекунды)
+    size_t scale_up_depth = 4096;              // Глубина очереди для подключения резерва
+    uint64_t scale_up_latency_us = 500;        // Оценка ожидания в очереди для подключения резерва
+    size_t scale_down_depth = 64;              // Глубина, ниже которой резерв отключается
+    uint64_t park_idle_us = 10000;             // Время простоя до парковки процессора
+};
+
+/**
+ * Конфигурация входных очередей в разделяемой памяти
+ * Очереди производителей размещаются в именованной области shm, внешние процессы
+ * (shm_producer) подключаются к слотам [producers.count, producers.count + external_producers)
+ */
+struct ShmConfig {
+    bool enabled = false;                      // Размещать ли очереди производителей в shm
+    std::string name = "/router_ingress";      // Имя области POSIX shm
+    uint32_t external_producers = 0;           // Количество внешних процессов-производителей
+    uint64_t peer_timeout_ms = 1000;           // Таймаут heartbeat для обнаружения упавших процессов
+};
+
+/**
+ * Политика сброса журнала на диск
+ */
+enum class JournalSyncPolicy {
+    None,       // Без явной синхронизации (только page cache)
+    Interval,   // msync не реже чем раз в sync_interval_ms
+    EveryN      // msync после каждых sync_every_n записей
+};
+
+/**
+ * Конфигурация журнала доставленных сообщений (mmap, append-only)
+ */
+struct JournalConfig {
+    bool enabled = false;                      // Включен ли журнал
+    std::string directory = "results/journal"; // Каталог сегментов
+    uint64_t segment_records = 1 << 20;        // Записей в одном сегменте
+    JournalSyncPolicy sync_policy = JournalSyncPolicy::Interval;
+    uint64_t sync_interval_ms = 10;            // Период синхронизации (политика Interval)
+    uint64_t sync_every_n = 65536;             // Записей между синхронизациями (политика EveryN)
+};
+
+/**
+ * Конфигурация воспроизведения журнала вместо производителей
+ */
+struct ReplayConfig {
+    bool enabled = false;                      // Воспроизводить ли журнал
+    std::string directory = "results/journal"; // Каталог сегментов
+    double speed = 1.0;                        // Ускорение относительно записи (0 - без пауз)
+};
+
+/**
+ * Конфигурация бортового самописца (требует сборки с ROUTER_FLIGHT_RECORDER)
+ */
+struct FlightRecorderConfig {
+    bool enabled = false;                      // Записывать ли события
+    size_t ring_events = 65536;                // Размер кольца событий на поток (степень 2)
+    uint64_t freeze_latency_us = 0;            // Порог end-to-end задержки для заморозки (0 - выкл)
+    std::string output = "results/flight_trace.json"; // Файл Chrome trace
+};
+
+/**
+ * Конфигурация сэмплера заполнения очередей
+ */
+struct QueueSamplerConfig {
+    bool enabled = false;                      // Включен ли сэмплер
+    uint64_t interval_us = 100;                // Период выборки (10..1000 мкс)
+    size_t ring_samples = 1 << 16;             // Выборок в кольце (хранятся последние)
+    int core = -1;                             // Ядро для потока сэмплера (-1 - без привязки)
+    std::string output_csv = "results/queue_depths.csv"; // CSV (пусто - не писать)
+    std::string output_bin;                    // Бинарный формат (пусто - не писать)
+};
+
+/**
+ * Конфигурация счетчиков производительности (perf_event_open) потоков конвейера
+ */
+struct PerfCountersConfig {
+    bool enabled = false;                      // Открывать ли счетчики в потоках компонентов
+    bool include_kernel = false;               // Считать ли события в режиме ядра
+};
+
+/**
+ * Размещение буферов очередей конвейера (queue_arena.hpp)
+ */
+enum class QueueBacking {
+    Heap,       // make_shared: страницы выделяются при первой записи, обычного размера
+    Mmap,       // Резервирование арены mmap, выделение страниц 4 КБ по первой записи (без THP)
+    Thp,        // Арена mmap с MADV_HUGEPAGE (transparent huge pages 2 МБ)
+    HugeTlb     // Арена MAP_HUGETLB из пула huge pages (при нехватке пула - Thp)
+};
+
+/**
+ * Конфигурация памяти очередей
+ */
+struct QueueMemoryConfig {
+    QueueBacking backing = QueueBacking::Heap;
+    bool prefault = false;                     // Выделить страницы до запуска (параллельно, на ядре потребителя)
+};
+
+/**
+ * Конфигурация отчета статистики
+ */
+struct StatisticsConfig {
+    std::string dimensions_output = "results/dimensions.json"; // JSON по типам и производителям (пусто - не писать)
+};
+
+/**
+ * Модель исполнения компонентов
+ */
+enum class RuntimeMode {
+    Threads,    // Отдельный поток на каждый компонент
+    Coroutines  // Корутины на небольшом числе планировщиков
+};
+
+/**
+ * Передача сообщений между стадиями
+ */
+enum class PipelineTransport {
+    Queues,     // Цепочка SPSC очередей, сообщение копируется на каждом ребре
+    SharedRing  // Общее кольцо на производителя, между стадиями передаются ссылки на слоты
+};
+
+/**
+ * Размещение маршрутизации
+ */
+enum class PipelineTopology {
+    Staged,     // Отдельные потоки Stage1/Stage2 с собственными очередями
+    Fused       // Маршрутизация в потоках производителей и процессоров, очереди-полосы между парами
+};
+
+/**
+ * Конфигурация среды исполнения
+ * В режиме coroutines производители, роутеры, процессоры и стратегии
+ * распределяются round-robin по schedulers кооперативным планировщикам
+ */
+struct RuntimeConfig {
+    RuntimeMode mode = RuntimeMode::Threads;
+    PipelineTransport transport = PipelineTransport::Queues;
+    PipelineTopology topology = PipelineTopology::Staged;
+    uint32_t schedulers = 1;                   // Количество потоков-планировщиков
+    bool pin = true;                           // Привязывать ли планировщики к ядрам
+    uint32_t first_core = 0;                   // Ядро первого планировщика
+    uint32_t batch = 64;                       // Сообщений за одно возобновление корутины
 };
 
 /**
@@ -60,6 +304,36 @@ struct SystemConfig {
 
     std::vector<Stage1Rule> stage1_rules;      // Правила маршрутизации Stage1
     std::vector<Stage2Rule> stage2_rules;      // Правила маршрутизации Stage2
+    std::vector<KeyRule> stage1_key_rules;     // Маршрутизация Stage1 по routing_key (вместо stage1_rules)
+    std::vector<KeyRule> stage2_key_rules;     // Маршрутизация Stage2 по routing_key (вместо stage2_rules)
+
+    ElasticConfig elastic;                     // Эластичное масштабирование процессоров
+    WatchdogConfig watchdog;                   // Сторож остановок процессоров
+    ShmConfig shm;                             // Входные очереди в разделяемой памяти
+    JournalConfig journal;                     // Журнал доставленных сообщений
+    ReplayConfig replay;                       // Воспроизведение журнала
+    RuntimeConfig runtime;                     // Модель исполнения компонентов
+    FlightRecorderConfig flight_recorder;      // Бортовой самописец событий
+    QueueSamplerConfig queue_sampler;          // Временной ряд заполнения очередей
+    PerfCountersConfig perf_counters;          // Аппаратные счетчики по стадиям
+    AdmissionConfig admission;                 // Контроль допуска в Stage1 (token bucket)
+    BatchingConfig batching;                   // Адаптивные пакеты роутеров и процессоров
+    StatisticsConfig statistics;               // Отчет статистики
+    QueueMemoryConfig queue_memory;            // Размещение буферов очередей
+
+    /**
+     * Общее количество потоков-процессоров (основные + резервные)
+     */
+    uint32_t total_processors() const {
+        return processors.count + (elastic.enabled ? elastic.standby_count : 0);
+    }
+
+    /**
+     * Общее количество производителей (внутренние + внешние процессы)
+     */
+    uint32_t total_producers() const {
+        return producers.count + (shm.enabled ? shm.external_producers : 0);
+    }
 
     /**
      * Загрузка конфигурации из JSON файла
@@ -68,6 +342,11 @@ struct SystemConfig {
      */
     static SystemConfig load_from_file(const std::string& filename);
 
+    /**
+     * Загрузка конфигурации из текста JSON (кандидаты router_test --tune)
+     */
+    static SystemConfig load_from_string(const std::string& text);
+
     /**
      * Проверка корректности конфигурации
      * @return true если конфигурация валидна
@@ -0,0 +1,187 @@
+#pragma once
+
+#include "message.hpp"
+#include <atomic>
+#include <coroutine>
+#include <cstdint>
+#include <exception>
+#include <memory>
+#include <utility>
+#include <vector>
+
+/**
+ * CoroTask - корутина компонента, исполняемая CoroScheduler'ом
+ * Создается приостановленной, владение кадром передается планировщику через spawn()
+ */
+class CoroTask {
+public:
+    struct promise_type {
+        CoroTask get_return_object() noexcept {
+            return CoroTask(std::coroutine_handle<promise_type>::from_promise(*this));
+        }
+        std::suspend_always initial_suspend() noexcept { return {}; }
+        std::suspend_always final_suspend() noexcept { return {}; }
+        void return_void() noexcept {}
+        void unhandled_exception() noexcept { std::terminate(); }
+    };
+
+    CoroTask(CoroTask&& other) noexcept : handle_(std::exchange(other.handle_, {})) {}
+    CoroTask(const CoroTask&) = delete;
+    CoroTask& operator=(const CoroTask&) = delete;
+    CoroTask& operator=(CoroTask&&) = delete;
+
+    ~CoroTask() {
+        if (handle_) {
+            handle_.destroy();
+        }
+    }
+
+    std::coroutine_handle<> release() noexcept { return std::exchange(handle_, {}); }
+
+private:
+    explicit CoroTask(std::coroutine_handle<promise_type> handle) : handle_(handle) {}
+
+    std::coroutine_handle<promise_type> handle_;
+};
+
+/**
+ * CoroScheduler - кооперативный планировщик корутин на одном ядре
+ *
+ * Один поток (опционально привязанный к ядру) по кругу опрашивает условия
+ * готовности приостановленных корутин и возобновляет готовые. Корутина работает
+ * до следующего co_await (run-to-completion), поэтому компоненты обрабатывают
+ * не больше batch() сообщений подряд и затем уступают ядро через yield().
+ *
+ * Условия готовности - непустая очередь, наступление времени или безусловное
+ * возобновление в следующем круге. После остановки (running == false) все
+ * корутины возобновляются, проверяют флаг и завершаются.
+ */
+class CoroScheduler {
+    // Проверка готовности: (контекст, срок, текущее время)
+    using ReadyFn = bool (*)(const void*, uint64_t, uint64_t) noexcept;
+
+    struct Waiter {
+        std::coroutine_handle<> handle;
+        ReadyFn ready;
+        const void* context;
+        uint64_t deadline_ns;
+    };
+
+public:
+    /**
+     * Awaitable ожидания условия; при выполненном условии не приостанавливает корутину
+     */
+    class Wait {
+    public:
+        Wait(CoroScheduler& scheduler, ReadyFn ready, const void* context,
+             uint64_t deadline_ns, bool always_suspend) noexcept
+            : scheduler_(scheduler), ready_(ready), context_(context)
+            , deadline_ns_(deadline_ns), always_suspend_(always_suspend) {}
+
+        bool await_ready() const noexcept {
+            return !always_suspend_ && ready_(context_, deadline_ns_, Message::get_timestamp_ns());
+        }
+
+        void await_suspend(std::coroutine_handle<> handle) noexcept {
+            scheduler_.next_.push_back({handle, ready_, context_, deadline_ns_});
+        }
+
+        void await_resume() const noexcept {}
+
+    private:
+        CoroScheduler& scheduler_;
+        ReadyFn ready_;
+        const void* context_;
+        uint64_t deadline_ns_;
+        bool always_suspend_;
+    };
+
+    /**
+     * @param id номер планировщика (для отчета)
+     * @param core ядро для привязки потока, -1 - без привязки
+     * @param batch максимум сообщений, обрабатываемых компонентом за одно возобновление
+     */
+    CoroScheduler(uint32_t id, int core, uint32_t batch);
+    ~CoroScheduler();
+
+    CoroScheduler(const CoroScheduler&) = delete;
+    CoroScheduler& operator=(const CoroScheduler&) = delete;
+
+    /**
+     * Передача корутины планировщику (до запуска run)
+     */
+    void spawn(CoroTask task);
+
+    /**
+     * Основной цикл планировщика (запускается в отдельном потоке)
+     * Возвращается, когда все корутины завершились
+     */
+    void run(std::atomic<bool>& running);
+
+    /**
+     * Ожидание непустой очереди
+     */
+    template<typename Queue>
+    Wait readable(const Queue& queue) noexcept {
+        return Wait(*this, [](const void* context, uint64_t, uint64_t) noexcept {
+            return !static_cast<const Queue*>(context)->empty();
+        }, &queue, 0, false);
+    }
+
+    /**
+     * Ожидание хотя бы одной непустой очереди из набора
+     */
+    template<typename Queue>
+    Wait readable_any(const std::vector<std::shared_ptr<Queue>>& queues) noexcept {
+        return Wait(*this, [](const void* context, uint64_t, uint64_t) noexcept {
+            for (const auto& queue : *static_cast<const std::vector<std::shared_ptr<Queue>>*>(context)) {
+                if (!queue->empty()) {
+                    return true;
+                }
+            }
+            return false;
+        }, &queues, 0, false);
+    }
+
+    /**
+     * Ожидание момента времени (Message::get_timestamp_ns)
+     */
+    Wait sleep_until(uint64_t deadline_ns) noexcept {
+        return Wait(*this, [](const void*, uint64_t deadline, uint64_t now) noexcept {
+            return now >= deadline;
+        }, nullptr, deadline_ns, false);
+    }
+
+    /**
+     * Уступить ядро остальным корутинам до следующего круга
+     */
+    Wait yield() noexcept {
+        return Wait(*this, [](const void*, uint64_t, uint64_t) noexcept {
+            return true;
+        }, nullptr, 0, true);
+    }
+
+    uint32_t batch() const { return batch_; }
+    uint32_t id() const { return id_; }
+
+    /**
+     * Вывод итогового отчета о планировщике (после завершения run)
+     */
+    void print_report() const;
+
+private:
+    uint32_t id_;
+    int core_;
+    uint32_t batch_;
+    bool pinned_ = false;
+
+    // Корутины, ожидающие в текущем круге, и приостановленные в нем
+    std::vector<Waiter> current_;
+    std::vector<Waiter> next_;
+
+    // Счетчики для отчета (пишет только поток планировщика)
+    size_t spawned_ = 0;
+    uint64_t rounds_ = 0;
+    uint64_t idle_rounds_ = 0;
+    uint64_t resumes_ = 0;
+};
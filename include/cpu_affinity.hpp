@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+/**
+ * Привязка текущего потока к ядру CPU
+ * @return true если привязка выполнена, false если ядро недоступно
+ */
+bool pin_current_thread(uint32_t core);
+
+/**
+ * Привязка текущего потока к набору ядер; потоки, созданные им позже, наследуют набор
+ * @return true если привязка выполнена
+ */
+bool pin_current_thread(const std::vector<uint32_t>& cores);
+
+/**
+ * Количество ядер, доступных процессу
+ */
+uint32_t available_cores();
+
+/**
+ * Минимальный приоритет (nice 19) для текущего потока: фоновые потоки
+ * уступают ядро компонентам конвейера, но не голодают полностью
+ * @return true если приоритет изменен
+ */
+bool set_current_thread_low_priority();
+
+/**
+ * Ядра, на которых процессу разрешено выполняться (по возрастанию)
+ */
+std::vector<uint32_t> allowed_cores();
+
+/**
+ * Взаимное расположение двух ядер (по данным /sys/devices/system/cpu)
+ */
+enum class CoreRelation {
+    Same,           // Одно и то же ядро
+    SmtSibling,     // Гиперпотоки одного физического ядра
+    SharedL3,       // Общий L3 (один CCX/кластер)
+    SameSocket,     // Один сокет, разные L3
+    CrossSocket     // Разные сокеты
+};
+
+CoreRelation core_relation(uint32_t a, uint32_t b);
+
+const char* core_relation_name(CoreRelation relation);
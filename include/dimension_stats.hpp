@@ -0,0 +1,226 @@
+#pragma once
+
+#include "message.hpp"
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <string>
+#include <vector>
+
+// Гистограмма задержек: октава [2^k, 2^(k+1)) нс делится на 2^LATENCY_SUB_BITS корзин
+// (ошибка перцентиля не больше 1/8), значения от 2^LATENCY_MAX_OCTAVE нс (~18 мин) - в последней корзине
+constexpr uint32_t LATENCY_SUB_BITS = 3;
+constexpr uint32_t LATENCY_MAX_OCTAVE = 40;
+constexpr size_t LATENCY_BUCKETS = (LATENCY_MAX_OCTAVE - LATENCY_SUB_BITS + 1) << LATENCY_SUB_BITS;
+
+/**
+ * Корзина гистограммы для задержки в наносекундах (значения до 2^LATENCY_SUB_BITS - точно)
+ */
+inline size_t latency_bucket(uint64_t ns) noexcept {
+    constexpr uint64_t exact = 1u << LATENCY_SUB_BITS;
+    if (ns < exact) {
+        return static_cast<size_t>(ns);
+    }
+    const uint32_t octave = static_cast<uint32_t>(std::bit_width(ns)) - 1;
+    if (octave >= LATENCY_MAX_OCTAVE) {
+        return LATENCY_BUCKETS - 1;
+    }
+    const uint64_t sub = (ns >> (octave - LATENCY_SUB_BITS)) & (exact - 1);
+    return (static_cast<size_t>(octave - LATENCY_SUB_BITS + 1) << LATENCY_SUB_BITS) + sub;
+}
+
+/**
+ * Нижняя граница корзины в наносекундах и ее ширина
+ */
+inline uint64_t latency_bucket_lower(size_t bucket) noexcept {
+    constexpr uint64_t exact = 1u << LATENCY_SUB_BITS;
+    if (bucket < exact) {
+        return bucket;
+    }
+    const uint32_t shift = static_cast<uint32_t>(bucket >> LATENCY_SUB_BITS) - 1;
+    return (exact + (bucket & (exact - 1))) << shift;
+}
+
+inline uint64_t latency_bucket_width(size_t bucket) noexcept {
+    return bucket < (1u << LATENCY_SUB_BITS) ? 1 : uint64_t{1} << ((bucket >> LATENCY_SUB_BITS) - 1);
+}
+
+/**
+ * Ячейка измерения (тип или производитель) в шарде потока
+ * Пишет только поток-владелец (без атомарных RMW), читает отчет
+ */
+struct DimensionCell {
+    std::atomic<uint64_t> produced{0};
+    std::atomic<uint64_t> delivered{0};
+    std::atomic<uint64_t> latency_sum_ns{0};
+    std::atomic<uint64_t> latency_max_ns{0};
+    std::array<std::atomic<uint64_t>, LATENCY_BUCKETS> latency{};
+
+    // Увеличение счетчика единственным писателем: чтение и запись вместо lock-префикса
+    static void bump(std::atomic<uint64_t>& counter, uint64_t n) noexcept {
+        counter.store(counter.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+    }
+
+    void record_latency(uint64_t ns) noexcept {
+        bump(delivered, 1);
+        bump(latency[latency_bucket(ns)], 1);
+        bump(latency_sum_ns, ns);
+        if (ns > latency_max_ns.load(std::memory_order_relaxed)) {
+            latency_max_ns.store(ns, std::memory_order_relaxed);
+        }
+    }
+};
+
+/**
+ * Сумма ячеек всех шардов по одному значению измерения (для отчета)
+ */
+struct DimensionTotals {
+    uint64_t produced = 0;
+    uint64_t delivered = 0;
+    uint64_t latency_sum_ns = 0;
+    uint64_t latency_max_ns = 0;
+    std::array<uint64_t, LATENCY_BUCKETS> latency{};
+
+    void add(const DimensionCell& cell);
+
+    /**
+     * Приращение с момента earlier (максимум остается накопленным)
+     */
+    DimensionTotals since(const DimensionTotals& earlier) const;
+
+    /**
+     * Перцентиль задержки (середина корзины), мкс
+     */
+    double percentile_us(double p) const;
+    double mean_us() const;
+    double max_us() const { return static_cast<double>(latency_max_ns) / 1000.0; }
+
+    bool empty() const { return produced == 0 && delivered == 0; }
+};
+
+/**
+ * Снимок измерений: по типам сообщений и по производителям
+ */
+struct DimensionSnapshot {
+    std::vector<DimensionTotals> types = std::vector<DimensionTotals>(256);
+    std::vector<DimensionTotals> producers = std::vector<DimensionTotals>(256);
+};
+
+/**
+ * DimensionShard - ячейки одного потока; ячейка создается при первом сообщении
+ * своего типа или производителя и публикуется для отчета через атомарный указатель
+ */
+class DimensionShard {
+public:
+    DimensionCell& type(uint8_t id) { return cell(types_, id); }
+    DimensionCell& producer(uint8_t id) { return cell(producers_, id); }
+
+    void collect(DimensionSnapshot& snapshot) const;
+
+private:
+    using Cells = std::array<std::atomic<DimensionCell*>, 256>;
+
+    Cells types_{};
+    Cells producers_{};
+    std::vector<std::unique_ptr<DimensionCell>> owned_;   // Меняет только владелец
+
+    DimensionCell& cell(Cells& cells, uint8_t id) {
+        DimensionCell* found = cells[id].load(std::memory_order_relaxed);
+        if (!found) [[unlikely]] {
+            owned_.push_back(std::make_unique<DimensionCell>());
+            found = owned_.back().get();
+            cells[id].store(found, std::memory_order_release);
+        }
+        return *found;
+    }
+};
+
+/**
+ * DimensionStats - счетчики и гистограммы задержки по msg_type и producer_id
+ *
+ * Каждый записывающий поток (производитель, стратегия, планировщик корутин)
+ * получает собственный шард при первой записи и пишет только в него: общих
+ * записей и блокировок на горячем пути нет. Отчет суммирует шарды. Задержка -
+ * от создания сообщения до получения стратегией, каждое сообщение (без выборки).
+ */
+class DimensionStats {
+public:
+    DimensionStats();
+
+    DimensionStats(const DimensionStats&) = delete;
+    DimensionStats& operator=(const DimensionStats&) = delete;
+
+    void record_produced(const Message& msg) {
+        DimensionShard& shard = local();
+        DimensionCell::bump(shard.type(msg.msg_type).produced, 1);
+        DimensionCell::bump(shard.producer(msg.producer_id).produced, 1);
+    }
+
+    /**
+     * Внешние производители (shm): известен только номер производителя
+     */
+    void record_produced(uint8_t producer_id, uint64_t count) {
+        DimensionCell::bump(local().producer(producer_id).produced, count);
+    }
+
+    /**
+     * Доставленный пакет; entry_ns - время получения, если оно не записано в сообщения
+     * (multicast: сообщение в кольце не изменяется)
+     */
+    template<typename Element>
+    void record_delivered(std::span<const Element> batch, uint64_t entry_ns = 0) {
+        DimensionShard& shard = local();
+        for (const Element& element : batch) {
+            const Message& msg = batch_message(element);
+            const uint64_t received = entry_ns ? entry_ns : msg.strategy_entry_ns;
+            const uint64_t latency = received > msg.timestamp_ns ? received - msg.timestamp_ns : 0;
+            shard.type(msg.msg_type).record_latency(latency);
+            shard.producer(msg.producer_id).record_latency(latency);
+        }
+    }
+
+    DimensionSnapshot snapshot() const;
+
+    /**
+     * Строки периодического отчета: пропускная способность и p99 за период с прошлого вызова
+     * (вызывается только потоком мониторинга)
+     */
+    void print_interval(double elapsed_secs) const;
+
+    /**
+     * Таблицы итогового отчета по типам и производителям
+     */
+    void print_report(double duration_secs) const;
+
+    /**
+     * Машиночитаемый дамп (JSON): счетчики, перцентили и непустые корзины гистограмм
+     */
+    void export_json(const std::string& path, const std::string& scenario, double duration_secs) const;
+
+private:
+    uint64_t id_;   // Уникален для процесса: кэш шарда потока не спутает экземпляры по адресу
+
+    mutable std::mutex shards_mutex_;
+    std::vector<std::unique_ptr<DimensionShard>> shards_;
+
+    // Предыдущий снимок периодического отчета
+    mutable DimensionSnapshot last_interval_;
+    mutable double last_elapsed_ = 0.0;
+
+    DimensionShard& local() {
+        thread_local uint64_t owner = 0;
+        thread_local DimensionShard* shard = nullptr;
+        if (owner != id_) [[unlikely]] {
+            shard = add_shard();
+            owner = id_;
+        }
+        return *shard;
+    }
+
+    DimensionShard* add_shard();
+};
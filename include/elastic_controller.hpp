@@ -0,0 +1,92 @@
+#pragma once
+
+#include "config.hpp"
+#include "processor.hpp"
+#include "router.hpp"
+#include <atomic>
+#include <memory>
+#include <vector>
+
+/**
+ * ElasticController - эластичное масштабирование процессоров по глубине очередей
+ *
+ * Периодически опрашивает глубину входной очереди каждого процессора и:
+ * - паркует процессор, если его очередь пуста дольше park_idle_us
+ * - подключает резервный процессор к балансировке Stage1, если очередь
+ *   основного процессора превышает scale_up_depth (или оценка ожидания
+ *   превышает scale_up_latency_us)
+ * - отключает резерв, когда обе очереди опустились ниже scale_down_depth
+ *
+ * Резерв подключается только для типов без требования порядка (ordering_required=false),
+ * иначе распределение типа по нескольким процессорам нарушило бы порядок.
+ */
+class ElasticController {
+public:
+    using ProcessorQueue = SPSCQueue<Message, PROCESSOR_QUEUE_SIZE>;
+
+    ElasticController(
+        const SystemConfig& config,
+        Stage1Router& stage1_router,
+        std::vector<std::unique_ptr<Processor>>& processors,
+        std::vector<std::shared_ptr<ProcessorQueue>>& processor_queues
+    );
+
+    /**
+     * Основной цикл контроллера (запускается в отдельном потоке)
+     */
+    void run(std::atomic<bool>& running);
+
+    /**
+     * Вывод текущего состояния (вызывается из мониторинга)
+     */
+    void print_current_state() const;
+
+    /**
+     * Вывод итогового отчета о масштабировании
+     */
+    void print_report() const;
+
+private:
+    ElasticConfig config_;
+    uint32_t base_count_;               // Количество основных процессоров
+    Stage1Router& stage1_router_;
+    std::vector<std::unique_ptr<Processor>>& processors_;
+    std::vector<std::shared_ptr<ProcessorQueue>>& processor_queues_;
+
+    // Типы без требования порядка, обслуживаемые основным процессором
+    std::vector<std::vector<uint8_t>> elastic_types_;
+
+    // Оценка времени обработки одного сообщения процессором (наносекунды)
+    std::vector<uint64_t> service_time_ns_;
+
+    // Назначения: основной -> резервный (-1 если нет) и обратно
+    std::vector<int> helper_of_;
+    std::vector<int> owner_of_;
+
+    // Момент начала простоя очереди (0 - очередь не пуста)
+    std::vector<uint64_t> idle_since_ns_;
+
+    // Счетчики событий
+    std::atomic<uint64_t> scale_ups_{0};
+    std::atomic<uint64_t> scale_downs_{0};
+    std::atomic<uint64_t> parks_{0};
+    std::atomic<uint64_t> unparks_{0};
+    std::atomic<uint32_t> standby_in_use_{0};
+    std::atomic<uint32_t> active_count_{0};
+    std::atomic<uint32_t> peak_active_{0};
+
+    /**
+     * Один шаг контроллера
+     */
+    void tick(uint64_t now_ns);
+
+    /**
+     * Подключение резервного процессора к основному
+     */
+    void attach_standby(uint32_t base_id);
+
+    /**
+     * Отключение резервного процессора от основного
+     */
+    void detach_standby(uint32_t base_id);
+};
@@ -0,0 +1,187 @@
+#pragma once
+
+#include "config.hpp"
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <x86intrin.h>
+
+/**
+ * События бортового самописца
+ */
+enum class TraceEvent : uint8_t {
+    Pop,            // Извлечение из очереди (lane - очередь/компонент, arg - количество)
+    Route,          // Решение маршрутизации (lane - получатель, arg - msg_type)
+    PushRetryBegin, // Выходная очередь полна, начало ожидания (lane - очередь)
+    PushRetryEnd,   // Сообщение отправлено после ожидания
+    Idle,           // Переход в простой (входные очереди пусты)
+    Park,           // Процессор припаркован (lane - процессор)
+    Unpark,         // Процессор возвращен в работу
+    Stall,          // Сторож обнаружил остановку (lane - процессор, arg - глубина очереди)
+    Restore         // Процессор возвращен в балансировку Stage1 после остановки
+};
+
+/**
+ * Компактная запись события (16 байт)
+ */
+struct TraceRecord {
+    uint64_t tsc;       // Метка времени TSC
+    uint32_t arg;       // Аргумент события
+    uint16_t lane;      // Очередь/компонент
+    TraceEvent event;
+    uint8_t reserved;
+};
+
+/**
+ * Кольцевой буфер событий одного потока
+ * Пишет только поток-владелец; читается после заморозки при экспорте
+ */
+class ThreadRecorder {
+public:
+    ThreadRecorder(std::string name, size_t capacity, const std::atomic<bool>& frozen)
+        : name_(std::move(name)), ring_(capacity), mask_(capacity - 1), frozen_(frozen) {}
+
+    void record(TraceEvent event, uint16_t lane, uint32_t arg) noexcept {
+        if (frozen_.load(std::memory_order_relaxed)) {
+            return;
+        }
+        const uint64_t head = head_.load(std::memory_order_relaxed);
+        TraceRecord& record = ring_[head & mask_];
+        record.tsc = __rdtsc();
+        record.arg = arg;
+        record.lane = lane;
+        record.event = event;
+        head_.store(head + 1, std::memory_order_release);
+    }
+
+    const std::string& name() const { return name_; }
+    uint64_t head() const { return head_.load(std::memory_order_acquire); }
+    size_t capacity() const { return ring_.size(); }
+    const TraceRecord& at(uint64_t index) const { return ring_[index & mask_]; }
+
+private:
+    std::string name_;
+    std::vector<TraceRecord> ring_;
+    size_t mask_;
+    const std::atomic<bool>& frozen_;
+    std::atomic<uint64_t> head_{0};
+};
+
+/**
+ * Причина заморозки самописца
+ */
+enum class FreezeReason : uint32_t {
+    None = 0,
+    Signal,         // SIGUSR1
+    Latency,        // Превышен порог задержки
+    Shutdown        // Остановка системы
+};
+
+/**
+ * FlightRecorder - бортовой самописец: кольцевые буферы событий по потокам
+ *
+ * Компоненты записывают события макросами FR_EVENT/FR_THREAD; без
+ * ROUTER_FLIGHT_RECORDER при компиляции макросы пусты и не стоят ничего.
+ * По заморозке (сигнал, порог задержки, остановка) запись прекращается,
+ * и последние события каждого потока экспортируются в формате
+ * Chrome trace (открывается в chrome://tracing и Perfetto).
+ */
+class FlightRecorder {
+public:
+    static FlightRecorder& instance();
+
+    /**
+     * Включение записи с параметрами из конфигурации (до запуска потоков)
+     */
+    void configure(const FlightRecorderConfig& config);
+
+    bool enabled() const { return enabled_; }
+
+    /**
+     * Регистрация текущего потока; без включенного самописца ничего не делает
+     * @param name имя потока в трассе
+     * @param index номер компонента (добавляется к имени)
+     */
+    void register_thread(const std::string& name, uint32_t index);
+
+    /**
+     * Запись события текущего потока (незарегистрированные потоки пропускаются)
+     */
+    static void record(TraceEvent event, uint16_t lane, uint32_t arg) noexcept {
+        if (ThreadRecorder* recorder = current_) {
+            recorder->record(event, lane, arg);
+        }
+    }
+
+    /**
+     * Заморозка по запросу; безопасна для вызова из обработчика сигнала
+     */
+    static void freeze(FreezeReason reason) noexcept {
+        uint32_t expected = static_cast<uint32_t>(FreezeReason::None);
+        if (freeze_reason_.compare_exchange_strong(expected, static_cast<uint32_t>(reason),
+                                                   std::memory_order_relaxed)) {
+            freeze_tsc_.store(__rdtsc(), std::memory_order_relaxed);
+            frozen_.store(true, std::memory_order_release);
+        }
+    }
+
+    static bool frozen() noexcept { return frozen_.load(std::memory_order_acquire); }
+
+    /**
+     * Автоматическая заморозка при задержке выше порога (0 - выключено)
+     */
+    static void check_latency(uint64_t latency_ns) noexcept {
+        const uint64_t threshold = freeze_latency_ns_.load(std::memory_order_relaxed);
+        if (threshold != 0 && latency_ns > threshold && !frozen_.load(std::memory_order_relaxed)) {
+            freeze(FreezeReason::Latency);
+        }
+    }
+
+    /**
+     * Экспорт в Chrome trace JSON (после заморозки)
+     * @return количество записанных событий
+     */
+    size_t export_chrome_trace(const std::string& path) const;
+
+    /**
+     * Экспорт в файл из конфигурации; повторные вызовы ничего не делают
+     */
+    void export_once();
+
+private:
+    FlightRecorder();
+
+    bool enabled_ = false;
+    size_t ring_events_ = 65536;
+    std::string output_;
+    bool exported_ = false;
+
+    // Калибровка TSC относительно steady_clock
+    uint64_t base_tsc_ = 0;
+    double ticks_per_ns_ = 1.0;
+
+    void calibrate();
+
+    mutable std::mutex registry_mutex_;
+    std::vector<std::unique_ptr<ThreadRecorder>> recorders_;
+
+    static inline thread_local ThreadRecorder* current_ = nullptr;
+    static inline std::atomic<bool> frozen_{false};
+    static inline std::atomic<uint32_t> freeze_reason_{0};
+    static inline std::atomic<uint64_t> freeze_tsc_{0};
+    static inline std::atomic<uint64_t> freeze_latency_ns_{0};
+};
+
+#ifdef ROUTER_FLIGHT_RECORDER
+#define FR_THREAD(name, index) FlightRecorder::instance().register_thread(name, index)
+#define FR_EVENT(event, lane, arg) \
+    FlightRecorder::record(TraceEvent::event, static_cast<uint16_t>(lane), static_cast<uint32_t>(arg))
+#define FR_CHECK_LATENCY(latency_ns) FlightRecorder::check_latency(latency_ns)
+#else
+#define FR_THREAD(name, index) ((void)0)
+#define FR_EVENT(event, lane, arg) ((void)0)
+#define FR_CHECK_LATENCY(latency_ns) ((void)0)
+#endif
@@ -0,0 +1,124 @@
+#pragma once
+
+#include "config.hpp"
+#include "message.hpp"
+#include "statistics.hpp"
+#include "spsc_queue.hpp"
+#include "producer.hpp"
+#include "router.hpp"
+#include "handlers.hpp"
+#include "journal.hpp"
+#include "queue_sampler.hpp"
+#include "timestamp_merge.hpp"
+#include <atomic>
+#include <memory>
+#include <vector>
+
+// Размер полосы между парой компонентов (пар много - полоса меньше обычной очереди)
+constexpr size_t FUSED_LANE_SIZE = 8192; // Должно быть степенью 2
+
+/**
+ * FusedPipeline - стадии конвейера в режиме runtime.topology = fused
+ *
+ * Маршрутизация - поиск в таблице, поэтому отдельных потоков Stage1/Stage2 нет:
+ * производитель выбирает процессор сам и пишет в полосу (производитель, процессор),
+ * процессор после обработки выбирает стратегию и пишет в полосу (процессор, стратегия).
+ * На сообщение две передачи между потоками вместо четырех.
+ *
+ * Каждая полоса - SPSC очередь одной пары, поэтому порядок сообщений производителя
+ * внутри полосы сохраняется так же, как в цепочке очередей. Отметки Stage1/Stage2
+ * ставятся в момент встроенной маршрутизации; учет и статистика те же, что в режиме staged.
+ * Потоки запускает Pipeline.
+ *
+ * С strategies.ordered_merge полосы сливаются по timestamp_ns (TimestampMerge) на двух уровнях:
+ * процессор - по полосам производителей, стратегия - по полосам процессоров. Производитель
+ * продвигает водяной знак после каждой отправки и heartbeat'ом в ожидании (Producer::run_with),
+ * процессор - границу своего слияния после отправки пакета, поэтому пустые полосы не
+ * останавливают слияние. Стратегии получают
+ * поток, упорядоченный по времени создания через всех производителей.
+ */
+class FusedPipeline {
+public:
+    using Lane = SPSCQueue<Message, FUSED_LANE_SIZE>;
+
+    FusedPipeline(const SystemConfig& config, SystemStatistics& stats);
+
+    FusedPipeline(const FusedPipeline&) = delete;
+    FusedPipeline& operator=(const FusedPipeline&) = delete;
+
+    /**
+     * Основные циклы компонентов (каждый в отдельном потоке)
+     */
+    void run_producer(size_t index, std::atomic<bool>& running, uint32_t duration_secs);
+    void run_processor(size_t index, std::atomic<bool>& running);
+    void run_strategy(size_t index, std::atomic<bool>& running);
+
+    /**
+     * Подключение журнала доставленных сообщений (nullptr - без журнала)
+     */
+    void set_journal(JournalWriter* journal) { journal_ = journal; }
+
+    /**
+     * Регистрация полос в сэмплере
+     */
+    void add_sampler_edges(QueueSampler& sampler) const;
+
+    /**
+     * Обновление глубин в статистике: сумма полос, входящих в процессор или стратегию
+     */
+    void update_queue_depths();
+
+    /**
+     * Отчет по полосам: максимальное заполнение и эпизоды переполнения
+     */
+    void print_report() const;
+
+    size_t producers() const { return producers_.size(); }
+    size_t processors() const { return processor_times_.size(); }
+    size_t strategies() const { return strategy_times_ns_.size(); }
+
+    /**
+     * Байт, копируемых транспортом на сообщение: два ребра, запись и чтение на каждом
+     */
+    static constexpr size_t transport_bytes_per_message() {
+        return 2 * 2 * sizeof(Message);
+    }
+
+private:
+    SystemStatistics& stats_;
+
+    // Полосы: [производитель][процессор] и [процессор][стратегия]
+    std::vector<std::vector<std::shared_ptr<Lane>>> producer_lanes_;
+    std::vector<std::vector<std::shared_ptr<Lane>>> processor_lanes_;
+
+    std::vector<std::unique_ptr<Producer>> producers_;
+
+    // Своя копия таблиц у каждого маршрутизирующего потока (счетчики round-robin)
+    std::vector<RouteTable> producer_routes_;
+    std::vector<RouteTable> processor_routes_;
+
+    // Имитация обработки: время процессоров по типам и стратегий на сообщение
+    std::vector<SimulatedWork> processor_times_;
+    std::vector<uint64_t> strategy_times_ns_;
+    size_t max_batch_;
+
+    JournalWriter* journal_ = nullptr;
+
+    // Слияние по времени (strategies.ordered_merge): водяные знаки источников и слияния потребителей
+    bool ordered_merge_;
+    std::vector<Watermark> producer_watermarks_;
+    std::vector<Watermark> processor_watermarks_;
+    std::vector<TimestampMerge<Lane>> processor_merges_;
+    std::vector<TimestampMerge<Lane>> strategy_merges_;
+    std::vector<uint64_t> time_order_violations_;   // Доставки старше предыдущей (по стратегиям)
+
+    /**
+     * Обработка пакета процессора и маршрутизация Stage2 в полосы стратегий
+     */
+    void process_batch(size_t index, Message* batch, size_t count);
+
+    /**
+     * Учет доставленного пакета стратегии: журнал, задержки, порядок, счетчики
+     */
+    void deliver_batch(uint8_t strategy_id, std::span<const Message> batch);
+};
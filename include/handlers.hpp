@@ -0,0 +1,232 @@
+#pragma once
+
+#include "message.hpp"
+#include "timer.hpp"
+#include <array>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <tuple>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <variant>
+
+/**
+ * Обработчики сообщений для Processor::run_with и Strategy::run_with
+ *
+ * Обработчик - любой вызываемый объект, передаваемый как параметр шаблона:
+ * - void(Message&)                  - преобразование сообщения
+ * - bool(Message&)                  - фильтр, false отклоняет сообщение
+ * - void/size_t(std::span<Message>) - пакетный вариант; size_t - количество
+ *                                     оставшихся сообщений (отклоненные удалены со сжатием)
+ *
+ * Цепочки и диспетчеризация по типу собираются на этапе компиляции и
+ * встраиваются в цикл компонента: без виртуальных вызовов и std::function.
+ */
+
+// Максимальный размер пакета для пакетных обработчиков
+constexpr size_t HANDLER_BATCH_SIZE = 32;
+
+template<typename Handler>
+concept MessageHandler = std::invocable<Handler&, Message&>;
+
+template<typename Handler>
+concept BatchHandler = std::invocable<Handler&, std::span<Message>>;
+
+/**
+ * Пакетный обработчик только для чтения: void(std::span<const Message>)
+ * Такому обработчику сообщения multicast передаются прямо в кольце, без копирования
+ */
+template<typename Handler>
+concept ReadOnlyBatchHandler = std::invocable<Handler&, std::span<const Message>>
+    && std::is_void_v<std::invoke_result_t<Handler&, std::span<const Message>>>;
+
+/**
+ * Вызов обработчика для одного сообщения
+ * @return false если сообщение отклонено
+ */
+template<MessageHandler Handler>
+inline bool invoke_handler(Handler& handler, Message& msg) {
+    if constexpr (std::is_void_v<std::invoke_result_t<Handler&, Message&>>) {
+        handler(msg);
+        return true;
+    } else {
+        return static_cast<bool>(handler(msg));
+    }
+}
+
+/**
+ * Вызов обработчика для пакета; обработчик без пакетного варианта вызывается
+ * для каждого сообщения, отклоненные сообщения удаляются со сжатием пакета
+ * @return количество оставшихся сообщений (в начале пакета)
+ */
+template<typename Handler>
+inline size_t invoke_handler_batch(Handler& handler, std::span<Message> batch) {
+    if constexpr (BatchHandler<Handler>) {
+        if constexpr (std::is_void_v<std::invoke_result_t<Handler&, std::span<Message>>>) {
+            handler(batch);
+            return batch.size();
+        } else {
+            return static_cast<size_t>(handler(batch));
+        }
+    } else {
+        size_t kept = 0;
+        for (size_t i = 0; i < batch.size(); ++i) {
+            if (invoke_handler(handler, batch[i])) {
+                if (kept != i) {
+                    batch[kept] = batch[i];
+                }
+                ++kept;
+            }
+        }
+        return kept;
+    }
+}
+
+/**
+ * Пустой обработчик (пропускает сообщение без изменений)
+ */
+struct PassThrough {
+    void operator()(Message&) const noexcept {}
+};
+
+/**
+ * Имитация работы активным ожиданием (поведение компонентов по умолчанию)
+ */
+class SimulatedWork {
+public:
+    SimulatedWork() = default;
+
+    /**
+     * Время по типам сообщений; для типов без записи - default_ns
+     */
+    SimulatedWork(const std::unordered_map<uint8_t, uint64_t>& times_ns, uint64_t default_ns) {
+        times_ns_.fill(default_ns);
+        for (const auto& [type, ns] : times_ns) {
+            times_ns_[type] = ns;
+        }
+    }
+
+    /**
+     * Одинаковое время для всех типов
+     */
+    explicit SimulatedWork(uint64_t ns) { times_ns_.fill(ns); }
+
+    void operator()(Message& msg) const {
+        uint64_t ns = times_ns_[msg.msg_type];
+        if (ns > 0) {
+            Timer::busy_wait_ns(ns);
+        }
+    }
+
+private:
+    std::array<uint64_t, 256> times_ns_{};
+};
+
+/**
+ * HandlerChain - цепочка обработчиков (например decode -> enrich -> validate)
+ *
+ * Для одного сообщения обработчики вызываются по порядку до первого отказа.
+ * Для пакета каждый этап применяется ко всему пакету, после чего следующий
+ * этап видит только оставшиеся сообщения.
+ */
+template<typename... Handlers>
+class HandlerChain {
+public:
+    HandlerChain() = default;
+    explicit HandlerChain(Handlers... handlers) : handlers_(std::move(handlers)...) {}
+
+    bool operator()(Message& msg) {
+        return std::apply([&msg](auto&... handler) {
+            return (invoke_handler(handler, msg) && ...);
+        }, handlers_);
+    }
+
+    size_t operator()(std::span<Message> batch) {
+        size_t kept = batch.size();
+        std::apply([&](auto&... handler) {
+            ((kept = kept > 0 ? invoke_handler_batch(handler, batch.first(kept)) : 0), ...);
+        }, handlers_);
+        return kept;
+    }
+
+private:
+    std::tuple<Handlers...> handlers_;
+};
+
+template<typename... Handlers>
+HandlerChain<std::decay_t<Handlers>...> make_chain(Handlers&&... handlers) {
+    return HandlerChain<std::decay_t<Handlers>...>(std::forward<Handlers>(handlers)...);
+}
+
+/**
+ * Обработчик для конкретного типа сообщения (элемент TypeDispatch)
+ */
+template<uint8_t Type, typename Handler>
+struct OnType {
+    static constexpr uint8_t msg_type = Type;
+    Handler handler;
+};
+
+template<uint8_t Type, typename Handler>
+OnType<Type, std::decay_t<Handler>> on_type(Handler&& handler) {
+    return {std::forward<Handler>(handler)};
+}
+
+/**
+ * TypeDispatch - выбор обработчика по msg_type, типы заданы параметрами шаблона
+ * Сравнения с константами разворачиваются компилятором в цепочку ветвлений
+ * или таблицу переходов; сообщения прочих типов получает fallback
+ */
+template<typename Fallback, typename... Entries>
+class TypeDispatch {
+public:
+    TypeDispatch() = default;
+    explicit TypeDispatch(Fallback fallback, Entries... entries)
+        : fallback_(std::move(fallback)), entries_(std::move(entries)...) {}
+
+    bool operator()(Message& msg) {
+        bool accepted = true;
+        const bool matched = std::apply([&](auto&... entry) {
+            return ((msg.msg_type == std::decay_t<decltype(entry)>::msg_type &&
+                     (accepted = invoke_handler(entry.handler, msg), true)) || ...);
+        }, entries_);
+        return matched ? accepted : invoke_handler(fallback_, msg);
+    }
+
+private:
+    Fallback fallback_;
+    std::tuple<Entries...> entries_;
+};
+
+template<typename Fallback, typename... Entries>
+TypeDispatch<std::decay_t<Fallback>, std::decay_t<Entries>...> dispatch_by_type(
+    Fallback&& fallback, Entries&&... entries) {
+    return TypeDispatch<std::decay_t<Fallback>, std::decay_t<Entries>...>(
+        std::forward<Fallback>(fallback), std::forward<Entries>(entries)...);
+}
+
+/**
+ * HandlerTable - таблица обработчиков по msg_type на std::variant
+ * Набор типов обработчиков фиксирован при компиляции, а назначение
+ * типам сообщений задается во время выполнения (например из конфигурации).
+ * Незаданные типы обрабатываются PassThrough.
+ */
+template<typename... Handlers>
+class HandlerTable {
+public:
+    using Entry = std::variant<PassThrough, Handlers...>;
+
+    void set(uint8_t msg_type, Entry entry) { table_[msg_type] = std::move(entry); }
+
+    bool operator()(Message& msg) {
+        return std::visit([&msg](auto& handler) {
+            return invoke_handler(handler, msg);
+        }, table_[msg.msg_type]);
+    }
+
+private:
+    std::array<Entry, 256> table_{};
+};
@@ -0,0 +1,157 @@
+#pragma once
+
+#include "message.hpp"
+#include "config.hpp"
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+constexpr uint64_t JOURNAL_MAGIC = 0x4C4E524A52544F52ULL; // "ROTRJRNL"
+constexpr uint32_t JOURNAL_VERSION = 2;  // 2: Message::routing_key
+constexpr size_t JOURNAL_HEADER_SIZE = 4096;
+
+/**
+ * Запись журнала: сообщение, полученное стратегией
+ * Флаг committed публикуется последним (release), поэтому читатель
+ * видит только полностью записанные записи
+ */
+struct alignas(64) JournalRecord {
+    std::atomic<uint32_t> committed;    // 1 после записи всех полей
+    uint8_t strategy_id;                // Стратегия-получатель
+    uint64_t receive_ns;                // Время получения стратегией
+    Message msg;                        // Сообщение в момент доставки
+};
+
+/**
+ * Заголовок файла сегмента (первая страница файла)
+ */
+struct JournalSegmentHeader {
+    uint64_t magic;
+    uint32_t version;
+    uint32_t record_size;               // sizeof(JournalRecord)
+    uint64_t segment_index;             // Номер сегмента
+    uint64_t records_per_segment;       // Вместимость сегмента
+    uint64_t first_record;              // Глобальный номер первой записи
+};
+
+/**
+ * JournalWriter - append-only журнал в предвыделенных mmap сегментах
+ *
+ * Горячий путь append():
+ * - резервирование слота через fetch_add (lock-free, несколько стратегий-писателей)
+ * - копирование записи в отображенную память, без системных вызовов
+ *
+ * Поток журнала run() заранее создает и отображает следующие сегменты,
+ * отслеживает непрерывный префикс записанных записей, синхронизирует его
+ * с диском согласно политике и закрывает заполненные сегменты.
+ */
+class JournalWriter {
+public:
+    explicit JournalWriter(const JournalConfig& config);
+    ~JournalWriter();
+
+    JournalWriter(const JournalWriter&) = delete;
+    JournalWriter& operator=(const JournalWriter&) = delete;
+
+    /**
+     * Добавление записи (вызывается стратегиями, потокобезопасно)
+     */
+    void append(const Message& msg, uint8_t strategy_id) noexcept;
+
+    /**
+     * Основной цикл потока журнала (запускается в отдельном потоке)
+     * После остановки выполняет финальную синхронизацию
+     */
+    void run(std::atomic<bool>& running);
+
+    /**
+     * Количество записей, сброшенных на диск (или в page cache при политике None)
+     */
+    uint64_t records_committed() const { return committed_records_.load(std::memory_order_relaxed); }
+
+    /**
+     * Вывод итогового отчета о журнале
+     */
+    void print_report(double duration_secs) const;
+
+private:
+    // Отображенный сегмент; слоты кольца переиспользуются, объекты не удаляются
+    struct Segment {
+        std::atomic<uint64_t> ready_index{0};  // Номер сегмента + 1, 0 - слот свободен
+        int fd = -1;
+        void* base = nullptr;
+        size_t size = 0;
+        JournalRecord* records = nullptr;
+    };
+
+    static constexpr size_t SEGMENT_RING = 4;
+
+    JournalConfig config_;
+    size_t segment_bytes_;
+
+    // Счетчик резервирования (пишут все стратегии)
+    alignas(64) std::atomic<uint64_t> next_record_{0};
+
+    // Кольцо отображенных сегментов
+    alignas(64) std::array<Segment, SEGMENT_RING> segments_;
+
+    // Состояние потока журнала
+    uint64_t committed_prefix_ = 0;     // Непрерывный префикс записанных записей
+    uint64_t synced_prefix_ = 0;        // Префикс, сброшенный на диск
+    uint64_t mapped_segments_ = 0;      // Количество созданных сегментов
+    uint64_t retired_segments_ = 0;     // Количество закрытых сегментов
+    uint64_t last_sync_ns_ = 0;
+
+    // Счетчики для отчета
+    std::atomic<uint64_t> committed_records_{0};
+    std::atomic<uint64_t> sync_calls_{0};
+    std::atomic<uint64_t> writer_stalls_{0};
+
+    void open_segment(uint64_t index);
+    void retire_segment(Segment& segment);
+    void sync_range(uint64_t from, uint64_t to);
+    void step(bool force_sync);
+};
+
+/**
+ * JournalReader - чтение журнала с индексным доступом к записям
+ *
+ * Записи имеют фиксированный размер, поэтому глобальный номер записи
+ * однозначно задает сегмент и смещение: доступ к любой записи O(1).
+ */
+class JournalReader {
+public:
+    explicit JournalReader(const std::string& directory);
+    ~JournalReader();
+
+    JournalReader(const JournalReader&) = delete;
+    JournalReader& operator=(const JournalReader&) = delete;
+
+    /**
+     * Количество полностью записанных записей (непрерывный префикс)
+     */
+    uint64_t size() const { return size_; }
+
+    /**
+     * Запись по глобальному номеру
+     */
+    const JournalRecord& record(uint64_t index) const {
+        const auto& segment = segments_[index / records_per_segment_];
+        return segment.records[index % records_per_segment_];
+    }
+
+    size_t segment_count() const { return segments_.size(); }
+
+private:
+    struct MappedSegment {
+        void* base;
+        size_t size;
+        const JournalRecord* records;
+    };
+
+    std::vector<MappedSegment> segments_;
+    uint64_t records_per_segment_ = 1;
+    uint64_t size_ = 0;
+};
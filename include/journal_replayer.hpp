@@ -0,0 +1,42 @@
+#pragma once
+
+#include "message.hpp"
+#include "config.hpp"
+#include "spsc_queue.hpp"
+#include "statistics.hpp"
+#include "producer.hpp"
+#include <atomic>
+#include <memory>
+#include <vector>
+
+/**
+ * JournalReplayer - воспроизведение журнала вместо производителей
+ *
+ * Читает записи журнала по порядку и отправляет сообщения в очереди
+ * производителей (по producer_id), сохраняя порядок внутри каждого производителя.
+ * Темп задается интервалами между receive_ns записей, деленными на speed;
+ * при speed = 0 сообщения отправляются без пауз.
+ */
+class JournalReplayer {
+public:
+    using OutputQueue = SPSCQueue<Message, PRODUCER_QUEUE_SIZE>;
+
+    JournalReplayer(
+        const ReplayConfig& config,
+        std::vector<std::shared_ptr<OutputQueue>>& output_queues,
+        SystemStatistics& stats
+    );
+
+    /**
+     * Основной цикл воспроизведения (запускается в отдельном потоке)
+     */
+    void run(std::atomic<bool>& running);
+
+    uint64_t messages_replayed() const { return replayed_.load(std::memory_order_relaxed); }
+
+private:
+    ReplayConfig config_;
+    std::vector<std::shared_ptr<OutputQueue>>& output_queues_;
+    SystemStatistics& stats_;
+    std::atomic<uint64_t> replayed_{0};
+};
@@ -0,0 +1,123 @@
+#pragma once
+
+#include "config.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// Пространство явных ключей до этого размера (и плотностью от 1/4) хранится плотным массивом
+constexpr size_t KEY_DENSE_SPAN_LIMIT = 1 << 24;
+
+// Максимум явных ключей (range + set) во всех правилах одной стадии
+constexpr size_t KEY_EXPLICIT_LIMIT = 1 << 24;
+
+/**
+ * KeyRouteMap - скомпилированные правила маршрутизации по routing_key
+ *
+ * Ключи правил range/set раскрываются при компиляции (первое совпавшее правило
+ * побеждает, с учетом hash-правил выше по списку) и хранятся в одном из видов:
+ * - плотный массив получателей по ключу - min_key, если ключи компактны;
+ * - perfect hash (CHD, hash and displace): смещение корзины и слот {ключ, получатель},
+ *   два обращения к памяти на поиск при любом числе ключей.
+ * Ключи без явной записи проверяются hash-правилами по порядку, затем ключ по модулю
+ * числа получателей. Структура неизменяемая, поиск из любого числа потоков.
+ */
+class KeyRouteMap {
+public:
+    static constexpr uint8_t NO_TARGET = 0xFF;
+
+    KeyRouteMap(const std::vector<KeyRule>& rules, size_t default_targets);
+
+    uint8_t lookup(uint32_t key) const noexcept {
+        uint8_t target = NO_TARGET;
+        if (!dense_.empty()) {
+            const uint32_t index = key - dense_base_;
+            if (index < dense_.size()) {
+                target = dense_[index];
+            }
+        } else if (!slots_.empty()) {
+            const uint32_t bucket = fast_range(hash(key, BUCKET_SEED), displacements_.size());
+            const Slot& slot = slots_[fast_range(hash(key, displacements_[bucket]), slots_.size())];
+            if (slot.key == key) {
+                target = slot.target;
+            }
+        }
+        if (target != NO_TARGET) {
+            return target;
+        }
+
+        for (const HashRule& rule : hash_rules_) {
+            if (rule.residues[hash(key, PARTITION_SEED) % rule.residues.size()]) {
+                return pick(rule.targets, key);
+            }
+        }
+        return static_cast<uint8_t>(key % default_targets_);
+    }
+
+    /**
+     * Количество явных ключей и вид хранения (для отчета и бенчмарка)
+     */
+    size_t explicit_keys() const noexcept { return explicit_keys_; }
+    bool dense() const noexcept { return !dense_.empty(); }
+    size_t memory_bytes() const noexcept {
+        return dense_.size() + slots_.size() * sizeof(Slot) + displacements_.size() * sizeof(uint32_t);
+    }
+
+    /**
+     * Получатель правила для ключа: разделение по hash ключа (стабильно для ключа)
+     */
+    static uint8_t pick(const std::vector<uint8_t>& targets, uint32_t key) noexcept {
+        return targets.size() == 1 ? targets[0] : targets[fast_range(hash(key, TARGET_SEED), targets.size())];
+    }
+
+    /**
+     * 32-битное перемешивание ключа с зерном (финализатор splitmix64)
+     */
+    static uint32_t hash(uint32_t key, uint32_t seed) noexcept {
+        uint64_t h = (static_cast<uint64_t>(seed) << 32 | key) * 0x9E3779B97F4A7C15ULL;
+        h ^= h >> 31;
+        h *= 0xBF58476D1CE4E5B9ULL;
+        h ^= h >> 29;
+        return static_cast<uint32_t>(h);
+    }
+
+private:
+    static constexpr uint32_t BUCKET_SEED = 0xB5297A4D;
+    static constexpr uint32_t PARTITION_SEED = 0x68E31DA4;
+    static constexpr uint32_t TARGET_SEED = 0x1B56C4E9;
+
+    struct Slot {
+        uint32_t key = 0;
+        uint8_t target = NO_TARGET;
+    };
+
+    struct HashRule {
+        std::vector<bool> residues;            // Разделы правила (размер - modulus)
+        std::vector<uint8_t> targets;
+    };
+
+    // Отображение hash в [0, n) без деления
+    static uint32_t fast_range(uint32_t h, size_t n) noexcept {
+        return static_cast<uint32_t>((static_cast<uint64_t>(h) * n) >> 32);
+    }
+
+    size_t default_targets_;
+    size_t explicit_keys_ = 0;
+    std::vector<HashRule> hash_rules_;
+
+    // Плотный вид
+    uint32_t dense_base_ = 0;
+    std::vector<uint8_t> dense_;
+
+    // Perfect hash: смещение (зерно) корзины и слоты
+    std::vector<uint32_t> displacements_;
+    std::vector<Slot> slots_;
+
+    void build_perfect_hash(const std::vector<std::pair<uint32_t, uint8_t>>& entries);
+};
+
+/**
+ * Компиляция правил стадии (nullptr - правил по ключу нет, маршрутизация по типу)
+ */
+std::shared_ptr<const KeyRouteMap> compile_key_routes(const std::vector<KeyRule>& rules, size_t targets);
@@ -9,8 +9,9 @@
  */
 struct Message {
     // Основные поля (устанавливаются Producer'ом)
-    uint8_t msg_type;           // Тип сообщения (0-7)
+    uint8_t msg_type;           // Тип сообщения (0-255)
     uint8_t producer_id;        // ID производителя
+    uint32_t routing_key;       // Ключ маршрутизации (инструмент), по умолчанию равен типу
     uint64_t sequence_number;   // Порядковый номер от производителя
     uint64_t timestamp_ns;      // Временная метка создания (наносекунды)
 
@@ -25,10 +26,12 @@ struct Message {
     uint64_t processing_exit_ns;  // Время выхода из Processor
     uint64_t stage2_entry_ns;   // Время входа в Stage2 Router
     uint64_t stage2_exit_ns;    // Время выхода из Stage2 Router
+    uint64_t strategy_entry_ns; // Время получения стратегией
 
     Message()
         : msg_type(0)
         , producer_id(0)
+        , routing_key(0)
         , sequence_number(0)
         , timestamp_ns(0)
         , processor_id(0)
@@ -39,6 +42,7 @@ struct Message {
         , processing_exit_ns(0)
         , stage2_entry_ns(0)
         , stage2_exit_ns(0)
+        , strategy_entry_ns(0)
     {}
 
     /**
@@ -48,6 +52,7 @@ struct Message {
         Message msg;
         msg.msg_type = type;
         msg.producer_id = producer_id;
+        msg.routing_key = type;
         msg.sequence_number = seq_num;
         msg.timestamp_ns = get_timestamp_ns();
         return msg;
@@ -103,8 +108,67 @@ struct Message {
         }
         return 0.0;
     }
+
+    /**
+     * Ожидание в очереди стратегии до получения (микросекунды)
+     */
+    double delivery_latency_us() const {
+        if (strategy_entry_ns > stage2_exit_ns) {
+            return static_cast<double>(strategy_entry_ns - stage2_exit_ns) / 1000.0;
+        }
+        return 0.0;
+    }
+
+    /**
+     * Время в очереди producer -> Stage1 от создания (микросекунды)
+     * Включает ожидание производителя при полной очереди
+     */
+    double producer_queue_dwell_us() const {
+        if (stage1_entry_ns > timestamp_ns) {
+            return static_cast<double>(stage1_entry_ns - timestamp_ns) / 1000.0;
+        }
+        return 0.0;
+    }
+
+    /**
+     * Время в очереди Stage1 -> Processor (микросекунды)
+     */
+    double processor_queue_dwell_us() const {
+        if (processing_entry_ns > stage1_exit_ns) {
+            return static_cast<double>(processing_entry_ns - stage1_exit_ns) / 1000.0;
+        }
+        return 0.0;
+    }
+
+    /**
+     * Время в очереди Processor -> Stage2 (микросекунды)
+     * Включает ожидание процессора при полной очереди
+     */
+    double stage2_queue_dwell_us() const {
+        if (stage2_entry_ns > processing_exit_ns) {
+            return static_cast<double>(stage2_entry_ns - processing_exit_ns) / 1000.0;
+        }
+        return 0.0;
+    }
+
+    /**
+     * Задержка от создания до получения стратегией (микросекунды)
+     * Сумма времени всех этапов и всех четырех очередей
+     */
+    double delivered_latency_us() const {
+        if (strategy_entry_ns > timestamp_ns) {
+            return static_cast<double>(strategy_entry_ns - timestamp_ns) / 1000.0;
+        }
+        return 0.0;
+    }
 };
 
 // Проверка, что Message является trivially copyable для использования в lock-free очередях
 static_assert(std::is_trivially_copyable_v<Message>,
               "Message должен быть trivially copyable");
+
+/**
+ * Сообщение элемента пакета: сам элемент или указатель на слот общего кольца
+ */
+inline const Message& batch_message(const Message& msg) { return msg; }
+inline const Message& batch_message(const Message* msg) { return *msg; }
@@ -2,8 +2,10 @@
 
 #include <atomic>
 #include <cstddef>
+#include <cstdint>
 #include <memory>
 #include <new>
+#include <type_traits>
 
 constexpr size_t CACHE_LINE = 64;
 
@@ -90,3 +92,114 @@ private:
     // Tail используется только consumer'ом, отдельная cache line
     alignas(CACHE_LINE) Node* tail_;
 };
+
+/**
+ * Ограниченная lock-free MPSC очередь на кольцевом буфере (схема Вьюкова)
+ *
+ * Особенности:
+ * - Без динамических выделений: все ячейки внутри объекта,
+ *   поэтому очередь можно разместить в разделяемой памяти (placement new)
+ * - Каждая ячейка хранит sequence, по которому производители резервируют слот
+ * - Производители конкурируют только за enqueue_pos_ (CAS)
+ */
+template<typename T, size_t Capacity>
+class BoundedMPSCQueue {
+    static_assert((Capacity & (Capacity - 1)) == 0,
+                  "Capacity должна быть степенью двойки");
+    static_assert(std::is_trivially_copyable_v<T>,
+                  "T должен быть trivially copyable");
+
+    struct Cell {
+        std::atomic<size_t> sequence;
+        T data;
+    };
+
+public:
+    BoundedMPSCQueue() : enqueue_pos_(0), dequeue_pos_(0) {
+        for (size_t i = 0; i < Capacity; ++i) {
+            cells_[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    BoundedMPSCQueue(const BoundedMPSCQueue&) = delete;
+    BoundedMPSCQueue& operator=(const BoundedMPSCQueue&) = delete;
+
+    /**
+     * Попытка добавить элемент (может вызываться из множества потоков/процессов)
+     *
+     * Memory ordering:
+     * - sequence.load: acquire - ячейка освобождена consumer'ом
+     * - enqueue_pos_ CAS: relaxed - резервирование слота, данные публикуются через sequence
+     * - sequence.store: release - публикация элемента для consumer
+     *
+     * @return true если успешно добавлен, false если очередь полная
+     */
+    bool try_push(const T& item) noexcept {
+        size_t pos = enqueue_pos_.load(std::memory_order_relaxed);
+        Cell* cell;
+
+        while (true) {
+            cell = &cells_[pos & (Capacity - 1)];
+            const size_t seq = cell->sequence.load(std::memory_order_acquire);
+            const intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+
+            if (diff == 0) {
+                if (enqueue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (diff < 0) {
+                return false; // Очередь полная
+            } else {
+                pos = enqueue_pos_.load(std::memory_order_relaxed);
+            }
+        }
+
+        cell->data = item;
+        cell->sequence.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * Попытка извлечь элемент (только один поток-consumer)
+     * @return true если успешно извлечен, false если очередь пустая
+     */
+    bool try_pop(T& item) noexcept {
+        const size_t pos = dequeue_pos_.load(std::memory_order_relaxed);
+        Cell& cell = cells_[pos & (Capacity - 1)];
+
+        if (cell.sequence.load(std::memory_order_acquire) != pos + 1) {
+            return false; // Очередь пустая (или запись еще не опубликована)
+        }
+
+        item = cell.data;
+        cell.sequence.store(pos + Capacity, std::memory_order_release);
+        dequeue_pos_.store(pos + 1, std::memory_order_relaxed);
+        return true;
+    }
+
+    /**
+     * Проверка, пуста ли очередь
+     * Внимание: результат может быть неактуальным в многопоточной среде
+     */
+    bool empty() const noexcept {
+        return size() == 0;
+    }
+
+    /**
+     * Приблизительный размер очереди (включая зарезервированные, но не опубликованные слоты)
+     */
+    size_t size() const noexcept {
+        const size_t d = dequeue_pos_.load(std::memory_order_relaxed);
+        const size_t e = enqueue_pos_.load(std::memory_order_relaxed);
+        return (e >= d) ? (e - d) : 0;
+    }
+
+    static constexpr size_t capacity() noexcept {
+        return Capacity;
+    }
+
+private:
+    alignas(CACHE_LINE) std::atomic<size_t> enqueue_pos_;
+    alignas(CACHE_LINE) std::atomic<size_t> dequeue_pos_;
+    alignas(CACHE_LINE) Cell cells_[Capacity];
+};
@@ -0,0 +1,127 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+/**
+ * События аппаратных и программных счетчиков (perf_event_open)
+ */
+enum PerfEvent : size_t {
+    PERF_CYCLES = 0,
+    PERF_INSTRUCTIONS,
+    PERF_L1D_MISSES,
+    PERF_LLC_MISSES,
+    PERF_BRANCH_MISSES,
+    PERF_CONTEXT_SWITCHES,
+    PERF_EVENT_COUNT
+};
+
+/**
+ * Имя события в отчетах и счетчиках бенчмарков ("cycles", "llc_misses", ...)
+ */
+const char* perf_event_name(PerfEvent event);
+
+/**
+ * Значения счетчиков; valid[i] = false, если событие не удалось открыть
+ * Значения масштабированы с учетом мультиплексирования (time_enabled / time_running)
+ */
+struct PerfCounts {
+    std::array<uint64_t, PERF_EVENT_COUNT> values{};
+    std::array<bool, PERF_EVENT_COUNT> valid{};
+
+    PerfCounts& operator+=(const PerfCounts& other);
+    PerfCounts operator-(const PerfCounts& other) const;
+
+    bool any_valid() const;
+};
+
+/**
+ * PerfCounterGroup - счетчики одного потока
+ *
+ * Аппаратные события открываются одной группой (лидер - cycles), чтобы ядро
+ * планировало их на PMU одновременно и отношения вроде IPC были согласованы.
+ * Переключения контекста - программное событие, открывается отдельно.
+ * События, которые не удалось открыть (нет PMU в виртуальной машине,
+ * perf_event_paranoid, seccomp в контейнере), пропускаются.
+ */
+class PerfCounterGroup {
+public:
+    PerfCounterGroup();
+    ~PerfCounterGroup();
+
+    PerfCounterGroup(const PerfCounterGroup&) = delete;
+    PerfCounterGroup& operator=(const PerfCounterGroup&) = delete;
+
+    /**
+     * Открытие счетчиков для вызывающего потока; счет начинается сразу
+     * @param include_kernel считать ли события в режиме ядра
+     * @return true если открыто хотя бы одно событие
+     */
+    bool open(bool include_kernel = false);
+
+    /**
+     * Текущие значения (можно вызывать из любого потока, в том числе
+     * после завершения потока-владельца счетчиков)
+     */
+    PerfCounts read() const;
+
+    /**
+     * Причина недоступности событий (errno первого неудачного открытия)
+     */
+    const std::string& error() const { return error_; }
+
+private:
+    int leader_fd_ = -1;
+    std::array<int, PERF_EVENT_COUNT> fds_;
+    std::array<uint64_t, PERF_EVENT_COUNT> ids_{};
+    std::string error_;
+
+    void close_all();
+};
+
+/**
+ * PerfStageCounters - счетчики потоков конвейера, сгруппированные по стадиям
+ *
+ * Каждый поток компонента при старте вызывает attach_current_thread(stage);
+ * группы остаются открытыми до уничтожения объекта, поэтому snapshot() дает
+ * накопленные значения и во время работы, и после остановки потоков.
+ */
+class PerfStageCounters {
+public:
+    explicit PerfStageCounters(bool include_kernel);
+
+    /**
+     * Открытие счетчиков вызывающего потока и регистрация в стадии
+     */
+    void attach_current_thread(const std::string& stage);
+
+    /**
+     * Суммарные значения по стадиям
+     */
+    std::map<std::string, PerfCounts> snapshot() const;
+
+    /**
+     * Суммарные значения по всем стадиям
+     */
+    PerfCounts total() const;
+
+    /**
+     * Вывод отчета по стадиям: абсолютные значения, IPC и нормировка
+     * на миллион сообщений, прошедших через стадию
+     * @param stage_order порядок стадий в таблице
+     * @param messages сообщений, прошедших через каждую стадию
+     */
+    void print_report(const std::vector<std::string>& stage_order,
+                      const std::map<std::string, uint64_t>& messages) const;
+
+private:
+    bool include_kernel_;
+    mutable std::mutex mutex_;
+    std::vector<std::pair<std::string, std::unique_ptr<PerfCounterGroup>>> groups_;
+    std::string error_;                 // Первая причина недоступности событий
+};
@@ -0,0 +1,193 @@
+#pragma once
+
+#include "config.hpp"
+#include "message.hpp"
+#include "statistics.hpp"
+#include "producer.hpp"
+#include "processor.hpp"
+#include "strategy.hpp"
+#include "router.hpp"
+#include "elastic_controller.hpp"
+#include "stall_watchdog.hpp"
+#include "queue_arena.hpp"
+#include "shm_queue.hpp"
+#include "journal.hpp"
+#include "journal_replayer.hpp"
+#include "coro_runtime.hpp"
+#include "queue_sampler.hpp"
+#include "perf_counters.hpp"
+#include "ring_pipeline.hpp"
+#include "fused_pipeline.hpp"
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * Pipeline - конвейер producers -> Stage1 -> processors -> Stage2 -> strategies,
+ * собранный по SystemConfig: очереди, компоненты и их потоки (или планировщики корутин)
+ *
+ * В режиме runtime.transport = shared_ring очереди сообщений заменяет RingPipeline:
+ * общие кольца производителей и очереди ссылок на слоты; в режиме runtime.topology = fused
+ * потоки роутеров и их очереди заменяет FusedPipeline с маршрутизацией в производителях и процессорах.
+ *
+ * Используется приложением и бенчмарками, чтобы измерялся тот же код, что работает в бою.
+ * Остановка в два шага: сначала производители, затем, после дренирования очередей,
+ * остальные компоненты - сообщения, извлеченные из очередей, не теряются.
+ */
+class Pipeline {
+public:
+    using ProducerQueue = SPSCQueue<Message, PRODUCER_QUEUE_SIZE>;
+    using ProcessorQueue = SPSCQueue<Message, PROCESSOR_QUEUE_SIZE>;
+    using StrategyQueue = SPSCQueue<Message, STRATEGY_QUEUE_SIZE>;
+    using ShmProducerQueues = ShmQueueSet<ProducerQueue>;
+    using MulticastRing = BroadcastRing<Message, MULTICAST_RING_SIZE>;
+
+    explicit Pipeline(const SystemConfig& config);
+    ~Pipeline();
+
+    Pipeline(const Pipeline&) = delete;
+    Pipeline& operator=(const Pipeline&) = delete;
+
+    /**
+     * Запуск потоков всех компонентов
+     */
+    void start();
+
+    /**
+     * Остановка производителей (и воспроизведения журнала); остальные компоненты
+     * продолжают дренировать очереди
+     */
+    void stop_producers();
+
+    /**
+     * Все произведенные сообщения доставлены или отклонены,
+     * а кольца multicast дочитаны всеми получателями
+     */
+    bool drained();
+
+    /**
+     * Ожидание дренирования очередей после stop_producers()
+     * @return true если все сообщения доставлены до истечения таймаута
+     */
+    bool drain(std::chrono::milliseconds timeout);
+
+    /**
+     * Остановка и join всех потоков; журнал останавливается последним,
+     * чтобы финальная синхронизация включала все доставленные сообщения
+     */
+    void stop();
+
+    /**
+     * Обновление глубин очередей в статистике (вызывается из мониторинга)
+     */
+    void update_queue_depths();
+
+    /**
+     * Учет сообщений внешних производителей (процессы shm_producer)
+     * Счетчики отправленных сообщений читаются из слотов участников в shm
+     * @return количество внешних производителей, признанных живыми
+     */
+    uint32_t sync_shm_producers();
+
+    /**
+     * Текущее состояние компонентов с собственной статистикой (вызывается из мониторинга)
+     */
+    void print_current_state();
+
+    /**
+     * Отчеты компонентов после остановки (масштабирование, журнал, планировщики и т.д.)
+     */
+    void print_reports(double duration_secs) const;
+
+    /**
+     * Сообщений, прошедших через каждую стадию (для нормировки счетчиков perf)
+     */
+    std::map<std::string, uint64_t> stage_messages() const;
+
+    /**
+     * Счетчики perf по стадиям (nullptr, если perf_counters выключены)
+     */
+    const PerfStageCounters* perf_counters() const { return perf_counters_.get(); }
+
+    /**
+     * Байт, копируемых транспортом на доставленное сообщение (запись и чтение копий)
+     */
+    size_t transport_bytes_per_message() const;
+
+    /**
+     * Время создания очередей конвейера с prefault, наносекунды (0 для shared_ring и fused)
+     */
+    uint64_t queue_setup_ns() const { return queue_setup_ns_; }
+
+    SystemStatistics& stats() { return stats_; }
+    const SystemConfig& config() const { return config_; }
+
+private:
+    SystemConfig config_;
+    SystemStatistics stats_;
+
+    // Раздельные флаги: производители останавливаются раньше остальных компонентов
+    std::atomic<bool> producers_running_{true};
+    std::atomic<bool> running_{true};
+    std::atomic<bool> journal_running_{true};
+
+    // Очереди
+    std::shared_ptr<QueueArena> queue_arena_;
+    uint64_t queue_setup_ns_ = 0;
+    std::shared_ptr<ShmProducerQueues> shm_queues_;
+    std::vector<uint64_t> shm_seen_pushed_;
+    std::vector<std::shared_ptr<ProducerQueue>> producer_queues_;
+    std::vector<std::shared_ptr<ProcessorQueue>> stage1_to_processor_queues_;
+    std::vector<std::shared_ptr<ProcessorQueue>> processor_to_stage2_queues_;
+    std::vector<std::shared_ptr<StrategyQueue>> stage2_to_strategy_queues_;
+    std::vector<std::shared_ptr<MulticastRing>> multicast_rings_;
+
+    // Компоненты
+    std::vector<std::unique_ptr<Producer>> producers_;
+    std::unique_ptr<JournalReplayer> replayer_;
+    std::vector<std::unique_ptr<Processor>> processors_;
+    std::vector<std::unique_ptr<Strategy>> strategies_;
+    std::unique_ptr<JournalWriter> journal_;
+    std::unique_ptr<Stage1Router> stage1_router_;
+    std::unique_ptr<AdmissionControl> admission_;
+    std::unique_ptr<Stage2Router> stage2_router_;
+    std::unique_ptr<ElasticController> elastic_controller_;
+    std::unique_ptr<StallWatchdog> watchdog_;
+    std::unique_ptr<RingPipeline> ring_;
+    std::unique_ptr<FusedPipeline> fused_;
+    std::unique_ptr<QueueSampler> queue_sampler_;
+    std::unique_ptr<PerfStageCounters> perf_counters_;
+    std::vector<std::unique_ptr<CoroScheduler>> schedulers_;
+
+    std::vector<std::thread> threads_;
+    std::thread journal_thread_;
+
+    /**
+     * Запуск потока компонента; при включенных perf_counters поток
+     * открывает свои счетчики и регистрирует их в стадии stage
+     */
+    template<typename Body>
+    void spawn(const char* stage, Body body);
+
+    /**
+     * Очередь в арене queue_memory или в куче (backing = heap)
+     */
+    template<typename Queue>
+    std::shared_ptr<Queue> make_queue(int consumer_core) {
+        return queue_arena_ ? queue_arena_->make<Queue>(consumer_core) : std::make_shared<Queue>();
+    }
+
+    void start_threads();
+    void start_coroutines();
+    void start_shared_ring();
+    void start_fused();
+
+    /**
+     * Отчет адаптивных пакетов по компонентам
+     */
+    void print_batching_report() const;
+};
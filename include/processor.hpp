@@ -4,14 +4,23 @@
 #include "config.hpp"
 #include "spsc_queue.hpp"
 #include "statistics.hpp"
+#include "coro_runtime.hpp"
+#include "handlers.hpp"
+#include "flight_recorder.hpp"
+#include "adaptive_batch.hpp"
+#include <array>
 #include <atomic>
 #include <memory>
-#include <unordered_map>
+#include <span>
+#include <vector>
 
 constexpr size_t PROCESSOR_QUEUE_SIZE = 65536;
 
 /**
  * Processor - обрабатывает сообщения с имитацией времени обработки
+ *
+ * Логика обработки подключается обработчиком (см. handlers.hpp) через run_with;
+ * run() использует SimulatedWork со временем обработки из конфигурации.
  */
 class Processor {
 public:
@@ -31,17 +40,204 @@ public:
      */
     void run(std::atomic<bool>& running);
 
+    /**
+     * Основной цикл с пользовательским обработчиком
+     * Пакетный обработчик получает до HANDLER_BATCH_SIZE сообщений за вызов,
+     * отклоненные обработчиком сообщения учитываются в счетчике Rejected
+     */
+    template<typename Handler>
+    void run_with(std::atomic<bool>& running, Handler handler);
+
+    /**
+     * Основной цикл процессора в виде корутины (режим runtime.mode = coroutines)
+     */
+    CoroTask run_coro(CoroScheduler& scheduler, std::atomic<bool>& running);
+
+    template<typename Handler>
+    CoroTask run_coro_with(CoroScheduler& scheduler, std::atomic<bool>& running, Handler handler);
+
+    /**
+     * Парковка процессора: при пустой очереди поток спит вместо busy-wait
+     * Вызывается ElasticController'ом, сообщения в очереди все равно обрабатываются
+     */
+    void park();
+    void unpark();
+    bool is_parked() const { return parked_.load(std::memory_order_relaxed); }
+
+    uint8_t id() const { return id_; }
+
+    /**
+     * Счетчик прогресса: сообщений, прошедших обработчик (читает StallWatchdog)
+     */
+    uint64_t progress() const { return progress_.load(std::memory_order_relaxed); }
+
+    /**
+     * Имитация остановки обработчика: сон pause_us каждые every_ms (до запуска потока)
+     */
+    void set_stall_injection(uint64_t every_ms, uint64_t pause_us) {
+        inject_every_ns_ = every_ms * 1'000'000;
+        inject_pause_ns_ = pause_us * 1000;
+    }
+
+    /**
+     * Адаптивные пакеты извлечения и отправки (до запуска потока; только run/run_with)
+     */
+    void set_batching(const BatchingConfig& config) { batching_ = AdaptiveBatch(config, 1); }
+    const AdaptiveBatch& batching() const { return batching_; }
+
 private:
     uint8_t id_;                        // ID процессора
     std::shared_ptr<InputQueue> input_queue_;
     std::shared_ptr<OutputQueue> output_queue_;
     SystemStatistics& stats_;
 
-    // Время обработки по типам сообщений (наносекунды)
-    std::unordered_map<uint8_t, uint64_t> processing_times_;
+    // Флаг парковки (устанавливается контроллером масштабирования)
+    std::atomic<bool> parked_{false};
+
+    // Прогресс (пишет только поток процессора)
+    std::atomic<uint64_t> progress_{0};
+
+    // Имитация остановки (0 - выключена) и момент следующей остановки
+    uint64_t inject_every_ns_ = 0;
+    uint64_t inject_pause_ns_ = 0;
+    uint64_t next_stall_ns_ = 0;
+
+    // Имитация времени обработки по типам сообщений (по умолчанию 100 наносекунд)
+    SimulatedWork simulated_work_;
+
+    // Размер пакета по глубине входной очереди (batching.enabled)
+    AdaptiveBatch batching_;
+
+    /**
+     * Извлечение до max_count сообщений с отметкой входа в обработку
+     */
+    size_t pop_batch(Message* batch, size_t max_count);
+
+    /**
+     * Отметка выхода из обработки и учет отклоненных сообщений
+     */
+    void complete_batch(Message* batch, size_t count, size_t kept);
+
+    /**
+     * Имитируемая остановка, если подошел ее момент
+     */
+    void inject_stall(uint64_t now_ns);
+
+    /**
+     * Отправка в выходную очередь с ожиданием места
+     */
+    void push_output(const Message& msg);
+
+    /**
+     * Отправка пакета в выходную очередь с ожиданием места
+     */
+    void push_output_batch(std::span<const Message> batch);
+
+    /**
+     * Ожидание при пустой входной очереди (пауза или сон в припаркованном состоянии)
+     */
+    void wait_idle();
 
     /**
-     * Получение времени обработки для типа сообщения
+     * Цикл с адаптивным пакетом: размер по глубине очереди и цели задержки
      */
-    uint64_t get_processing_time(uint8_t msg_type) const;
+    template<typename Handler>
+    void run_adaptive(std::atomic<bool>& running, Handler& handler);
 };
+
+template<typename Handler>
+void Processor::run_with(std::atomic<bool>& running, Handler handler) {
+    if (batching_.enabled()) {
+        run_adaptive(running, handler);
+        return;
+    }
+
+    // Поштучный обработчик не накапливает пакет, чтобы не добавлять задержку
+    constexpr size_t batch_size = BatchHandler<Handler> ? HANDLER_BATCH_SIZE : 1;
+    std::array<Message, batch_size> batch;
+    bool idle = false;
+
+    while (running.load(std::memory_order_relaxed)) {
+        const size_t count = pop_batch(batch.data(), batch_size);
+        if (count == 0) {
+            if (!idle) {
+                FR_EVENT(Idle, id_, 0);
+                idle = true;
+            }
+            wait_idle();
+            continue;
+        }
+        idle = false;
+
+        const size_t kept = invoke_handler_batch(handler, std::span<Message>(batch.data(), count));
+        complete_batch(batch.data(), count, kept);
+
+        // ВАЖНО: продолжаем пытаться отправить даже если running==false
+        for (size_t i = 0; i < kept; ++i) {
+            push_output(batch[i]);
+        }
+    }
+}
+
+template<typename Handler>
+void Processor::run_adaptive(std::atomic<bool>& running, Handler& handler) {
+    // Поштучный обработчик тоже получает пакет: задержку ограничивает цель контроллера
+    std::vector<Message> batch(batching_.max_batch());
+    bool idle = false;
+
+    while (running.load(std::memory_order_relaxed)) {
+        const size_t count = pop_batch(batch.data(), batching_.limit(input_queue_->size()));
+        if (count == 0) {
+            if (!idle) {
+                FR_EVENT(Idle, id_, 0);
+                idle = true;
+            }
+            wait_idle();
+            continue;
+        }
+        idle = false;
+
+        const uint64_t entry_ns = batch[0].processing_entry_ns;
+        const size_t kept = invoke_handler_batch(handler, std::span<Message>(batch.data(), count));
+        complete_batch(batch.data(), count, kept);
+        push_output_batch(std::span<const Message>(batch.data(), kept));
+        batching_.complete(count, Message::get_timestamp_ns() - entry_ns);
+    }
+}
+
+template<typename Handler>
+CoroTask Processor::run_coro_with(CoroScheduler& scheduler, std::atomic<bool>& running, Handler handler) {
+    constexpr size_t batch_size = BatchHandler<Handler> ? HANDLER_BATCH_SIZE : 1;
+    std::array<Message, batch_size> batch;
+    uint32_t budget = scheduler.batch();
+
+    while (running.load(std::memory_order_relaxed)) {
+        const size_t count = pop_batch(batch.data(), batch_size);
+
+        // Пустая очередь: корутина приостанавливается до появления сообщений
+        // (парковка ElasticController'а в этом режиме не требуется)
+        if (count == 0) {
+            co_await scheduler.readable(*input_queue_);
+            budget = scheduler.batch();
+            continue;
+        }
+
+        const size_t kept = invoke_handler_batch(handler, std::span<Message>(batch.data(), count));
+        complete_batch(batch.data(), count, kept);
+
+        for (size_t i = 0; i < kept; ++i) {
+            while (!output_queue_->try_push(batch[i])) {
+                co_await scheduler.yield();
+                budget = scheduler.batch();
+            }
+            stats_.count(StatsField::Processed, 1);
+        }
+
+        if (budget <= count) {
+            co_await scheduler.yield();
+            budget = scheduler.batch();
+        } else {
+            budget -= static_cast<uint32_t>(count);
+        }
+    }
+}
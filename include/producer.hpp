@@ -4,12 +4,18 @@
 #include "config.hpp"
 #include "spsc_queue.hpp"
 #include "statistics.hpp"
+#include "coro_runtime.hpp"
+#include "timer.hpp"
+#include "flight_recorder.hpp"
 #include <atomic>
 #include <memory>
 #include <random>
 
 constexpr size_t PRODUCER_QUEUE_SIZE = 65536;
 
+// Наименьший период heartbeat в ожидании следующей отправки (наносекунды)
+constexpr uint64_t PRODUCER_HEARTBEAT_NS = 1000;
+
 /**
  * Producer - генерирует сообщения с заданной скоростью
  */
@@ -21,7 +27,8 @@ public:
         uint8_t id,
         const ProducerConfig& config,
         std::shared_ptr<OutputQueue> output_queue,
-        SystemStatistics& stats
+        SystemStatistics& stats,
+        uint64_t first_sequence = 0     // Продолжение нумерации прежнего владельца слота (shm_producer)
     );
 
     /**
@@ -29,6 +36,42 @@ public:
      */
     void run(std::atomic<bool>& running, uint32_t duration_secs);
 
+    /**
+     * Основной цикл с произвольным приемником сообщений
+     * publish(const Message&) -> bool: false - нет места, отправка повторяется
+     * run() передает выходную очередь, кольцевой режим конвейера - общее кольцо
+     */
+    template<typename Publish>
+    void run_with(std::atomic<bool>& running, uint32_t duration_secs, Publish publish) {
+        run_with(running, duration_secs, [](Message&) {}, publish);
+    }
+
+    /**
+     * Основной цикл с подготовкой сообщения перед отправкой
+     * prepare(Message&) - один раз на сгенерированное сообщение (маршрутизация и отметки
+     * Stage1 в режиме fused); publish(Message&) -> bool повторяет только отправку
+     */
+    template<typename Prepare, typename Publish>
+    void run_with(std::atomic<bool>& running, uint32_t duration_secs, Prepare prepare, Publish publish) {
+        run_with(running, duration_secs, prepare, publish, [](uint64_t) {});
+    }
+
+    /**
+     * Основной цикл с heartbeat: heartbeat(timestamp_ns) сообщает, что будущие сообщения
+     * производителя не старше timestamp_ns. Вызывается в ожидании следующей отправки
+     * (текущее время, не чаще PRODUCER_HEARTBEAT_NS) и в начале повторов отправки
+     * (время ожидающего сообщения) - водяной знак простаивающего производителя не стоит
+     */
+    template<typename Prepare, typename Publish, typename Heartbeat>
+    void run_with(std::atomic<bool>& running, uint32_t duration_secs, Prepare prepare, Publish publish,
+                  Heartbeat heartbeat);
+
+    /**
+     * Основной цикл производителя в виде корутины (режим runtime.mode = coroutines)
+     * Между отправками корутина спит в планировщике, не занимая ядро
+     */
+    CoroTask run_coro(CoroScheduler& scheduler, std::atomic<bool>& running, uint32_t duration_secs);
+
 private:
     uint8_t id_;                        // ID производителя
     uint64_t messages_per_sec_;         // Целевая скорость генерации
@@ -43,6 +86,10 @@ private:
     std::mt19937 rng_;
     std::discrete_distribution<size_t> type_distribution_;
 
+    // Ключи маршрутизации (producers.keys > 0): равномерно из [0, keys)
+    uint32_t key_space_;
+    std::uniform_int_distribution<uint32_t> key_distribution_;
+
     // Счетчик последовательности
     uint64_t sequence_number_;
 
@@ -50,4 +97,86 @@ private:
      * Генерация случайного типа сообщения согласно распределению
      */
     uint8_t generate_message_type();
+
+    /**
+     * Создание следующего сообщения производителя
+     */
+    Message next_message() {
+        Message msg = Message::create(generate_message_type(), id_, sequence_number_++);
+        if (key_space_ > 0) {
+            msg.routing_key = key_distribution_(rng_);
+        }
+        return msg;
+    }
 };
+
+template<typename Prepare, typename Publish, typename Heartbeat>
+void Producer::run_with(std::atomic<bool>& running, uint32_t duration_secs, Prepare prepare, Publish publish,
+                        Heartbeat heartbeat) {
+    // Вычисление интервала между сообщениями (наносекунды)
+    const uint64_t interval_ns = 1'000'000'000ULL / messages_per_sec_;
+
+    Timer timer;
+    uint64_t next_send_time = 0;
+    uint64_t next_heartbeat_time = 0;
+    uint64_t messages_sent = 0;
+
+    FR_THREAD("producer", id_);
+
+    while (running.load(std::memory_order_relaxed)) {
+        // Проверка времени выполнения
+        if (timer.elapsed_seconds() >= duration_secs) {
+            break;
+        }
+
+        uint64_t current_time = timer.elapsed_nanoseconds();
+
+        // Проверка, пора ли отправлять следующее сообщение
+        if (current_time >= next_send_time) {
+            // Генерация сообщения
+            Message msg = next_message();
+            prepare(msg);
+
+            // Попытка отправить
+            bool retrying = false;
+            while (running.load(std::memory_order_relaxed)) {
+                if (publish(msg)) {
+                    stats_.count(StatsField::Produced, 1);
+                    stats_.dimensions.record_produced(msg);
+                    messages_sent++;
+                    break;
+                }
+
+                if (!retrying) {
+                    FR_EVENT(PushRetryBegin, id_, 0);
+                    retrying = true;
+                    // Сообщение ждет места: следующие за ним не старше его
+                    heartbeat(msg.timestamp_ns);
+                }
+
+                // Если места нет, активно ждем
+                __builtin_ia32_pause();
+            }
+            if (retrying) {
+                FR_EVENT(PushRetryEnd, id_, 0);
+            }
+
+            // Планирование следующей отправки
+            next_send_time += interval_ns;
+
+            // Если мы отстали от графика, корректируем
+            if (next_send_time < current_time) {
+                next_send_time = current_time;
+            }
+        } else {
+            // Следующее сообщение будет создано не раньше текущего момента
+            if (current_time >= next_heartbeat_time) {
+                heartbeat(Message::get_timestamp_ns());
+                next_heartbeat_time = current_time + PRODUCER_HEARTBEAT_NS;
+            }
+
+            // Активное ожидание с минимальной паузой
+            __builtin_ia32_pause();
+        }
+    }
+}
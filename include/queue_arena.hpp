@@ -0,0 +1,119 @@
+#pragma once
+
+#include "config.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <string>
+#include <vector>
+
+// Размер huge page (x86-64): блоки очередей в арене выровнены по нему
+constexpr size_t HUGE_PAGE_SIZE = 2 * 1024 * 1024;
+
+/**
+ * Имя размещения для конфигурации и отчетов ("heap", "mmap", "thp", "hugetlb")
+ */
+const char* queue_backing_name(QueueBacking backing);
+
+/**
+ * Размещение по имени (std::runtime_error для неизвестного имени)
+ */
+QueueBacking queue_backing_from_name(const std::string& name);
+
+/**
+ * Резидентная память процесса (VmRSS из /proc/self/statm), байт
+ */
+size_t resident_set_bytes();
+
+/**
+ * QueueArena - память очередей конвейера в одном резервировании mmap
+ *
+ * Арена резервирует адресное пространство под все очереди сразу (MAP_NORESERVE):
+ * физические страницы выделяются при первой записи в слот, поэтому простаивающие
+ * очереди не занимают RSS на всю емкость. Каждая очередь занимает блок, выровненный
+ * по HUGE_PAGE_SIZE, чтобы ее буфер покрывался целыми huge pages (Thp, HugeTlb).
+ *
+ * prefault() заранее выделяет страницы всех блоков: по потоку на очередь, поток
+ * привязан к ядру потребителя очереди (если оно известно), чтобы страницы
+ * оказались на его узле NUMA, а ожидание первых страниц не попало в первые
+ * секунды работы конвейера.
+ *
+ * Ошибки системных вызовов сообщаются исключением std::runtime_error; HugeTlb
+ * без свободных huge pages в пуле переходит на Thp с предупреждением.
+ */
+class QueueArena : public std::enable_shared_from_this<QueueArena> {
+public:
+    /**
+     * Резервирование арены под bytes байт (сумма footprint() всех очередей)
+     */
+    static std::shared_ptr<QueueArena> create(QueueBacking backing, size_t bytes);
+
+    ~QueueArena();
+
+    QueueArena(const QueueArena&) = delete;
+    QueueArena& operator=(const QueueArena&) = delete;
+
+    /**
+     * Место, которое очередь размера object_bytes занимает в арене
+     */
+    static constexpr size_t footprint(size_t object_bytes) noexcept {
+        return (object_bytes + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE * HUGE_PAGE_SIZE;
+    }
+
+    /**
+     * Конструирование очереди в следующем блоке арены
+     * Указатель удерживает арену: она освобождается после последней очереди
+     * @param consumer_core ядро потребителя для prefault (-1 - неизвестно)
+     */
+    template<typename Queue>
+    std::shared_ptr<Queue> make(int consumer_core = -1) {
+        Queue* queue = new (allocate(sizeof(Queue), consumer_core)) Queue();
+        return std::shared_ptr<Queue>(queue, [arena = shared_from_this()](Queue* q) { q->~Queue(); });
+    }
+
+    /**
+     * Выделение страниц всех блоков до запуска конвейера (параллельно, по потоку на блок)
+     * Вызывается до начала работы с очередями
+     */
+    void prefault();
+
+    /**
+     * Фактическое размещение (HugeTlb может перейти на Thp)
+     */
+    QueueBacking backing() const noexcept { return backing_; }
+
+    size_t reserved_bytes() const noexcept { return size_; }
+    size_t used_bytes() const noexcept { return used_; }
+
+    /**
+     * Резидентные байты арены (mincore) и байты в transparent huge pages (smaps)
+     */
+    size_t resident_bytes() const;
+    size_t huge_page_bytes() const;
+
+    /**
+     * Отчет: размещение, резерв, резидентная часть и время prefault
+     */
+    void print_report() const;
+
+private:
+    struct Block {
+        size_t offset;
+        size_t bytes;
+        int core;
+    };
+
+    QueueArena(QueueBacking requested, QueueBacking backing, void* base, size_t size);
+
+    void* allocate(size_t bytes, int consumer_core);
+
+    QueueBacking requested_;
+    QueueBacking backing_;
+    uint8_t* base_;
+    size_t size_;
+    size_t used_ = 0;
+    std::vector<Block> blocks_;
+    uint64_t prefault_ns_ = 0;
+    bool prefaulted_ = false;
+};
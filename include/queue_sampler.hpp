@@ -0,0 +1,103 @@
+#pragma once
+
+#include "config.hpp"
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+constexpr uint64_t QUEUE_SAMPLES_MAGIC = 0x53454C504D415351ULL; // "QSAMPLES"
+constexpr uint32_t QUEUE_SAMPLES_VERSION = 1;
+constexpr size_t QUEUE_SAMPLES_NAME_SIZE = 32;
+
+/**
+ * Заголовок бинарного файла выборок
+ * За ним следуют edges имен ребер по QUEUE_SAMPLES_NAME_SIZE байт (с нулем в конце)
+ * и samples записей: uint64_t время (нс от старта сэмплера), uint32_t глубина[edges]
+ */
+struct QueueSamplesHeader {
+    uint64_t magic;
+    uint32_t version;
+    uint32_t edges;                     // Количество ребер (очередей)
+    uint64_t samples;                   // Количество записей
+    uint64_t interval_ns;               // Период выборки
+};
+
+/**
+ * QueueSampler - временной ряд заполнения очередей всех ребер конвейера
+ *
+ * Фоновый поток с минимальным приоритетом (nice 19) с заданным периодом
+ * (10 мкс - 1 мс) читает SPSCQueue::size() каждого ребра и пишет выборку
+ * в предвыделенное кольцо, хранящее последние ring_samples выборок.
+ * Короткие всплески, невидимые в ежесекундном мониторинге, дополнительно
+ * фиксируют счетчики самих очередей: максимум заполнения и эпизоды переполнения.
+ * По завершении ряд выгружается в CSV и/или бинарный файл.
+ */
+class QueueSampler {
+public:
+    explicit QueueSampler(const QueueSamplerConfig& config);
+
+    /**
+     * Регистрация ребра (до запуска потока)
+     * @param name имя ребра в отчете и заголовке CSV, например "stage1->proc0"
+     */
+    template<typename Queue>
+    void add_edge(std::string name, std::shared_ptr<Queue> queue);
+
+    /**
+     * Основной цикл сэмплера (запускается в отдельном потоке)
+     */
+    void run(std::atomic<bool>& running);
+
+    /**
+     * Выгрузка ряда в файлы из конфигурации (после остановки потока)
+     */
+    void export_series() const;
+
+    /**
+     * Вывод итогового отчета по ребрам
+     */
+    void print_report() const;
+
+private:
+    struct Edge {
+        std::string name;
+        std::shared_ptr<const void> queue;
+        size_t (*depth)(const void*);
+        size_t (*high_watermark)(const void*);
+        uint64_t (*full_events)(const void*);
+    };
+
+    QueueSamplerConfig config_;
+    std::vector<Edge> edges_;
+
+    // Кольцо выборок: время и глубины всех ребер подряд
+    std::vector<uint64_t> times_ns_;
+    std::vector<uint32_t> depths_;
+    uint64_t start_ns_ = 0;             // Время запуска сэмплера
+    uint64_t samples_taken_ = 0;        // Всего выборок (в кольце - последние ring_samples)
+    uint64_t missed_ticks_ = 0;         // Пропущенные периоды (поток не успел проснуться)
+
+    void sample(uint64_t time_ns);
+
+    /**
+     * Номер первой хранящейся выборки и их количество
+     */
+    uint64_t first_sample() const;
+    size_t stored_samples() const;
+
+    void export_csv(const std::string& path) const;
+    void export_binary(const std::string& path) const;
+};
+
+template<typename Queue>
+void QueueSampler::add_edge(std::string name, std::shared_ptr<Queue> queue) {
+    edges_.push_back(Edge{
+        std::move(name),
+        std::shared_ptr<const void>(queue, queue.get()),
+        [](const void* q) { return static_cast<const Queue*>(q)->size(); },
+        [](const void* q) { return static_cast<const Queue*>(q)->high_watermark(); },
+        [](const void* q) { return static_cast<uint64_t>(static_cast<const Queue*>(q)->full_events()); }
+    });
+}
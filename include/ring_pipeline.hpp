@@ -0,0 +1,111 @@
+#pragma once
+
+#include "config.hpp"
+#include "message.hpp"
+#include "statistics.hpp"
+#include "shared_ring.hpp"
+#include "spsc_queue.hpp"
+#include "producer.hpp"
+#include "router.hpp"
+#include "handlers.hpp"
+#include "journal.hpp"
+#include "queue_sampler.hpp"
+#include <array>
+#include <atomic>
+#include <memory>
+#include <vector>
+
+/**
+ * RingPipeline - стадии конвейера в режиме runtime.transport = shared_ring
+ *
+ * У каждого производителя одно общее кольцо (SharedMessageRing): сообщение
+ * записывается один раз, Stage1 продвигает свой курсор по опубликованным слотам,
+ * процессор и стратегия пишут поля (processor_id, отметки времени) прямо в слоте.
+ * Между Stage1, процессорами, Stage2 и стратегиями по SPSC очередям идут
+ * только 8-байтные SlotRef вместо копий сообщения.
+ *
+ * Маршрутизация, имитация обработки и учет совпадают с режимом очередей
+ * (Stage1Router, Processor с SimulatedWork, Strategy::on_batch), поэтому
+ * режимы сравнимы на одних конфигурациях. Потоки запускает Pipeline.
+ */
+class RingPipeline {
+public:
+    using Ring = SharedMessageRing<SHARED_RING_SIZE>;
+    using RefQueue = SPSCQueue<SlotRef, QUEUE_SIZE>;
+
+    RingPipeline(const SystemConfig& config, SystemStatistics& stats);
+
+    RingPipeline(const RingPipeline&) = delete;
+    RingPipeline& operator=(const RingPipeline&) = delete;
+
+    /**
+     * Основные циклы стадий (каждый в отдельном потоке)
+     */
+    void run_producer(size_t index, std::atomic<bool>& running, uint32_t duration_secs);
+    void run_stage1(std::atomic<bool>& running);
+    void run_processor(size_t index, std::atomic<bool>& running);
+    void run_stage2(std::atomic<bool>& running);
+    void run_strategy(size_t index, std::atomic<bool>& running);
+
+    /**
+     * Подключение журнала доставленных сообщений (nullptr - без журнала)
+     */
+    void set_journal(JournalWriter* journal) { journal_ = journal; }
+
+    /**
+     * Регистрация колец и очередей ссылок в сэмплере
+     */
+    void add_sampler_edges(QueueSampler& sampler) const;
+
+    /**
+     * Обновление глубин очередей в статистике (вызывается из мониторинга)
+     */
+    void update_queue_depths();
+
+    /**
+     * Отчет по кольцам: максимальное заполнение и эпизоды переполнения
+     */
+    void print_report() const;
+
+    size_t producers() const { return producers_.size(); }
+    size_t processors() const { return processor_inputs_.size(); }
+    size_t strategies() const { return strategy_inputs_.size(); }
+
+    /**
+     * Байт, копируемых транспортом на сообщение (запись и чтение каждой копии):
+     * сообщение записывается в кольцо один раз, по трем ребрам идут SlotRef,
+     * плюс отметка завершения слота
+     */
+    static constexpr size_t transport_bytes_per_message() {
+        return sizeof(Message) + 3 * 2 * sizeof(SlotRef) + sizeof(uint64_t);
+    }
+
+private:
+    SystemStatistics& stats_;
+
+    // Общие кольца производителей и курсоры Stage1 по ним (только поток Stage1)
+    std::vector<std::shared_ptr<Ring>> rings_;
+    std::vector<uint64_t> stage1_cursors_;
+
+    // Очереди ссылок между стадиями
+    std::vector<std::shared_ptr<RefQueue>> processor_inputs_;
+    std::vector<std::shared_ptr<RefQueue>> processor_outputs_;
+    std::vector<std::shared_ptr<RefQueue>> strategy_inputs_;
+
+    std::vector<std::unique_ptr<Producer>> producers_;
+
+    // Маршрутизация по типу (таблицей пользуются только потоки Stage1 и Stage2)
+    RouteTable routes_;
+
+    // Имитация обработки: время процессоров по типам и стратегий на сообщение
+    SimulatedWork processor_work_;
+    std::vector<uint64_t> strategy_times_ns_;
+    size_t max_batch_;
+
+    JournalWriter* journal_ = nullptr;
+
+    /**
+     * Отправка ссылки с ожиданием места (сообщение уже извлечено - не теряется)
+     */
+    static void push_ref(RefQueue& queue, SlotRef ref, uint16_t lane);
+};
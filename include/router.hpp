@@ -3,6 +3,12 @@
 #include "message.hpp"
 #include "config.hpp"
 #include "spsc_queue.hpp"
+#include "broadcast_ring.hpp"
+#include "coro_runtime.hpp"
+#include "admission.hpp"
+#include "key_routes.hpp"
+#include "adaptive_batch.hpp"
+#include <array>
 #include <vector>
 #include <unordered_map>
 #include <atomic>
@@ -11,6 +17,64 @@
 // Размер очереди между компонентами
 constexpr size_t QUEUE_SIZE = 65536; // Должно быть степенью 2
 
+/**
+ * RouteTable - таблицы маршрутизации Stage1/Stage2 для встроенной маршрутизации
+ * (кольцевой и слитный режимы, где отдельных потоков роутеров нет)
+ *
+ * Правила те же, что у Stage1Router/Stage2Router: балансировка round-robin
+ * по списку процессоров, для типов без правила - тип по модулю; при правилах
+ * по ключу - поиск в KeyRouteMap (общий для всех копий). Счетчики round-robin
+ * не атомарны: у каждого маршрутизирующего потока своя копия таблицы.
+ */
+class RouteTable {
+public:
+    RouteTable(const std::vector<Stage1Rule>& stage1_rules, const std::vector<Stage2Rule>& stage2_rules,
+               size_t processors, size_t strategies,
+               std::shared_ptr<const KeyRouteMap> stage1_keys = nullptr,
+               std::shared_ptr<const KeyRouteMap> stage2_keys = nullptr)
+        : processors_(static_cast<uint8_t>(processors))
+        , stage1_keys_(std::move(stage1_keys))
+        , stage2_keys_(std::move(stage2_keys))
+    {
+        for (const auto& rule : stage1_rules) {
+            stage1_[rule.msg_type] = rule.processors;
+        }
+        for (size_t type = 0; type < stage2_.size(); ++type) {
+            stage2_[type] = static_cast<uint8_t>(type % strategies);
+        }
+        for (const auto& rule : stage2_rules) {
+            stage2_[rule.msg_type] = rule.strategy;
+        }
+    }
+
+    uint8_t select_processor(const Message& msg) {
+        if (stage1_keys_) {
+            return stage1_keys_->lookup(msg.routing_key);
+        }
+        const uint8_t msg_type = msg.msg_type;
+        const auto& processors = stage1_[msg_type];
+        if (processors.empty()) {
+            return msg_type % processors_;
+        }
+        if (processors.size() == 1) {
+            return processors[0];
+        }
+        return processors[rr_counters_[msg_type]++ % processors.size()];
+    }
+
+    uint8_t select_strategy(const Message& msg) const {
+        return stage2_keys_ ? stage2_keys_->lookup(msg.routing_key) : stage2_[msg.msg_type];
+    }
+
+private:
+    uint8_t processors_;
+    std::shared_ptr<const KeyRouteMap> stage1_keys_;
+    std::shared_ptr<const KeyRouteMap> stage2_keys_;
+    std::array<std::vector<uint8_t>, 256> stage1_;
+    std::array<size_t, 256> rr_counters_{};
+    std::array<uint8_t, 256> stage2_{};
+};
+
 /**
  * Stage1 Router - маршрутизирует сообщения от производителей к процессорам
  */
@@ -30,10 +94,61 @@ public:
      */
     void run(std::atomic<bool>& running);
 
+    /**
+     * Основной цикл роутера в виде корутины (режим runtime.mode = coroutines)
+     */
+    CoroTask run_coro(CoroScheduler& scheduler, std::atomic<bool>& running);
+
+    /**
+     * Добавление процессора в набор балансировки типа "на лету"
+     * Безопасно вызывать из другого потока (ElasticController)
+     * Действует только для типов, для которых задано правило Stage1
+     */
+    void add_extra_processor(uint8_t msg_type, uint8_t processor_id);
+
+    /**
+     * Удаление ранее добавленного процессора из набора балансировки типа
+     */
+    void remove_extra_processor(uint8_t msg_type, uint8_t processor_id);
+
+    /**
+     * Временное исключение процессора из набора балансировки типа (StallWatchdog)
+     * Сообщения типа распределяются между остальными процессорами набора; если
+     * исключены все, балансировка идет по полному набору
+     */
+    void exclude_processor(uint8_t msg_type, uint8_t processor_id);
+
+    /**
+     * Возврат исключенного процессора в набор балансировки типа
+     */
+    void restore_processor(uint8_t msg_type, uint8_t processor_id);
+
+    /**
+     * Подключение контроля допуска (nullptr - допускаются все сообщения)
+     */
+    void set_admission(AdmissionControl* admission) { admission_ = admission; }
+
+    /**
+     * Маршрутизация по routing_key вместо правил по типу (nullptr - по типу)
+     */
+    void set_key_routes(std::shared_ptr<const KeyRouteMap> routes) { key_routes_ = std::move(routes); }
+
+    /**
+     * Адаптивные пакеты извлечения и отправки (до запуска потока; только run)
+     */
+    void set_batching(const BatchingConfig& config);
+    const std::vector<AdaptiveBatch>& batching() const { return batching_; }
+
 private:
     // Правила маршрутизации: msg_type -> список процессоров
     std::unordered_map<uint8_t, std::vector<uint8_t>> routing_table_;
 
+    // Дополнительные процессоры по типам (битовая маска, изменяется на лету)
+    std::unordered_map<uint8_t, std::atomic<uint32_t>> extra_processors_;
+
+    // Исключенные из балансировки процессоры по типам (битовая маска, изменяется на лету)
+    std::unordered_map<uint8_t, std::atomic<uint32_t>> excluded_processors_;
+
     // Входные очереди от производителей
     std::vector<std::shared_ptr<InputQueue>>& input_queues_;
 
@@ -43,24 +158,59 @@ private:
     // Счетчик для round-robin балансировки
     std::unordered_map<uint8_t, std::atomic<size_t>> rr_counters_;
 
+    // Контроль допуска (token bucket), опционально
+    AdmissionControl* admission_ = nullptr;
+
+    // Скомпилированные правила по ключу, опционально
+    std::shared_ptr<const KeyRouteMap> key_routes_;
+
     /**
      * Выбор процессора для сообщения (с round-robin балансировкой)
      */
     uint8_t select_processor(uint8_t msg_type);
+
+    /**
+     * Выбор процессора по ключу (правила по ключу) или по типу
+     */
+    uint8_t select_processor(const Message& msg) {
+        return key_routes_ ? key_routes_->lookup(msg.routing_key) : select_processor(msg.msg_type);
+    }
+
+    /**
+     * Извлечение головы очереди с учетом контроля допуска
+     * @return false - очередь пуста или голова ждет токена (decision = Delay)
+     */
+    bool pop_next(InputQueue& queue, Message& msg, AdmissionDecision& decision);
+
+    // Адаптивные пакеты: контроллер на входную очередь и накопление по выходным очередям
+    std::vector<AdaptiveBatch> batching_;
+    std::vector<std::vector<Message>> staged_;
+
+    /**
+     * Пакет из входной очереди q: извлечение, маршрутизация, отправка накопленного
+     * @return количество извлеченных сообщений
+     */
+    size_t route_batch(size_t q);
 };
 
 /**
  * Stage2 Router - маршрутизирует обработанные сообщения к стратегиям
+ *
+ * Типы с multicast-правилом публикуются один раз в кольцо группы получателей
+ * (BroadcastRing, группы - multicast_groups(rules)); стратегии группы читают
+ * сообщение на месте. Без переданных колец multicast-правила работают как unicast.
  */
 class Stage2Router {
 public:
     using InputQueue = SPSCQueue<Message, QUEUE_SIZE>;
     using OutputQueue = SPSCQueue<Message, QUEUE_SIZE>;
+    using MulticastRing = BroadcastRing<Message, MULTICAST_RING_SIZE>;
 
     Stage2Router(
         const std::vector<Stage2Rule>& rules,
         std::vector<std::shared_ptr<InputQueue>>& input_queues,
-        std::vector<std::shared_ptr<OutputQueue>>& output_queues
+        std::vector<std::shared_ptr<OutputQueue>>& output_queues,
+        std::vector<std::shared_ptr<MulticastRing>> multicast_rings = {}
     );
 
     /**
@@ -68,6 +218,22 @@ public:
      */
     void run(std::atomic<bool>& running);
 
+    /**
+     * Основной цикл роутера в виде корутины (режим runtime.mode = coroutines)
+     */
+    CoroTask run_coro(CoroScheduler& scheduler, std::atomic<bool>& running);
+
+    /**
+     * Маршрутизация по routing_key вместо правил по типу (nullptr - по типу)
+     */
+    void set_key_routes(std::shared_ptr<const KeyRouteMap> routes) { key_routes_ = std::move(routes); }
+
+    /**
+     * Адаптивные пакеты извлечения и отправки (до запуска потока; только run)
+     */
+    void set_batching(const BatchingConfig& config);
+    const std::vector<AdaptiveBatch>& batching() const { return batching_; }
+
 private:
     // Правила маршрутизации: msg_type -> strategy_id
     std::unordered_map<uint8_t, uint8_t> routing_table_;
@@ -77,4 +243,34 @@ private:
 
     // Выходные очереди к стратегиям
     std::vector<std::shared_ptr<OutputQueue>>& output_queues_;
+
+    // Кольца multicast-групп и номер кольца по типу сообщения (-1 - unicast)
+    std::vector<std::shared_ptr<MulticastRing>> multicast_rings_;
+    std::array<int16_t, 256> multicast_ring_;
+
+    // Скомпилированные правила по ключу, опционально
+    std::shared_ptr<const KeyRouteMap> key_routes_;
+
+    /**
+     * Выбор стратегии по ключу (правила по ключу) или по типу сообщения
+     */
+    uint8_t select_strategy(const Message& msg) const {
+        if (key_routes_) {
+            return key_routes_->lookup(msg.routing_key);
+        }
+        auto it = routing_table_.find(msg.msg_type);
+        return (it != routing_table_.end())
+            ? it->second
+            : static_cast<uint8_t>(msg.msg_type % output_queues_.size());
+    }
+
+    // Адаптивные пакеты: контроллер на входную очередь и накопление по выходным очередям
+    std::vector<AdaptiveBatch> batching_;
+    std::vector<std::vector<Message>> staged_;
+
+    /**
+     * Пакет из входной очереди q (multicast публикуется сразу, unicast - накоплением)
+     * @return количество извлеченных сообщений
+     */
+    size_t route_batch(size_t q);
 };
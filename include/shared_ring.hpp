@@ -0,0 +1,168 @@
+#pragma once
+
+#include "message.hpp"
+#include "spsc_queue.hpp"
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+// Размер общего кольца производителя (кольцевой режим конвейера)
+constexpr size_t SHARED_RING_SIZE = 65536; // Должно быть степенью 2
+
+/**
+ * Ссылка на слот общего кольца: номер кольца (производителя) и порядковый
+ * номер слота, упакованные в 8 байт - только она передается между стадиями
+ */
+struct SlotRef {
+    static constexpr uint64_t SEQUENCE_MASK = (1ULL << 56) - 1;
+
+    uint64_t value = 0;
+
+    static SlotRef make(uint8_t ring, uint64_t sequence) noexcept {
+        return SlotRef{(static_cast<uint64_t>(ring) << 56) | (sequence & SEQUENCE_MASK)};
+    }
+
+    uint8_t ring() const noexcept { return static_cast<uint8_t>(value >> 56); }
+    uint64_t sequence() const noexcept { return value & SEQUENCE_MASK; }
+};
+
+/**
+ * Общее кольцо сообщений производителя (кольцевой режим, в духе Disruptor)
+ *
+ * Производитель записывает сообщение в слот один раз и публикует курсор;
+ * Stage1 читает опубликованные слоты по собственному курсору (барьер),
+ * стадии дописывают свои поля прямо в слоте, а дальше по конвейеру идут
+ * только SlotRef. Последняя стадия (стратегия или отклонивший процессор)
+ * завершает слот отметкой complete().
+ *
+ * Особенности:
+ * - Слоты завершаются не по порядку (разные процессоры и стратегии): отметка
+ *   завершения - номер слота + 1, производитель продвигает курсор освобождения
+ *   по непрерывной серии отметок, и сбрасывать их не нужно
+ * - Опоздавший слот только задерживает переиспользование следующих
+ * - Публикация и передача SlotRef через SPSCQueue дают нужные release/acquire:
+ *   стадия видит поля, записанные предыдущими стадиями
+ */
+template<size_t Capacity>
+class SharedMessageRing {
+    static_assert((Capacity & (Capacity - 1)) == 0,
+                  "Capacity должна быть степенью двойки");
+
+public:
+    SharedMessageRing() = default;
+
+    SharedMessageRing(const SharedMessageRing&) = delete;
+    SharedMessageRing& operator=(const SharedMessageRing&) = delete;
+
+    /**
+     * Попытка записать и опубликовать сообщение (сторона производителя)
+     *
+     * Memory ordering:
+     * - done_.load: acquire - синхронизация с release стадии, завершившей слот
+     * - published_.store: release - публикация слота для Stage1
+     *
+     * @return true если опубликовано, false если все слоты еще в обработке
+     */
+    bool try_publish(const Message& msg) noexcept {
+        const uint64_t sequence = published_.load(std::memory_order_relaxed);
+
+        reclaim(sequence);
+        if (sequence - reclaimed_ >= Capacity) {
+            // Эпизод переполнения считается один раз до следующей успешной публикации
+            if (!full_) {
+                full_ = true;
+                full_events_.store(full_events_.load(std::memory_order_relaxed) + 1,
+                                   std::memory_order_relaxed);
+            }
+            return false;
+        }
+
+        slots_[sequence & (Capacity - 1)] = msg;
+        published_.store(sequence + 1, std::memory_order_release);
+
+        const size_t depth = static_cast<size_t>(sequence + 1 - reclaimed_);
+        if (depth > high_watermark_.load(std::memory_order_relaxed)) {
+            high_watermark_.store(depth, std::memory_order_relaxed);
+        }
+        full_ = false;
+        return true;
+    }
+
+    /**
+     * Курсор публикации: слоты с номерами меньше него доступны Stage1
+     */
+    uint64_t published() const noexcept {
+        return published_.load(std::memory_order_acquire);
+    }
+
+    /**
+     * Слот по номеру; стадия, владеющая SlotRef, может изменять его поля
+     */
+    Message& slot(uint64_t sequence) noexcept {
+        return slots_[sequence & (Capacity - 1)];
+    }
+
+    /**
+     * Завершение слота: сообщение доставлено или отклонено, слот можно переиспользовать
+     */
+    void complete(uint64_t sequence) noexcept {
+        done_[sequence & (Capacity - 1)].store(sequence + 1, std::memory_order_release);
+    }
+
+    /**
+     * Занятые слоты: опубликованные и еще не освобожденные производителем
+     * (производитель освобождает слоты при публикации - оценка сверху)
+     */
+    size_t size() const noexcept {
+        return static_cast<size_t>(published_.load(std::memory_order_acquire)
+                                   - reclaimed_cursor_.load(std::memory_order_relaxed));
+    }
+
+    bool empty() const noexcept {
+        return size() == 0;
+    }
+
+    /**
+     * Максимальное заполнение, наблюдавшееся производителем после публикации
+     */
+    size_t high_watermark() const noexcept {
+        return high_watermark_.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * Количество эпизодов переполнения (серия неудачных публикаций считается одной)
+     */
+    uint64_t full_events() const noexcept {
+        return full_events_.load(std::memory_order_relaxed);
+    }
+
+    static constexpr size_t capacity() noexcept { return Capacity; }
+
+private:
+    /**
+     * Продвижение курсора освобождения по непрерывной серии завершенных слотов
+     */
+    void reclaim(uint64_t sequence) noexcept {
+        const uint64_t before = reclaimed_;
+        while (reclaimed_ < sequence &&
+               done_[reclaimed_ & (Capacity - 1)].load(std::memory_order_acquire) == reclaimed_ + 1) {
+            ++reclaimed_;
+        }
+        if (reclaimed_ != before) {
+            reclaimed_cursor_.store(reclaimed_, std::memory_order_relaxed);
+        }
+    }
+
+    // Курсоры производителя и его локальное состояние в одной cache line
+    alignas(CACHE_LINE_SIZE) std::atomic<uint64_t> published_{0};
+    uint64_t reclaimed_ = 0;            // Курсор освобождения (только производитель)
+    std::atomic<uint64_t> reclaimed_cursor_{0};
+    std::atomic<size_t> high_watermark_{0};
+    std::atomic<uint64_t> full_events_{0};
+    bool full_ = false;
+
+    // Отметки завершения отдельно от слотов: производитель читает их подряд
+    alignas(CACHE_LINE_SIZE) std::array<std::atomic<uint64_t>, Capacity> done_{};
+    alignas(CACHE_LINE_SIZE) Message slots_[Capacity];
+};
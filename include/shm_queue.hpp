@@ -0,0 +1,255 @@
+#pragma once
+
+#include "message.hpp"
+#include "shm_region.hpp"
+#include "spsc_queue.hpp"
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <signal.h>
+#include <unistd.h>
+
+// Формат заголовка разделяемой области очередей
+constexpr uint64_t SHM_QUEUE_MAGIC = 0x5154554F52524D53ULL; // "SMRROUTQ"
+constexpr uint32_t SHM_QUEUE_VERSION = 3;  // 2: счетчики заполнения в SPSCQueue, 3: Message::routing_key
+constexpr uint32_t SHM_MAX_PEERS = 32;
+constexpr uint64_t SHM_ATTACH_TIMEOUT_MS = 5000;   // Ожидание инициализации области создателем
+
+// Очереди в разделяемой памяти требуют address-free атомиков
+static_assert(std::atomic<size_t>::is_always_lock_free,
+              "Атомики очередей должны быть lock-free для размещения в shm");
+
+/**
+ * Состояние участника (процесса-производителя), подключенного к очереди
+ */
+enum class ShmPeerState : uint32_t {
+    Free = 0,       // Слот свободен
+    Attached = 1,   // Процесс подключен и пишет в очередь
+    Finished = 2    // Процесс штатно завершил работу
+};
+
+/**
+ * Слот участника: pid и heartbeat для обнаружения упавших процессов
+ * Пишется только владельцем слота, каждый слот в своей cache line
+ */
+struct alignas(CACHE_LINE_SIZE) ShmPeerSlot {
+    std::atomic<uint32_t> state;        // ShmPeerState
+    std::atomic<int32_t> pid;           // pid процесса-владельца
+    std::atomic<uint64_t> heartbeat_ns; // Время последнего heartbeat
+    std::atomic<uint64_t> pushed;       // Количество отправленных сообщений
+};
+
+/**
+ * Версионированный заголовок области
+ * Подключающийся процесс проверяет совместимость раскладки до доступа к очередям
+ */
+struct alignas(CACHE_LINE_SIZE) ShmQueueHeader {
+    uint64_t magic;
+    uint32_t version;
+    uint32_t queue_count;
+    uint64_t queue_size;            // sizeof(Queue)
+    uint64_t queue_stride;          // Расстояние между очередями в области
+    uint64_t element_size;          // sizeof(элемента)
+    uint64_t capacity;              // Queue::capacity()
+    int32_t creator_pid;
+    std::atomic<uint32_t> ready;    // 1 после конструирования всех очередей
+    ShmPeerSlot peers[SHM_MAX_PEERS];
+};
+
+/**
+ * ShmQueueSet - набор очередей, размещенных в одной области разделяемой памяти
+ *
+ * Очереди конструируются placement new, поэтому горячий путь try_push/try_pop
+ * не отличается от внутрипроцессного: ни копий сверх записи в слот, ни системных вызовов.
+ * Подходит для SPSCQueue и BoundedMPSCQueue (любая очередь без указателей внутри).
+ */
+template<typename Queue, typename T = Message>
+class ShmQueueSet : public std::enable_shared_from_this<ShmQueueSet<Queue, T>> {
+public:
+    /**
+     * Создание области с queue_count очередями
+     * @param name имя POSIX shm ("/name") или пустая строка для анонимной memfd области
+     */
+    static std::shared_ptr<ShmQueueSet> create(const std::string& name, uint32_t queue_count) {
+        if (queue_count == 0 || queue_count > SHM_MAX_PEERS) {
+            throw std::runtime_error("Недопустимое количество очередей в shm: " +
+                                     std::to_string(queue_count));
+        }
+
+        const size_t total = queues_offset() + queue_stride() * queue_count;
+        auto region = name.empty() ? ShmRegion::create_anonymous(total)
+                                   : ShmRegion::create(name, total, offsetof(ShmQueueHeader, creator_pid));
+
+        // pid пишется первым: по нему следующий запуск отличает брошенную область от занятой
+        auto* header = new (region->data()) ShmQueueHeader();
+        header->creator_pid = static_cast<int32_t>(getpid());
+        header->magic = SHM_QUEUE_MAGIC;
+        header->version = SHM_QUEUE_VERSION;
+        header->queue_count = queue_count;
+        header->queue_size = sizeof(Queue);
+        header->queue_stride = queue_stride();
+        header->element_size = sizeof(T);
+        header->capacity = Queue::capacity();
+
+        auto set = std::shared_ptr<ShmQueueSet>(new ShmQueueSet(region));
+        for (uint32_t i = 0; i < queue_count; ++i) {
+            new (set->queue_address(i)) Queue();
+        }
+
+        header->ready.store(1, std::memory_order_release);
+        return set;
+    }
+
+    /**
+     * Подключение к существующей области с проверкой версии и раскладки
+     * Если создатель еще инициализирует область (размер не задан или ready = 0),
+     * подключение ждет до SHM_ATTACH_TIMEOUT_MS; заголовок читается только после ready
+     */
+    static std::shared_ptr<ShmQueueSet> attach(const std::string& name) {
+        const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(SHM_ATTACH_TIMEOUT_MS);
+        auto timed_out = [&deadline]() { return std::chrono::steady_clock::now() >= deadline; };
+
+        // Между shm_open и ftruncate создателя область имеет нулевой размер
+        auto region = ShmRegion::attach(name);
+        while (region->size() < sizeof(ShmQueueHeader)) {
+            if (timed_out()) {
+                throw std::runtime_error("Область shm слишком мала: " + name);
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            region = ShmRegion::attach(name);
+        }
+
+        // Ожидание завершения инициализации создателем: поля заголовка до ready не читаются
+        const auto* header = static_cast<const ShmQueueHeader*>(region->data());
+        while (header->ready.load(std::memory_order_acquire) == 0) {
+            if (timed_out()) {
+                throw std::runtime_error("Область shm не инициализирована создателем за "
+                                         + std::to_string(SHM_ATTACH_TIMEOUT_MS) + " мс: " + name);
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+
+        if (header->magic != SHM_QUEUE_MAGIC) {
+            throw std::runtime_error("Область shm не содержит очередей роутера: " + name);
+        }
+        if (header->version != SHM_QUEUE_VERSION) {
+            throw std::runtime_error("Несовместимая версия раскладки shm: " +
+                                     std::to_string(header->version));
+        }
+        if (header->queue_size != sizeof(Queue) || header->element_size != sizeof(T) ||
+            header->capacity != Queue::capacity() || header->queue_stride != queue_stride()) {
+            throw std::runtime_error("Раскладка очередей в shm не совпадает с бинарником: " + name);
+        }
+        if (header->queue_count == 0 || header->queue_count > SHM_MAX_PEERS ||
+            region->size() < queues_offset() + queue_stride() * header->queue_count) {
+            throw std::runtime_error("Количество очередей в shm не соответствует размеру области: " + name);
+        }
+
+        return std::shared_ptr<ShmQueueSet>(new ShmQueueSet(region));
+    }
+
+    uint32_t queue_count() const noexcept { return header().queue_count; }
+
+    Queue& queue(uint32_t index) noexcept {
+        return *static_cast<Queue*>(queue_address(index));
+    }
+
+    /**
+     * shared_ptr на очередь, продлевающий жизнь всей области
+     * Позволяет передавать очереди в компоненты, принимающие std::shared_ptr<Queue>
+     */
+    std::shared_ptr<Queue> shared_queue(uint32_t index) {
+        return std::shared_ptr<Queue>(this->shared_from_this(), &queue(index));
+    }
+
+    ShmQueueHeader& header() const noexcept {
+        return *static_cast<ShmQueueHeader*>(region_->data());
+    }
+
+    ShmPeerSlot& peer(uint32_t index) const noexcept {
+        return header().peers[index];
+    }
+
+    /**
+     * Захват слота участника текущим процессом
+     * Слот упавшего процесса можно захватить повторно
+     */
+    void attach_peer(uint32_t index) {
+        ShmPeerSlot& slot = peer(index);
+        uint32_t state = slot.state.load(std::memory_order_acquire);
+
+        if (state == static_cast<uint32_t>(ShmPeerState::Attached) &&
+            process_alive(slot.pid.load(std::memory_order_relaxed))) {
+            throw std::runtime_error("Слот shm " + std::to_string(index) + " уже занят процессом " +
+                                     std::to_string(slot.pid.load(std::memory_order_relaxed)));
+        }
+
+        slot.pid.store(static_cast<int32_t>(getpid()), std::memory_order_relaxed);
+        slot.heartbeat_ns.store(now_ns(), std::memory_order_relaxed);
+        slot.state.store(static_cast<uint32_t>(ShmPeerState::Attached), std::memory_order_release);
+    }
+
+    /**
+     * Обновление heartbeat и счетчика отправленных сообщений (вне горячего пути)
+     */
+    void heartbeat(uint32_t index, uint64_t pushed) noexcept {
+        ShmPeerSlot& slot = peer(index);
+        slot.pushed.store(pushed, std::memory_order_relaxed);
+        slot.heartbeat_ns.store(now_ns(), std::memory_order_release);
+    }
+
+    void finish_peer(uint32_t index) noexcept {
+        peer(index).state.store(static_cast<uint32_t>(ShmPeerState::Finished),
+                                std::memory_order_release);
+    }
+
+    /**
+     * Проверка живости участника: процесс существует и heartbeat свежий
+     */
+    bool peer_alive(uint32_t index, uint64_t timeout_ns) const noexcept {
+        const ShmPeerSlot& slot = peer(index);
+        if (slot.state.load(std::memory_order_acquire) != static_cast<uint32_t>(ShmPeerState::Attached)) {
+            return false;
+        }
+        if (!process_alive(slot.pid.load(std::memory_order_relaxed))) {
+            return false;
+        }
+        return now_ns() - slot.heartbeat_ns.load(std::memory_order_acquire) <= timeout_ns;
+    }
+
+    static bool process_alive(int32_t pid) noexcept {
+        if (pid <= 0) {
+            return false;
+        }
+        return kill(pid, 0) == 0 || errno == EPERM;
+    }
+
+private:
+    std::shared_ptr<ShmRegion> region_;
+
+    explicit ShmQueueSet(std::shared_ptr<ShmRegion> region) : region_(std::move(region)) {}
+
+    static constexpr size_t round_up(size_t value, size_t alignment) {
+        return (value + alignment - 1) / alignment * alignment;
+    }
+
+    // Очереди выравниваются по странице, чтобы не делить страницы с заголовком
+    static constexpr size_t queues_offset() { return round_up(sizeof(ShmQueueHeader), 4096); }
+    static constexpr size_t queue_stride() { return round_up(sizeof(Queue), 4096); }
+
+    void* queue_address(uint32_t index) const noexcept {
+        return static_cast<char*>(region_->data()) + queues_offset() + queue_stride() * index;
+    }
+
+    static uint64_t now_ns() noexcept {
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count());
+    }
+};
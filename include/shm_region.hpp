@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+/**
+ * ShmRegion - область разделяемой памяти (POSIX shm_open или memfd)
+ *
+ * Именованная область (имя вида "/router_ingress") доступна любому процессу
+ * через attach(). Анонимная область (memfd) наследуется дочерними процессами
+ * после fork() и используется в бенчмарках.
+ *
+ * Все ошибки системных вызовов сообщаются исключением std::runtime_error.
+ */
+class ShmRegion {
+public:
+    ~ShmRegion();
+
+    ShmRegion(const ShmRegion&) = delete;
+    ShmRegion& operator=(const ShmRegion&) = delete;
+
+    static constexpr size_t NO_OWNER_PID = SIZE_MAX;
+
+    /**
+     * Создание именованной области (ошибка, если область уже существует)
+     * Владелец удаляет имя (shm_unlink) в деструкторе
+     * @param owner_pid_offset смещение int32 pid создателя в области: если имя
+     *        осталось от завершившегося процесса, оно удаляется и область создается заново
+     */
+    static std::shared_ptr<ShmRegion> create(const std::string& name, size_t size,
+                                             size_t owner_pid_offset = NO_OWNER_PID);
+
+    /**
+     * Создание анонимной области через memfd_create
+     */
+    static std::shared_ptr<ShmRegion> create_anonymous(size_t size);
+
+    /**
+     * Подключение к существующей именованной области
+     */
+    static std::shared_ptr<ShmRegion> attach(const std::string& name);
+
+    void* data() const noexcept { return data_; }
+    size_t size() const noexcept { return size_; }
+    const std::string& name() const noexcept { return name_; }
+
+private:
+    ShmRegion(std::string name, void* data, size_t size, bool owner);
+
+    std::string name_;      // Имя области (пустое для memfd)
+    void* data_;            // Адрес отображения
+    size_t size_;           // Размер отображения
+    bool owner_;            // Удалять ли имя при разрушении
+};
@@ -1,9 +1,13 @@
 #pragma once
 
+#include <algorithm>
 #include <atomic>
 #include <cstddef>
+#include <cstdint>
 #include <memory>
 #include <new>
+#include <span>
+#include <type_traits>
 
 // Размер cache line для предотвращения false sharing
 constexpr size_t CACHE_LINE_SIZE = 64;
@@ -16,6 +20,7 @@ constexpr size_t CACHE_LINE_SIZE = 64;
  * - Без блокировок, использует только атомарные операции
  * - Cache-aligned для избежания false sharing
  * - Поддерживает только POD типы для производительности
+ * - Ведет максимум заполнения и число эпизодов переполнения (пишет только producer)
  */
 template<typename T, size_t Capacity>
 class SPSCQueue {
@@ -23,6 +28,8 @@ class SPSCQueue {
                   "Capacity должна быть степенью двойки");
     static_assert(std::is_trivially_copyable_v<T>,
                   "T должен быть trivially copyable");
+    static_assert(alignof(T) <= CACHE_LINE_SIZE,
+                  "Выравнивание T больше cache line");
 
 public:
     SPSCQueue() : head_(0), tail_(0) {}
@@ -38,23 +45,80 @@ public:
      * - head_.load: acquire - синхронизация с consumer's release при pop
      * - tail_.store: release - публикация нового элемента для consumer
      *
+     * Счетчики заполнения обновляются обычной записью без RMW: их пишет только producer,
+     * и они лежат в его cache line рядом с tail_.
+     *
      * @param item элемент для добавления
      * @return true если успешно добавлен, false если очередь полная
      */
     bool try_push(const T& item) noexcept {
         const size_t current_tail = tail_.load(std::memory_order_relaxed);
         const size_t next_tail = (current_tail + 1) & (Capacity - 1);
+        const size_t current_head = head_.load(std::memory_order_acquire);
 
         // Проверка переполнения: если next_tail догнал head, очередь полная
-        if (next_tail == head_.load(std::memory_order_acquire)) {
+        if (next_tail == current_head) {
+            // Эпизод переполнения считается один раз до следующей успешной вставки
+            if (!full_.load(std::memory_order_relaxed)) {
+                full_.store(true, std::memory_order_relaxed);
+                full_events_.store(full_events_.load(std::memory_order_relaxed) + 1,
+                                   std::memory_order_relaxed);
+            }
             return false;
         }
 
-        buffer_[current_tail] = item;
+        slots()[current_tail] = item;
         tail_.store(next_tail, std::memory_order_release);
+
+        const size_t depth = (next_tail - current_head) & (Capacity - 1);
+        if (depth > high_watermark_.load(std::memory_order_relaxed)) {
+            high_watermark_.store(depth, std::memory_order_relaxed);
+        }
+        if (full_.load(std::memory_order_relaxed)) {
+            full_.store(false, std::memory_order_relaxed);
+        }
         return true;
     }
 
+    /**
+     * Добавление пакета элементов (producer side): столько, сколько помещается,
+     * с одной публикацией tail_ на весь пакет
+     *
+     * @param items элементы для добавления
+     * @return количество добавленных элементов (0 - очередь полная)
+     */
+    size_t try_push_batch(std::span<const T> items) noexcept {
+        const size_t current_tail = tail_.load(std::memory_order_relaxed);
+        const size_t current_head = head_.load(std::memory_order_acquire);
+        const size_t free_slots = (current_head - current_tail - 1) & (Capacity - 1);
+        const size_t count = std::min(free_slots, items.size());
+
+        if (count == 0) {
+            if (!items.empty() && !full_.load(std::memory_order_relaxed)) {
+                full_.store(true, std::memory_order_relaxed);
+                full_events_.store(full_events_.load(std::memory_order_relaxed) + 1,
+                                   std::memory_order_relaxed);
+            }
+            return 0;
+        }
+
+        // Копирование двумя участками, если пакет пересекает границу кольца
+        const size_t first = std::min(count, Capacity - current_tail);
+        std::copy_n(items.data(), first, slots() + current_tail);
+        std::copy_n(items.data() + first, count - first, slots());
+        const size_t next_tail = (current_tail + count) & (Capacity - 1);
+        tail_.store(next_tail, std::memory_order_release);
+
+        const size_t depth = (next_tail - current_head) & (Capacity - 1);
+        if (depth > high_watermark_.load(std::memory_order_relaxed)) {
+            high_watermark_.store(depth, std::memory_order_relaxed);
+        }
+        if (full_.load(std::memory_order_relaxed)) {
+            full_.store(false, std::memory_order_relaxed);
+        }
+        return count;
+    }
+
     /**
      * Попытка извлечь элемент из очереди (consumer side)
      *
@@ -74,11 +138,37 @@ public:
             return false;
         }
 
-        item = buffer_[current_head];
+        item = slots()[current_head];
         head_.store((current_head + 1) & (Capacity - 1), std::memory_order_release);
         return true;
     }
 
+    /**
+     * Доступ к непрерывному участку готовых элементов без копирования (consumer side)
+     * Элементы принадлежат consumer'у до вызова release() и могут изменяться на месте.
+     * Участок не пересекает границу кольца: остаток доступен следующим вызовом.
+     *
+     * @param max_count максимальная длина участка
+     * @return участок буфера, пустой если очередь пустая
+     */
+    std::span<T> peek(size_t max_count) noexcept {
+        const size_t current_head = head_.load(std::memory_order_relaxed);
+        const size_t current_tail = tail_.load(std::memory_order_acquire);
+
+        const size_t available = (current_tail >= current_head)
+            ? current_tail - current_head
+            : Capacity - current_head;
+        return std::span<T>(slots() + current_head, std::min(available, max_count));
+    }
+
+    /**
+     * Освобождение count элементов, полученных через peek() (consumer side)
+     */
+    void release(size_t count) noexcept {
+        const size_t current_head = head_.load(std::memory_order_relaxed);
+        head_.store((current_head + count) & (Capacity - 1), std::memory_order_release);
+    }
+
     /**
      * Проверка, пуста ли очередь
      * Внимание: результат может быть неактуальным в многопоточной среде
@@ -98,6 +188,34 @@ public:
         return (t >= h) ? (t - h) : (Capacity - h + t);
     }
 
+    /**
+     * Последний записанный элемент (producer side): новый писатель очереди, например
+     * процесс, заменивший упавший в слоте shm, продолжает нумерацию предшественника
+     * @return false если в очередь еще ничего не записывалось
+     */
+    bool last_pushed(T& item) const noexcept {
+        if (high_watermark_.load(std::memory_order_relaxed) == 0) {
+            return false;
+        }
+        const size_t current_tail = tail_.load(std::memory_order_acquire);
+        item = slots()[(current_tail - 1) & (Capacity - 1)];
+        return true;
+    }
+
+    /**
+     * Максимальное заполнение, наблюдавшееся producer'ом после вставки
+     */
+    size_t high_watermark() const noexcept {
+        return high_watermark_.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * Количество эпизодов переполнения (серия неудачных try_push считается одним)
+     */
+    uint64_t full_events() const noexcept {
+        return full_events_.load(std::memory_order_relaxed);
+    }
+
     /**
      * Максимальная вместимость очереди
      */
@@ -109,5 +227,16 @@ private:
     // Выравнивание по cache line для избежания false sharing
     alignas(CACHE_LINE_SIZE) std::atomic<size_t> head_;
     alignas(CACHE_LINE_SIZE) std::atomic<size_t> tail_;
-    alignas(CACHE_LINE_SIZE) T buffer_[Capacity];
+    // Счетчики producer'а в той же cache line, что и tail_
+    std::atomic<size_t> high_watermark_{0};
+    std::atomic<uint64_t> full_events_{0};
+    std::atomic<bool> full_{false};
+
+    // Слоты без конструирования элементов: T trivially copyable, значение появляется
+    // при записи producer'ом. Конструктор не касается страниц буфера - память
+    // выделяется ОС при первой записи (или заранее, см. QueueArena::prefault)
+    alignas(CACHE_LINE_SIZE) std::byte storage_[Capacity * sizeof(T)];
+
+    T* slots() noexcept { return reinterpret_cast<T*>(storage_); }
+    const T* slots() const noexcept { return reinterpret_cast<const T*>(storage_); }
 };
@@ -0,0 +1,98 @@
+#pragma once
+
+#include "config.hpp"
+#include "processor.hpp"
+#include "router.hpp"
+#include <atomic>
+#include <memory>
+#include <vector>
+
+/**
+ * StallWatchdog - обнаружение остановившихся процессоров и обход их в Stage1
+ *
+ * Периодически сравнивает счетчик прогресса каждого процессора с прошлым опросом.
+ * Процессор остановлен, если его входная очередь не пуста, а прогресса нет дольше
+ * stall_threshold_us (поток снят с ядра, пауза в обработчике, шторм page fault).
+ * Пока процессор остановлен, Stage1 исключает его из балансировки типов без
+ * требования порядка (ordering_required=false), у которых в наборе есть другие
+ * процессоры; типы с порядком продолжают ждать его. Процессор возвращается в
+ * балансировку, когда прогресс возобновился и очередь опустилась до restore_depth.
+ */
+class StallWatchdog {
+public:
+    using ProcessorQueue = SPSCQueue<Message, PROCESSOR_QUEUE_SIZE>;
+
+    StallWatchdog(
+        const SystemConfig& config,
+        Stage1Router& stage1_router,
+        std::vector<std::unique_ptr<Processor>>& processors,
+        std::vector<std::shared_ptr<ProcessorQueue>>& processor_queues
+    );
+
+    /**
+     * Основной цикл сторожа (запускается в отдельном потоке)
+     */
+    void run(std::atomic<bool>& running);
+
+    /**
+     * Вывод текущего состояния (вызывается из мониторинга)
+     */
+    void print_current_state() const;
+
+    /**
+     * Вывод итогового отчета об остановках (после остановки потока сторожа)
+     */
+    void print_report() const;
+
+private:
+    /**
+     * Остановка процессора: моменты в наносекундах (0 - еще не наступил)
+     */
+    struct StallEvent {
+        uint8_t processor = 0;
+        uint64_t last_progress_ns = 0;  // Последний замеченный прогресс
+        uint64_t detected_ns = 0;       // Обнаружение остановки
+        uint64_t resumed_ns = 0;        // Возобновление прогресса
+        uint64_t restored_ns = 0;       // Возврат в балансировку
+        size_t depth = 0;               // Глубина очереди при обнаружении
+        size_t peak_depth = 0;          // Максимальная глубина за время остановки
+        bool rerouted = false;          // Были ли типы, перенаправленные на другие процессоры
+    };
+
+    /**
+     * Состояние наблюдения за одним процессором
+     */
+    struct Watch {
+        uint64_t progress = 0;          // Счетчик прогресса на прошлом опросе
+        uint64_t progress_ns = 0;       // Момент последнего изменения счетчика
+        int event = -1;                 // Индекс открытой остановки (-1 - работает)
+    };
+
+    WatchdogConfig config_;
+    Stage1Router& stage1_router_;
+    std::vector<std::unique_ptr<Processor>>& processors_;
+    std::vector<std::shared_ptr<ProcessorQueue>>& processor_queues_;
+
+    // Типы без требования порядка, которые можно отвести от процессора
+    std::vector<std::vector<uint8_t>> reroutable_types_;
+
+    std::vector<Watch> watches_;
+    std::vector<StallEvent> events_;    // Пишет только поток сторожа
+    uint64_t start_ns_ = 0;
+
+    // Счетчики для периодического отчета
+    std::atomic<uint64_t> stalls_{0};
+    std::atomic<uint32_t> stalled_now_{0};
+    std::atomic<uint32_t> excluded_now_{0};
+
+    /**
+     * Один шаг сторожа
+     */
+    void tick(uint64_t now_ns);
+
+    /**
+     * Исключение процессора из балансировки и возврат в нее
+     */
+    void exclude(uint8_t processor_id);
+    void restore(uint8_t processor_id);
+};
@@ -1,13 +1,19 @@
 #pragma once
 
 #include "message.hpp"
+#include "dimension_stats.hpp"
+#include "stats_snapshot.hpp"
+#include <array>
 #include <atomic>
 #include <vector>
 #include <map>
+#include <memory>
 #include <algorithm>
 #include <cstdint>
 #include <string>
 #include <mutex>
+#include <span>
+#include <unordered_map>
 
 /**
  * Структура для хранения статистики задержек
@@ -46,23 +52,59 @@ struct LatencyStats {
         if (latencies.empty()) return 0.0;
         return *std::max_element(latencies.begin(), latencies.end());
     }
+    double mean() const {
+        if (latencies.empty()) return 0.0;
+        double sum = 0.0;
+        for (double latency : latencies) {
+            sum += latency;
+        }
+        return sum / static_cast<double>(latencies.size());
+    }
 };
 
 /**
  * Отслеживание порядка сообщений от конкретного производителя
+ * Порядок проверяется по routing_key (без producers.keys ключ равен типу)
  */
 struct OrderTracker {
-    std::map<uint8_t, uint64_t> last_sequence;  // Последний seq_num для каждого типа
+    std::unordered_map<uint32_t, uint64_t> last_sequence;  // Последний seq_num для каждого ключа
     std::atomic<uint64_t> messages_received{0};
     std::atomic<uint64_t> order_violations{0};
     std::mutex tracker_mutex;  // Защита last_sequence от race condition
 
-    void track(const Message& msg) {
+    void track(const Message& msg, bool check_order = true) {
         messages_received.fetch_add(1, std::memory_order_relaxed);
+        if (!check_order) {
+            return;
+        }
 
         std::lock_guard<std::mutex> lock(tracker_mutex);
+        check_locked(msg);
+    }
+
+    /**
+     * Отслеживание пакета сообщений этого производителя под одной блокировкой
+     */
+    template<typename Element>
+    void track_batch(std::span<const Element> batch, const std::array<bool, 256>& exempt_types) {
+        messages_received.fetch_add(batch.size(), std::memory_order_relaxed);
+
+        std::lock_guard<std::mutex> lock(tracker_mutex);
+        for (const Element& element : batch) {
+            const Message& msg = batch_message(element);
+            if (!exempt_types[msg.msg_type]) {
+                check_locked(msg);
+            }
+        }
+    }
+
+    bool is_ordered() const {
+        return order_violations.load(std::memory_order_relaxed) == 0;
+    }
 
-        uint8_t key = msg.msg_type;
+private:
+    void check_locked(const Message& msg) {
+        const uint32_t key = msg.routing_key;
         auto it = last_sequence.find(key);
 
         if (it != last_sequence.end()) {
@@ -70,13 +112,10 @@ struct OrderTracker {
             if (msg.sequence_number <= it->second) {
                 order_violations.fetch_add(1, std::memory_order_relaxed);
             }
+            it->second = msg.sequence_number;
+        } else {
+            last_sequence[key] = msg.sequence_number;
         }
-
-        last_sequence[key] = msg.sequence_number;
-    }
-
-    bool is_ordered() const {
-        return order_violations.load(std::memory_order_relaxed) == 0;
     }
 };
 
@@ -85,10 +124,8 @@ struct OrderTracker {
  */
 class SystemStatistics {
 public:
-    // Счетчики сообщений
-    std::atomic<uint64_t> messages_produced{0};
-    std::atomic<uint64_t> messages_processed{0};
-    std::atomic<uint64_t> messages_delivered{0};
+    // Счетчики сообщений: блоки потоков под seqlock (stats_snapshot.hpp)
+    StatsBlocks workers;
     std::atomic<uint64_t> messages_lost{0};
 
     // Глубины очередей (по индексам) - используем unique_ptr чтобы избежать проблем с move
@@ -99,11 +136,24 @@ public:
     LatencyStats stage1_latencies;
     LatencyStats processing_latencies;
     LatencyStats stage2_latencies;
+    LatencyStats delivery_latencies;
     LatencyStats total_latencies;
 
+    // Время ожидания в очередях между компонентами (delivery_latencies - очередь стратегии)
+    LatencyStats producer_queue_dwell;
+    LatencyStats processor_queue_dwell;
+    LatencyStats stage2_queue_dwell;
+    LatencyStats delivered_latencies;   // От создания до получения стратегией
+
+    // Счетчики и гистограммы задержки по типам и производителям (шарды потоков)
+    DimensionStats dimensions;
+
     // Отслеживание порядка для каждого производителя (используем unique_ptr чтобы избежать проблем с move)
     std::vector<std::unique_ptr<OrderTracker>> producer_order_trackers;
 
+    // Типы без требования порядка (ordering_required=false в stage2_rules)
+    std::array<bool, 256> order_exempt_types{};
+
     // Мьютекс для защиты latency stats (mutable для использования в const методах)
     mutable std::mutex latency_mutex;
 
@@ -122,22 +172,70 @@ public:
         }
     }
 
+    /**
+     * Увеличение счетчика в блоке текущего потока (без общих атомарных RMW)
+     */
+    void count(StatsField field, uint64_t n) {
+        workers.local().add(field, n);
+    }
+
+    /**
+     * Согласованный снимок счетчиков (сумма блоков потоков)
+     */
+    StatsCounters counters() const {
+        return workers.snapshot();
+    }
+
+    /**
+     * Sampling: записываем только каждое 1000-е сообщение для снижения overhead
+     */
+    static bool latency_sampled(const Message& msg) {
+        return msg.sequence_number % 1000 == 0;
+    }
+
     /**
      * Добавление информации о задержке из обработанного сообщения
      * Используется sampling для снижения contention на мьютексе
      */
     void record_message_latencies(const Message& msg) {
-        // Sampling: записываем только каждое 1000-е сообщение для снижения overhead
-        if (msg.sequence_number % 1000 != 0) {
+        if (!latency_sampled(msg)) {
             return;
         }
 
+        // Суммы выборки для периодической строки: монитор не берет latency_mutex
+        {
+            StatsBlock::Update update(workers.local());
+            update.add(StatsField::LatencySamples, 1);
+            update.add(StatsField::Stage1Ns, static_cast<uint64_t>(msg.stage1_latency_us() * 1000.0));
+            update.add(StatsField::ProcessingNs, static_cast<uint64_t>(msg.processing_latency_us() * 1000.0));
+            update.add(StatsField::Stage2Ns, static_cast<uint64_t>(msg.stage2_latency_us() * 1000.0));
+            update.add(StatsField::TotalNs, static_cast<uint64_t>(msg.end_to_end_latency_us() * 1000.0));
+        }
+
         std::lock_guard<std::mutex> lock(latency_mutex);
 
         stage1_latencies.add(msg.stage1_latency_us());
         processing_latencies.add(msg.processing_latency_us());
         stage2_latencies.add(msg.stage2_latency_us());
+        delivery_latencies.add(msg.delivery_latency_us());
         total_latencies.add(msg.end_to_end_latency_us());
+
+        producer_queue_dwell.add(msg.producer_queue_dwell_us());
+        processor_queue_dwell.add(msg.processor_queue_dwell_us());
+        stage2_queue_dwell.add(msg.stage2_queue_dwell_us());
+        delivered_latencies.add(msg.delivered_latency_us());
+    }
+
+    /**
+     * Сброс накопленных задержек (например после прогрева в бенчмарке)
+     */
+    void clear_latencies() {
+        std::lock_guard<std::mutex> lock(latency_mutex);
+        for (LatencyStats* stats : {&stage1_latencies, &processing_latencies, &stage2_latencies,
+                                    &delivery_latencies, &total_latencies, &producer_queue_dwell,
+                                    &processor_queue_dwell, &stage2_queue_dwell, &delivered_latencies}) {
+            stats->clear();
+        }
     }
 
     /**
@@ -145,12 +243,36 @@ public:
      */
     void track_message_order(const Message& msg) {
         if (msg.producer_id < producer_order_trackers.size()) {
-            producer_order_trackers[msg.producer_id]->track(msg);
+            producer_order_trackers[msg.producer_id]->track(msg, !order_exempt_types[msg.msg_type]);
+        }
+    }
+
+    /**
+     * Отслеживание порядка пакета: подряд идущие сообщения одного производителя
+     * проверяются под одной блокировкой его трекера
+     * Элементы пакета - сообщения или указатели на слоты (кольцевой режим)
+     */
+    template<typename Element>
+    void track_batch_order(std::span<const Element> batch) {
+        size_t begin = 0;
+        while (begin < batch.size()) {
+            const uint8_t producer_id = batch_message(batch[begin]).producer_id;
+            size_t end = begin + 1;
+            while (end < batch.size() && batch_message(batch[end]).producer_id == producer_id) {
+                ++end;
+            }
+
+            if (producer_id < producer_order_trackers.size()) {
+                producer_order_trackers[producer_id]->track_batch(
+                    batch.subspan(begin, end - begin), order_exempt_types);
+            }
+            begin = end;
         }
     }
 
     /**
-     * Вывод текущей статистики (каждую секунду)
+     * Вывод текущей статистики (каждую секунду, только поток мониторинга)
+     * Счетчики и скорости - из одного снимка блоков, приращения - с прошлого вызова
      */
     void print_current_stats(double elapsed_secs) const;
 
@@ -159,15 +281,22 @@ public:
      */
     void print_final_report(const std::string& scenario, double duration_secs) const;
 
+    /**
+     * Разбивка задержки до стратегии по этапам и очередям (вызывается под latency_mutex)
+     */
+    void print_latency_breakdown() const;
+
     /**
      * Проверка, все ли сообщения доставлены корректно
      */
     bool validate() const {
-        uint64_t produced = messages_produced.load(std::memory_order_relaxed);
-        uint64_t delivered = messages_delivered.load(std::memory_order_relaxed);
+        const StatsCounters totals = counters();
+        uint64_t produced = totals[StatsField::Produced];
+        uint64_t delivered = totals[StatsField::Delivered];
+        uint64_t rejected = totals[StatsField::Rejected] + totals[StatsField::Shed];
 
-        // Проверка потерь
-        if (produced != delivered) {
+        // Проверка потерь (отклоненные обработчиками и сброшенные допуском не считаются потерянными)
+        if (produced != delivered + rejected) {
             return false;
         }
 
@@ -191,4 +320,9 @@ public:
         }
         return total;
     }
+
+private:
+    // Предыдущий снимок периодического отчета
+    mutable StatsCounters last_interval_;
+    mutable double last_elapsed_ = 0.0;
 };
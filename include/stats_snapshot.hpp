@@ -0,0 +1,190 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+/**
+ * Счетчики блока статистики потока
+ * Задержки - сумма по выборке latency_sampled (каждое 1000-е сообщение), наносекунды
+ */
+enum class StatsField : size_t {
+    Produced,
+    Processed,
+    Delivered,
+    Rejected,       // Отклонены обработчиками (handlers.hpp)
+    Shed,           // Сброшены контролем допуска Stage1 (admission.hpp)
+    Multicast,      // Доставки multicast не первым получателям группы
+    LatencySamples,
+    Stage1Ns,
+    ProcessingNs,
+    Stage2Ns,
+    TotalNs,
+    Count
+};
+
+constexpr size_t STATS_FIELDS = static_cast<size_t>(StatsField::Count);
+
+/**
+ * Снимок счетчиков (одного блока или сумма блоков)
+ */
+struct StatsCounters {
+    std::array<uint64_t, STATS_FIELDS> values{};
+
+    uint64_t operator[](StatsField field) const noexcept {
+        return values[static_cast<size_t>(field)];
+    }
+
+    void add(const StatsCounters& other) noexcept {
+        for (size_t i = 0; i < STATS_FIELDS; ++i) {
+            values[i] += other.values[i];
+        }
+    }
+
+    /**
+     * Приращение с момента earlier
+     */
+    StatsCounters since(const StatsCounters& earlier) const noexcept {
+        StatsCounters delta;
+        for (size_t i = 0; i < STATS_FIELDS; ++i) {
+            delta.values[i] = values[i] - earlier.values[i];
+        }
+        return delta;
+    }
+
+    /**
+     * Средняя задержка участка по выборке, мкс
+     */
+    double mean_us(StatsField field) const noexcept {
+        const uint64_t samples = (*this)[StatsField::LatencySamples];
+        return samples > 0 ? static_cast<double>((*this)[field]) / static_cast<double>(samples) / 1000.0 : 0.0;
+    }
+};
+
+/**
+ * StatsBlock - счетчики одного потока под seqlock
+ *
+ * Пишет только поток-владелец: номер версии становится нечетным, поля
+ * обновляются, номер снова четный. Читатель копирует поля и повторяет
+ * копирование, если версия была нечетной или изменилась, - писатель никогда
+ * не ждет читателя, а читатель получает поля из одного момента потока
+ * (например, доставленные и отклоненные одного пакета вместе).
+ * Поля атомарны (relaxed) только для отсутствия гонки данных в модели памяти C++.
+ */
+class alignas(64) StatsBlock {
+public:
+    /**
+     * Секция записи: несколько полей публикуются одной версией
+     */
+    class Update {
+    public:
+        explicit Update(StatsBlock& block) noexcept : block_(block) { block_.begin(); }
+        ~Update() { block_.end(); }
+
+        Update(const Update&) = delete;
+        Update& operator=(const Update&) = delete;
+
+        void add(StatsField field, uint64_t n) noexcept { block_.bump(field, n); }
+
+    private:
+        StatsBlock& block_;
+    };
+
+    /**
+     * Одно поле отдельной секцией записи
+     */
+    void add(StatsField field, uint64_t n) noexcept {
+        begin();
+        bump(field, n);
+        end();
+    }
+
+    /**
+     * Согласованная копия полей; возвращает число повторов из-за параллельной записи
+     */
+    uint64_t read(StatsCounters& out) const noexcept {
+        uint64_t retries = 0;
+        for (;;) {
+            const uint64_t before = sequence_.load(std::memory_order_acquire);
+            if ((before & 1) == 0) {
+                for (size_t i = 0; i < STATS_FIELDS; ++i) {
+                    out.values[i] = fields_[i].load(std::memory_order_relaxed);
+                }
+                std::atomic_thread_fence(std::memory_order_acquire);
+                if (sequence_.load(std::memory_order_relaxed) == before) {
+                    return retries;
+                }
+            }
+            ++retries;
+            __builtin_ia32_pause();
+        }
+    }
+
+private:
+    std::atomic<uint64_t> sequence_{0};
+    std::array<std::atomic<uint64_t>, STATS_FIELDS> fields_{};
+
+    void begin() noexcept {
+        sequence_.store(sequence_.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        // Нечетная версия видна раньше любого из новых значений полей
+        std::atomic_thread_fence(std::memory_order_release);
+    }
+
+    void end() noexcept {
+        sequence_.store(sequence_.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+
+    void bump(StatsField field, uint64_t n) noexcept {
+        std::atomic<uint64_t>& counter = fields_[static_cast<size_t>(field)];
+        counter.store(counter.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+    }
+};
+
+/**
+ * StatsBlocks - блоки статистики потоков
+ *
+ * Поток получает свой блок при первой записи (как шарды DimensionStats) и
+ * пишет только в него: общих атомарных RMW на горячем пути нет. snapshot()
+ * складывает согласованные копии блоков. Блоки разных потоков копируются
+ * последовательно, поэтому сумма - не мгновенный срез всей системы, но каждое
+ * сообщение учтено в ровно одном снимке, и разности соседних снимков точны.
+ */
+class StatsBlocks {
+public:
+    StatsBlocks();
+
+    StatsBlocks(const StatsBlocks&) = delete;
+    StatsBlocks& operator=(const StatsBlocks&) = delete;
+
+    StatsBlock& local() {
+        thread_local uint64_t owner = 0;
+        thread_local StatsBlock* block = nullptr;
+        if (owner != id_) [[unlikely]] {
+            block = add_block();
+            owner = id_;
+        }
+        return *block;
+    }
+
+    StatsCounters snapshot() const;
+
+    /**
+     * Повторы копирования блоков из-за параллельной записи (за все снимки)
+     */
+    uint64_t read_retries() const noexcept { return retries_.load(std::memory_order_relaxed); }
+
+    size_t blocks() const;
+
+private:
+    uint64_t id_;   // Уникален для процесса: кэш блока потока не спутает экземпляры по адресу
+
+    mutable std::mutex blocks_mutex_;   // Только регистрация блоков и обход списка
+    std::vector<std::unique_ptr<StatsBlock>> blocks_;
+    mutable std::atomic<uint64_t> retries_{0};
+
+    StatsBlock* add_block();
+};
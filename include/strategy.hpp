@@ -3,19 +3,39 @@
 #include "message.hpp"
 #include "config.hpp"
 #include "spsc_queue.hpp"
+#include "broadcast_ring.hpp"
 #include "statistics.hpp"
+#include "journal.hpp"
+#include "coro_runtime.hpp"
+#include "handlers.hpp"
+#include "flight_recorder.hpp"
+#include <algorithm>
 #include <atomic>
 #include <memory>
-#include <unordered_map>
+#include <span>
+#include <vector>
 
 constexpr size_t STRATEGY_QUEUE_SIZE = 65536;
 
 /**
  * Strategy - финальный получатель сообщений, проверяет порядок
+ *
+ * Сообщения доставляются пакетами: непрерывный участок входной очереди
+ * (все готовые сообщения, не больше max_batch) передается обработчику
+ * без копирования, учет порядка, журнал и счетчики ведутся на пакет.
+ *
+ * Логика стратегии подключается обработчиком (см. handlers.hpp) через run_with;
+ * run() вызывает on_batch.
+ *
+ * Стратегия может быть подписана на кольца multicast-групп: сообщения кольца
+ * передаются обработчику только для чтения (ReadOnlyBatchHandler) прямо в кольце,
+ * остальным обработчикам - через локальную копию пакета. Доставку учитывает
+ * только первый получатель группы, остальные увеличивают счетчик Multicast.
  */
 class Strategy {
 public:
     using InputQueue = SPSCQueue<Message, STRATEGY_QUEUE_SIZE>;
+    using MulticastRing = BroadcastRing<Message, MULTICAST_RING_SIZE>;
 
     Strategy(
         uint8_t id,
@@ -29,16 +49,212 @@ public:
      */
     void run(std::atomic<bool>& running);
 
+    /**
+     * Обработка пакета по умолчанию: имитация времени обработки
+     * (одно активное ожидание на весь пакет)
+     */
+    void on_batch(std::span<const Message> batch);
+
+    /**
+     * Основной цикл с пользовательским обработчиком
+     * Отклоненные обработчиком сообщения учитываются в счетчике Rejected
+     */
+    template<typename Handler>
+    void run_with(std::atomic<bool>& running, Handler handler);
+
+    /**
+     * Основной цикл стратегии в виде корутины (режим runtime.mode = coroutines)
+     */
+    CoroTask run_coro(CoroScheduler& scheduler, std::atomic<bool>& running);
+
+    template<typename Handler>
+    CoroTask run_coro_with(CoroScheduler& scheduler, std::atomic<bool>& running, Handler handler);
+
+    /**
+     * Подключение журнала доставленных сообщений (nullptr - без журнала)
+     */
+    void set_journal(JournalWriter* journal) { journal_ = journal; }
+
+    /**
+     * Подписка на кольцо multicast-группы (до запуска)
+     * @param reader номер читателя стратегии в кольце
+     * @param primary первый получатель группы: ведет учет доставки (счетчики, порядок, журнал)
+     */
+    void add_multicast(std::shared_ptr<MulticastRing> ring, size_t reader, bool primary);
+
 private:
+    struct MulticastInput {
+        std::shared_ptr<MulticastRing> ring;
+        size_t reader;
+        bool primary;
+    };
+
     uint8_t id_;                        // ID стратегии
     std::shared_ptr<InputQueue> input_queue_;
     SystemStatistics& stats_;
 
-    // Время обработки (наносекунды)
+    // Время обработки одного сообщения (наносекунды)
     uint64_t processing_time_ns_;
 
+    // Максимальный размер пакета доставки
+    size_t max_batch_;
+
+    // Журнал доставленных сообщений (опционально)
+    JournalWriter* journal_ = nullptr;
+
+    // Подписки на кольца multicast и буфер копии пакета для изменяющих обработчиков
+    std::vector<MulticastInput> multicast_;
+    std::vector<Message> scratch_;
+
+    /**
+     * Обработка пакета: отметка времени получения, вызов обработчика, учет
+     */
+    template<typename Handler>
+    void handle_batch(Handler& handler, std::span<Message> batch);
+
     /**
-     * Обработка полученного сообщения
+     * Учет обработанных сообщений: журнал, порядок, задержки, счетчики
      */
-    void process_message(const Message& msg);
+    void deliver_batch(std::span<const Message> delivered, size_t rejected);
+
+    /**
+     * Обработка готовых сообщений всех колец multicast
+     * @return количество обработанных сообщений
+     */
+    template<typename Handler>
+    size_t poll_multicast(Handler& handler, size_t max_count);
+
+    /**
+     * Обработка пакета multicast (сообщения в кольце не изменяются)
+     */
+    template<typename Handler>
+    void handle_shared_batch(Handler& handler, bool primary, std::span<const Message> batch);
+
+    /**
+     * Учет пакета multicast; время получения передается отдельно
+     */
+    void deliver_shared_batch(std::span<const Message> delivered, size_t rejected,
+                              uint64_t entry_ns, bool primary);
+
+    /**
+     * Условие готовности корутины: непуста входная очередь или одно из колец
+     */
+    static bool input_ready(const void* self, uint64_t, uint64_t) noexcept;
 };
+
+template<typename Handler>
+void Strategy::handle_batch(Handler& handler, std::span<Message> batch) {
+    // Сообщения пакета получены одновременно
+    const uint64_t entry_ns = Message::get_timestamp_ns();
+    for (Message& msg : batch) {
+        msg.strategy_entry_ns = entry_ns;
+    }
+
+    const size_t kept = invoke_handler_batch(handler, batch);
+    deliver_batch(batch.first(kept), batch.size() - kept);
+}
+
+template<typename Handler>
+void Strategy::handle_shared_batch(Handler& handler, bool primary, std::span<const Message> batch) {
+    const uint64_t entry_ns = Message::get_timestamp_ns();
+
+    if constexpr (ReadOnlyBatchHandler<Handler>) {
+        // Обработчик только читает: пакет обрабатывается прямо в кольце
+        handler(batch);
+        deliver_shared_batch(batch, 0, entry_ns, primary);
+    } else {
+        // Обработчик может изменять и отклонять сообщения: работаем с копией
+        std::span<Message> copy(scratch_.data(), batch.size());
+        std::copy(batch.begin(), batch.end(), copy.begin());
+        for (Message& msg : copy) {
+            msg.strategy_entry_ns = entry_ns;
+        }
+        const size_t kept = invoke_handler_batch(handler, copy);
+        deliver_shared_batch(copy.first(kept), copy.size() - kept, entry_ns, primary);
+    }
+}
+
+template<typename Handler>
+size_t Strategy::poll_multicast(Handler& handler, size_t max_count) {
+    size_t handled = 0;
+    for (const MulticastInput& input : multicast_) {
+        std::span<const Message> batch = input.ring->peek(input.reader, max_count);
+        if (batch.empty()) {
+            continue;
+        }
+        FR_EVENT(Pop, id_, batch.size());
+
+        handle_shared_batch(handler, input.primary, batch);
+        input.ring->release(input.reader, batch.size());
+        handled += batch.size();
+    }
+    return handled;
+}
+
+template<typename Handler>
+void Strategy::run_with(std::atomic<bool>& running, Handler handler) {
+    FR_THREAD("strategy", id_);
+    bool idle = false;
+
+    while (running.load(std::memory_order_relaxed)) {
+        // Сообщения multicast читаются на месте в кольцах групп
+        const size_t multicast = multicast_.empty() ? 0 : poll_multicast(handler, max_batch_);
+
+        // Все готовые сообщения (до max_batch) прямо в буфере очереди
+        std::span<Message> batch = input_queue_->peek(max_batch_);
+        if (batch.empty()) {
+            if (multicast > 0) {
+                idle = false;
+                continue;
+            }
+            if (!idle) {
+                FR_EVENT(Idle, id_, 0);
+                idle = true;
+            }
+            // Если очередь пустая, минимальная пауза
+            __builtin_ia32_pause();
+            continue;
+        }
+        idle = false;
+        FR_EVENT(Pop, id_, batch.size());
+
+        handle_batch(handler, batch);
+        input_queue_->release(batch.size());
+    }
+}
+
+template<typename Handler>
+CoroTask Strategy::run_coro_with(CoroScheduler& scheduler, std::atomic<bool>& running, Handler handler) {
+    uint32_t budget = scheduler.batch();
+
+    while (running.load(std::memory_order_relaxed)) {
+        // Пакет ограничен и размером доставки, и бюджетом возобновления
+        const size_t max_count = std::min<size_t>(max_batch_, budget);
+        std::span<Message> batch = input_queue_->peek(max_count);
+        size_t count = batch.size();
+        if (!batch.empty()) {
+            handle_batch(handler, batch);
+            input_queue_->release(batch.size());
+        }
+        if (!multicast_.empty()) {
+            count += poll_multicast(handler, max_count);
+        }
+
+        if (count == 0) {
+            if (multicast_.empty()) {
+                co_await scheduler.readable(*input_queue_);
+            } else {
+                co_await CoroScheduler::Wait(scheduler, &Strategy::input_ready, this, 0, false);
+            }
+            budget = scheduler.batch();
+            continue;
+        }
+
+        if (budget <= count) {
+            co_await scheduler.yield();
+            budget = scheduler.batch();
+        } else {
+            budget -= static_cast<uint32_t>(count);
+        }
+    }
+}
@@ -0,0 +1,197 @@
+#pragma once
+
+#include "message.hpp"
+#include "spsc_queue.hpp"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <span>
+#include <utility>
+#include <vector>
+
+// Водяной знак закрытой полосы: сообщений больше не будет
+constexpr uint64_t WATERMARK_CLOSED = std::numeric_limits<uint64_t>::max();
+
+/**
+ * Водяной знак (heartbeat) источника полос: ни одно будущее сообщение источника
+ * не будет иметь timestamp_ns меньше знака
+ *
+ * Источник продвигает знак после отправки сообщений (release), поэтому слияние,
+ * прочитавшее знак W и пустую полосу, знает, что сообщений старше W в ней не появится.
+ */
+struct alignas(CACHE_LINE_SIZE) Watermark {
+    std::atomic<uint64_t> value{0};
+
+    void advance(uint64_t timestamp_ns) noexcept {
+        value.store(timestamp_ns, std::memory_order_release);
+    }
+
+    void close() noexcept {
+        value.store(WATERMARK_CLOSED, std::memory_order_release);
+    }
+
+    uint64_t load() const noexcept {
+        return value.load(std::memory_order_acquire);
+    }
+};
+
+/**
+ * TimestampMerge - k-way слияние полос по timestamp_ns на дереве проигравших (loser tree)
+ *
+ * Каждая полоса - SPSC очередь с неубывающими timestamp_ns и водяным знаком источника.
+ * Ключ листа - время головы полосы, а для пустой полосы - ее водяной знак (фантом).
+ * Ключи только растут, поэтому устаревший ключ - нижняя граница: если победитель
+ * дерева - настоящая голова, она не старше всего, что еще может прийти. Если побеждает
+ * фантом, лист перечитывается; не изменился - слияние ждет знака (полоса блокирует).
+ *
+ * Выбор следующего сообщения - log2(k) сравнений вдоль пути листа.
+ * Используется одним потоком-потребителем полос.
+ */
+template<typename Lane>
+class TimestampMerge {
+public:
+    /**
+     * Добавление полосы (до первого merge)
+     */
+    void add_input(Lane* lane, const Watermark* watermark) {
+        inputs_.push_back({lane, watermark});
+        keys_.push_back({0, true});
+        built_ = false;
+    }
+
+    /**
+     * Извлечение до max_count сообщений в порядке timestamp_ns
+     * @param emit вызывается для каждого сообщения (Message&) до его освобождения в полосе
+     * @return количество извлеченных сообщений
+     */
+    template<typename Emit>
+    size_t merge(size_t max_count, Emit emit) {
+        if (inputs_.empty()) {
+            return 0;
+        }
+        if (!built_) {
+            build();
+        }
+
+        size_t count = 0;
+        while (count < max_count) {
+            const uint32_t leaf = winner_;
+            if (keys_[leaf].phantom) {
+                // Пустая полоса с наименьшим знаком: возможно, пришли данные или знак продвинулся
+                const Key before = keys_[leaf];
+                refresh(leaf);
+                if (keys_[leaf].phantom && keys_[leaf].timestamp_ns == before.timestamp_ns) {
+                    // Эпизод ожидания считается один раз до следующего извлеченного сообщения
+                    if (!stalled_ && before.timestamp_ns != WATERMARK_CLOSED) {
+                        ++blocked_;
+                        stalled_ = true;
+                    }
+                    break;
+                }
+                replay(leaf);
+                continue;
+            }
+
+            Lane& lane = *inputs_[leaf].lane;
+            emit(lane.peek(1)[0]);
+            lane.release(1);
+            ++count;
+            stalled_ = false;
+
+            refresh(leaf);
+            replay(leaf);
+        }
+        merged_ += count;
+        return count;
+    }
+
+    /**
+     * Нижняя граница timestamp_ns следующего извлеченного сообщения
+     * (водяной знак для следующего уровня слияния)
+     */
+    uint64_t frontier() const noexcept {
+        return keys_.empty() ? WATERMARK_CLOSED : keys_[winner_].timestamp_ns;
+    }
+
+    size_t inputs() const noexcept { return inputs_.size(); }
+
+    /**
+     * Извлечено сообщений всего
+     */
+    uint64_t merged() const noexcept { return merged_; }
+
+    /**
+     * Эпизодов ожидания водяного знака пустой полосы
+     */
+    uint64_t blocked() const noexcept { return blocked_; }
+
+private:
+    struct Input {
+        Lane* lane;
+        const Watermark* watermark;
+    };
+
+    struct Key {
+        uint64_t timestamp_ns;
+        bool phantom;                   // Пустая полоса: ключ - водяной знак
+    };
+
+    // При равном времени настоящая голова выигрывает у фантома
+    static bool less(const Key& a, const Key& b) noexcept {
+        return a.timestamp_ns < b.timestamp_ns || (a.timestamp_ns == b.timestamp_ns && !a.phantom && b.phantom);
+    }
+
+    void refresh(uint32_t leaf) noexcept {
+        // Знак читается до проверки полосы: сообщения старше знака уже видны в ней
+        const uint64_t watermark = inputs_[leaf].watermark->load();
+        std::span<Message> head = inputs_[leaf].lane->peek(1);
+        keys_[leaf] = head.empty() ? Key{watermark, true} : Key{head[0].timestamp_ns, false};
+    }
+
+    /**
+     * Проход от листа к корню: в узлах остаются проигравшие, наверх идет победитель
+     */
+    void replay(uint32_t leaf) noexcept {
+        const size_t k = inputs_.size();
+        uint32_t winner = leaf;
+        for (size_t node = (leaf + k) / 2; node > 0; node /= 2) {
+            if (less(keys_[losers_[node]], keys_[winner])) {
+                std::swap(losers_[node], winner);
+            }
+        }
+        winner_ = winner;
+    }
+
+    /**
+     * Построение дерева: листья k..2k-1, внутренние узлы 1..k-1
+     */
+    void build() {
+        const size_t k = inputs_.size();
+        losers_.assign(k, 0);
+        std::vector<uint32_t> winners(2 * k, 0);
+        for (size_t i = 0; i < k; ++i) {
+            refresh(static_cast<uint32_t>(i));
+            winners[k + i] = static_cast<uint32_t>(i);
+        }
+        for (size_t node = k - 1; node > 0; --node) {
+            const uint32_t a = winners[2 * node];
+            const uint32_t b = winners[2 * node + 1];
+            const bool b_wins = less(keys_[b], keys_[a]);
+            winners[node] = b_wins ? b : a;
+            losers_[node] = b_wins ? a : b;
+        }
+        winner_ = k > 1 ? winners[1] : 0;
+        built_ = true;
+    }
+
+    std::vector<Input> inputs_;
+    std::vector<Key> keys_;
+    std::vector<uint32_t> losers_;
+    uint32_t winner_ = 0;
+    bool built_ = false;
+    bool stalled_ = false;
+
+    uint64_t merged_ = 0;
+    uint64_t blocked_ = 0;
+};
@@ -0,0 +1,101 @@
+#pragma once
+
+#include "config.hpp"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * Параметры подбора топологии (router_test --tune)
+ */
+struct TuneOptions {
+    double target_rate = 0.0;           // Цель: доставлено сообщений/с (0 - наибольшая пропускная способность)
+    double slo_p99_us = 0.0;            // Цель: p99 от создания до стратегии, мкс (0 - без ограничения)
+    uint32_t trial_ms = 1000;           // Измеряемая часть пробы
+    uint32_t warmup_ms = 200;           // Прогрев перед измерением (задержки прогрева не учитываются)
+    uint32_t window_ms = 100;           // Окно проверки досрочной остановки
+    uint32_t max_processors = 0;        // Верхняя граница перебора (0 - вдвое больше processors.count)
+    uint32_t cores = 0;                 // Пробы на первых N доступных ядрах (0 - на всех)
+    double stop_margin = 0.2;           // Доля, на которую проба хуже цели, чтобы остановить ее досрочно
+    std::string output = "results/tuned_config.json";
+};
+
+/**
+ * Кандидат: исходная конфигурация с другим числом процессоров и правилами
+ */
+struct TuneCandidate {
+    std::string name;                   // Например "p6/spread/balanced"
+    uint32_t processors = 0;
+    std::string json;                   // Полная конфигурация кандидата
+};
+
+/**
+ * Результат пробы кандидата на настоящем конвейере
+ */
+struct TrialResult {
+    std::string name;
+    uint32_t processors = 0;
+    double msgs_per_sec = 0.0;          // Доставлено стратегиям за измеряемые окна
+    double p99_us = 0.0;
+    uint32_t measured_ms = 0;           // Меньше trial_ms при досрочной остановке
+    uint64_t order_violations = 0;
+    bool stopped_early = false;
+    bool drained = false;
+    bool meets = false;                 // Цель по пропускной способности и SLO достигнута
+};
+
+/**
+ * TopologyTuner - подбор числа процессоров и правил маршрутизации пробными запусками
+ *
+ * Кандидаты строятся из исходной конфигурации: число процессоров от наименьшего
+ * допустимого до max_processors, типы раскладываются по процессорам жадно по
+ * нагрузке (доля типа * время обработки), горячие типы без требования порядка
+ * дополнительно разносятся по нескольким процессорам (spread), типы назначаются
+ * стратегиям с выравниванием нагрузки стратегий (balanced) или как в исходных
+ * stage2_rules. Правила с требованием порядка остаются на одном процессоре,
+ * multicast-правила не меняются.
+ *
+ * Каждый кандидат запускается на том же коде, что и router_test (Pipeline):
+ * прогрев, измеряемые окна, остановка с дренированием. Проба останавливается
+ * досрочно, если после трех окон темп доставки ниже цели (или лучшего
+ * кандидата) на stop_margin или p99 вдвое превысил SLO. Перебор числа
+ * процессоров прекращается, когда цель достигнута (больше процессоров - только
+ * лишние ядра) или пропускная способность не растет два шага подряд.
+ *
+ * Лучший кандидат - достигший цели с наименьшим числом процессоров и меньшим
+ * p99; если цели не достиг никто - с наибольшей пропускной способностью.
+ */
+class TopologyTuner {
+public:
+    TopologyTuner(const std::string& config_file, const TuneOptions& options);
+
+    /**
+     * Кандидаты с данным числом процессоров (без повторов)
+     */
+    std::vector<TuneCandidate> candidates(uint32_t processors) const;
+
+    /**
+     * Проба кандидата; best_rate - темп лучшего кандидата для досрочной остановки
+     */
+    TrialResult trial(const TuneCandidate& candidate, double best_rate) const;
+
+    /**
+     * Перебор, отчет и запись лучшей конфигурации в options.output
+     * @return true если цель достигнута
+     */
+    bool run();
+
+private:
+    std::string base_json_;             // Исходный текст: кандидаты сохраняют все прочие разделы
+    SystemConfig base_;
+    TuneOptions options_;
+    uint32_t min_processors_ = 1;       // divert_processor и inject_processor должны существовать
+    uint32_t max_processors_ = 1;
+
+    /**
+     * Потоки конвейера кандидата, которым нужно по ядру
+     */
+    uint32_t pipeline_threads(const SystemConfig& config) const;
+
+    bool better(const TrialResult& a, const TrialResult& b) const;
+};
@@ -22,6 +22,11 @@ scenarios=(
     "imbalanced_processing"
     "ordering_stress"
     "strategy_bottleneck"
+    "elastic_burst"
+    "coroutine_strategies"
+    "multicast_fanout"
+    "type_flood"
+    "stalled_processor"
 )
 
 # Запуск каждого сценария
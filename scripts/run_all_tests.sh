@@ -22,6 +22,11 @@ scenarios=(
     "imbalanced_processing"
     "ordering_stress"
     "strategy_bottleneck"
+    "elastic_burst"
+    "coroutine_strategies"
+    "multicast_fanout"
+    "type_flood"
+    "stalled_processor"
 )
 
 # Запуск каждого сценария
@@ -50,6 +55,43 @@ for scenario in "${scenarios[@]}"; do
     sleep 2
 done
 
+# Перезапуск внешнего производителя: процесс в слоте shm падает (SIGKILL), замена
+# подключается к тому же слоту и продолжает нумерацию - порядок по производителю соблюдается
+echo "=========================================="
+echo "Сценарий: shm_restart (перезапуск shm_producer)"
+echo "=========================================="
+
+shm_config="$CONFIGS_DIR/shm_restart.json"
+shm_result="$RESULTS_DIR/shm_restart_result.txt"
+shm_slot=2   # producers.count: первый внешний слот
+
+./router_test "$shm_config" > "$shm_result" 2>&1 &
+router_pid=$!
+sleep 1
+
+./shm_producer "$shm_config" "$shm_slot" &
+first_pid=$!
+sleep 2
+kill -KILL "$first_pid"
+wait "$first_pid" 2>/dev/null || true
+
+./shm_producer "$shm_config" "$shm_slot" &
+second_pid=$!
+
+wait "$router_pid" || true
+# Замена переживает роутер (очередь без потребителя) - штатная остановка сигналом
+kill -TERM "$second_pid" 2>/dev/null || true
+wait "$second_pid" 2>/dev/null || true
+
+cat "$shm_result"
+if grep -q "Результат теста: PASSED" "$shm_result"; then
+    echo "shm_restart: порядок после перезапуска соблюден"
+else
+    echo "ОШИБКА: shm_restart не прошел, см. $shm_result"
+    exit 1
+fi
+echo ""
+
 echo "=========================================="
 echo "Все тесты завершены!"
 echo "Результаты находятся в директории: $RESULTS_DIR"
@@ -0,0 +1,33 @@
+#include "adaptive_batch.hpp"
+#include <iomanip>
+#include <iostream>
+
+void AdaptiveBatch::print_header() {
+    std::cout << "  " << std::left << std::setw(14) << "Component" << std::right
+              << std::setw(12) << "batches" << std::setw(10) << "mean" << std::setw(10) << "largest"
+              << std::setw(11) << "boosted%" << std::setw(12) << "ns/msg" << std::endl;
+}
+
+void AdaptiveBatch::print_row(const std::string& name, const std::vector<const AdaptiveBatch*>& controllers) {
+    uint64_t batches = 0;
+    uint64_t messages = 0;
+    uint64_t boosted = 0;
+    uint32_t largest = 0;
+    double cost_sum = 0.0;
+    for (const AdaptiveBatch* batch : controllers) {
+        batches += batch->batches();
+        messages += batch->messages();
+        boosted += batch->boosted();
+        largest = std::max(largest, batch->largest());
+        // Стоимость взвешивается по числу сообщений очереди
+        cost_sum += batch->cost_ns() * static_cast<double>(batch->messages());
+    }
+
+    const double mean = batches > 0 ? static_cast<double>(messages) / static_cast<double>(batches) : 0.0;
+    const double boosted_share = batches > 0 ? static_cast<double>(boosted) / static_cast<double>(batches) * 100.0 : 0.0;
+    const double cost = messages > 0 ? cost_sum / static_cast<double>(messages) : 0.0;
+    std::cout << "  " << std::left << std::setw(14) << name << std::right
+              << std::setw(12) << batches << std::fixed << std::setprecision(1)
+              << std::setw(10) << mean << std::setw(10) << largest
+              << std::setw(10) << boosted_share << "%" << std::setw(12) << cost << std::endl;
+}
@@ -0,0 +1,45 @@
+#include "admission.hpp"
+#include <iomanip>
+#include <iostream>
+
+AdmissionControl::AdmissionControl(const AdmissionConfig& config, SystemStatistics& stats)
+    : stats_(stats)
+    , divert_processor_(static_cast<uint8_t>(std::max(config.divert_processor, 0)))
+{
+    // Ведра начинают полными: всплеск до burst допускается сразу после старта
+    const uint64_t now_ns = Message::get_timestamp_ns();
+    for (const auto& bucket : config.types) {
+        buckets_.push_back(std::make_unique<TokenBucket>(
+            "type " + std::to_string(bucket.id), bucket, now_ns));
+        type_buckets_[bucket.id] = buckets_.back().get();
+    }
+    for (const auto& bucket : config.producers) {
+        buckets_.push_back(std::make_unique<TokenBucket>(
+            "producer " + std::to_string(bucket.id), bucket, now_ns));
+        producer_buckets_[bucket.id] = buckets_.back().get();
+    }
+}
+
+void AdmissionControl::print_report() const {
+    static const char* overflow_names[] = {"delay", "drop", "divert"};
+
+    std::cout << "Контроль допуска Stage1 (token bucket):" << std::endl;
+    std::cout << "  " << std::left << std::setw(14) << "bucket" << std::right
+              << std::setw(12) << "rate/s" << std::setw(9) << "burst" << std::setw(8) << "policy"
+              << std::setw(14) << "admitted" << std::setw(12) << "delayed"
+              << std::setw(12) << "dropped" << std::setw(14) << "diverted" << std::endl;
+    for (const auto& bucket : buckets_) {
+        std::cout << "  " << std::left << std::setw(14) << bucket->name() << std::right
+                  << std::setw(12) << bucket->rate() << std::setw(9) << bucket->burst()
+                  << std::setw(8) << overflow_names[static_cast<int>(bucket->overflow())]
+                  << std::setw(14) << bucket->admitted << std::setw(12) << bucket->delayed
+                  << std::setw(12) << bucket->dropped << std::setw(14) << bucket->diverted << std::endl;
+    }
+    for (const auto& bucket : buckets_) {
+        if (bucket->overflow() == AdmissionOverflow::Divert) {
+            std::cout << "  Процессор divert: " << static_cast<int>(divert_processor_) << std::endl;
+            break;
+        }
+    }
+    std::cout << std::endl;
+}
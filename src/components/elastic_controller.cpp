@@ -0,0 +1,172 @@
+#include "elastic_controller.hpp"
+#include "flight_recorder.hpp"
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <thread>
+
+ElasticController::ElasticController(
+    const SystemConfig& config,
+    Stage1Router& stage1_router,
+    std::vector<std::unique_ptr<Processor>>& processors,
+    std::vector<std::shared_ptr<ProcessorQueue>>& processor_queues
+) : config_(config.elastic)
+  , base_count_(config.processors.count)
+  , stage1_router_(stage1_router)
+  , processors_(processors)
+  , processor_queues_(processor_queues)
+  , elastic_types_(config.processors.count)
+  , service_time_ns_(config.processors.count, 0)
+  , helper_of_(config.processors.count, -1)
+  , owner_of_(processors.size(), -1)
+  , idle_since_ns_(processors.size(), 0)
+{
+    // Типы, которые можно распределять по нескольким процессорам
+    std::vector<bool> order_free(256, false);
+    for (const auto& rule : config.stage2_rules) {
+        order_free[rule.msg_type] = !rule.ordering_required;
+    }
+
+    for (const auto& rule : config.stage1_rules) {
+        auto time_it = config.processors.processing_times_ns.find(rule.msg_type);
+        uint64_t time_ns = (time_it != config.processors.processing_times_ns.end())
+            ? time_it->second : 100;
+
+        for (uint8_t proc_id : rule.processors) {
+            service_time_ns_[proc_id] = std::max(service_time_ns_[proc_id], time_ns);
+            if (order_free[rule.msg_type]) {
+                elastic_types_[proc_id].push_back(rule.msg_type);
+            }
+        }
+    }
+
+    // Резервные процессоры стартуют припаркованными
+    for (size_t i = base_count_; i < processors_.size(); ++i) {
+        processors_[i]->park();
+    }
+    active_count_.store(base_count_, std::memory_order_relaxed);
+    peak_active_.store(base_count_, std::memory_order_relaxed);
+}
+
+void ElasticController::attach_standby(uint32_t base_id) {
+    for (size_t s = base_count_; s < processors_.size(); ++s) {
+        if (owner_of_[s] != -1) {
+            continue;
+        }
+
+        owner_of_[s] = static_cast<int>(base_id);
+        helper_of_[base_id] = static_cast<int>(s);
+
+        // Сначала будим процессор, затем открываем ему трафик
+        processors_[s]->unpark();
+        idle_since_ns_[s] = 0;
+        for (uint8_t type : elastic_types_[base_id]) {
+            stage1_router_.add_extra_processor(type, static_cast<uint8_t>(s));
+        }
+
+        standby_in_use_.fetch_add(1, std::memory_order_relaxed);
+        scale_ups_.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+}
+
+void ElasticController::detach_standby(uint32_t base_id) {
+    size_t s = static_cast<size_t>(helper_of_[base_id]);
+
+    // Процессор дорабатывает свою очередь и паркуется по таймеру простоя
+    for (uint8_t type : elastic_types_[base_id]) {
+        stage1_router_.remove_extra_processor(type, static_cast<uint8_t>(s));
+    }
+
+    owner_of_[s] = -1;
+    helper_of_[base_id] = -1;
+    standby_in_use_.fetch_sub(1, std::memory_order_relaxed);
+    scale_downs_.fetch_add(1, std::memory_order_relaxed);
+}
+
+void ElasticController::tick(uint64_t now_ns) {
+    // Масштабирование: подключение и отключение резерва
+    for (uint32_t p = 0; p < base_count_; ++p) {
+        if (elastic_types_[p].empty()) {
+            continue;
+        }
+
+        size_t depth = processor_queues_[p]->size();
+        uint64_t est_wait_us = depth * service_time_ns_[p] / 1000;
+
+        if (helper_of_[p] == -1) {
+            if (depth >= config_.scale_up_depth || est_wait_us >= config_.scale_up_latency_us) {
+                attach_standby(p);
+            }
+        } else {
+            size_t helper_depth = processor_queues_[helper_of_[p]]->size();
+            if (depth <= config_.scale_down_depth && helper_depth <= config_.scale_down_depth) {
+                detach_standby(p);
+            }
+        }
+    }
+
+    // Парковка простаивающих и пробуждение получивших работу процессоров
+    uint32_t active = 0;
+    for (size_t i = 0; i < processors_.size(); ++i) {
+        auto& processor = processors_[i];
+
+        if (!processor_queues_[i]->empty()) {
+            idle_since_ns_[i] = 0;
+            if (processor->is_parked()) {
+                processor->unpark();
+                unparks_.fetch_add(1, std::memory_order_relaxed);
+            }
+        } else if (idle_since_ns_[i] == 0) {
+            idle_since_ns_[i] = now_ns;
+        } else if (!processor->is_parked() && owner_of_[i] == -1 &&
+                   now_ns - idle_since_ns_[i] >= config_.park_idle_us * 1000) {
+            processor->park();
+            parks_.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        if (!processor->is_parked()) {
+            ++active;
+        }
+    }
+
+    active_count_.store(active, std::memory_order_relaxed);
+    if (active > peak_active_.load(std::memory_order_relaxed)) {
+        peak_active_.store(active, std::memory_order_relaxed);
+    }
+}
+
+void ElasticController::run(std::atomic<bool>& running) {
+    const auto interval = std::chrono::microseconds(config_.check_interval_us);
+
+    FR_THREAD("elastic", 0);
+
+    while (running.load(std::memory_order_relaxed)) {
+        tick(Message::get_timestamp_ns());
+        std::this_thread::sleep_for(interval);
+    }
+
+    // При остановке будим всех, чтобы очереди дренировались без задержек сна
+    for (auto& processor : processors_) {
+        processor->unpark();
+    }
+}
+
+void ElasticController::print_current_state() const {
+    std::cout << "        Elastic: активно " << active_count_.load(std::memory_order_relaxed)
+              << "/" << processors_.size()
+              << " | резерв подключен: " << standby_in_use_.load(std::memory_order_relaxed)
+              << "/" << (processors_.size() - base_count_) << std::endl;
+}
+
+void ElasticController::print_report() const {
+    std::cout << "Эластичное масштабирование процессоров:" << std::endl;
+    std::cout << "  Основных / резервных:   " << base_count_ << " / "
+              << (processors_.size() - base_count_) << std::endl;
+    std::cout << "  Пик активных:           " << peak_active_.load(std::memory_order_relaxed) << std::endl;
+    std::cout << "  Подключений резерва:    " << scale_ups_.load(std::memory_order_relaxed) << std::endl;
+    std::cout << "  Отключений резерва:     " << scale_downs_.load(std::memory_order_relaxed) << std::endl;
+    std::cout << "  Парковок / пробуждений: " << parks_.load(std::memory_order_relaxed) << " / "
+              << unparks_.load(std::memory_order_relaxed) << std::endl;
+    std::cout << std::endl;
+}
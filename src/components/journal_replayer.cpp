@@ -0,0 +1,53 @@
+#include "journal_replayer.hpp"
+#include "journal.hpp"
+#include <iostream>
+
+JournalReplayer::JournalReplayer(
+    const ReplayConfig& config,
+    std::vector<std::shared_ptr<OutputQueue>>& output_queues,
+    SystemStatistics& stats
+) : config_(config)
+  , output_queues_(output_queues)
+  , stats_(stats)
+{
+}
+
+void JournalReplayer::run(std::atomic<bool>& running) {
+    JournalReader reader(config_.directory);
+    if (reader.size() == 0) {
+        std::cerr << "Журнал пуст: " << config_.directory << std::endl;
+        return;
+    }
+
+    const uint64_t recorded_start = reader.record(0).receive_ns;
+    const uint64_t replay_start = Message::get_timestamp_ns();
+
+    for (uint64_t i = 0; i < reader.size() && running.load(std::memory_order_relaxed); ++i) {
+        const JournalRecord& record = reader.record(i);
+
+        // Выдерживание записанного темпа (с ускорением speed)
+        if (config_.speed > 0.0) {
+            const uint64_t offset = static_cast<uint64_t>(
+                static_cast<double>(record.receive_ns - recorded_start) / config_.speed);
+            while (Message::get_timestamp_ns() - replay_start < offset) {
+                __builtin_ia32_pause();
+            }
+        }
+
+        // Новое сообщение с исходными типом, ключом, производителем и номером
+        Message msg = Message::create(record.msg.msg_type, record.msg.producer_id,
+                                      record.msg.sequence_number);
+        msg.routing_key = record.msg.routing_key;
+        auto& queue = output_queues_[record.msg.producer_id % output_queues_.size()];
+
+        while (running.load(std::memory_order_relaxed)) {
+            if (queue->try_push(msg)) {
+                stats_.count(StatsField::Produced, 1);
+                stats_.dimensions.record_produced(msg);
+                replayed_.fetch_add(1, std::memory_order_relaxed);
+                break;
+            }
+            __builtin_ia32_pause();
+        }
+    }
+}
@@ -1,5 +1,9 @@
 #include "processor.hpp"
-#include "timer.hpp"
+#include "flight_recorder.hpp"
+#include <thread>
+
+// Период сна припаркованного процессора при пустой очереди
+constexpr std::chrono::microseconds PARKED_SLEEP{50};
 
 Processor::Processor(
     uint8_t id,
@@ -11,55 +15,106 @@ Processor::Processor(
   , input_queue_(input_queue)
   , output_queue_(output_queue)
   , stats_(stats)
-  , processing_times_(config.processing_times_ns)
+  , simulated_work_(config.processing_times_ns, 100)
 {
 }
 
-uint64_t Processor::get_processing_time(uint8_t msg_type) const {
-    auto it = processing_times_.find(msg_type);
-    if (it != processing_times_.end()) {
-        return it->second;
+size_t Processor::pop_batch(Message* batch, size_t max_count) {
+    size_t count = 0;
+    while (count < max_count && input_queue_->try_pop(batch[count])) {
+        // Отметка времени входа в обработку и ID процессора
+        batch[count].processing_entry_ns = Message::get_timestamp_ns();
+        batch[count].processor_id = id_;
+        ++count;
+    }
+    if (count > 0) {
+        FR_EVENT(Pop, id_, count);
     }
-    // По умолчанию 100 наносекунд
-    return 100;
+    return count;
 }
 
-void Processor::run(std::atomic<bool>& running) {
-    while (running.load(std::memory_order_relaxed)) {
-        Message msg;
+void Processor::complete_batch(Message* batch, size_t count, size_t kept) {
+    // Отметка времени завершения обработки
+    const uint64_t exit_ns = Message::get_timestamp_ns();
+    for (size_t i = 0; i < kept; ++i) {
+        batch[i].processing_exit_ns = exit_ns;
+        batch[i].processing_ts_ns = exit_ns;
+    }
 
-        // Попытка получить сообщение из входной очереди
-        if (input_queue_->try_pop(msg)) {
-            // Отметка времени входа в обработку
-            msg.processing_entry_ns = Message::get_timestamp_ns();
+    if (kept < count) {
+        stats_.count(StatsField::Rejected, count - kept);
+    }
 
-            // Установка ID процессора
-            msg.processor_id = id_;
+    progress_.store(progress_.load(std::memory_order_relaxed) + count, std::memory_order_relaxed);
+    if (inject_every_ns_ != 0) [[unlikely]] {
+        inject_stall(exit_ns);
+    }
+}
 
-            // Имитация времени обработки (busy-wait)
-            uint64_t processing_time = get_processing_time(msg.msg_type);
-            if (processing_time > 0) {
-                Timer::busy_wait_ns(processing_time);
-            }
+void Processor::inject_stall(uint64_t now_ns) {
+    if (next_stall_ns_ == 0) {
+        next_stall_ns_ = now_ns + inject_every_ns_;
+        return;
+    }
+    if (now_ns < next_stall_ns_) {
+        return;
+    }
 
-            // Отметка времени завершения обработки
-            msg.processing_exit_ns = Message::get_timestamp_ns();
-            msg.processing_ts_ns = msg.processing_exit_ns;
+    // Поток снят с ядра (как при паузе обработчика): очередь копится, прогресса нет
+    std::this_thread::sleep_for(std::chrono::nanoseconds(inject_pause_ns_));
+    next_stall_ns_ = Message::get_timestamp_ns() + inject_every_ns_;
+}
 
-            // Попытка отправить в выходную очередь
-            // ВАЖНО: продолжаем пытаться отправить даже если running==false
-            while (true) {
-                if (output_queue_->try_push(msg)) {
-                    stats_.messages_processed.fetch_add(1, std::memory_order_relaxed);
-                    break;
-                }
+void Processor::push_output(const Message& msg) {
+    if (!output_queue_->try_push(msg)) {
+        FR_EVENT(PushRetryBegin, id_, 0);
+        do {
+            // Если очередь полная, активно ждем
+            __builtin_ia32_pause();
+        } while (!output_queue_->try_push(msg));
+        FR_EVENT(PushRetryEnd, id_, 0);
+    }
+    stats_.count(StatsField::Processed, 1);
+}
 
-                // Если очередь полная, активно ждем
-                __builtin_ia32_pause();
-            }
-        } else {
-            // Если очередь пустая, минимальная пауза
+void Processor::push_output_batch(std::span<const Message> batch) {
+    size_t pushed = output_queue_->try_push_batch(batch);
+    if (pushed < batch.size()) {
+        FR_EVENT(PushRetryBegin, id_, 0);
+        do {
             __builtin_ia32_pause();
-        }
+            pushed += output_queue_->try_push_batch(batch.subspan(pushed));
+        } while (pushed < batch.size());
+        FR_EVENT(PushRetryEnd, id_, 0);
     }
+    stats_.count(StatsField::Processed, batch.size());
+}
+
+void Processor::park() {
+    parked_.store(true, std::memory_order_relaxed);
+    FR_EVENT(Park, id_, 0);
+}
+
+void Processor::unpark() {
+    parked_.store(false, std::memory_order_relaxed);
+    FR_EVENT(Unpark, id_, 0);
+}
+
+void Processor::wait_idle() {
+    if (parked_.load(std::memory_order_relaxed)) {
+        // Припаркованный процессор не занимает ядро, пока нет работы
+        std::this_thread::sleep_for(PARKED_SLEEP);
+    } else {
+        // Если очередь пустая, минимальная пауза
+        __builtin_ia32_pause();
+    }
+}
+
+void Processor::run(std::atomic<bool>& running) {
+    FR_THREAD("processor", id_);
+    run_with(running, simulated_work_);
+}
+
+CoroTask Processor::run_coro(CoroScheduler& scheduler, std::atomic<bool>& running) {
+    return run_coro_with(scheduler, running, simulated_work_);
 }
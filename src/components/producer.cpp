@@ -1,5 +1,5 @@
 #include "producer.hpp"
-#include "timer.hpp"
+#include <algorithm>
 #include <chrono>
 #include <thread>
 
@@ -7,13 +7,16 @@ Producer::Producer(
     uint8_t id,
     const ProducerConfig& config,
     std::shared_ptr<OutputQueue> output_queue,
-    SystemStatistics& stats
+    SystemStatistics& stats,
+    uint64_t first_sequence
 ) : id_(id)
   , messages_per_sec_(config.messages_per_sec)
   , output_queue_(output_queue)
   , stats_(stats)
   , rng_(std::random_device{}())
-  , sequence_number_(0)
+  , key_space_(config.keys)
+  , key_distribution_(0, config.keys > 0 ? config.keys - 1 : 0)
+  , sequence_number_(first_sequence)
 {
     // Подготовка распределения типов сообщений
     for (const auto& [type, prob] : config.distribution) {
@@ -34,49 +37,55 @@ uint8_t Producer::generate_message_type() {
 }
 
 void Producer::run(std::atomic<bool>& running, uint32_t duration_secs) {
-    // Вычисление интервала между сообщениями (наносекунды)
+    run_with(running, duration_secs, [this](const Message& msg) {
+        return output_queue_->try_push(msg);
+    });
+}
+
+CoroTask Producer::run_coro(CoroScheduler& scheduler, std::atomic<bool>& running, uint32_t duration_secs) {
     const uint64_t interval_ns = 1'000'000'000ULL / messages_per_sec_;
+    const uint64_t start_ns = Message::get_timestamp_ns();
+    const uint64_t end_ns = start_ns + duration_secs * 1'000'000'000ULL;
 
-    Timer timer;
-    uint64_t next_send_time = 0;
-    uint64_t messages_sent = 0;
+    uint64_t next_send_ns = start_ns;
+    uint32_t budget = scheduler.batch();
 
     while (running.load(std::memory_order_relaxed)) {
-        // Проверка времени выполнения
-        if (timer.elapsed_seconds() >= duration_secs) {
+        uint64_t current_time = Message::get_timestamp_ns();
+        if (current_time >= end_ns) {
             break;
         }
 
-        uint64_t current_time = timer.elapsed_nanoseconds();
-
-        // Проверка, пора ли отправлять следующее сообщение
-        if (current_time >= next_send_time) {
-            // Генерация сообщения
-            uint8_t msg_type = generate_message_type();
-            Message msg = Message::create(msg_type, id_, sequence_number_++);
+        // До времени следующей отправки ядро отдается другим корутинам
+        if (current_time < next_send_ns) {
+            co_await scheduler.sleep_until(std::min(next_send_ns, end_ns));
+            budget = scheduler.batch();
+            continue;
+        }
 
-            // Попытка отправить в очередь
-            while (running.load(std::memory_order_relaxed)) {
-                if (output_queue_->try_push(msg)) {
-                    stats_.messages_produced.fetch_add(1, std::memory_order_relaxed);
-                    messages_sent++;
-                    break;
-                }
+        Message msg = next_message();
 
-                // Если очередь полная, активно ждем
-                __builtin_ia32_pause();
+        // Если очередь полная, уступаем ядро (потребитель может быть на этом же планировщике)
+        while (running.load(std::memory_order_relaxed)) {
+            if (output_queue_->try_push(msg)) {
+                stats_.count(StatsField::Produced, 1);
+                stats_.dimensions.record_produced(msg);
+                break;
             }
+            co_await scheduler.yield();
+            budget = scheduler.batch();
+        }
 
-            // Планирование следующей отправки
-            next_send_time += interval_ns;
+        // Планирование следующей отправки с коррекцией отставания
+        next_send_ns += interval_ns;
+        if (next_send_ns < current_time) {
+            next_send_ns = current_time;
+        }
 
-            // Если мы отстали от графика, корректируем
-            if (next_send_time < current_time) {
-                next_send_time = current_time;
-            }
-        } else {
-            // Активное ожидание с минимальной паузой
-            __builtin_ia32_pause();
+        // Отставая от графика, отправляем не больше batch сообщений подряд
+        if (--budget == 0) {
+            co_await scheduler.yield();
+            budget = scheduler.batch();
         }
     }
 }
@@ -0,0 +1,190 @@
+#include "queue_sampler.hpp"
+#include "cpu_affinity.hpp"
+#include "message.hpp"
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <thread>
+
+// До конца периода дольше этого порога поток спит, ближе к выборке - активно ждет
+constexpr uint64_t SAMPLER_SPIN_THRESHOLD_NS = 100'000;
+
+namespace {
+
+std::ofstream open_output(const std::string& path, std::ios::openmode mode) {
+    const auto parent = std::filesystem::path(path).parent_path();
+    if (!parent.empty()) {
+        std::filesystem::create_directories(parent);
+    }
+    std::ofstream out(path, mode);
+    if (!out.is_open()) {
+        std::cerr << "Не удалось открыть файл выборок: " << path << std::endl;
+    }
+    return out;
+}
+
+} // namespace
+
+QueueSampler::QueueSampler(const QueueSamplerConfig& config)
+    : config_(config)
+{
+}
+
+void QueueSampler::sample(uint64_t time_ns) {
+    const size_t slot = static_cast<size_t>(samples_taken_ % config_.ring_samples);
+    times_ns_[slot] = time_ns - start_ns_;
+
+    uint32_t* depths = &depths_[slot * edges_.size()];
+    for (size_t i = 0; i < edges_.size(); ++i) {
+        depths[i] = static_cast<uint32_t>(edges_[i].depth(edges_[i].queue.get()));
+    }
+    ++samples_taken_;
+}
+
+void QueueSampler::run(std::atomic<bool>& running) {
+    // Кольцо выделяется и заполняется до начала выборок, чтобы не ловить page faults
+    times_ns_.assign(config_.ring_samples, 0);
+    depths_.assign(config_.ring_samples * edges_.size(), 0);
+
+    set_current_thread_low_priority();
+    if (config_.core >= 0) {
+        pin_current_thread(static_cast<uint32_t>(config_.core));
+    }
+
+    const uint64_t interval_ns = config_.interval_us * 1000;
+    start_ns_ = Message::get_timestamp_ns();
+    uint64_t next_ns = start_ns_;
+
+    while (running.load(std::memory_order_relaxed)) {
+        const uint64_t now = Message::get_timestamp_ns();
+        if (now < next_ns) {
+            const uint64_t remaining = next_ns - now;
+            if (remaining > SAMPLER_SPIN_THRESHOLD_NS) {
+                std::this_thread::sleep_for(
+                    std::chrono::nanoseconds(remaining - SAMPLER_SPIN_THRESHOLD_NS));
+            } else {
+                __builtin_ia32_pause();
+            }
+            continue;
+        }
+
+        sample(now);
+
+        // Пропущенные периоды не наверстываются: следующая выборка по сетке после now
+        next_ns += interval_ns;
+        if (next_ns <= now) {
+            const uint64_t behind = (now - next_ns) / interval_ns + 1;
+            missed_ticks_ += behind;
+            next_ns += behind * interval_ns;
+        }
+    }
+}
+
+uint64_t QueueSampler::first_sample() const {
+    return samples_taken_ > config_.ring_samples ? samples_taken_ - config_.ring_samples : 0;
+}
+
+size_t QueueSampler::stored_samples() const {
+    return static_cast<size_t>(samples_taken_ - first_sample());
+}
+
+void QueueSampler::export_csv(const std::string& path) const {
+    std::ofstream out = open_output(path, std::ios::out);
+    if (!out.is_open()) {
+        return;
+    }
+
+    out << "time_us";
+    for (const auto& edge : edges_) {
+        out << "," << edge.name;
+    }
+    out << "\n";
+
+    out << std::fixed << std::setprecision(3);
+    for (uint64_t n = first_sample(); n < samples_taken_; ++n) {
+        const size_t slot = static_cast<size_t>(n % config_.ring_samples);
+        out << static_cast<double>(times_ns_[slot]) / 1000.0;
+        for (size_t i = 0; i < edges_.size(); ++i) {
+            out << "," << depths_[slot * edges_.size() + i];
+        }
+        out << "\n";
+    }
+}
+
+void QueueSampler::export_binary(const std::string& path) const {
+    std::ofstream out = open_output(path, std::ios::out | std::ios::binary);
+    if (!out.is_open()) {
+        return;
+    }
+
+    QueueSamplesHeader header{};
+    header.magic = QUEUE_SAMPLES_MAGIC;
+    header.version = QUEUE_SAMPLES_VERSION;
+    header.edges = static_cast<uint32_t>(edges_.size());
+    header.samples = stored_samples();
+    header.interval_ns = config_.interval_us * 1000;
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+    for (const auto& edge : edges_) {
+        char name[QUEUE_SAMPLES_NAME_SIZE] = {};
+        std::strncpy(name, edge.name.c_str(), QUEUE_SAMPLES_NAME_SIZE - 1);
+        out.write(name, sizeof(name));
+    }
+
+    for (uint64_t n = first_sample(); n < samples_taken_; ++n) {
+        const size_t slot = static_cast<size_t>(n % config_.ring_samples);
+        out.write(reinterpret_cast<const char*>(&times_ns_[slot]), sizeof(uint64_t));
+        out.write(reinterpret_cast<const char*>(&depths_[slot * edges_.size()]),
+                  static_cast<std::streamsize>(edges_.size() * sizeof(uint32_t)));
+    }
+}
+
+void QueueSampler::export_series() const {
+    if (!config_.output_csv.empty()) {
+        export_csv(config_.output_csv);
+    }
+    if (!config_.output_bin.empty()) {
+        export_binary(config_.output_bin);
+    }
+}
+
+void QueueSampler::print_report() const {
+    const size_t stored = stored_samples();
+
+    std::cout << "Заполнение очередей (выборка каждые " << config_.interval_us << " мкс):" << std::endl;
+    std::cout << "  Выборок: " << samples_taken_ << " (сохранено " << stored
+              << ", пропущено периодов " << missed_ticks_ << ")" << std::endl;
+    std::cout << "  " << std::left << std::setw(20) << "Ребро" << std::right
+              << std::setw(10) << "среднее" << std::setw(10) << "max"
+              << std::setw(12) << "watermark" << std::setw(12) << "переполн." << std::endl;
+
+    for (size_t i = 0; i < edges_.size(); ++i) {
+        // Среднее и максимум по сохраненным выборкам
+        uint64_t sum = 0;
+        uint32_t max_depth = 0;
+        for (uint64_t n = first_sample(); n < samples_taken_; ++n) {
+            const uint32_t depth = depths_[(n % config_.ring_samples) * edges_.size() + i];
+            sum += depth;
+            max_depth = std::max(max_depth, depth);
+        }
+        const double mean = stored > 0 ? static_cast<double>(sum) / static_cast<double>(stored) : 0.0;
+        const void* queue = edges_[i].queue.get();
+
+        std::cout << "  " << std::left << std::setw(20) << edges_[i].name << std::right
+                  << std::fixed << std::setprecision(1) << std::setw(10) << mean
+                  << std::setw(10) << max_depth
+                  << std::setw(12) << edges_[i].high_watermark(queue)
+                  << std::setw(12) << edges_[i].full_events(queue) << std::endl;
+    }
+
+    if (!config_.output_csv.empty()) {
+        std::cout << "  CSV: " << config_.output_csv << std::endl;
+    }
+    if (!config_.output_bin.empty()) {
+        std::cout << "  Бинарный файл: " << config_.output_bin << std::endl;
+    }
+    std::cout << std::endl;
+}
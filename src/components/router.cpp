@@ -1,6 +1,50 @@
 #include "router.hpp"
+#include "flight_recorder.hpp"
+#include <algorithm>
 #include <iostream>
 
+namespace {
+
+/**
+ * Отправка накопленных пакетов в выходные очереди с ожиданием места
+ * Отметка выхода (exit_field) ставится перед публикацией и обновляется после ожидания
+ * @return время последней отметки выхода
+ */
+template<typename Queue>
+uint64_t flush_staged(std::vector<std::shared_ptr<Queue>>& outputs,
+                      std::vector<std::vector<Message>>& staged,
+                      uint64_t Message::*exit_field) {
+    uint64_t exit_ns = Message::get_timestamp_ns();
+    for (size_t id = 0; id < staged.size(); ++id) {
+        std::vector<Message>& pending = staged[id];
+        if (pending.empty()) {
+            continue;
+        }
+
+        for (Message& msg : pending) {
+            msg.*exit_field = exit_ns;
+        }
+        size_t pushed = outputs[id]->try_push_batch(pending);
+        if (pushed < pending.size()) {
+            FR_EVENT(PushRetryBegin, id, 0);
+            do {
+                // Очередь полная: активно ждем, остаток получает новую отметку выхода
+                __builtin_ia32_pause();
+                exit_ns = Message::get_timestamp_ns();
+                for (size_t i = pushed; i < pending.size(); ++i) {
+                    pending[i].*exit_field = exit_ns;
+                }
+                pushed += outputs[id]->try_push_batch(std::span<const Message>(pending).subspan(pushed));
+            } while (pushed < pending.size());
+            FR_EVENT(PushRetryEnd, id, 0);
+        }
+        pending.clear();
+    }
+    return exit_ns;
+}
+
+} // namespace
+
 // Stage1Router реализация
 
 Stage1Router::Stage1Router(
@@ -12,6 +56,36 @@ Stage1Router::Stage1Router(
     for (const auto& rule : rules) {
         routing_table_[rule.msg_type] = rule.processors;
         rr_counters_[rule.msg_type].store(0, std::memory_order_relaxed);
+        extra_processors_[rule.msg_type].store(0, std::memory_order_relaxed);
+        excluded_processors_[rule.msg_type].store(0, std::memory_order_relaxed);
+    }
+}
+
+void Stage1Router::add_extra_processor(uint8_t msg_type, uint8_t processor_id) {
+    auto it = extra_processors_.find(msg_type);
+    if (it != extra_processors_.end()) {
+        it->second.fetch_or(1u << processor_id, std::memory_order_relaxed);
+    }
+}
+
+void Stage1Router::remove_extra_processor(uint8_t msg_type, uint8_t processor_id) {
+    auto it = extra_processors_.find(msg_type);
+    if (it != extra_processors_.end()) {
+        it->second.fetch_and(~(1u << processor_id), std::memory_order_relaxed);
+    }
+}
+
+void Stage1Router::exclude_processor(uint8_t msg_type, uint8_t processor_id) {
+    auto it = excluded_processors_.find(msg_type);
+    if (it != excluded_processors_.end()) {
+        it->second.fetch_or(1u << processor_id, std::memory_order_relaxed);
+    }
+}
+
+void Stage1Router::restore_processor(uint8_t msg_type, uint8_t processor_id) {
+    auto it = excluded_processors_.find(msg_type);
+    if (it != excluded_processors_.end()) {
+        it->second.fetch_and(~(1u << processor_id), std::memory_order_relaxed);
     }
 }
 
@@ -23,52 +97,216 @@ uint8_t Stage1Router::select_processor(uint8_t msg_type) {
     }
 
     const auto& processors = it->second;
-    if (processors.size() == 1) {
+
+    // Набор балансировки = процессоры из правила + подключенные на лету
+    uint32_t extra = extra_processors_.find(msg_type)->second.load(std::memory_order_relaxed);
+    if (processors.size() == 1 && extra == 0) {
         return processors[0];
     }
 
     // Round-robin балансировка между несколькими процессорами
     size_t counter = rr_counters_[msg_type].fetch_add(1, std::memory_order_relaxed);
-    return processors[counter % processors.size()];
+
+    // Есть исключенные процессоры: round-robin по маске оставшихся
+    uint32_t excluded = excluded_processors_.find(msg_type)->second.load(std::memory_order_relaxed);
+    if (excluded != 0) [[unlikely]] {
+        uint32_t healthy = extra;
+        for (uint8_t proc_id : processors) {
+            healthy |= 1u << proc_id;
+        }
+        healthy &= ~excluded;
+        if (healthy != 0) {
+            for (size_t skip = counter % static_cast<size_t>(__builtin_popcount(healthy)); skip > 0; --skip) {
+                healthy &= healthy - 1;
+            }
+            return static_cast<uint8_t>(__builtin_ctz(healthy));
+        }
+    }
+
+    size_t index = counter % (processors.size() + static_cast<size_t>(__builtin_popcount(extra)));
+    if (index < processors.size()) {
+        return processors[index];
+    }
+
+    // Выбор index-го установленного бита маски дополнительных процессоров
+    for (index -= processors.size(); index > 0; --index) {
+        extra &= extra - 1;
+    }
+    return static_cast<uint8_t>(__builtin_ctz(extra));
+}
+
+void Stage1Router::set_batching(const BatchingConfig& config) {
+    batching_.assign(input_queues_.size(), AdaptiveBatch(config, 1));
+    staged_.assign(output_queues_.size(), {});
+    for (auto& pending : staged_) {
+        pending.reserve(config.max_batch);
+    }
+}
+
+size_t Stage1Router::route_batch(size_t q) {
+    InputQueue& queue = *input_queues_[q];
+    AdaptiveBatch& batch = batching_[q];
+    const uint32_t limit = batch.limit(queue.size());
+
+    // Одна отметка входа на пакет: сообщения извлекаются подряд
+    const uint64_t entry_ns = Message::get_timestamp_ns();
+    size_t count = 0;
+    Message msg;
+    AdmissionDecision decision;
+    while (count < limit && pop_next(queue, msg, decision)) {
+        ++count;
+        if (decision == AdmissionDecision::Drop) {
+            continue;
+        }
+        msg.stage1_entry_ns = entry_ns;
+        const uint8_t processor_id = decision == AdmissionDecision::Divert
+            ? admission_->divert_processor()
+            : select_processor(msg);
+        staged_[processor_id].push_back(msg);
+    }
+    if (count == 0) {
+        return 0;
+    }
+    FR_EVENT(Pop, q, count);
+
+    const uint64_t exit_ns = flush_staged(output_queues_, staged_, &Message::stage1_exit_ns);
+    batch.complete(count, exit_ns - entry_ns);
+    return count;
+}
+
+bool Stage1Router::pop_next(InputQueue& queue, Message& msg, AdmissionDecision& decision) {
+    decision = AdmissionDecision::Admit;
+    if (!admission_) {
+        return queue.try_pop(msg);
+    }
+
+    // Решение по голове до извлечения: при delay сообщение остается в очереди
+    std::span<Message> head = queue.peek(1);
+    if (head.empty()) {
+        return false;
+    }
+    decision = admission_->admit(head[0]);
+    if (decision == AdmissionDecision::Delay) {
+        return false;
+    }
+    msg = head[0];
+    queue.release(1);
+    return true;
 }
 
 void Stage1Router::run(std::atomic<bool>& running) {
+    FR_THREAD("stage1", 0);
+    bool idle = false;
+
     while (running.load(std::memory_order_relaxed)) {
         bool processed_any = false;
+        if (admission_) {
+            admission_->begin_pass();
+        }
 
         // Обработка сообщений из всех входных очередей
-        for (auto& input_queue : input_queues_) {
-            Message msg;
-            if (input_queue->try_pop(msg)) {
-                // Отметка времени входа в Stage1
-                msg.stage1_entry_ns = Message::get_timestamp_ns();
+        for (size_t q = 0; q < input_queues_.size(); ++q) {
+            if (!batching_.empty()) {
+                processed_any = route_batch(q) > 0 || processed_any;
+                continue;
+            }
 
-                // Выбор процессора
-                uint8_t processor_id = select_processor(msg.msg_type);
+            Message msg;
+            AdmissionDecision decision;
+            if (!pop_next(*input_queues_[q], msg, decision)) {
+                continue;
+            }
+            processed_any = true;
+            if (decision == AdmissionDecision::Drop) {
+                continue;
+            }
 
-                // Попытка отправить в выходную очередь
-                // ВАЖНО: продолжаем пытаться отправить даже если running==false,
-                // чтобы не потерять сообщение, которое уже извлекли из входной очереди
-                while (true) {
-                    msg.stage1_exit_ns = Message::get_timestamp_ns();
+            // Отметка времени входа в Stage1
+            msg.stage1_entry_ns = Message::get_timestamp_ns();
+            FR_EVENT(Pop, q, 1);
 
-                    if (output_queues_[processor_id]->try_push(msg)) {
-                        processed_any = true;
-                        break;
-                    }
+            // Выбор процессора (сверх бюджета при divert - процессор низкого приоритета)
+            uint8_t processor_id = decision == AdmissionDecision::Divert
+                ? admission_->divert_processor()
+                : select_processor(msg);
+            FR_EVENT(Route, processor_id, msg.msg_type);
 
+            // Попытка отправить в выходную очередь
+            // ВАЖНО: продолжаем пытаться отправить даже если running==false,
+            // чтобы не потерять сообщение, которое уже извлекли из входной очереди
+            msg.stage1_exit_ns = Message::get_timestamp_ns();
+            if (!output_queues_[processor_id]->try_push(msg)) {
+                FR_EVENT(PushRetryBegin, processor_id, 0);
+                do {
                     // Если очередь полная, активно ждем (busy-wait)
                     // Это минимизирует задержку
                     __builtin_ia32_pause();
-                }
+                    msg.stage1_exit_ns = Message::get_timestamp_ns();
+                } while (!output_queues_[processor_id]->try_push(msg));
+                FR_EVENT(PushRetryEnd, processor_id, 0);
             }
         }
 
         // Если ничего не обработали, делаем небольшую паузу
         // чтобы не нагружать CPU на 100% без пользы
         if (!processed_any) {
+            if (!idle) {
+                FR_EVENT(Idle, 0, 0);
+                idle = true;
+            }
             // Минимальная пауза (можно убрать для максимальной производительности)
             __builtin_ia32_pause();
+        } else {
+            idle = false;
+        }
+    }
+}
+
+CoroTask Stage1Router::run_coro(CoroScheduler& scheduler, std::atomic<bool>& running) {
+    uint32_t budget = scheduler.batch();
+
+    while (running.load(std::memory_order_relaxed)) {
+        bool processed_any = false;
+        bool delayed = false;
+        if (admission_) {
+            admission_->begin_pass();
+        }
+
+        for (auto& input_queue : input_queues_) {
+            Message msg;
+            AdmissionDecision decision;
+            if (!pop_next(*input_queue, msg, decision)) {
+                delayed = delayed || decision == AdmissionDecision::Delay;
+                continue;
+            }
+            processed_any = true;
+            if (decision == AdmissionDecision::Drop) {
+                continue;
+            }
+
+            msg.stage1_entry_ns = Message::get_timestamp_ns();
+            uint8_t processor_id = decision == AdmissionDecision::Divert
+                ? admission_->divert_processor()
+                : select_processor(msg);
+
+            // Полная очередь: уступаем ядро, процессор может быть на этом же планировщике
+            while (true) {
+                msg.stage1_exit_ns = Message::get_timestamp_ns();
+                if (output_queues_[processor_id]->try_push(msg)) {
+                    break;
+                }
+                co_await scheduler.yield();
+                budget = scheduler.batch();
+            }
+        }
+
+        if (!processed_any && !delayed) {
+            co_await scheduler.readable_any(input_queues_);
+            budget = scheduler.batch();
+        } else if (!processed_any || --budget == 0) {
+            // Бюджет исчерпан или головы ждут токенов (очереди непусты - readable_any не уснет)
+            co_await scheduler.yield();
+            budget = scheduler.batch();
         }
     }
 }
@@ -78,50 +316,184 @@ void Stage1Router::run(std::atomic<bool>& running) {
 Stage2Router::Stage2Router(
     const std::vector<Stage2Rule>& rules,
     std::vector<std::shared_ptr<InputQueue>>& input_queues,
-    std::vector<std::shared_ptr<OutputQueue>>& output_queues
-) : input_queues_(input_queues), output_queues_(output_queues) {
-    // Построение таблицы маршрутизации
+    std::vector<std::shared_ptr<OutputQueue>>& output_queues,
+    std::vector<std::shared_ptr<MulticastRing>> multicast_rings
+) : input_queues_(input_queues)
+  , output_queues_(output_queues)
+  , multicast_rings_(std::move(multicast_rings))
+{
+    multicast_ring_.fill(-1);
+    const auto groups = multicast_groups(rules);
+
+    // Построение таблицы маршрутизации (последнее правило типа побеждает)
     for (const auto& rule : rules) {
         routing_table_[rule.msg_type] = rule.strategy;
+        multicast_ring_[rule.msg_type] = -1;
+
+        if (!rule.multicast.empty() && groups.size() == multicast_rings_.size()) {
+            auto group = std::find(groups.begin(), groups.end(), rule.multicast);
+            multicast_ring_[rule.msg_type] = static_cast<int16_t>(group - groups.begin());
+        }
     }
 }
 
+void Stage2Router::set_batching(const BatchingConfig& config) {
+    batching_.assign(input_queues_.size(), AdaptiveBatch(config, 1));
+    staged_.assign(output_queues_.size(), {});
+    for (auto& pending : staged_) {
+        pending.reserve(config.max_batch);
+    }
+}
+
+size_t Stage2Router::route_batch(size_t q) {
+    InputQueue& queue = *input_queues_[q];
+    AdaptiveBatch& batch = batching_[q];
+    const uint32_t limit = batch.limit(queue.size());
+
+    const uint64_t entry_ns = Message::get_timestamp_ns();
+    size_t count = 0;
+    Message msg;
+    while (count < limit && queue.try_pop(msg)) {
+        ++count;
+        msg.stage2_entry_ns = entry_ns;
+
+        // Multicast: публикация в кольцо группы сразу (у кольца свой порядок)
+        const int16_t ring = multicast_ring_[msg.msg_type];
+        if (ring >= 0) {
+            MulticastRing& output = *multicast_rings_[ring];
+            msg.stage2_exit_ns = Message::get_timestamp_ns();
+            while (!output.try_push(msg)) {
+                __builtin_ia32_pause();
+                msg.stage2_exit_ns = Message::get_timestamp_ns();
+            }
+            continue;
+        }
+        staged_[select_strategy(msg)].push_back(msg);
+    }
+    if (count == 0) {
+        return 0;
+    }
+    FR_EVENT(Pop, q, count);
+
+    const uint64_t exit_ns = flush_staged(output_queues_, staged_, &Message::stage2_exit_ns);
+    batch.complete(count, exit_ns - entry_ns);
+    return count;
+}
+
 void Stage2Router::run(std::atomic<bool>& running) {
+    FR_THREAD("stage2", 0);
+    bool idle = false;
+
     while (running.load(std::memory_order_relaxed)) {
         bool processed_any = false;
 
         // Обработка сообщений из всех входных очередей
-        for (auto& input_queue : input_queues_) {
+        for (size_t q = 0; q < input_queues_.size(); ++q) {
+            if (!batching_.empty()) {
+                processed_any = route_batch(q) > 0 || processed_any;
+                continue;
+            }
+
             Message msg;
-            if (input_queue->try_pop(msg)) {
+            if (input_queues_[q]->try_pop(msg)) {
                 // Отметка времени входа в Stage2
                 msg.stage2_entry_ns = Message::get_timestamp_ns();
+                FR_EVENT(Pop, q, 1);
+
+                // Multicast: одна публикация в кольцо группы получателей
+                const int16_t ring = multicast_ring_[msg.msg_type];
+                if (ring >= 0) {
+                    FR_EVENT(Route, ring, msg.msg_type);
+                    MulticastRing& output = *multicast_rings_[ring];
+                    msg.stage2_exit_ns = Message::get_timestamp_ns();
+                    if (!output.try_push(msg)) {
+                        FR_EVENT(PushRetryBegin, ring, 0);
+                        do {
+                            // Ждем самого медленного читателя группы
+                            __builtin_ia32_pause();
+                            msg.stage2_exit_ns = Message::get_timestamp_ns();
+                        } while (!output.try_push(msg));
+                        FR_EVENT(PushRetryEnd, ring, 0);
+                    }
+                    processed_any = true;
+                    continue;
+                }
 
                 // Определение стратегии по типу сообщения
-                auto it = routing_table_.find(msg.msg_type);
-                uint8_t strategy_id = (it != routing_table_.end())
-                    ? it->second
-                    : (msg.msg_type % static_cast<uint8_t>(output_queues_.size()));
+                uint8_t strategy_id = select_strategy(msg);
+                FR_EVENT(Route, strategy_id, msg.msg_type);
 
                 // Попытка отправить в выходную очередь
                 // ВАЖНО: продолжаем пытаться отправить даже если running==false
-                while (true) {
-                    msg.stage2_exit_ns = Message::get_timestamp_ns();
-
-                    if (output_queues_[strategy_id]->try_push(msg)) {
-                        processed_any = true;
-                        break;
-                    }
-
-                    // Если очередь полная, активно ждем (busy-wait)
-                    __builtin_ia32_pause();
+                msg.stage2_exit_ns = Message::get_timestamp_ns();
+                if (!output_queues_[strategy_id]->try_push(msg)) {
+                    FR_EVENT(PushRetryBegin, strategy_id, 0);
+                    do {
+                        // Если очередь полная, активно ждем (busy-wait)
+                        __builtin_ia32_pause();
+                        msg.stage2_exit_ns = Message::get_timestamp_ns();
+                    } while (!output_queues_[strategy_id]->try_push(msg));
+                    FR_EVENT(PushRetryEnd, strategy_id, 0);
                 }
+                processed_any = true;
             }
         }
 
         // Если ничего не обработали, минимальная пауза
         if (!processed_any) {
+            if (!idle) {
+                FR_EVENT(Idle, 0, 0);
+                idle = true;
+            }
             __builtin_ia32_pause();
+        } else {
+            idle = false;
+        }
+    }
+}
+
+CoroTask Stage2Router::run_coro(CoroScheduler& scheduler, std::atomic<bool>& running) {
+    uint32_t budget = scheduler.batch();
+
+    while (running.load(std::memory_order_relaxed)) {
+        bool processed_any = false;
+
+        for (auto& input_queue : input_queues_) {
+            Message msg;
+            if (input_queue->try_pop(msg)) {
+                msg.stage2_entry_ns = Message::get_timestamp_ns();
+                const int16_t ring = multicast_ring_[msg.msg_type];
+
+                if (ring >= 0) {
+                    while (true) {
+                        msg.stage2_exit_ns = Message::get_timestamp_ns();
+                        if (multicast_rings_[ring]->try_push(msg)) {
+                            break;
+                        }
+                        co_await scheduler.yield();
+                        budget = scheduler.batch();
+                    }
+                } else {
+                    uint8_t strategy_id = select_strategy(msg);
+                    while (true) {
+                        msg.stage2_exit_ns = Message::get_timestamp_ns();
+                        if (output_queues_[strategy_id]->try_push(msg)) {
+                            break;
+                        }
+                        co_await scheduler.yield();
+                        budget = scheduler.batch();
+                    }
+                }
+                processed_any = true;
+            }
+        }
+
+        if (!processed_any) {
+            co_await scheduler.readable_any(input_queues_);
+            budget = scheduler.batch();
+        } else if (--budget == 0) {
+            co_await scheduler.yield();
+            budget = scheduler.batch();
         }
     }
 }
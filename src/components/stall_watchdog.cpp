@@ -0,0 +1,227 @@
+#include "stall_watchdog.hpp"
+#include "flight_recorder.hpp"
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <thread>
+
+// Строк остановок в итоговом отчете (остальные только в сводке)
+constexpr size_t MAX_REPORTED_STALLS = 20;
+
+namespace {
+
+double to_ms(uint64_t ns) {
+    return static_cast<double>(ns) / 1e6;
+}
+
+} // namespace
+
+StallWatchdog::StallWatchdog(
+    const SystemConfig& config,
+    Stage1Router& stage1_router,
+    std::vector<std::unique_ptr<Processor>>& processors,
+    std::vector<std::shared_ptr<ProcessorQueue>>& processor_queues
+) : config_(config.watchdog)
+  , stage1_router_(stage1_router)
+  , processors_(processors)
+  , processor_queues_(processor_queues)
+  , reroutable_types_(processors.size())
+  , watches_(processors.size())
+{
+    std::vector<bool> order_free(256, false);
+    for (const auto& rule : config.stage2_rules) {
+        order_free[rule.msg_type] = !rule.ordering_required;
+    }
+
+    // Тип можно отвести от процессора, если в наборе есть другие процессоры
+    // (с эластичным масштабированием их может подключить контроллер)
+    for (const auto& rule : config.stage1_rules) {
+        if (!order_free[rule.msg_type]) {
+            continue;
+        }
+        if (rule.processors.size() > 1 || config.elastic.enabled) {
+            for (uint8_t proc_id : rule.processors) {
+                reroutable_types_[proc_id].push_back(rule.msg_type);
+            }
+        }
+        // Резервные процессоры подключаются к любому типу без порядка
+        for (size_t s = config.processors.count; s < processors.size(); ++s) {
+            reroutable_types_[s].push_back(rule.msg_type);
+        }
+    }
+}
+
+void StallWatchdog::exclude(uint8_t processor_id) {
+    for (uint8_t type : reroutable_types_[processor_id]) {
+        stage1_router_.exclude_processor(type, processor_id);
+    }
+    excluded_now_.fetch_add(1, std::memory_order_relaxed);
+}
+
+void StallWatchdog::restore(uint8_t processor_id) {
+    for (uint8_t type : reroutable_types_[processor_id]) {
+        stage1_router_.restore_processor(type, processor_id);
+    }
+    excluded_now_.fetch_sub(1, std::memory_order_relaxed);
+}
+
+void StallWatchdog::tick(uint64_t now_ns) {
+    for (size_t p = 0; p < processors_.size(); ++p) {
+        Watch& watch = watches_[p];
+        const uint64_t progress = processors_[p]->progress();
+        const size_t depth = processor_queues_[p]->size();
+
+        // Пустая очередь - простой, а не остановка
+        const bool moved = progress != watch.progress || depth == 0;
+        if (moved) {
+            watch.progress = progress;
+            watch.progress_ns = now_ns;
+        }
+
+        if (watch.event >= 0) {
+            StallEvent& event = events_[static_cast<size_t>(watch.event)];
+            if (event.resumed_ns == 0) {
+                if (!moved) {
+                    event.peak_depth = std::max(event.peak_depth, depth);
+                    continue;
+                }
+                event.resumed_ns = now_ns;
+                stalled_now_.fetch_sub(1, std::memory_order_relaxed);
+            }
+
+            // Процессор возвращается в балансировку, когда разобрал накопленное
+            if (depth <= config_.restore_depth) {
+                if (event.rerouted) {
+                    restore(static_cast<uint8_t>(p));
+                }
+                event.restored_ns = now_ns;
+                watch.event = -1;
+                FR_EVENT(Restore, event.processor, depth);
+            }
+            continue;
+        }
+
+        if (moved || now_ns - watch.progress_ns < config_.stall_threshold_us * 1000) {
+            continue;
+        }
+
+        StallEvent event;
+        event.processor = static_cast<uint8_t>(p);
+        event.last_progress_ns = watch.progress_ns;
+        event.detected_ns = now_ns;
+        event.depth = depth;
+        event.peak_depth = depth;
+        event.rerouted = !reroutable_types_[p].empty();
+        if (event.rerouted) {
+            exclude(event.processor);
+        }
+        FR_EVENT(Stall, event.processor, depth);
+
+        watch.event = static_cast<int>(events_.size());
+        events_.push_back(event);
+        stalls_.fetch_add(1, std::memory_order_relaxed);
+        stalled_now_.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+void StallWatchdog::run(std::atomic<bool>& running) {
+    const auto interval = std::chrono::microseconds(config_.check_interval_us);
+
+    FR_THREAD("watchdog", 0);
+
+    start_ns_ = Message::get_timestamp_ns();
+    for (size_t p = 0; p < processors_.size(); ++p) {
+        watches_[p].progress = processors_[p]->progress();
+        watches_[p].progress_ns = start_ns_;
+    }
+
+    while (running.load(std::memory_order_relaxed)) {
+        tick(Message::get_timestamp_ns());
+        std::this_thread::sleep_for(interval);
+    }
+}
+
+void StallWatchdog::print_current_state() const {
+    std::cout << "        Watchdog: остановлено " << stalled_now_.load(std::memory_order_relaxed)
+              << "/" << processors_.size()
+              << " | исключено из балансировки: " << excluded_now_.load(std::memory_order_relaxed)
+              << " | всего остановок: " << stalls_.load(std::memory_order_relaxed) << std::endl;
+}
+
+void StallWatchdog::print_report() const {
+    size_t rerouted = 0;
+    size_t unresolved = 0;
+    uint64_t stall_sum_ns = 0;
+    uint64_t stall_max_ns = 0;
+    uint64_t excluded_sum_ns = 0;
+    uint64_t excluded_max_ns = 0;
+    size_t resumed = 0;
+
+    for (const StallEvent& event : events_) {
+        if (event.resumed_ns == 0) {
+            ++unresolved;
+            continue;
+        }
+        const uint64_t stall_ns = event.resumed_ns - event.last_progress_ns;
+        stall_sum_ns += stall_ns;
+        stall_max_ns = std::max(stall_max_ns, stall_ns);
+        ++resumed;
+
+        if (event.rerouted && event.restored_ns != 0) {
+            ++rerouted;
+            const uint64_t excluded_ns = event.restored_ns - event.detected_ns;
+            excluded_sum_ns += excluded_ns;
+            excluded_max_ns = std::max(excluded_max_ns, excluded_ns);
+        }
+    }
+
+    std::cout << "Сторож остановок процессоров (порог " << config_.stall_threshold_us
+              << " мкс, опрос " << config_.check_interval_us << " мкс):" << std::endl;
+    std::cout << "  Остановок:                  " << events_.size()
+              << " (с перенаправлением и возвратом: " << rerouted << ")" << std::endl;
+    std::cout << "  Не возобновились до конца:  " << unresolved << std::endl;
+
+    std::cout << std::fixed << std::setprecision(2);
+    if (resumed > 0) {
+        std::cout << "  Остановка, мс:              среднее " << to_ms(stall_sum_ns) / resumed
+                  << ", максимум " << to_ms(stall_max_ns) << std::endl;
+    }
+    if (rerouted > 0) {
+        std::cout << "  Вне балансировки, мс:       среднее " << to_ms(excluded_sum_ns) / rerouted
+                  << ", максимум " << to_ms(excluded_max_ns) << std::endl;
+    }
+
+    if (!events_.empty()) {
+        // at - от запуска сторожа; stall - от последнего прогресса до возобновления;
+        // detect - задержка обнаружения; excluded - от обнаружения до возврата в балансировку
+        std::cout << "  " << std::left << std::setw(6) << "proc" << std::right
+                  << std::setw(12) << "at_ms" << std::setw(12) << "stall_ms"
+                  << std::setw(12) << "detect_ms" << std::setw(13) << "excluded_ms"
+                  << std::setw(10) << "depth" << std::setw(10) << "peak"
+                  << std::setw(10) << "rerouted" << std::endl;
+
+        for (size_t i = 0; i < std::min(events_.size(), MAX_REPORTED_STALLS); ++i) {
+            const StallEvent& event = events_[i];
+            std::cout << "  " << std::left << std::setw(6) << static_cast<int>(event.processor) << std::right
+                      << std::setw(12) << to_ms(event.last_progress_ns - start_ns_);
+            if (event.resumed_ns != 0) {
+                std::cout << std::setw(12) << to_ms(event.resumed_ns - event.last_progress_ns);
+            } else {
+                std::cout << std::setw(12) << "-";
+            }
+            std::cout << std::setw(12) << to_ms(event.detected_ns - event.last_progress_ns);
+            if (event.rerouted && event.restored_ns != 0) {
+                std::cout << std::setw(13) << to_ms(event.restored_ns - event.detected_ns);
+            } else {
+                std::cout << std::setw(13) << "-";
+            }
+            std::cout << std::setw(10) << event.depth << std::setw(10) << event.peak_depth
+                      << std::setw(10) << (event.rerouted ? "yes" : "no") << std::endl;
+        }
+        if (events_.size() > MAX_REPORTED_STALLS) {
+            std::cout << "  ... еще " << (events_.size() - MAX_REPORTED_STALLS) << std::endl;
+        }
+    }
+    std::cout << std::defaultfloat << std::endl;
+}
@@ -10,6 +10,7 @@ Strategy::Strategy(
   , input_queue_(input_queue)
   , stats_(stats)
   , processing_time_ns_(100) // По умолчанию
+  , max_batch_(config.max_batch)
 {
     // Получение времени обработки для этой стратегии
     auto it = config.processing_times_ns.find(id);
@@ -18,33 +19,89 @@ Strategy::Strategy(
     }
 }
 
-void Strategy::process_message(const Message& msg) {
-    // Имитация времени обработки (busy-wait)
+void Strategy::on_batch(std::span<const Message> batch) {
+    // Имитация времени обработки (busy-wait) за весь пакет
     if (processing_time_ns_ > 0) {
-        Timer::busy_wait_ns(processing_time_ns_);
+        Timer::busy_wait_ns(processing_time_ns_ * batch.size());
     }
+}
+
+void Strategy::deliver_batch(std::span<const Message> delivered, size_t rejected) {
+    for (const Message& msg : delivered) {
+        // Запись в журнал (без системных вызовов на горячем пути)
+        if (journal_) {
+            journal_->append(msg, id_);
+        }
 
-    // Отслеживание порядка сообщений
-    stats_.track_message_order(msg);
+        // Запись статистики задержек
+        stats_.record_message_latencies(msg);
 
-    // Запись статистики задержек
-    stats_.record_message_latencies(msg);
+        // Заморозка самописца при превышении порога end-to-end задержки
+        FR_CHECK_LATENCY(msg.strategy_entry_ns - msg.timestamp_ns);
+    }
+
+    // Отслеживание порядка сообщений (одна блокировка на серию от производителя)
+    stats_.track_batch_order(delivered);
+    stats_.dimensions.record_delivered(delivered);
 
-    // Увеличение счетчика доставленных сообщений
-    stats_.messages_delivered.fetch_add(1, std::memory_order_relaxed);
+    // Доставленные и отклоненные сообщения пакета публикуются одной версией блока
+    StatsBlock::Update update(stats_.workers.local());
+    update.add(StatsField::Delivered, delivered.size());
+    update.add(StatsField::Rejected, rejected);
 }
 
-void Strategy::run(std::atomic<bool>& running) {
-    while (running.load(std::memory_order_relaxed)) {
-        Message msg;
-
-        // Попытка получить сообщение из входной очереди
-        if (input_queue_->try_pop(msg)) {
-            // Обработка сообщения
-            process_message(msg);
-        } else {
-            // Если очередь пустая, минимальная пауза
-            __builtin_ia32_pause();
+void Strategy::add_multicast(std::shared_ptr<MulticastRing> ring, size_t reader, bool primary) {
+    multicast_.push_back({std::move(ring), reader, primary});
+    scratch_.resize(max_batch_);
+}
+
+void Strategy::deliver_shared_batch(std::span<const Message> delivered, size_t rejected,
+                                    uint64_t entry_ns, bool primary) {
+    // Остальные получатели группы только считают доставки: сообщение уже учтено первым
+    if (!primary) {
+        stats_.count(StatsField::Multicast, delivered.size());
+        return;
+    }
+
+    for (const Message& msg : delivered) {
+        if (journal_) {
+            journal_->append(msg, id_);
+        }
+
+        // Сообщение в кольце не изменяется: время получения подставляется в копию выборки
+        if (SystemStatistics::latency_sampled(msg)) {
+            Message sampled = msg;
+            sampled.strategy_entry_ns = entry_ns;
+            stats_.record_message_latencies(sampled);
+        }
+
+        FR_CHECK_LATENCY(entry_ns - msg.timestamp_ns);
+    }
+
+    stats_.track_batch_order(delivered);
+    stats_.dimensions.record_delivered(delivered, entry_ns);
+    StatsBlock::Update update(stats_.workers.local());
+    update.add(StatsField::Delivered, delivered.size());
+    update.add(StatsField::Rejected, rejected);
+}
+
+bool Strategy::input_ready(const void* self, uint64_t, uint64_t) noexcept {
+    const Strategy& strategy = *static_cast<const Strategy*>(self);
+    if (!strategy.input_queue_->empty()) {
+        return true;
+    }
+    for (const MulticastInput& input : strategy.multicast_) {
+        if (input.ring->readable(input.reader)) {
+            return true;
         }
     }
+    return false;
+}
+
+void Strategy::run(std::atomic<bool>& running) {
+    run_with(running, [this](std::span<const Message> batch) { on_batch(batch); });
+}
+
+CoroTask Strategy::run_coro(CoroScheduler& scheduler, std::atomic<bool>& running) {
+    return run_coro_with(scheduler, running, [this](std::span<const Message> batch) { on_batch(batch); });
 }
@@ -0,0 +1,680 @@
+#include "capacity_planner.hpp"
+#include "admission.hpp"
+#include "cpu_affinity.hpp"
+#include "key_routes.hpp"
+#include "message.hpp"
+#include "router.hpp"
+#include <algorithm>
+#include <cmath>
+#include <deque>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <map>
+#include <random>
+#include <sstream>
+
+// Ключей routing_key, по которым оценивается доля правил по ключу (большие пространства - выборка)
+constexpr uint32_t PLAN_KEY_SAMPLES = 65536;
+
+// Время по умолчанию для типов и стратегий без записи в конфигурации (как у Processor и Strategy)
+constexpr uint64_t DEFAULT_PROCESSING_NS = 100;
+
+namespace {
+
+constexpr double INF = std::numeric_limits<double>::infinity();
+
+// Скорость в сообщениях/с: 950, 12.3k, 1.25M
+std::string format_rate(double per_second) {
+    std::ostringstream out;
+    out << std::fixed;
+    if (per_second >= 1e6) {
+        out << std::setprecision(2) << per_second / 1e6 << "M";
+    } else if (per_second >= 1e3) {
+        out << std::setprecision(1) << per_second / 1e3 << "k";
+    } else {
+        out << std::setprecision(0) << per_second;
+    }
+    return out.str();
+}
+
+std::string format_fixed(double value, int digits) {
+    if (!std::isfinite(value)) {
+        return "inf";
+    }
+    std::ostringstream out;
+    out << std::fixed << std::setprecision(digits) << value;
+    return out.str();
+}
+
+std::string format_us(double ns) {
+    return format_fixed(ns / 1000.0, 2);
+}
+
+double percentile(std::vector<uint64_t>& values, double p) {
+    if (values.empty()) {
+        return 0.0;
+    }
+    const size_t index = std::min(values.size() - 1, static_cast<size_t>(p * static_cast<double>(values.size())));
+    std::nth_element(values.begin(), values.begin() + static_cast<std::ptrdiff_t>(index), values.end());
+    return static_cast<double>(values[index]);
+}
+
+/**
+ * Однопоточный FIFO-сервер симуляции: сообщения поступают в порядке обслуживания
+ */
+struct SimServer {
+    std::string name;
+    uint64_t horizon_ns = 0;
+    uint64_t free_ns = 0;                   // Момент освобождения сервера
+    uint64_t busy_ns = 0;
+    std::vector<uint64_t> waits;
+    std::deque<uint64_t> in_system;         // Моменты выхода сообщений в очереди и в обслуживании
+    size_t max_depth = 0;
+    std::array<double, 4> depth_sum{};      // Глубина по четвертям модельного времени
+    std::array<uint64_t, 4> depth_count{};
+
+    /**
+     * Обслуживание сообщения, пришедшего в arrival_ns; возвращает момент выхода
+     */
+    uint64_t serve(uint64_t arrival_ns, uint64_t service_ns) {
+        const uint64_t start = std::max(arrival_ns, free_ns);
+        free_ns = start + service_ns;
+        busy_ns += service_ns;
+        waits.push_back(start - arrival_ns);
+
+        while (!in_system.empty() && in_system.front() <= arrival_ns) {
+            in_system.pop_front();
+        }
+        in_system.push_back(free_ns);
+        max_depth = std::max(max_depth, in_system.size());
+
+        const size_t quarter = std::min<size_t>(3, arrival_ns * 4 / std::max<uint64_t>(horizon_ns, 1));
+        depth_sum[quarter] += static_cast<double>(in_system.size());
+        ++depth_count[quarter];
+        return free_ns;
+    }
+
+    SimulatedServer result() {
+        SimulatedServer out;
+        out.name = name;
+        out.messages = waits.size();
+        out.utilization = static_cast<double>(busy_ns) / static_cast<double>(horizon_ns);
+        double sum = 0.0;
+        for (uint64_t wait : waits) {
+            sum += static_cast<double>(wait);
+        }
+        out.wait_mean_ns = waits.empty() ? 0.0 : sum / static_cast<double>(waits.size());
+        out.wait_p99_ns = percentile(waits, 0.99);
+        out.max_depth = max_depth;
+
+        const double first = depth_count[0] ? depth_sum[0] / static_cast<double>(depth_count[0]) : 0.0;
+        const double last = depth_count[3] ? depth_sum[3] / static_cast<double>(depth_count[3]) : 0.0;
+        out.growing = last > 64.0 && last > 2.0 * first;
+        return out;
+    }
+};
+
+} // namespace
+
+CapacityPlanner::CapacityPlanner(const SystemConfig& config, const PlanOptions& options)
+    : config_(config)
+    , options_(options)
+    , routers_(config.runtime.topology != PipelineTopology::Fused)
+    , type_rates_(256, 0.0)
+{
+    build_flows();
+    build_servers();
+}
+
+uint64_t CapacityPlanner::processor_time_ns(uint8_t type) const {
+    auto it = config_.processors.processing_times_ns.find(type);
+    return it != config_.processors.processing_times_ns.end() ? it->second : DEFAULT_PROCESSING_NS;
+}
+
+uint64_t CapacityPlanner::strategy_time_ns(uint8_t strategy) const {
+    auto it = config_.strategies.processing_times_ns.find(strategy);
+    return it != config_.strategies.processing_times_ns.end() ? it->second : DEFAULT_PROCESSING_NS;
+}
+
+void CapacityPlanner::build_flows() {
+    // Темп производителей с учетом их ведер допуска
+    std::vector<double> producer_rates(config_.producers.count,
+                                       static_cast<double>(config_.producers.messages_per_sec) / 1e9);
+    offered_rate_ = static_cast<double>(config_.producers.count) * static_cast<double>(config_.producers.messages_per_sec) / 1e9;
+    if (config_.admission.enabled) {
+        for (const auto& bucket : config_.admission.producers) {
+            if (bucket.id < producer_rates.size()) {
+                producer_rates[bucket.id] = std::min(producer_rates[bucket.id], static_cast<double>(bucket.rate) / 1e9);
+            }
+        }
+    }
+    double admitted = 0.0;
+    for (double rate : producer_rates) {
+        admitted += rate;
+    }
+    shed_rate_ = offered_rate_ - admitted;
+
+    double weight_sum = 0.0;
+    for (const auto& [type, weight] : config_.producers.distribution) {
+        weight_sum += weight;
+    }
+    for (const auto& [type, weight] : config_.producers.distribution) {
+        type_rates_[type] = weight_sum > 0.0 ? admitted * weight / weight_sum : 0.0;
+    }
+
+    // Ведра типов: излишек сбрасывается, ждет или уходит в процессор divert
+    std::vector<double> diverted(256, 0.0);
+    if (config_.admission.enabled) {
+        for (const auto& bucket : config_.admission.types) {
+            const double limit = static_cast<double>(bucket.rate) / 1e9;
+            if (type_rates_[bucket.id] <= limit) {
+                continue;
+            }
+            const double excess = type_rates_[bucket.id] - limit;
+            type_rates_[bucket.id] = limit;
+            if (bucket.overflow == AdmissionOverflow::Divert && config_.admission.divert_processor >= 0) {
+                diverted[bucket.id] = excess;
+            } else {
+                shed_rate_ += excess;
+            }
+        }
+        notes_.push_back("контроль допуска учтен как ограничение средних темпов (всплески ведер не моделируются)");
+    }
+
+    // Ключи маршрутизации: без producers.keys ключ равен типу
+    const uint32_t key_space = config_.producers.keys;
+    std::vector<uint32_t> keys;
+    if (key_space > 0) {
+        const uint32_t samples = std::min(key_space, PLAN_KEY_SAMPLES);
+        for (uint32_t i = 0; i < samples; ++i) {
+            keys.push_back(static_cast<uint32_t>(static_cast<uint64_t>(i) * key_space / samples));
+        }
+        if (samples < key_space) {
+            notes_.push_back("доли правил по ключу оценены по " + std::to_string(samples) + " ключам из "
+                             + std::to_string(key_space));
+        }
+    }
+
+    const auto stage1_keys = compile_key_routes(config_.stage1_key_rules, config_.processors.count);
+    const auto stage2_keys = compile_key_routes(config_.stage2_key_rules, config_.strategies.count);
+
+    std::vector<std::vector<uint8_t>> stage1_sets(256);
+    std::vector<std::vector<uint8_t>> recipients(256);
+    for (size_t type = 0; type < 256; ++type) {
+        recipients[type] = {static_cast<uint8_t>(type % config_.strategies.count)};
+        stage1_sets[type] = {static_cast<uint8_t>(type % config_.processors.count)};
+    }
+    for (const auto& rule : config_.stage1_rules) {
+        stage1_sets[rule.msg_type] = rule.processors;
+    }
+    for (const auto& rule : config_.stage2_rules) {
+        recipients[rule.msg_type] = rule.multicast.empty() ? std::vector<uint8_t>{rule.strategy} : rule.multicast;
+    }
+
+    for (size_t t = 0; t < 256; ++t) {
+        const uint8_t type = static_cast<uint8_t>(t);
+        if (type_rates_[t] <= 0.0 && diverted[t] <= 0.0) {
+            continue;
+        }
+
+        // Доли пар (процессор, получатели) типа: ключ типа независим, поэтому доли по ключам общие
+        std::map<std::pair<uint8_t, std::vector<uint8_t>>, double> shares;
+        const std::vector<uint32_t> type_keys = key_space > 0 ? keys : std::vector<uint32_t>{type};
+        const double key_weight = 1.0 / static_cast<double>(type_keys.size());
+        for (uint32_t key : type_keys) {
+            const std::vector<uint8_t> strategies = stage2_keys ? std::vector<uint8_t>{stage2_keys->lookup(key)}
+                                                                : recipients[t];
+            if (stage1_keys) {
+                shares[{stage1_keys->lookup(key), strategies}] += key_weight;
+                continue;
+            }
+            // Round-robin по набору процессоров правила
+            const auto& set = stage1_sets[t];
+            for (uint8_t processor : set) {
+                shares[{processor, strategies}] += key_weight / static_cast<double>(set.size());
+            }
+        }
+
+        for (const auto& [target, share] : shares) {
+            flows_.push_back({type, target.first, target.second, type_rates_[t] * share});
+            if (diverted[t] > 0.0) {
+                flows_.push_back({type, static_cast<uint8_t>(config_.admission.divert_processor),
+                                  target.second, diverted[t] * share});
+            }
+        }
+        type_rates_[t] += diverted[t];
+    }
+}
+
+void CapacityPlanner::build_servers() {
+    double total = 0.0;
+    for (const Flow& flow : flows_) {
+        total += flow.rate;
+    }
+
+    auto deterministic = [](const std::string& name, double rate, double service_ns) {
+        ServerLoad server;
+        server.name = name;
+        server.arrival_rate = rate;
+        server.service_ns = service_ns;
+        server.service_sq_ns = service_ns * service_ns;
+        return server;
+    };
+
+    if (routers_) {
+        servers_.push_back(deterministic("stage1", total, static_cast<double>(options_.router_ns)));
+    }
+
+    // Процессор: смесь типов, время обслуживания по типу
+    for (uint32_t p = 0; p < config_.processors.count; ++p) {
+        ServerLoad server;
+        server.name = "processor " + std::to_string(p);
+        double sum = 0.0;
+        double sum_sq = 0.0;
+        for (const Flow& flow : flows_) {
+            if (flow.processor != p) {
+                continue;
+            }
+            const double service = static_cast<double>(processor_time_ns(flow.type));
+            server.arrival_rate += flow.rate;
+            sum += flow.rate * service;
+            sum_sq += flow.rate * service * service;
+        }
+        if (server.arrival_rate > 0.0) {
+            server.service_ns = sum / server.arrival_rate;
+            server.service_sq_ns = sum_sq / server.arrival_rate;
+        }
+        servers_.push_back(server);
+    }
+
+    if (routers_) {
+        servers_.push_back(deterministic("stage2", total, static_cast<double>(options_.router_ns)));
+    }
+
+    for (uint32_t s = 0; s < config_.strategies.count; ++s) {
+        double rate = 0.0;
+        for (const Flow& flow : flows_) {
+            if (std::find(flow.strategies.begin(), flow.strategies.end(), s) != flow.strategies.end()) {
+                rate += flow.rate;
+            }
+        }
+        servers_.push_back(deterministic("strategy " + std::to_string(s), rate,
+                                         static_cast<double>(strategy_time_ns(static_cast<uint8_t>(s)))));
+    }
+
+    for (ServerLoad& server : servers_) {
+        server.utilization = server.arrival_rate * server.service_ns;
+        server.wait_ns = server.utilization < 1.0
+            ? server.arrival_rate * server.service_sq_ns / (2.0 * (1.0 - server.utilization))
+            : INF;
+    }
+
+    if (config_.elastic.enabled) {
+        notes_.push_back("резервные процессоры elastic не учтены: контроллер подключает их только при перегрузке");
+    }
+    if (config_.shm.enabled && config_.shm.external_producers > 0) {
+        notes_.push_back("внешние производители shm не учтены: их темп конфигурацией не задается");
+    }
+    if (config_.replay.enabled) {
+        notes_.push_back("воспроизведение журнала не учтено: темп задается записанным журналом");
+    }
+}
+
+const ServerLoad& CapacityPlanner::bottleneck() const {
+    return *std::max_element(servers_.begin(), servers_.end(),
+                             [](const ServerLoad& a, const ServerLoad& b) { return a.utilization < b.utilization; });
+}
+
+double CapacityPlanner::mean_delivered_ns() const {
+    auto sojourn = [](const ServerLoad& server) { return server.wait_ns + server.service_ns; };
+    const size_t processors_at = routers_ ? 1 : 0;
+    const size_t strategies_at = processors_at + config_.processors.count + (routers_ ? 1 : 0);
+
+    double weighted = 0.0;
+    double total = 0.0;
+    for (const Flow& flow : flows_) {
+        double latency = static_cast<double>(processor_time_ns(flow.type))
+                       + servers_[processors_at + flow.processor].wait_ns
+                       + servers_[strategies_at + flow.strategies.front()].wait_ns;
+        if (routers_) {
+            latency += sojourn(servers_.front()) + sojourn(servers_[strategies_at - 1]);
+        }
+        weighted += flow.rate * latency;
+        total += flow.rate;
+    }
+    return total > 0.0 ? weighted / total : 0.0;
+}
+
+uint32_t CapacityPlanner::spinning_threads() const {
+    if (config_.runtime.mode == RuntimeMode::Coroutines) {
+        return config_.runtime.schedulers;
+    }
+    return config_.producers.count + config_.total_processors() + config_.strategies.count + (routers_ ? 2 : 0);
+}
+
+SimulationResult CapacityPlanner::simulate() const {
+    const uint64_t horizon = static_cast<uint64_t>(options_.simulate_ms) * 1'000'000ULL;
+
+    struct SimMessage {
+        uint64_t created_ns;
+        uint64_t ready_ns;      // Выход из предыдущей стадии
+        uint32_t key;
+        uint8_t type;
+        uint8_t producer;
+        uint8_t processor;
+        bool diverted;
+
+        // Сообщение для RouteTable (маршрутизация по типу и ключу)
+        Message message() const {
+            Message msg = Message::create(type, producer, 0);
+            msg.routing_key = key;
+            return msg;
+        }
+    };
+
+    // Производители: равномерный темп со случайной фазой, тип по распределению
+    std::vector<SimMessage> messages;
+    std::vector<uint8_t> types;
+    std::vector<double> weights;
+    for (const auto& [type, weight] : config_.producers.distribution) {
+        types.push_back(type);
+        weights.push_back(weight);
+    }
+    for (uint32_t p = 0; p < config_.producers.count && !types.empty(); ++p) {
+        std::mt19937 rng(static_cast<uint32_t>(options_.seed + p));
+        std::discrete_distribution<size_t> type_distribution(weights.begin(), weights.end());
+        std::uniform_int_distribution<uint32_t> key_distribution(0, std::max(config_.producers.keys, 1u) - 1);
+
+        const uint64_t interval = std::max<uint64_t>(1, 1'000'000'000ULL / std::max<uint64_t>(config_.producers.messages_per_sec, 1));
+        for (uint64_t t = std::uniform_int_distribution<uint64_t>(0, interval - 1)(rng); t < horizon; t += interval) {
+            const uint8_t type = types[type_distribution(rng)];
+            const uint32_t key = config_.producers.keys > 0 ? key_distribution(rng) : type;
+            messages.push_back({t, t, key, type, static_cast<uint8_t>(p), 0, false});
+        }
+    }
+    auto by_ready = [](const SimMessage& a, const SimMessage& b) { return a.ready_ns < b.ready_ns; };
+    std::stable_sort(messages.begin(), messages.end(), by_ready);
+
+    SimulationResult result;
+    result.generated = messages.size();
+    if (config_.admission.enabled) {
+        // Ведра допуска Stage1 (те же TokenBucket, время - модельное): delay задерживает
+        // голову очереди производителя до появления токена, за ней ждут и его следующие сообщения
+        std::vector<std::unique_ptr<TokenBucket>> buckets;
+        std::array<TokenBucket*, 256> type_buckets{};
+        std::array<TokenBucket*, 256> producer_buckets{};
+        for (const auto& bucket : config_.admission.types) {
+            buckets.push_back(std::make_unique<TokenBucket>("type " + std::to_string(bucket.id), bucket, 0));
+            type_buckets[bucket.id] = buckets.back().get();
+        }
+        for (const auto& bucket : config_.admission.producers) {
+            buckets.push_back(std::make_unique<TokenBucket>("producer " + std::to_string(bucket.id), bucket, 0));
+            producer_buckets[bucket.id] = buckets.back().get();
+        }
+
+        std::vector<uint64_t> blocked_until(config_.producers.count, 0);
+        std::vector<SimMessage> admitted;
+        admitted.reserve(messages.size());
+        for (SimMessage sim : messages) {
+            TokenBucket* type = type_buckets[sim.type];
+            TokenBucket* producer = producer_buckets[sim.producer];
+            uint64_t now = std::max(sim.ready_ns, blocked_until[sim.producer]);
+            bool dropped = false;
+            bool waited = false;
+            for (;;) {
+                TokenBucket* limited = nullptr;
+                if (type && !type->available(now)) {
+                    limited = type;
+                } else if (producer && !producer->available(now)) {
+                    limited = producer;
+                }
+                if (!limited) {
+                    if (type) {
+                        type->take();
+                    }
+                    if (producer) {
+                        producer->take();
+                    }
+                    break;
+                }
+                if (limited->overflow() == AdmissionOverflow::Drop) {
+                    dropped = true;
+                    break;
+                }
+                if (limited->overflow() == AdmissionOverflow::Divert) {
+                    sim.diverted = true;
+                    break;
+                }
+                // За один интервал токена ведро получает целый токен
+                waited = true;
+                now += 1'000'000'000ULL / limited->rate() + 1;
+            }
+
+            blocked_until[sim.producer] = now;
+            result.delayed += waited ? 1 : 0;
+            if (dropped) {
+                ++result.dropped;
+                continue;
+            }
+            result.diverted += sim.diverted ? 1 : 0;
+            sim.ready_ns = now;
+            admitted.push_back(sim);
+        }
+        messages = std::move(admitted);
+        std::stable_sort(messages.begin(), messages.end(), by_ready);
+    }
+
+    RouteTable routes(config_.stage1_rules, config_.stage2_rules, config_.processors.count, config_.strategies.count,
+                      compile_key_routes(config_.stage1_key_rules, config_.processors.count),
+                      compile_key_routes(config_.stage2_key_rules, config_.strategies.count));
+
+    std::vector<std::vector<uint8_t>> multicast(256);
+    for (const auto& rule : config_.stage2_rules) {
+        multicast[rule.msg_type] = rule.multicast;
+    }
+
+    auto make_server = [horizon](const std::string& name) {
+        SimServer server;
+        server.name = name;
+        server.horizon_ns = horizon;
+        return server;
+    };
+    SimServer stage1 = make_server("stage1");
+    SimServer stage2 = make_server("stage2");
+    std::vector<SimServer> processors;
+    for (uint32_t p = 0; p < config_.processors.count; ++p) {
+        processors.push_back(make_server("processor " + std::to_string(p)));
+    }
+    std::vector<SimServer> strategies;
+    for (uint32_t s = 0; s < config_.strategies.count; ++s) {
+        strategies.push_back(make_server("strategy " + std::to_string(s)));
+    }
+
+    // Stage1 и процессоры: FIFO сохраняет порядок прихода
+    for (SimMessage& sim : messages) {
+        if (routers_) {
+            sim.ready_ns = stage1.serve(sim.ready_ns, options_.router_ns);
+        }
+        sim.processor = sim.diverted ? static_cast<uint8_t>(config_.admission.divert_processor)
+                                     : routes.select_processor(sim.message());
+        sim.ready_ns = processors[sim.processor].serve(sim.ready_ns, processor_time_ns(sim.type));
+    }
+
+    // Stage2 получает сообщения в порядке выхода из процессоров
+    std::stable_sort(messages.begin(), messages.end(),
+                     [](const SimMessage& a, const SimMessage& b) { return a.ready_ns < b.ready_ns; });
+
+    std::vector<uint64_t>& delivered_ns = result.delivered_ns;
+    delivered_ns.reserve(messages.size());
+    for (SimMessage& sim : messages) {
+        if (routers_) {
+            sim.ready_ns = stage2.serve(sim.ready_ns, options_.router_ns);
+        }
+        const uint8_t primary = routes.select_strategy(sim.message());
+        const std::vector<uint8_t>& group = multicast[sim.type];
+
+        // Получение стратегией - начало обслуживания основным получателем
+        const uint64_t service = strategy_time_ns(primary);
+        const uint64_t done = strategies[primary].serve(sim.ready_ns, service);
+        delivered_ns.push_back(done - service - sim.created_ns);
+        for (uint8_t strategy : group) {
+            if (strategy != primary) {
+                strategies[strategy].serve(sim.ready_ns, strategy_time_ns(strategy));
+            }
+        }
+    }
+
+    if (routers_) {
+        result.servers.push_back(stage1.result());
+    }
+    for (SimServer& server : processors) {
+        result.servers.push_back(server.result());
+    }
+    if (routers_) {
+        result.servers.push_back(stage2.result());
+    }
+    for (SimServer& server : strategies) {
+        result.servers.push_back(server.result());
+    }
+    return result;
+}
+
+bool CapacityPlanner::report() const {
+    bool keeps_up = true;
+    std::vector<std::string> warnings;
+
+    std::cout << "=== ПЛАН МОЩНОСТИ ===" << std::endl;
+    std::cout << "Сценарий: " << config_.scenario << std::endl;
+    std::cout << "Нагрузка: " << config_.producers.count << " x " << format_rate(
+                     static_cast<double>(config_.producers.messages_per_sec))
+              << " msg/s = " << format_rate(offered_rate_ * 1e9) << " msg/s";
+    if (shed_rate_ > 0.0) {
+        std::cout << " (сброшено или задержано допуском: " << format_rate(shed_rate_ * 1e9) << " msg/s)";
+    }
+    std::cout << std::endl;
+    if (routers_) {
+        std::cout << "Время роутера на сообщение: " << options_.router_ns << " нс (оценка, --router_ns)" << std::endl;
+    }
+    std::cout << std::endl;
+
+    std::cout << "Загрузка компонентов (M/G/1, детерминированное обслуживание по типу):" << std::endl;
+    std::cout << "  " << std::left << std::setw(14) << "component" << std::right
+              << std::setw(10) << "msg/s" << std::setw(12) << "service_ns"
+              << std::setw(8) << "util" << std::setw(11) << "wait_us" << std::setw(12) << "sojourn_us"
+              << std::endl;
+    for (const ServerLoad& server : servers_) {
+        std::cout << "  " << std::left << std::setw(14) << server.name << std::right
+                  << std::setw(10) << format_rate(server.arrival_rate * 1e9)
+                  << std::fixed << std::setprecision(1) << std::setw(12) << server.service_ns
+                  << std::setprecision(3) << std::setw(8) << server.utilization
+                  << std::setw(11) << format_us(server.wait_ns)
+                  << std::setw(12) << format_us(server.wait_ns + server.service_ns) << std::endl;
+
+        if (server.utilization >= 1.0) {
+            keeps_up = false;
+            warnings.push_back(server.name + ": загрузка " + format_fixed(server.utilization, 2)
+                               + " >= 1 - очередь растет без предела");
+        } else if (server.utilization >= options_.warn_utilization) {
+            warnings.push_back(server.name + ": загрузка " + format_fixed(server.utilization, 2)
+                               + " - ожидание растет как 1/(1 - rho)");
+        }
+    }
+    std::cout << std::endl;
+
+    const ServerLoad& worst = bottleneck();
+    std::cout << "Узкое место: " << worst.name << " (util " << std::setprecision(3) << worst.utilization << ")"
+              << std::endl;
+    if (worst.utilization > 0.0) {
+        std::cout << "Предельный темп производителя: "
+                  << format_rate(static_cast<double>(config_.producers.messages_per_sec) / worst.utilization)
+                  << " msg/s (при тех же распределении и правилах)" << std::endl;
+    }
+    std::cout << "Средняя задержка до стратегии (модель): " << format_us(mean_delivered_ns()) << " мкс"
+              << std::endl;
+    std::cout << std::endl;
+
+    const uint32_t threads = spinning_threads();
+    const uint32_t cores = options_.cores > 0 ? options_.cores : available_cores();
+    if (threads > cores) {
+        keeps_up = false;
+        warnings.push_back(std::to_string(threads) + " активно ожидающих потоков на " + std::to_string(cores)
+                           + " ядрах (--cores): потоки делят ядра, загрузки модели недостижимы");
+    }
+    if (config_.runtime.mode == RuntimeMode::Coroutines) {
+        double total = 0.0;
+        for (const ServerLoad& server : servers_) {
+            total += server.utilization;
+        }
+        const double per_scheduler = total / static_cast<double>(std::max(config_.runtime.schedulers, 1u));
+        if (per_scheduler >= 1.0) {
+            keeps_up = false;
+        }
+        warnings.push_back("coroutines: суммарная загрузка на планировщик " + format_fixed(per_scheduler, 2)
+                           + " (компоненты делят " + std::to_string(config_.runtime.schedulers) + " потоков)");
+    }
+
+    if (options_.simulate_ms > 0) {
+        SimulationResult simulated = simulate();
+        std::vector<uint64_t>& delivered = simulated.delivered_ns;
+
+        std::cout << "Симуляция: " << options_.simulate_ms << " мс модельного времени, "
+                  << simulated.generated << " сообщений" << std::endl;
+        if (config_.admission.enabled) {
+            std::cout << "  Допуск: сброшено " << simulated.dropped << ", ждали токена " << simulated.delayed
+                      << ", перенаправлено " << simulated.diverted << std::endl;
+        }
+        std::cout << "  " << std::left << std::setw(14) << "component" << std::right
+                  << std::setw(10) << "messages" << std::setw(8) << "util"
+                  << std::setw(11) << "wait_us" << std::setw(12) << "wait_p99_us"
+                  << std::setw(11) << "max_depth" << std::endl;
+        for (const SimulatedServer& server : simulated.servers) {
+            std::cout << "  " << std::left << std::setw(14) << server.name << std::right
+                      << std::setw(10) << server.messages
+                      << std::fixed << std::setprecision(3) << std::setw(8) << server.utilization
+                      << std::setw(11) << format_us(server.wait_mean_ns)
+                      << std::setw(12) << format_us(server.wait_p99_ns)
+                      << std::setw(11) << server.max_depth << std::endl;
+
+            if (server.growing) {
+                keeps_up = false;
+                warnings.push_back(server.name + ": очередь в симуляции растет до конца интервала");
+            }
+            if (server.max_depth > QUEUE_SIZE) {
+                warnings.push_back(server.name + ": глубина " + std::to_string(server.max_depth)
+                                   + " больше емкости очереди " + std::to_string(QUEUE_SIZE)
+                                   + " - в конвейере производители ждали бы места");
+            }
+        }
+
+        double sum = 0.0;
+        for (uint64_t latency : delivered) {
+            sum += static_cast<double>(latency);
+        }
+        const double mean = delivered.empty() ? 0.0 : sum / static_cast<double>(delivered.size());
+        std::cout << "  Задержка до стратегии, мкс: mean " << format_us(mean)
+                  << ", p50 " << format_us(percentile(delivered, 0.50))
+                  << ", p99 " << format_us(percentile(delivered, 0.99))
+                  << ", p99.9 " << format_us(percentile(delivered, 0.999)) << std::endl;
+        std::cout << std::endl;
+    }
+
+    if (!warnings.empty()) {
+        std::cout << "Предупреждения:" << std::endl;
+        for (const std::string& warning : warnings) {
+            std::cout << "  - " << warning << std::endl;
+        }
+        std::cout << std::endl;
+    }
+    if (!notes_.empty()) {
+        std::cout << "Допущения модели:" << std::endl;
+        for (const std::string& note : notes_) {
+            std::cout << "  - " << note << std::endl;
+        }
+        std::cout << std::endl;
+    }
+
+    std::cout << "Результат плана: " << (keeps_up ? "УСПЕВАЕТ ✓" : "НЕ УСПЕВАЕТ ✗") << std::endl;
+    std::cout << std::endl;
+    return keeps_up;
+}
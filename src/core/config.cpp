@@ -1,20 +1,89 @@
 #include "config.hpp"
+#include "broadcast_ring.hpp"
+#include "key_routes.hpp"
+#include "queue_arena.hpp"
 #include <nlohmann/json.hpp>
+#include <algorithm>
+#include <array>
 #include <fstream>
 #include <stdexcept>
 #include <iostream>
+#include <sstream>
 
 using json = nlohmann::json;
 
+/**
+ * Тип сообщения из ключа объекта: "msg_type_N" или просто "N" (0..255)
+ */
+static uint8_t parse_type_key(const std::string& key, const char* prefix) {
+    const size_t prefix_size = std::char_traits<char>::length(prefix);
+    const std::string digits = key.compare(0, prefix_size, prefix) == 0 ? key.substr(prefix_size) : key;
+
+    size_t parsed = 0;
+    int value = -1;
+    try {
+        value = std::stoi(digits, &parsed);
+    } catch (const std::exception&) {
+        parsed = 0;
+    }
+    if (parsed == 0 || parsed != digits.size() || value < 0 || value > 255) {
+        throw std::runtime_error("Некорректный ключ \"" + key + "\": ожидается " + prefix + "N, N от 0 до 255");
+    }
+    return static_cast<uint8_t>(value);
+}
+
+/**
+ * Правила по routing_key: {"range": [a, b]} | {"keys": [...]} | {"hash": {"modulus": N, "residues": [...]}}
+ * и получатели targets_key (одиночный получатель - single_key)
+ */
+static std::vector<KeyRule> parse_key_rules(const json& rules, const char* targets_key, const char* single_key) {
+    std::vector<KeyRule> parsed;
+    for (const auto& rule : rules) {
+        KeyRule r;
+        if (rule.contains("range")) {
+            r.match = KeyMatch::Range;
+            const auto range = rule["range"].get<std::vector<uint32_t>>();
+            if (range.size() != 2) {
+                throw std::runtime_error("Правило по ключу: range должен быть [first, last]");
+            }
+            r.first = range[0];
+            r.last = range[1];
+        } else if (rule.contains("keys")) {
+            r.match = KeyMatch::Set;
+            r.keys = rule["keys"].get<std::vector<uint32_t>>();
+        } else if (rule.contains("hash")) {
+            r.match = KeyMatch::Hash;
+            r.modulus = rule["hash"].value("modulus", 0u);
+            r.residues = rule["hash"].value("residues", std::vector<uint32_t>{});
+        } else {
+            throw std::runtime_error("Правило по ключу должно содержать range, keys или hash");
+        }
+
+        if (rule.contains(targets_key)) {
+            r.targets = rule[targets_key].get<std::vector<uint8_t>>();
+        } else if (rule.contains(single_key)) {
+            r.targets.push_back(rule[single_key].get<uint8_t>());
+        }
+        parsed.push_back(std::move(r));
+    }
+    return parsed;
+}
+
 SystemConfig SystemConfig::load_from_file(const std::string& filename) {
     std::ifstream file(filename);
     if (!file.is_open()) {
         throw std::runtime_error("Не удалось открыть файл конфигурации: " + filename);
     }
 
+    std::stringstream text;
+    text << file.rdbuf();
+    return load_from_string(text.str());
+}
+
+SystemConfig SystemConfig::load_from_string(const std::string& text) {
     json j;
     try {
-        file >> j;
+        j = json::parse(text);
     } catch (const json::parse_error& e) {
         throw std::runtime_error("Ошибка парсинга JSON: " + std::string(e.what()));
     }
@@ -30,14 +99,12 @@ SystemConfig SystemConfig::load_from_file(const std::string& filename) {
         const auto& prod = j["producers"];
         config.producers.count = prod.value("count", 4);
         config.producers.messages_per_sec = prod.value("messages_per_sec", 1000000);
+        config.producers.keys = prod.value("keys", config.producers.keys);
 
         if (prod.contains("distribution")) {
             for (const auto& [key, value] : prod["distribution"].items()) {
-                // Извлекаем номер типа из строки вида "msg_type_0"
-                if (key.find("msg_type_") == 0) {
-                    uint8_t type = std::stoi(key.substr(9));
-                    config.producers.distribution[type] = value.get<double>();
-                }
+                // Номер типа из строки вида "msg_type_0" (или "0")
+                config.producers.distribution[parse_type_key(key, "msg_type_")] = value.get<double>();
             }
         }
     }
@@ -49,10 +116,7 @@ SystemConfig SystemConfig::load_from_file(const std::string& filename) {
 
         if (proc.contains("processing_times_ns")) {
             for (const auto& [key, value] : proc["processing_times_ns"].items()) {
-                if (key.find("msg_type_") == 0) {
-                    uint8_t type = std::stoi(key.substr(9));
-                    config.processors.processing_times_ns[type] = value.get<uint64_t>();
-                }
+                config.processors.processing_times_ns[parse_type_key(key, "msg_type_")] = value.get<uint64_t>();
             }
         }
     }
@@ -61,13 +125,12 @@ SystemConfig SystemConfig::load_from_file(const std::string& filename) {
     if (j.contains("strategies")) {
         const auto& strat = j["strategies"];
         config.strategies.count = strat.value("count", 3);
+        config.strategies.max_batch = strat.value("max_batch", config.strategies.max_batch);
+        config.strategies.ordered_merge = strat.value("ordered_merge", config.strategies.ordered_merge);
 
         if (strat.contains("processing_times_ns")) {
             for (const auto& [key, value] : strat["processing_times_ns"].items()) {
-                if (key.find("strategy_") == 0) {
-                    uint8_t id = std::stoi(key.substr(9));
-                    config.strategies.processing_times_ns[id] = value.get<uint64_t>();
-                }
+                config.strategies.processing_times_ns[parse_type_key(key, "strategy_")] = value.get<uint64_t>();
             }
         }
     }
@@ -96,10 +159,213 @@ SystemConfig SystemConfig::load_from_file(const std::string& filename) {
             r.strategy = rule.value("strategy", 0);
             r.ordering_required = rule.value("ordering_required", true);
 
+            // "strategies": [a, b, ...] - multicast, первый получатель ведет учет доставки
+            if (rule.contains("strategies")) {
+                r.multicast = rule["strategies"].get<std::vector<uint8_t>>();
+                if (!r.multicast.empty()) {
+                    r.strategy = r.multicast.front();
+                }
+                if (r.multicast.size() == 1) {
+                    r.multicast.clear();
+                }
+            }
+
             config.stage2_rules.push_back(r);
         }
     }
 
+    // Правила по routing_key (опционально, вместо правил по типу)
+    if (j.contains("stage1_key_rules")) {
+        config.stage1_key_rules = parse_key_rules(j["stage1_key_rules"], "processors", "processor");
+    }
+    if (j.contains("stage2_key_rules")) {
+        config.stage2_key_rules = parse_key_rules(j["stage2_key_rules"], "strategies", "strategy");
+    }
+
+    // Эластичное масштабирование процессоров (опционально)
+    if (j.contains("elastic")) {
+        const auto& el = j["elastic"];
+        config.elastic.enabled = el.value("enabled", false);
+        config.elastic.standby_count = el.value("standby_count", 0u);
+        config.elastic.check_interval_us = el.value("check_interval_us", config.elastic.check_interval_us);
+        config.elastic.scale_up_depth = el.value("scale_up_depth", config.elastic.scale_up_depth);
+        config.elastic.scale_up_latency_us = el.value("scale_up_latency_us", config.elastic.scale_up_latency_us);
+        config.elastic.scale_down_depth = el.value("scale_down_depth", config.elastic.scale_down_depth);
+        config.elastic.park_idle_us = el.value("park_idle_us", config.elastic.park_idle_us);
+    }
+
+    // Входные очереди в разделяемой памяти (опционально)
+    if (j.contains("shm")) {
+        const auto& shm = j["shm"];
+        config.shm.enabled = shm.value("enabled", false);
+        config.shm.name = shm.value("name", config.shm.name);
+        config.shm.external_producers = shm.value("external_producers", 0u);
+        config.shm.peer_timeout_ms = shm.value("peer_timeout_ms", config.shm.peer_timeout_ms);
+    }
+
+    // Журнал доставленных сообщений (опционально)
+    if (j.contains("journal")) {
+        const auto& jr = j["journal"];
+        config.journal.enabled = jr.value("enabled", false);
+        config.journal.directory = jr.value("directory", config.journal.directory);
+        config.journal.segment_records = jr.value("segment_records", config.journal.segment_records);
+        config.journal.sync_interval_ms = jr.value("sync_interval_ms", config.journal.sync_interval_ms);
+        config.journal.sync_every_n = jr.value("sync_every_n", config.journal.sync_every_n);
+
+        std::string policy = jr.value("sync_policy", "interval");
+        if (policy == "none") {
+            config.journal.sync_policy = JournalSyncPolicy::None;
+        } else if (policy == "interval") {
+            config.journal.sync_policy = JournalSyncPolicy::Interval;
+        } else if (policy == "every_n") {
+            config.journal.sync_policy = JournalSyncPolicy::EveryN;
+        } else {
+            throw std::runtime_error("Неизвестная политика journal.sync_policy: " + policy);
+        }
+    }
+
+    // Воспроизведение журнала (опционально)
+    if (j.contains("replay")) {
+        const auto& rp = j["replay"];
+        config.replay.enabled = rp.value("enabled", false);
+        config.replay.directory = rp.value("directory", config.replay.directory);
+        config.replay.speed = rp.value("speed", config.replay.speed);
+    }
+
+    // Модель исполнения (опционально)
+    if (j.contains("runtime")) {
+        const auto& rt = j["runtime"];
+        config.runtime.schedulers = rt.value("schedulers", config.runtime.schedulers);
+        config.runtime.pin = rt.value("pin", config.runtime.pin);
+        config.runtime.first_core = rt.value("first_core", config.runtime.first_core);
+        config.runtime.batch = rt.value("batch", config.runtime.batch);
+
+        std::string mode = rt.value("mode", "threads");
+        if (mode == "threads") {
+            config.runtime.mode = RuntimeMode::Threads;
+        } else if (mode == "coroutines") {
+            config.runtime.mode = RuntimeMode::Coroutines;
+        } else {
+            throw std::runtime_error("Неизвестный режим runtime.mode: " + mode);
+        }
+
+        std::string transport = rt.value("transport", "queues");
+        if (transport == "queues") {
+            config.runtime.transport = PipelineTransport::Queues;
+        } else if (transport == "shared_ring") {
+            config.runtime.transport = PipelineTransport::SharedRing;
+        } else {
+            throw std::runtime_error("Неизвестный транспорт runtime.transport: " + transport);
+        }
+
+        std::string topology = rt.value("topology", "staged");
+        if (topology == "staged") {
+            config.runtime.topology = PipelineTopology::Staged;
+        } else if (topology == "fused") {
+            config.runtime.topology = PipelineTopology::Fused;
+        } else {
+            throw std::runtime_error("Неизвестная топология runtime.topology: " + topology);
+        }
+    }
+
+    // Бортовой самописец (опционально)
+    if (j.contains("flight_recorder")) {
+        const auto& fr = j["flight_recorder"];
+        config.flight_recorder.enabled = fr.value("enabled", false);
+        config.flight_recorder.ring_events = fr.value("ring_events", config.flight_recorder.ring_events);
+        config.flight_recorder.freeze_latency_us = fr.value("freeze_latency_us", config.flight_recorder.freeze_latency_us);
+        config.flight_recorder.output = fr.value("output", config.flight_recorder.output);
+    }
+
+    // Сэмплер заполнения очередей (опционально)
+    if (j.contains("queue_sampler")) {
+        const auto& qs = j["queue_sampler"];
+        config.queue_sampler.enabled = qs.value("enabled", false);
+        config.queue_sampler.interval_us = qs.value("interval_us", config.queue_sampler.interval_us);
+        config.queue_sampler.ring_samples = qs.value("ring_samples", config.queue_sampler.ring_samples);
+        config.queue_sampler.core = qs.value("core", config.queue_sampler.core);
+        config.queue_sampler.output_csv = qs.value("output_csv", config.queue_sampler.output_csv);
+        config.queue_sampler.output_bin = qs.value("output_bin", config.queue_sampler.output_bin);
+    }
+
+    // Счетчики производительности (опционально)
+    if (j.contains("perf_counters")) {
+        const auto& pc = j["perf_counters"];
+        config.perf_counters.enabled = pc.value("enabled", false);
+        config.perf_counters.include_kernel = pc.value("include_kernel", config.perf_counters.include_kernel);
+    }
+
+    // Адаптивные пакеты (опционально)
+    if (j.contains("batching")) {
+        const auto& bt = j["batching"];
+        config.batching.enabled = bt.value("enabled", false);
+        config.batching.target_latency_us = bt.value("target_latency_us", config.batching.target_latency_us);
+        config.batching.min_batch = bt.value("min_batch", config.batching.min_batch);
+        config.batching.max_batch = bt.value("max_batch", config.batching.max_batch);
+    }
+
+    // Память очередей (опционально)
+    if (j.contains("queue_memory")) {
+        const auto& qm = j["queue_memory"];
+        config.queue_memory.backing = queue_backing_from_name(qm.value("backing", "heap"));
+        config.queue_memory.prefault = qm.value("prefault", false);
+    }
+
+    // Сторож остановок процессоров (опционально)
+    if (j.contains("watchdog")) {
+        const auto& wd = j["watchdog"];
+        config.watchdog.enabled = wd.value("enabled", false);
+        config.watchdog.check_interval_us = wd.value("check_interval_us", config.watchdog.check_interval_us);
+        config.watchdog.stall_threshold_us = wd.value("stall_threshold_us", config.watchdog.stall_threshold_us);
+        config.watchdog.restore_depth = wd.value("restore_depth", config.watchdog.restore_depth);
+        if (wd.contains("inject_stall")) {
+            const auto& inject = wd["inject_stall"];
+            config.watchdog.inject_processor = inject.value("processor", config.watchdog.inject_processor);
+            config.watchdog.inject_every_ms = inject.value("every_ms", config.watchdog.inject_every_ms);
+            config.watchdog.inject_pause_us = inject.value("pause_us", config.watchdog.inject_pause_us);
+        }
+    }
+
+    // Отчет статистики (опционально)
+    if (j.contains("statistics")) {
+        const auto& st = j["statistics"];
+        config.statistics.dimensions_output = st.value("dimensions_output", config.statistics.dimensions_output);
+    }
+
+    // Контроль допуска в Stage1 (опционально)
+    if (j.contains("admission")) {
+        const auto& ad = j["admission"];
+        config.admission.enabled = ad.value("enabled", false);
+        config.admission.divert_processor = ad.value("divert_processor", config.admission.divert_processor);
+
+        auto parse_buckets = [](const json& rules, const char* id_key, std::vector<AdmissionBucketConfig>& out) {
+            for (const auto& rule : rules) {
+                AdmissionBucketConfig bucket;
+                bucket.id = rule[id_key].get<uint8_t>();
+                bucket.rate = rule.value("rate", uint64_t{0});
+                bucket.burst = rule.value("burst", uint64_t{1});
+
+                std::string overflow = rule.value("overflow", "delay");
+                if (overflow == "delay") {
+                    bucket.overflow = AdmissionOverflow::Delay;
+                } else if (overflow == "drop") {
+                    bucket.overflow = AdmissionOverflow::Drop;
+                } else if (overflow == "divert") {
+                    bucket.overflow = AdmissionOverflow::Divert;
+                } else {
+                    throw std::runtime_error("Неизвестная политика admission overflow: " + overflow);
+                }
+                out.push_back(bucket);
+            }
+        };
+        if (ad.contains("types")) {
+            parse_buckets(ad["types"], "msg_type", config.admission.types);
+        }
+        if (ad.contains("producers")) {
+            parse_buckets(ad["producers"], "producer", config.admission.producers);
+        }
+    }
+
     // Валидация конфигурации
     if (!config.validate()) {
         throw std::runtime_error("Конфигурация не прошла валидацию");
@@ -115,8 +381,8 @@ bool SystemConfig::validate() const {
         return false;
     }
 
-    // Проверка производителей
-    if (producers.count == 0 || producers.count > 16) {
+    // Проверка производителей (внутренних может не быть, если есть внешние)
+    if (total_producers() == 0 || total_producers() > 16) {
         std::cerr << "Ошибка: количество producers должно быть от 1 до 16" << std::endl;
         return false;
     }
@@ -137,14 +403,84 @@ bool SystemConfig::validate() const {
         return false;
     }
 
-    // Проверка стратегий
-    if (strategies.count == 0 || strategies.count > 16) {
-        std::cerr << "Ошибка: количество strategies должно быть от 1 до 16" << std::endl;
+    // Проверка стратегий (корутины позволяют держать больше стратегий, чем ядер)
+    const uint32_t max_strategies = runtime.mode == RuntimeMode::Coroutines ? 64 : 16;
+    if (strategies.count == 0 || strategies.count > max_strategies) {
+        std::cerr << "Ошибка: количество strategies должно быть от 1 до " << max_strategies
+                  << std::endl;
+        return false;
+    }
+
+    if (strategies.max_batch == 0) {
+        std::cerr << "Ошибка: strategies.max_batch должен быть больше 0" << std::endl;
+        return false;
+    }
+
+    // Правила по ключу заменяют правила по типу своей стадии
+    for (const auto* key_rules : {&stage1_key_rules, &stage2_key_rules}) {
+        const bool stage1 = key_rules == &stage1_key_rules;
+        const char* stage = stage1 ? "stage1" : "stage2";
+        const uint32_t targets = stage1 ? processors.count : strategies.count;
+        if (key_rules->empty()) {
+            continue;
+        }
+        if (stage1 ? !stage1_rules.empty() : !stage2_rules.empty()) {
+            std::cerr << "Ошибка: " << stage << "_rules и " << stage << "_key_rules взаимоисключающие"
+                      << std::endl;
+            return false;
+        }
+
+        size_t explicit_keys = 0;
+        for (const auto& rule : *key_rules) {
+            if (rule.targets.empty()) {
+                std::cerr << "Ошибка: правило " << stage << "_key_rules без получателей" << std::endl;
+                return false;
+            }
+            for (uint8_t target : rule.targets) {
+                if (target >= targets) {
+                    std::cerr << "Ошибка: правило " << stage << "_key_rules ссылается на несуществующего получателя "
+                              << static_cast<int>(target) << std::endl;
+                    return false;
+                }
+            }
+            if (rule.match == KeyMatch::Range) {
+                if (rule.first > rule.last) {
+                    std::cerr << "Ошибка: range правила " << stage << "_key_rules пуст" << std::endl;
+                    return false;
+                }
+                explicit_keys += static_cast<size_t>(rule.last - rule.first) + 1;
+            } else if (rule.match == KeyMatch::Set) {
+                explicit_keys += rule.keys.size();
+            } else {
+                if (rule.modulus == 0 || rule.modulus > 4096 || rule.residues.empty()) {
+                    std::cerr << "Ошибка: hash правила " << stage << "_key_rules требует modulus 1..4096 "
+                              << "и непустые residues" << std::endl;
+                    return false;
+                }
+                for (uint32_t residue : rule.residues) {
+                    if (residue >= rule.modulus) {
+                        std::cerr << "Ошибка: residue " << residue << " не меньше modulus в "
+                                  << stage << "_key_rules" << std::endl;
+                        return false;
+                    }
+                }
+            }
+        }
+        if (explicit_keys > KEY_EXPLICIT_LIMIT) {
+            std::cerr << "Ошибка: в " << stage << "_key_rules больше " << KEY_EXPLICIT_LIMIT
+                      << " явных ключей - для больших пространств используйте hash" << std::endl;
+            return false;
+        }
+    }
+
+    if (!stage1_key_rules.empty() && elastic.enabled) {
+        std::cerr << "Ошибка: elastic подключает процессоры к правилам по типу и несовместим со stage1_key_rules"
+                  << std::endl;
         return false;
     }
 
     // Проверка правил Stage1
-    if (stage1_rules.empty()) {
+    if (stage1_rules.empty() && stage1_key_rules.empty()) {
         std::cerr << "Ошибка: должно быть хотя бы одно правило stage1" << std::endl;
         return false;
     }
@@ -166,7 +502,7 @@ bool SystemConfig::validate() const {
     }
 
     // Проверка правил Stage2
-    if (stage2_rules.empty()) {
+    if (stage2_rules.empty() && stage2_key_rules.empty()) {
         std::cerr << "Ошибка: должно быть хотя бы одно правило stage2" << std::endl;
         return false;
     }
@@ -177,7 +513,267 @@ bool SystemConfig::validate() const {
                       << static_cast<int>(rule.strategy) << std::endl;
             return false;
         }
+
+        // Получатели multicast: существующие, без повторов, не больше читателей кольца
+        if (rule.multicast.size() > BROADCAST_MAX_READERS) {
+            std::cerr << "Ошибка: multicast-правило stage2 допускает не больше "
+                      << BROADCAST_MAX_READERS << " стратегий" << std::endl;
+            return false;
+        }
+        for (size_t i = 0; i < rule.multicast.size(); ++i) {
+            if (rule.multicast[i] >= strategies.count) {
+                std::cerr << "Ошибка: multicast-правило stage2 ссылается на несуществующую стратегию "
+                          << static_cast<int>(rule.multicast[i]) << std::endl;
+                return false;
+            }
+            if (std::find(rule.multicast.begin(), rule.multicast.begin() + i, rule.multicast[i])
+                != rule.multicast.begin() + i) {
+                std::cerr << "Ошибка: стратегия " << static_cast<int>(rule.multicast[i])
+                          << " повторяется в multicast-правиле stage2" << std::endl;
+                return false;
+            }
+        }
+    }
+
+    // Проверка эластичного масштабирования
+    if (elastic.enabled) {
+        if (total_processors() > 16) {
+            std::cerr << "Ошибка: processors.count + elastic.standby_count должно быть не больше 16"
+                      << std::endl;
+            return false;
+        }
+        if (elastic.check_interval_us == 0) {
+            std::cerr << "Ошибка: elastic.check_interval_us должен быть больше 0" << std::endl;
+            return false;
+        }
+        if (elastic.scale_down_depth >= elastic.scale_up_depth) {
+            std::cerr << "Ошибка: elastic.scale_down_depth должен быть меньше scale_up_depth"
+                      << std::endl;
+            return false;
+        }
+    }
+
+    // Проверка входных очередей в разделяемой памяти
+    if (shm.enabled) {
+        if (shm.name.size() < 2 || shm.name[0] != '/') {
+            std::cerr << "Ошибка: shm.name должно иметь вид \"/имя\"" << std::endl;
+            return false;
+        }
+        if (shm.peer_timeout_ms == 0) {
+            std::cerr << "Ошибка: shm.peer_timeout_ms должен быть больше 0" << std::endl;
+            return false;
+        }
+    }
+
+    // Проверка журнала и воспроизведения
+    if (journal.enabled) {
+        if (journal.segment_records == 0 || journal.sync_every_n == 0 || journal.sync_interval_ms == 0) {
+            std::cerr << "Ошибка: параметры journal должны быть больше 0" << std::endl;
+            return false;
+        }
+        if (replay.enabled && replay.directory == journal.directory) {
+            std::cerr << "Ошибка: journal.directory и replay.directory должны различаться" << std::endl;
+            return false;
+        }
+    }
+    if (replay.enabled && replay.speed < 0.0) {
+        std::cerr << "Ошибка: replay.speed не может быть отрицательным" << std::endl;
+        return false;
+    }
+
+    // Проверка модели исполнения
+    if (runtime.mode == RuntimeMode::Coroutines) {
+        if (runtime.schedulers == 0 || runtime.schedulers > 64) {
+            std::cerr << "Ошибка: runtime.schedulers должно быть от 1 до 64" << std::endl;
+            return false;
+        }
+        if (runtime.batch == 0) {
+            std::cerr << "Ошибка: runtime.batch должен быть больше 0" << std::endl;
+            return false;
+        }
+    }
+
+    // Слияние по времени работает над полосами слитного режима
+    if (strategies.ordered_merge && runtime.topology != PipelineTopology::Fused) {
+        std::cerr << "Ошибка: strategies.ordered_merge требует runtime.topology = fused" << std::endl;
+        return false;
+    }
+
+    // Кольцевой и слитный режимы: только потоки и фиксированный набор компонентов
+    const bool shared_ring = runtime.transport == PipelineTransport::SharedRing;
+    const bool fused = runtime.topology == PipelineTopology::Fused;
+    if (shared_ring && fused) {
+        std::cerr << "Ошибка: runtime.transport = shared_ring и runtime.topology = fused несовместимы"
+                  << std::endl;
+        return false;
+    }
+    if (shared_ring || fused) {
+        const std::string option = shared_ring ? "runtime.transport = shared_ring" : "runtime.topology = fused";
+        if (runtime.mode != RuntimeMode::Threads) {
+            std::cerr << "Ошибка: " << option << " поддерживается только в режиме threads" << std::endl;
+            return false;
+        }
+        if (elastic.enabled || shm.enabled || replay.enabled) {
+            std::cerr << "Ошибка: " << option << " несовместим с elastic, shm и replay" << std::endl;
+            return false;
+        }
+        for (const auto& rule : stage2_rules) {
+            if (!rule.multicast.empty()) {
+                std::cerr << "Ошибка: " << option << " не поддерживает multicast-правила" << std::endl;
+                return false;
+            }
+        }
+    }
+
+    // Проверка контроля допуска
+    if (admission.enabled) {
+        if (runtime.topology != PipelineTopology::Staged || runtime.transport != PipelineTransport::Queues) {
+            std::cerr << "Ошибка: admission работает в Stage1Router и требует runtime.topology = staged "
+                      << "и runtime.transport = queues" << std::endl;
+            return false;
+        }
+
+        std::array<bool, 256> seen{};
+        for (const auto& bucket : admission.types) {
+            if (seen[bucket.id]) {
+                std::cerr << "Ошибка: ведро admission для типа " << static_cast<int>(bucket.id)
+                          << " задано дважды" << std::endl;
+                return false;
+            }
+            seen[bucket.id] = true;
+
+            // Перенаправленные сообщения обгоняют ожидающие - только для типов без требования порядка
+            if (bucket.overflow == AdmissionOverflow::Divert) {
+                auto rule = std::find_if(stage2_rules.begin(), stage2_rules.end(),
+                                         [&](const Stage2Rule& r) { return r.msg_type == bucket.id; });
+                if (rule == stage2_rules.end() || rule->ordering_required) {
+                    std::cerr << "Ошибка: admission overflow = divert для типа " << static_cast<int>(bucket.id)
+                              << " требует ordering_required = false в stage2_rules" << std::endl;
+                    return false;
+                }
+            }
+        }
+
+        seen.fill(false);
+        for (const auto& bucket : admission.producers) {
+            if (bucket.id >= total_producers() || seen[bucket.id]) {
+                std::cerr << "Ошибка: ведро admission для производителя " << static_cast<int>(bucket.id)
+                          << " задано дважды или производителя нет" << std::endl;
+                return false;
+            }
+            seen[bucket.id] = true;
+            if (bucket.overflow == AdmissionOverflow::Divert) {
+                std::cerr << "Ошибка: overflow = divert допустим только для ведер типов" << std::endl;
+                return false;
+            }
+        }
+
+        bool divert = false;
+        for (const auto* buckets : {&admission.types, &admission.producers}) {
+            for (const auto& bucket : *buckets) {
+                if (bucket.rate == 0 || bucket.rate > 1'000'000'000 || bucket.burst == 0
+                    || bucket.burst > 1'000'000'000) {
+                    std::cerr << "Ошибка: rate и burst ведер admission должны быть от 1 до 10^9" << std::endl;
+                    return false;
+                }
+                divert = divert || bucket.overflow == AdmissionOverflow::Divert;
+            }
+        }
+        if (divert && (admission.divert_processor < 0
+                       || admission.divert_processor >= static_cast<int>(processors.count))) {
+            std::cerr << "Ошибка: политика divert требует admission.divert_processor из processors.count"
+                      << std::endl;
+            return false;
+        }
+    }
+
+    // Проверка адаптивных пакетов
+    if (batching.enabled) {
+        if (runtime.mode != RuntimeMode::Threads || runtime.topology != PipelineTopology::Staged
+            || runtime.transport != PipelineTransport::Queues) {
+            std::cerr << "Ошибка: batching работает в потоках роутеров и процессоров и требует "
+                      << "runtime.mode = threads, topology = staged и transport = queues" << std::endl;
+            return false;
+        }
+        if (batching.min_batch == 0 || batching.min_batch > batching.max_batch || batching.max_batch > 4096) {
+            std::cerr << "Ошибка: batching требует 1 <= min_batch <= max_batch <= 4096" << std::endl;
+            return false;
+        }
+        if (batching.target_latency_us == 0 || batching.target_latency_us > 1'000'000) {
+            std::cerr << "Ошибка: batching.target_latency_us должен быть в диапазоне 1..1000000" << std::endl;
+            return false;
+        }
+    }
+
+    // Проверка памяти очередей
+    if (queue_memory.backing != QueueBacking::Heap || queue_memory.prefault) {
+        if (runtime.topology != PipelineTopology::Staged || runtime.transport != PipelineTransport::Queues) {
+            std::cerr << "Ошибка: queue_memory размещает очереди staged-конвейера и требует "
+                      << "runtime.topology = staged и transport = queues" << std::endl;
+            return false;
+        }
+        if (queue_memory.prefault && queue_memory.backing == QueueBacking::Heap) {
+            std::cerr << "Ошибка: queue_memory.prefault требует backing = mmap, thp или hugetlb" << std::endl;
+            return false;
+        }
+    }
+
+    // Проверка сторожа остановок
+    if (watchdog.enabled) {
+        if (runtime.topology != PipelineTopology::Staged || runtime.transport != PipelineTransport::Queues) {
+            std::cerr << "Ошибка: watchdog перенаправляет трафик Stage1 и требует "
+                      << "runtime.topology = staged и transport = queues" << std::endl;
+            return false;
+        }
+        if (!stage1_key_rules.empty()) {
+            std::cerr << "Ошибка: watchdog исключает процессоры из правил по типу и несовместим со stage1_key_rules"
+                      << std::endl;
+            return false;
+        }
+        if (watchdog.check_interval_us == 0 || watchdog.stall_threshold_us < watchdog.check_interval_us) {
+            std::cerr << "Ошибка: watchdog требует 0 < check_interval_us <= stall_threshold_us" << std::endl;
+            return false;
+        }
+        if (watchdog.inject_processor >= static_cast<int>(total_processors())
+            || (watchdog.inject_processor >= 0 && (watchdog.inject_every_ms == 0 || watchdog.inject_pause_us == 0))) {
+            std::cerr << "Ошибка: watchdog.inject_stall требует существующий процессор, every_ms > 0 и pause_us > 0"
+                      << std::endl;
+            return false;
+        }
+    }
+
+    // Проверка бортового самописца
+    if (flight_recorder.enabled) {
+        const size_t ring = flight_recorder.ring_events;
+        if (ring < 1024 || (ring & (ring - 1)) != 0) {
+            std::cerr << "Ошибка: flight_recorder.ring_events должен быть степенью 2 не меньше 1024"
+                      << std::endl;
+            return false;
+        }
+    }
+
+    // Проверка сэмплера очередей
+    if (queue_sampler.enabled) {
+        if (queue_sampler.interval_us < 10 || queue_sampler.interval_us > 1000) {
+            std::cerr << "Ошибка: queue_sampler.interval_us должен быть в диапазоне 10..1000" << std::endl;
+            return false;
+        }
+        if (queue_sampler.ring_samples == 0) {
+            std::cerr << "Ошибка: queue_sampler.ring_samples должен быть больше 0" << std::endl;
+            return false;
+        }
     }
 
     return true;
 }
+
+std::vector<std::vector<uint8_t>> multicast_groups(const std::vector<Stage2Rule>& rules) {
+    std::vector<std::vector<uint8_t>> groups;
+    for (const auto& rule : rules) {
+        if (!rule.multicast.empty()
+            && std::find(groups.begin(), groups.end(), rule.multicast) == groups.end()) {
+            groups.push_back(rule.multicast);
+        }
+    }
+    return groups;
+}
@@ -0,0 +1,82 @@
+#include "coro_runtime.hpp"
+#include "cpu_affinity.hpp"
+#include "flight_recorder.hpp"
+#include <iomanip>
+#include <iostream>
+
+CoroScheduler::CoroScheduler(uint32_t id, int core, uint32_t batch)
+    : id_(id), core_(core), batch_(batch > 0 ? batch : 1)
+{
+}
+
+CoroScheduler::~CoroScheduler() {
+    // Кадры корутин, не дошедших до завершения (run не запускался)
+    for (const auto& waiter : current_) {
+        waiter.handle.destroy();
+    }
+    for (const auto& waiter : next_) {
+        waiter.handle.destroy();
+    }
+}
+
+void CoroScheduler::spawn(CoroTask task) {
+    // Первое возобновление - в первом круге планировщика
+    current_.push_back({task.release(), [](const void*, uint64_t, uint64_t) noexcept {
+        return true;
+    }, nullptr, 0});
+    ++spawned_;
+}
+
+void CoroScheduler::run(std::atomic<bool>& running) {
+    if (core_ >= 0) {
+        pinned_ = pin_current_thread(static_cast<uint32_t>(core_));
+    }
+    FR_THREAD("scheduler", id_);
+
+    while (!current_.empty()) {
+        const bool stopping = !running.load(std::memory_order_relaxed);
+        const uint64_t now = Message::get_timestamp_ns();
+        uint64_t resumed = 0;
+
+        for (const Waiter& waiter : current_) {
+            if (stopping || waiter.ready(waiter.context, waiter.deadline_ns, now)) {
+                // Корутина работает до следующего co_await и сама встает в next_
+                waiter.handle.resume();
+                ++resumed;
+                if (waiter.handle.done()) {
+                    waiter.handle.destroy();
+                }
+            } else {
+                next_.push_back(waiter);
+            }
+        }
+
+        current_.swap(next_);
+        next_.clear();
+
+        ++rounds_;
+        resumes_ += resumed;
+        if (resumed == 0) {
+            // Ни одна корутина не готова, минимальная пауза
+            ++idle_rounds_;
+            __builtin_ia32_pause();
+        }
+    }
+}
+
+void CoroScheduler::print_report() const {
+    const double idle_pct = rounds_ > 0
+        ? static_cast<double>(idle_rounds_) * 100.0 / static_cast<double>(rounds_)
+        : 0.0;
+
+    std::cout << "  Планировщик " << id_ << ": ядро ";
+    if (core_ < 0) {
+        std::cout << "-";
+    } else {
+        std::cout << core_ << (pinned_ ? "" : " (привязка не удалась)");
+    }
+    std::cout << ", корутин " << spawned_
+              << ", возобновлений " << resumes_
+              << ", холостых кругов " << std::fixed << std::setprecision(1) << idle_pct << "%"
+              << std::endl;
+}
@@ -0,0 +1,240 @@
+#include "dimension_stats.hpp"
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+
+namespace {
+
+std::atomic<uint64_t> next_dimension_stats_id{1};
+
+// Скорость в сообщениях/с для периодической строки: 950, 12.3k, 1.25M
+std::string format_rate(double rate) {
+    std::ostringstream out;
+    out << std::fixed;
+    if (rate >= 1e6) {
+        out << std::setprecision(2) << rate / 1e6 << "M";
+    } else if (rate >= 1e3) {
+        out << std::setprecision(1) << rate / 1e3 << "k";
+    } else {
+        out << std::setprecision(0) << rate;
+    }
+    return out.str();
+}
+
+// Строка периодического отчета по одному измерению (только значения с доставками за период)
+void print_interval_row(const char* title, const char* prefix,
+                        const std::vector<DimensionTotals>& current,
+                        const std::vector<DimensionTotals>& previous, double period_secs) {
+    std::ostringstream row;
+    bool any = false;
+    for (size_t id = 0; id < current.size(); ++id) {
+        const DimensionTotals delta = current[id].since(previous[id]);
+        if (delta.delivered == 0) {
+            continue;
+        }
+        row << (any ? " | " : "") << prefix << id << " "
+            << format_rate(static_cast<double>(delta.delivered) / period_secs)
+            << " p99 " << std::fixed << std::setprecision(2) << delta.percentile_us(0.99);
+        any = true;
+    }
+    if (any) {
+        std::cout << "        " << title << ": " << row.str() << std::endl;
+    }
+}
+
+void print_table(const char* title, const char* column, const std::vector<DimensionTotals>& rows,
+                 double duration_secs) {
+    std::cout << title << std::endl;
+    std::cout << "  " << std::left << std::setw(6) << column << std::right
+              << std::setw(12) << "produced" << std::setw(12) << "delivered"
+              << std::setw(10) << "msg/s" << std::setw(12) << "mean"
+              << std::setw(12) << "p50" << std::setw(12) << "p99"
+              << std::setw(12) << "p99.9" << std::setw(12) << "max" << std::endl;
+
+    for (size_t id = 0; id < rows.size(); ++id) {
+        const DimensionTotals& row = rows[id];
+        if (row.empty()) {
+            continue;
+        }
+        const double rate = duration_secs > 0.0 ? static_cast<double>(row.delivered) / duration_secs : 0.0;
+        std::cout << "  " << std::left << std::setw(6) << id << std::right
+                  << std::setw(12) << row.produced << std::setw(12) << row.delivered
+                  << std::setw(10) << format_rate(rate)
+                  << std::fixed << std::setprecision(2)
+                  << std::setw(12) << row.mean_us()
+                  << std::setw(12) << row.percentile_us(0.50)
+                  << std::setw(12) << row.percentile_us(0.99)
+                  << std::setw(12) << row.percentile_us(0.999)
+                  << std::setw(12) << row.max_us() << std::endl;
+    }
+    std::cout << std::endl;
+}
+
+void write_json_rows(std::ostream& out, const char* id_key, const std::vector<DimensionTotals>& rows,
+                     double duration_secs) {
+    out << "[";
+    bool first = true;
+    for (size_t id = 0; id < rows.size(); ++id) {
+        const DimensionTotals& row = rows[id];
+        if (row.empty()) {
+            continue;
+        }
+        const double rate = duration_secs > 0.0 ? static_cast<double>(row.delivered) / duration_secs : 0.0;
+        out << (first ? "\n" : ",\n")
+            << "    {\"" << id_key << "\": " << id
+            << ", \"produced\": " << row.produced
+            << ", \"delivered\": " << row.delivered
+            << ", \"throughput_msg_s\": " << rate
+            << ", \"latency_us\": {\"mean\": " << row.mean_us()
+            << ", \"p50\": " << row.percentile_us(0.50)
+            << ", \"p90\": " << row.percentile_us(0.90)
+            << ", \"p99\": " << row.percentile_us(0.99)
+            << ", \"p999\": " << row.percentile_us(0.999)
+            << ", \"max\": " << row.max_us() << "}"
+            << ", \"histogram_ns\": [";
+        // Непустые корзины: [нижняя граница, ширина, количество]
+        bool first_bucket = true;
+        for (size_t bucket = 0; bucket < LATENCY_BUCKETS; ++bucket) {
+            if (row.latency[bucket] == 0) {
+                continue;
+            }
+            out << (first_bucket ? "" : ", ") << "[" << latency_bucket_lower(bucket) << ", "
+                << latency_bucket_width(bucket) << ", " << row.latency[bucket] << "]";
+            first_bucket = false;
+        }
+        out << "]}";
+        first = false;
+    }
+    out << (first ? "]" : "\n  ]");
+}
+
+} // namespace
+
+void DimensionTotals::add(const DimensionCell& cell) {
+    produced += cell.produced.load(std::memory_order_relaxed);
+    delivered += cell.delivered.load(std::memory_order_relaxed);
+    latency_sum_ns += cell.latency_sum_ns.load(std::memory_order_relaxed);
+    latency_max_ns = std::max(latency_max_ns, cell.latency_max_ns.load(std::memory_order_relaxed));
+    for (size_t i = 0; i < LATENCY_BUCKETS; ++i) {
+        latency[i] += cell.latency[i].load(std::memory_order_relaxed);
+    }
+}
+
+DimensionTotals DimensionTotals::since(const DimensionTotals& earlier) const {
+    DimensionTotals delta;
+    delta.produced = produced - earlier.produced;
+    delta.delivered = delivered - earlier.delivered;
+    delta.latency_sum_ns = latency_sum_ns - earlier.latency_sum_ns;
+    delta.latency_max_ns = latency_max_ns;
+    for (size_t i = 0; i < LATENCY_BUCKETS; ++i) {
+        delta.latency[i] = latency[i] - earlier.latency[i];
+    }
+    return delta;
+}
+
+double DimensionTotals::percentile_us(double p) const {
+    uint64_t total = 0;
+    for (uint64_t count : latency) {
+        total += count;
+    }
+    if (total == 0) {
+        return 0.0;
+    }
+
+    // Тот же ранг, что у LatencyStats::percentile
+    const uint64_t rank = std::min(static_cast<uint64_t>(p * static_cast<double>(total)), total - 1);
+    uint64_t seen = 0;
+    for (size_t bucket = 0; bucket < LATENCY_BUCKETS; ++bucket) {
+        seen += latency[bucket];
+        if (seen > rank) {
+            const double mid = static_cast<double>(latency_bucket_lower(bucket))
+                             + static_cast<double>(latency_bucket_width(bucket) - 1) / 2.0;
+            return std::min(mid, static_cast<double>(latency_max_ns)) / 1000.0;
+        }
+    }
+    return max_us();
+}
+
+double DimensionTotals::mean_us() const {
+    if (delivered == 0) {
+        return 0.0;
+    }
+    return static_cast<double>(latency_sum_ns) / static_cast<double>(delivered) / 1000.0;
+}
+
+void DimensionShard::collect(DimensionSnapshot& snapshot) const {
+    for (size_t id = 0; id < 256; ++id) {
+        if (const DimensionCell* cell = types_[id].load(std::memory_order_acquire)) {
+            snapshot.types[id].add(*cell);
+        }
+        if (const DimensionCell* cell = producers_[id].load(std::memory_order_acquire)) {
+            snapshot.producers[id].add(*cell);
+        }
+    }
+}
+
+DimensionStats::DimensionStats()
+    : id_(next_dimension_stats_id.fetch_add(1, std::memory_order_relaxed))
+{
+}
+
+DimensionShard* DimensionStats::add_shard() {
+    std::lock_guard<std::mutex> lock(shards_mutex_);
+    shards_.push_back(std::make_unique<DimensionShard>());
+    return shards_.back().get();
+}
+
+DimensionSnapshot DimensionStats::snapshot() const {
+    DimensionSnapshot snapshot;
+    std::lock_guard<std::mutex> lock(shards_mutex_);
+    for (const auto& shard : shards_) {
+        shard->collect(snapshot);
+    }
+    return snapshot;
+}
+
+void DimensionStats::print_interval(double elapsed_secs) const {
+    DimensionSnapshot current = snapshot();
+    const double period = elapsed_secs - last_elapsed_;
+    if (period > 0.0) {
+        print_interval_row("Типы (msg/s, p99 мкс)", "t", current.types, last_interval_.types, period);
+        print_interval_row("Производители", "p", current.producers, last_interval_.producers, period);
+    }
+    last_interval_ = std::move(current);
+    last_elapsed_ = elapsed_secs;
+}
+
+void DimensionStats::print_report(double duration_secs) const {
+    const DimensionSnapshot totals = snapshot();
+    std::cout << "Задержка до стратегии (микросекунды) - каждое сообщение, гистограммы потоков:" << std::endl;
+    print_table("По типам сообщений:", "type", totals.types, duration_secs);
+    print_table("По производителям:", "prod", totals.producers, duration_secs);
+}
+
+void DimensionStats::export_json(const std::string& path, const std::string& scenario,
+                                 double duration_secs) const {
+    const auto parent = std::filesystem::path(path).parent_path();
+    if (!parent.empty()) {
+        std::filesystem::create_directories(parent);
+    }
+    std::ofstream out(path);
+    if (!out.is_open()) {
+        std::cerr << "Не удалось открыть файл разбивки статистики: " << path << std::endl;
+        return;
+    }
+
+    const DimensionSnapshot totals = snapshot();
+    out << std::fixed << std::setprecision(3);
+    out << "{\n  \"scenario\": \"" << scenario << "\",\n"
+        << "  \"duration_secs\": " << duration_secs << ",\n"
+        << "  \"types\": ";
+    write_json_rows(out, "msg_type", totals.types, duration_secs);
+    out << ",\n  \"producers\": ";
+    write_json_rows(out, "producer_id", totals.producers, duration_secs);
+    out << "\n}\n";
+
+    std::cout << "Разбивка по типам и производителям: " << path << std::endl << std::endl;
+}
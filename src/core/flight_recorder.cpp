@@ -0,0 +1,161 @@
+#include "flight_recorder.hpp"
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <thread>
+
+namespace {
+
+const char* event_name(TraceEvent event) {
+    switch (event) {
+        case TraceEvent::Pop:            return "pop";
+        case TraceEvent::Route:          return "route";
+        case TraceEvent::PushRetryBegin: return "push_retry";
+        case TraceEvent::PushRetryEnd:   return "push_retry";
+        case TraceEvent::Idle:           return "idle";
+        case TraceEvent::Park:           return "park";
+        case TraceEvent::Unpark:         return "unpark";
+        case TraceEvent::Stall:          return "stall";
+        case TraceEvent::Restore:        return "restore";
+    }
+    return "unknown";
+}
+
+const char* freeze_reason_name(uint32_t reason) {
+    switch (static_cast<FreezeReason>(reason)) {
+        case FreezeReason::Signal:   return "signal";
+        case FreezeReason::Latency:  return "latency";
+        case FreezeReason::Shutdown: return "shutdown";
+        default:                     return "none";
+    }
+}
+
+} // namespace
+
+FlightRecorder& FlightRecorder::instance() {
+    static FlightRecorder recorder;
+    return recorder;
+}
+
+FlightRecorder::FlightRecorder() = default;
+
+void FlightRecorder::configure(const FlightRecorderConfig& config) {
+    enabled_ = config.enabled;
+    ring_events_ = config.ring_events;
+    output_ = config.output;
+    freeze_latency_ns_.store(config.freeze_latency_us * 1000, std::memory_order_relaxed);
+
+#ifndef ROUTER_FLIGHT_RECORDER
+    if (enabled_) {
+        std::cerr << "Предупреждение: flight_recorder включен в конфигурации, но сборка выполнена "
+                  << "без ROUTER_FLIGHT_RECORDER - события не записываются" << std::endl;
+    }
+#endif
+
+    if (enabled_) {
+        calibrate();
+    }
+}
+
+void FlightRecorder::calibrate() {
+    // Калибровка частоты TSC по steady_clock (однократно, ~10ms)
+    const auto start_time = std::chrono::steady_clock::now();
+    const uint64_t start_tsc = __rdtsc();
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    const uint64_t end_tsc = __rdtsc();
+    const auto elapsed = std::chrono::steady_clock::now() - start_time;
+
+    const double elapsed_ns = static_cast<double>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+    ticks_per_ns_ = static_cast<double>(end_tsc - start_tsc) / elapsed_ns;
+    base_tsc_ = end_tsc;
+}
+
+void FlightRecorder::register_thread(const std::string& name, uint32_t index) {
+    if (!enabled_) {
+        return;
+    }
+
+    auto recorder = std::make_unique<ThreadRecorder>(
+        name + " " + std::to_string(index), ring_events_, frozen_);
+
+    std::lock_guard<std::mutex> lock(registry_mutex_);
+    current_ = recorder.get();
+    recorders_.push_back(std::move(recorder));
+}
+
+size_t FlightRecorder::export_chrome_trace(const std::string& path) const {
+    const auto parent = std::filesystem::path(path).parent_path();
+    if (!parent.empty()) {
+        std::filesystem::create_directories(parent);
+    }
+
+    std::ofstream out(path);
+    if (!out.is_open()) {
+        std::cerr << "Не удалось открыть файл трассы: " << path << std::endl;
+        return 0;
+    }
+
+    auto to_us = [this](uint64_t tsc) {
+        return (static_cast<double>(tsc) - static_cast<double>(base_tsc_)) / ticks_per_ns_ / 1000.0;
+    };
+
+    std::lock_guard<std::mutex> lock(registry_mutex_);
+    size_t events = 0;
+    char line[256];
+
+    out << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n";
+    out << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"args\":{\"name\":\"router\"}}";
+
+    for (size_t tid = 0; tid < recorders_.size(); ++tid) {
+        const ThreadRecorder& recorder = *recorders_[tid];
+        out << ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << tid
+            << ",\"args\":{\"name\":\"" << recorder.name() << "\"}}";
+
+        // Последние capacity() событий в порядке записи
+        const uint64_t head = recorder.head();
+        const uint64_t begin = head > recorder.capacity() ? head - recorder.capacity() : 0;
+        for (uint64_t i = begin; i < head; ++i) {
+            const TraceRecord& record = recorder.at(i);
+            const char* phase = record.event == TraceEvent::PushRetryBegin ? "B"
+                              : record.event == TraceEvent::PushRetryEnd ? "E"
+                              : "i";
+            std::snprintf(line, sizeof(line),
+                ",\n{\"name\":\"%s\",\"ph\":\"%s\",\"s\":\"t\",\"ts\":%.3f,\"pid\":1,\"tid\":%zu,"
+                "\"args\":{\"lane\":%u,\"arg\":%u}}",
+                event_name(record.event), phase, to_us(record.tsc), tid,
+                static_cast<unsigned>(record.lane), static_cast<unsigned>(record.arg));
+            out << line;
+            ++events;
+        }
+    }
+
+    // Глобальная отметка момента заморозки
+    const uint32_t reason = freeze_reason_.load(std::memory_order_relaxed);
+    if (reason != 0) {
+        std::snprintf(line, sizeof(line),
+            ",\n{\"name\":\"freeze: %s\",\"ph\":\"i\",\"s\":\"g\",\"ts\":%.3f,\"pid\":1,\"tid\":0}",
+            freeze_reason_name(reason), to_us(freeze_tsc_.load(std::memory_order_relaxed)));
+        out << line;
+    }
+
+    out << "\n]}\n";
+    return events;
+}
+
+void FlightRecorder::export_once() {
+    if (!enabled_ || exported_) {
+        return;
+    }
+    exported_ = true;
+
+    // Даем потокам завершить запись, начатую до заморозки
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+    const size_t events = export_chrome_trace(output_);
+    std::cout << "Бортовой самописец: заморозка ("
+              << freeze_reason_name(freeze_reason_.load(std::memory_order_relaxed))
+              << "), " << events << " событий в " << output_ << std::endl;
+}
@@ -0,0 +1,356 @@
+#include "fused_pipeline.hpp"
+#include "timer.hpp"
+#include "flight_recorder.hpp"
+#include <algorithm>
+#include <array>
+#include <iostream>
+#include <string>
+
+FusedPipeline::FusedPipeline(const SystemConfig& config, SystemStatistics& stats)
+    : stats_(stats)
+    , strategy_times_ns_(config.strategies.count, 100) // По умолчанию
+    , max_batch_(config.strategies.max_batch)
+    , ordered_merge_(config.strategies.ordered_merge)
+    , producer_watermarks_(config.producers.count)
+    , processor_watermarks_(config.processors.count)
+    , time_order_violations_(config.strategies.count, 0)
+{
+    const RouteTable routes(config.stage1_rules, config.stage2_rules,
+                            config.processors.count, config.strategies.count,
+                            compile_key_routes(config.stage1_key_rules, config.processors.count),
+                            compile_key_routes(config.stage2_key_rules, config.strategies.count));
+
+    for (size_t p = 0; p < config.producers.count; ++p) {
+        producer_lanes_.emplace_back();
+        for (size_t c = 0; c < config.processors.count; ++c) {
+            producer_lanes_[p].push_back(std::make_shared<Lane>());
+        }
+        producers_.push_back(std::make_unique<Producer>(
+            static_cast<uint8_t>(p),
+            config.producers,
+            nullptr,
+            stats_
+        ));
+        producer_routes_.push_back(routes);
+    }
+
+    for (size_t c = 0; c < config.processors.count; ++c) {
+        processor_lanes_.emplace_back();
+        for (size_t s = 0; s < config.strategies.count; ++s) {
+            processor_lanes_[c].push_back(std::make_shared<Lane>());
+        }
+        processor_routes_.push_back(routes);
+        processor_times_.emplace_back(config.processors.processing_times_ns, 100);
+    }
+
+    for (const auto& [id, ns] : config.strategies.processing_times_ns) {
+        if (id < strategy_times_ns_.size()) {
+            strategy_times_ns_[id] = ns;
+        }
+    }
+
+    // Слияния: процессор - по полосам производителей, стратегия - по полосам процессоров
+    if (ordered_merge_) {
+        processor_merges_.resize(config.processors.count);
+        for (size_t c = 0; c < config.processors.count; ++c) {
+            for (size_t p = 0; p < config.producers.count; ++p) {
+                processor_merges_[c].add_input(producer_lanes_[p][c].get(), &producer_watermarks_[p]);
+            }
+        }
+        strategy_merges_.resize(config.strategies.count);
+        for (size_t s = 0; s < config.strategies.count; ++s) {
+            for (size_t c = 0; c < config.processors.count; ++c) {
+                strategy_merges_[s].add_input(processor_lanes_[c][s].get(), &processor_watermarks_[c]);
+            }
+        }
+    }
+}
+
+void FusedPipeline::run_producer(size_t index, std::atomic<bool>& running, uint32_t duration_secs) {
+    RouteTable& routes = producer_routes_[index];
+    auto& lanes = producer_lanes_[index];
+    Watermark* watermark = ordered_merge_ ? &producer_watermarks_[index] : nullptr;
+
+    // Маршрутизация Stage1 в потоке производителя - один раз на сообщение, как в Stage1Router:
+    // повторы при полной полосе не сдвигают round-robin и не уводят сообщение к другому процессору
+    uint8_t processor_id = 0;
+    auto route = [&routes, &processor_id](Message& msg) {
+        msg.stage1_entry_ns = Message::get_timestamp_ns();
+        processor_id = routes.select_processor(msg);
+        FR_EVENT(Route, processor_id, msg.msg_type);
+    };
+
+    producers_[index]->run_with(running, duration_secs, route, [&lanes, &processor_id, watermark](Message& msg) {
+        // Выход из Stage1 - момент успешной записи: ожидание места в полосе входит в Stage1
+        msg.stage1_exit_ns = Message::get_timestamp_ns();
+        if (!lanes[processor_id]->try_push(msg)) {
+            return false;
+        }
+
+        // Heartbeat для всех полос производителя: следующие сообщения будут новее
+        if (watermark) {
+            watermark->advance(msg.timestamp_ns);
+        }
+        return true;
+    }, [watermark](uint64_t timestamp_ns) {
+        // Простой и ожидание места: полосы производителя не задерживают слияние до следующей отправки
+        if (watermark) {
+            watermark->advance(timestamp_ns);
+        }
+    });
+
+    // Производитель остановлен: его полосы больше не задерживают слияние
+    if (watermark) {
+        watermark->close();
+    }
+}
+
+void FusedPipeline::process_batch(size_t index, Message* batch, size_t count) {
+    RouteTable& routes = processor_routes_[index];
+    auto& outputs = processor_lanes_[index];
+
+    const size_t kept = invoke_handler_batch(processor_times_[index], std::span<Message>(batch, count));
+    if (kept < count) {
+        stats_.count(StatsField::Rejected, count - kept);
+    }
+
+    const uint64_t exit_ns = Message::get_timestamp_ns();
+    for (size_t i = 0; i < kept; ++i) {
+        Message& msg = batch[i];
+        msg.processing_exit_ns = exit_ns;
+        msg.processing_ts_ns = exit_ns;
+
+        // Маршрутизация Stage2 в потоке процессора
+        msg.stage2_entry_ns = Message::get_timestamp_ns();
+        const uint8_t strategy_id = routes.select_strategy(msg);
+        FR_EVENT(Route, strategy_id, msg.msg_type);
+
+        // ВАЖНО: продолжаем пытаться отправить даже если running==false
+        msg.stage2_exit_ns = Message::get_timestamp_ns();
+        if (!outputs[strategy_id]->try_push(msg)) {
+            FR_EVENT(PushRetryBegin, strategy_id, 0);
+            do {
+                __builtin_ia32_pause();
+                msg.stage2_exit_ns = Message::get_timestamp_ns();
+            } while (!outputs[strategy_id]->try_push(msg));
+            FR_EVENT(PushRetryEnd, strategy_id, 0);
+        }
+        stats_.count(StatsField::Processed, 1);
+    }
+}
+
+void FusedPipeline::run_processor(size_t index, std::atomic<bool>& running) {
+    FR_THREAD("processor", index);
+    const uint8_t id = static_cast<uint8_t>(index);
+
+    std::array<Message, HANDLER_BATCH_SIZE> batch;
+    uint64_t published_frontier = 0;
+    bool idle = false;
+
+    while (running.load(std::memory_order_relaxed)) {
+        bool processed_any = false;
+
+        if (ordered_merge_) {
+            // Пакет в порядке timestamp_ns по полосам всех производителей
+            size_t count = 0;
+            processor_merges_[index].merge(batch.size(), [&](const Message& msg) {
+                batch[count] = msg;
+                batch[count].processing_entry_ns = Message::get_timestamp_ns();
+                batch[count].processor_id = id;
+                ++count;
+            });
+            if (count > 0) {
+                FR_EVENT(Pop, index, count);
+                process_batch(index, batch.data(), count);
+                processed_any = true;
+            }
+
+            // Граница слияния публикуется после отправки пакета: старше нее процессор не отправит
+            const uint64_t frontier = processor_merges_[index].frontier();
+            if (frontier != published_frontier) {
+                processor_watermarks_[index].advance(frontier);
+                published_frontier = frontier;
+            }
+        } else {
+            // Полосы всех производителей по очереди, до HANDLER_BATCH_SIZE сообщений из каждой
+            for (size_t p = 0; p < producer_lanes_.size(); ++p) {
+                Lane& input = *producer_lanes_[p][index];
+                size_t count = 0;
+                while (count < batch.size() && input.try_pop(batch[count])) {
+                    batch[count].processing_entry_ns = Message::get_timestamp_ns();
+                    batch[count].processor_id = id;
+                    ++count;
+                }
+                if (count == 0) {
+                    continue;
+                }
+                FR_EVENT(Pop, index, count);
+                process_batch(index, batch.data(), count);
+                processed_any = true;
+            }
+        }
+
+        if (!processed_any) {
+            if (!idle) {
+                FR_EVENT(Idle, index, 0);
+                idle = true;
+            }
+            __builtin_ia32_pause();
+        } else {
+            idle = false;
+        }
+    }
+}
+
+void FusedPipeline::deliver_batch(uint8_t strategy_id, std::span<const Message> batch) {
+    for (const Message& msg : batch) {
+        if (journal_) {
+            journal_->append(msg, strategy_id);
+        }
+        stats_.record_message_latencies(msg);
+        FR_CHECK_LATENCY(msg.strategy_entry_ns - msg.timestamp_ns);
+    }
+    stats_.track_batch_order(batch);
+    stats_.dimensions.record_delivered(batch);
+    stats_.count(StatsField::Delivered, batch.size());
+}
+
+void FusedPipeline::run_strategy(size_t index, std::atomic<bool>& running) {
+    FR_THREAD("strategy", index);
+    const uint8_t id = static_cast<uint8_t>(index);
+    const uint64_t processing_time_ns = strategy_times_ns_[index];
+
+    // Пакет слияния собирается из голов разных полос - копия в локальный буфер
+    std::vector<Message> merged(ordered_merge_ ? max_batch_ : 0);
+    uint64_t last_timestamp_ns = 0;
+    bool idle = false;
+
+    auto handle = [&](std::span<Message> batch) {
+        FR_EVENT(Pop, index, batch.size());
+
+        const uint64_t entry_ns = Message::get_timestamp_ns();
+        for (Message& msg : batch) {
+            msg.strategy_entry_ns = entry_ns;
+        }
+
+        // Имитация времени обработки за весь пакет (как Strategy::on_batch)
+        if (processing_time_ns > 0) {
+            Timer::busy_wait_ns(processing_time_ns * batch.size());
+        }
+
+        deliver_batch(id, batch);
+    };
+
+    while (running.load(std::memory_order_relaxed)) {
+        bool processed_any = false;
+
+        if (ordered_merge_) {
+            size_t count = 0;
+            strategy_merges_[index].merge(max_batch_, [&](const Message& msg) {
+                // Контроль слияния: поток стратегии не должен идти назад по времени
+                if (msg.timestamp_ns < last_timestamp_ns) {
+                    ++time_order_violations_[index];
+                }
+                last_timestamp_ns = msg.timestamp_ns;
+                merged[count++] = msg;
+            });
+            if (count > 0) {
+                handle(std::span<Message>(merged.data(), count));
+                processed_any = true;
+            }
+        } else {
+            // Готовые сообщения каждой полосы обрабатываются прямо в ее буфере
+            for (size_t c = 0; c < processor_lanes_.size(); ++c) {
+                Lane& input = *processor_lanes_[c][index];
+                std::span<Message> batch = input.peek(max_batch_);
+                if (batch.empty()) {
+                    continue;
+                }
+                handle(batch);
+                input.release(batch.size());
+                processed_any = true;
+            }
+        }
+
+        if (!processed_any) {
+            if (!idle) {
+                FR_EVENT(Idle, index, 0);
+                idle = true;
+            }
+            __builtin_ia32_pause();
+        } else {
+            idle = false;
+        }
+    }
+}
+
+void FusedPipeline::add_sampler_edges(QueueSampler& sampler) const {
+    for (size_t p = 0; p < producer_lanes_.size(); ++p) {
+        for (size_t c = 0; c < producer_lanes_[p].size(); ++c) {
+            sampler.add_edge("prod" + std::to_string(p) + "->proc" + std::to_string(c), producer_lanes_[p][c]);
+        }
+    }
+    for (size_t c = 0; c < processor_lanes_.size(); ++c) {
+        for (size_t s = 0; s < processor_lanes_[c].size(); ++s) {
+            sampler.add_edge("proc" + std::to_string(c) + "->strat" + std::to_string(s), processor_lanes_[c][s]);
+        }
+    }
+}
+
+void FusedPipeline::update_queue_depths() {
+    for (size_t c = 0; c < processor_lanes_.size(); ++c) {
+        size_t depth = 0;
+        for (const auto& lanes : producer_lanes_) {
+            depth += lanes[c]->size();
+        }
+        stats_.stage1_queue_depths[c]->store(depth, std::memory_order_relaxed);
+    }
+    for (size_t s = 0; s < strategy_times_ns_.size(); ++s) {
+        size_t depth = 0;
+        for (const auto& lanes : processor_lanes_) {
+            depth += lanes[s]->size();
+        }
+        stats_.stage2_queue_depths[s]->store(depth, std::memory_order_relaxed);
+    }
+}
+
+void FusedPipeline::print_report() const {
+    auto summarize = [](const std::vector<std::vector<std::shared_ptr<Lane>>>& lanes,
+                        size_t& count, size_t& high_watermark, uint64_t& full_events) {
+        for (const auto& row : lanes) {
+            for (const auto& lane : row) {
+                ++count;
+                high_watermark = std::max(high_watermark, lane->high_watermark());
+                full_events += lane->full_events();
+            }
+        }
+    };
+
+    size_t count = 0, high_watermark = 0;
+    uint64_t full_events = 0;
+    summarize(producer_lanes_, count, high_watermark, full_events);
+    std::cout << "Полосы fused (" << FUSED_LANE_SIZE << " сообщений):" << std::endl;
+    std::cout << "  producer->processor: " << count << " полос, макс. заполнение " << high_watermark
+              << ", переполнений " << full_events << std::endl;
+
+    count = high_watermark = 0;
+    full_events = 0;
+    summarize(processor_lanes_, count, high_watermark, full_events);
+    std::cout << "  processor->strategy: " << count << " полос, макс. заполнение " << high_watermark
+              << ", переполнений " << full_events << std::endl;
+
+    if (ordered_merge_) {
+        std::cout << "  Слияние по timestamp_ns (сообщений / ожиданий водяного знака / нарушений времени):"
+                  << std::endl;
+        for (size_t c = 0; c < processor_merges_.size(); ++c) {
+            std::cout << "    processor " << c << ": " << processor_merges_[c].merged()
+                      << " / " << processor_merges_[c].blocked() << std::endl;
+        }
+        for (size_t s = 0; s < strategy_merges_.size(); ++s) {
+            std::cout << "    strategy " << s << ": " << strategy_merges_[s].merged()
+                      << " / " << strategy_merges_[s].blocked()
+                      << " / " << time_order_violations_[s] << std::endl;
+        }
+    }
+    std::cout << std::endl;
+}
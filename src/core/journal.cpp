@@ -0,0 +1,294 @@
+#include "journal.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <iomanip>
+#include <iostream>
+#include <stdexcept>
+#include <thread>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+constexpr size_t PAGE_SIZE = 4096;
+constexpr const char* SEGMENT_EXTENSION = ".journal";
+
+std::string segment_path(const std::string& directory, uint64_t index) {
+    char name[64];
+    std::snprintf(name, sizeof(name), "segment_%06llu%s",
+                  static_cast<unsigned long long>(index), SEGMENT_EXTENSION);
+    return (fs::path(directory) / name).string();
+}
+
+std::runtime_error journal_error(const std::string& what, const std::string& path) {
+    return std::runtime_error(what + " (" + path + "): " + std::strerror(errno));
+}
+
+} // namespace
+
+// JournalWriter реализация
+
+JournalWriter::JournalWriter(const JournalConfig& config)
+    : config_(config)
+    , segment_bytes_(JOURNAL_HEADER_SIZE + config.segment_records * sizeof(JournalRecord))
+{
+    fs::create_directories(config_.directory);
+
+    // Сегменты предыдущего запуска удаляются, чтобы читатель не смешал журналы
+    for (const auto& entry : fs::directory_iterator(config_.directory)) {
+        if (entry.path().extension() == SEGMENT_EXTENSION) {
+            fs::remove(entry.path());
+        }
+    }
+
+    // Два сегмента готовы до старта, чтобы писатели не ждали первого отображения
+    open_segment(0);
+    open_segment(1);
+    last_sync_ns_ = Message::get_timestamp_ns();
+}
+
+JournalWriter::~JournalWriter() {
+    for (auto& segment : segments_) {
+        if (segment.ready_index.load(std::memory_order_relaxed) != 0) {
+            retire_segment(segment);
+        }
+    }
+}
+
+void JournalWriter::open_segment(uint64_t index) {
+    Segment& segment = segments_[index % SEGMENT_RING];
+    const std::string path = segment_path(config_.directory, index);
+
+    int fd = ::open(path.c_str(), O_CREAT | O_TRUNC | O_RDWR, 0644);
+    if (fd < 0) {
+        throw journal_error("Не удалось создать сегмент журнала", path);
+    }
+
+    // Предвыделение места, чтобы запись не расширяла файл на горячем пути
+    int err = posix_fallocate(fd, 0, static_cast<off_t>(segment_bytes_));
+    if (err != 0) {
+        ::close(fd);
+        errno = err;
+        throw journal_error("Не удалось выделить место под сегмент", path);
+    }
+
+    // MAP_POPULATE заранее подтягивает страницы, стратегии не ловят page fault
+    void* base = mmap(nullptr, segment_bytes_, PROT_READ | PROT_WRITE,
+                      MAP_SHARED | MAP_POPULATE, fd, 0);
+    if (base == MAP_FAILED) {
+        ::close(fd);
+        throw journal_error("Не удалось отобразить сегмент журнала", path);
+    }
+
+    auto* header = static_cast<JournalSegmentHeader*>(base);
+    header->magic = JOURNAL_MAGIC;
+    header->version = JOURNAL_VERSION;
+    header->record_size = sizeof(JournalRecord);
+    header->segment_index = index;
+    header->records_per_segment = config_.segment_records;
+    header->first_record = index * config_.segment_records;
+
+    segment.fd = fd;
+    segment.base = base;
+    segment.size = segment_bytes_;
+    segment.records = reinterpret_cast<JournalRecord*>(static_cast<char*>(base) + JOURNAL_HEADER_SIZE);
+    segment.ready_index.store(index + 1, std::memory_order_release);
+
+    ++mapped_segments_;
+}
+
+void JournalWriter::retire_segment(Segment& segment) {
+    segment.ready_index.store(0, std::memory_order_release);
+
+    if (config_.sync_policy != JournalSyncPolicy::None) {
+        msync(segment.base, segment.size, MS_SYNC);
+        fdatasync(segment.fd);
+        sync_calls_.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    munmap(segment.base, segment.size);
+    ::close(segment.fd);
+    segment.fd = -1;
+    segment.base = nullptr;
+    segment.records = nullptr;
+}
+
+void JournalWriter::append(const Message& msg, uint8_t strategy_id) noexcept {
+    const uint64_t pos = next_record_.fetch_add(1, std::memory_order_relaxed);
+    const uint64_t index = pos / config_.segment_records;
+    Segment& segment = segments_[index % SEGMENT_RING];
+
+    // Сегмент отображается потоком журнала заранее; ожидание - редкий случай
+    if (segment.ready_index.load(std::memory_order_acquire) != index + 1) {
+        writer_stalls_.fetch_add(1, std::memory_order_relaxed);
+        while (segment.ready_index.load(std::memory_order_acquire) != index + 1) {
+            __builtin_ia32_pause();
+        }
+    }
+
+    JournalRecord& record = segment.records[pos % config_.segment_records];
+    record.strategy_id = strategy_id;
+    record.receive_ns = Message::get_timestamp_ns();
+    record.msg = msg;
+    record.committed.store(1, std::memory_order_release);
+}
+
+void JournalWriter::sync_range(uint64_t from, uint64_t to) {
+    while (from < to) {
+        const uint64_t index = from / config_.segment_records;
+        const uint64_t segment_end = (index + 1) * config_.segment_records;
+        const uint64_t end = std::min(to, segment_end);
+        Segment& segment = segments_[index % SEGMENT_RING];
+
+        // Диапазон записей, выровненный по границам страниц
+        size_t begin_off = JOURNAL_HEADER_SIZE + (from % config_.segment_records) * sizeof(JournalRecord);
+        size_t end_off = JOURNAL_HEADER_SIZE + ((end - 1) % config_.segment_records + 1) * sizeof(JournalRecord);
+        begin_off &= ~(PAGE_SIZE - 1);
+
+        msync(static_cast<char*>(segment.base) + begin_off, end_off - begin_off, MS_SYNC);
+        sync_calls_.fetch_add(1, std::memory_order_relaxed);
+        from = end;
+    }
+    synced_prefix_ = to;
+}
+
+void JournalWriter::step(bool force_sync) {
+    const uint64_t reserved = next_record_.load(std::memory_order_acquire);
+
+    // 1. Продвижение непрерывного префикса записанных записей
+    while (committed_prefix_ < reserved) {
+        const uint64_t index = committed_prefix_ / config_.segment_records;
+        const Segment& segment = segments_[index % SEGMENT_RING];
+        if (segment.ready_index.load(std::memory_order_acquire) != index + 1) {
+            break;
+        }
+        const JournalRecord& record = segment.records[committed_prefix_ % config_.segment_records];
+        if (record.committed.load(std::memory_order_acquire) == 0) {
+            break;
+        }
+        ++committed_prefix_;
+    }
+
+    // 2. Синхронизация согласно политике
+    const uint64_t now = Message::get_timestamp_ns();
+    bool do_sync = force_sync;
+    if (config_.sync_policy == JournalSyncPolicy::EveryN) {
+        do_sync = do_sync || committed_prefix_ - synced_prefix_ >= config_.sync_every_n;
+    } else if (config_.sync_policy == JournalSyncPolicy::Interval) {
+        do_sync = do_sync || now - last_sync_ns_ >= config_.sync_interval_ms * 1'000'000ULL;
+    }
+    if (do_sync && config_.sync_policy != JournalSyncPolicy::None && committed_prefix_ > synced_prefix_) {
+        sync_range(synced_prefix_, committed_prefix_);
+        last_sync_ns_ = now;
+    }
+    committed_records_.store(committed_prefix_, std::memory_order_relaxed);
+
+    // 3. Закрытие полностью записанных сегментов
+    while (retired_segments_ < committed_prefix_ / config_.segment_records) {
+        retire_segment(segments_[retired_segments_ % SEGMENT_RING]);
+        ++retired_segments_;
+    }
+
+    // 4. Отображение сегментов впрок: текущий сегмент писателей + следующий
+    const uint64_t needed = reserved / config_.segment_records + 2;
+    while (mapped_segments_ < needed && mapped_segments_ - retired_segments_ < SEGMENT_RING) {
+        open_segment(mapped_segments_);
+    }
+}
+
+void JournalWriter::run(std::atomic<bool>& running) {
+    while (running.load(std::memory_order_relaxed)) {
+        step(false);
+        std::this_thread::sleep_for(std::chrono::microseconds(100));
+    }
+
+    // Стратегии могут дописывать после остановки: даем им завершиться
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    step(true);
+}
+
+void JournalWriter::print_report(double duration_secs) const {
+    const uint64_t records = committed_records_.load(std::memory_order_relaxed);
+    const char* policy = config_.sync_policy == JournalSyncPolicy::None ? "none"
+                       : config_.sync_policy == JournalSyncPolicy::Interval ? "interval"
+                       : "every_n";
+
+    std::cout << "Журнал доставленных сообщений:" << std::endl;
+    std::cout << "  Каталог:                " << config_.directory << std::endl;
+    std::cout << "  Политика синхронизации: " << policy << std::endl;
+    std::cout << "  Записей:                " << records << std::endl;
+    std::cout << "  Сегментов:              " << mapped_segments_ << std::endl;
+    std::cout << "  Вызовов msync:          " << sync_calls_.load(std::memory_order_relaxed) << std::endl;
+    std::cout << "  Ожиданий сегмента:      " << writer_stalls_.load(std::memory_order_relaxed) << std::endl;
+    std::cout << "  Скорость записи:        " << std::fixed << std::setprecision(2)
+              << (static_cast<double>(records * sizeof(JournalRecord)) / duration_secs / 1e6)
+              << " MB/сек" << std::endl;
+    std::cout << std::endl;
+}
+
+// JournalReader реализация
+
+JournalReader::JournalReader(const std::string& directory) {
+    std::vector<fs::path> paths;
+    for (const auto& entry : fs::directory_iterator(directory)) {
+        if (entry.path().extension() == SEGMENT_EXTENSION) {
+            paths.push_back(entry.path());
+        }
+    }
+    std::sort(paths.begin(), paths.end());
+
+    for (size_t i = 0; i < paths.size(); ++i) {
+        const std::string path = paths[i].string();
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            throw journal_error("Не удалось открыть сегмент журнала", path);
+        }
+
+        const size_t size = static_cast<size_t>(fs::file_size(paths[i]));
+        void* base = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+        ::close(fd);
+        if (base == MAP_FAILED) {
+            throw journal_error("Не удалось отобразить сегмент журнала", path);
+        }
+
+        const auto* header = static_cast<const JournalSegmentHeader*>(base);
+        if (size < JOURNAL_HEADER_SIZE || header->magic != JOURNAL_MAGIC ||
+            header->version != JOURNAL_VERSION || header->record_size != sizeof(JournalRecord) ||
+            header->segment_index != i) {
+            munmap(base, size);
+            throw std::runtime_error("Некорректный или несовместимый сегмент журнала: " + path);
+        }
+
+        records_per_segment_ = header->records_per_segment;
+        segments_.push_back({
+            base, size,
+            reinterpret_cast<const JournalRecord*>(static_cast<const char*>(base) + JOURNAL_HEADER_SIZE)
+        });
+    }
+
+    // Непрерывный префикс записанных записей
+    for (const auto& segment : segments_) {
+        uint64_t count = 0;
+        while (count < records_per_segment_ &&
+               segment.records[count].committed.load(std::memory_order_acquire) != 0) {
+            ++count;
+        }
+        size_ += count;
+        if (count < records_per_segment_) {
+            break;
+        }
+    }
+}
+
+JournalReader::~JournalReader() {
+    for (const auto& segment : segments_) {
+        munmap(segment.base, segment.size);
+    }
+}
@@ -0,0 +1,148 @@
+#include "key_routes.hpp"
+#include <algorithm>
+#include <numeric>
+#include <stdexcept>
+#include <utility>
+
+// Корзин perfect hash: в среднем 4 ключа на корзину
+constexpr size_t KEYS_PER_BUCKET = 4;
+
+// Предел перебора смещений одной корзины (при исчерпании - ошибка компиляции правил)
+constexpr uint32_t MAX_DISPLACEMENT = 1u << 24;
+
+KeyRouteMap::KeyRouteMap(const std::vector<KeyRule>& rules, size_t default_targets)
+    : default_targets_(std::max<size_t>(default_targets, 1))
+{
+    // Явные ключи в порядке правил; ключ под hash-правилом выше по списку получает его получателя
+    std::vector<std::pair<uint32_t, uint8_t>> entries;
+    for (const auto& rule : rules) {
+        if (rule.match == KeyMatch::Hash) {
+            HashRule compiled;
+            compiled.residues.assign(rule.modulus, false);
+            for (uint32_t residue : rule.residues) {
+                compiled.residues[residue] = true;
+            }
+            compiled.targets = rule.targets;
+            hash_rules_.push_back(std::move(compiled));
+            continue;
+        }
+
+        auto add = [&](uint32_t key) {
+            uint8_t target = pick(rule.targets, key);
+            for (const HashRule& earlier : hash_rules_) {
+                if (earlier.residues[hash(key, PARTITION_SEED) % earlier.residues.size()]) {
+                    target = pick(earlier.targets, key);
+                    break;
+                }
+            }
+            entries.emplace_back(key, target);
+        };
+        if (rule.match == KeyMatch::Range) {
+            for (uint64_t key = rule.first; key <= rule.last; ++key) {
+                add(static_cast<uint32_t>(key));
+            }
+        } else {
+            for (uint32_t key : rule.keys) {
+                add(key);
+            }
+        }
+    }
+
+    // Повторы ключа: остается первое правило (устойчивая сортировка сохраняет порядок правил)
+    std::stable_sort(entries.begin(), entries.end(),
+                     [](const auto& a, const auto& b) { return a.first < b.first; });
+    entries.erase(std::unique(entries.begin(), entries.end(),
+                              [](const auto& a, const auto& b) { return a.first == b.first; }),
+                  entries.end());
+    explicit_keys_ = entries.size();
+    if (entries.empty()) {
+        return;
+    }
+
+    const uint64_t span = static_cast<uint64_t>(entries.back().first) - entries.front().first + 1;
+    if (span <= KEY_DENSE_SPAN_LIMIT && span <= std::max<uint64_t>(4 * entries.size(), 4096)) {
+        dense_base_ = entries.front().first;
+        dense_.assign(span, NO_TARGET);
+        for (const auto& [key, target] : entries) {
+            dense_[key - dense_base_] = target;
+        }
+        return;
+    }
+
+    build_perfect_hash(entries);
+}
+
+void KeyRouteMap::build_perfect_hash(const std::vector<std::pair<uint32_t, uint8_t>>& entries) {
+    const size_t count = entries.size();
+    const size_t bucket_count = std::max<size_t>(1, count / KEYS_PER_BUCKET);
+    const size_t slot_count = count + count / 8 + 1;
+
+    displacements_.assign(bucket_count, 0);
+    slots_.assign(slot_count, Slot{});
+
+    // Ключи по корзинам (сортировка подсчетом)
+    std::vector<uint32_t> bucket_of(count);
+    std::vector<uint32_t> offsets(bucket_count + 1, 0);
+    for (size_t i = 0; i < count; ++i) {
+        bucket_of[i] = fast_range(hash(entries[i].first, BUCKET_SEED), bucket_count);
+        ++offsets[bucket_of[i] + 1];
+    }
+    std::partial_sum(offsets.begin(), offsets.end(), offsets.begin());
+    std::vector<uint32_t> members(count);
+    {
+        std::vector<uint32_t> cursor(offsets.begin(), offsets.end() - 1);
+        for (size_t i = 0; i < count; ++i) {
+            members[cursor[bucket_of[i]]++] = static_cast<uint32_t>(i);
+        }
+    }
+
+    // Большие корзины размещаются первыми, пока в таблице много свободных слотов
+    std::vector<uint32_t> order(bucket_count);
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) {
+        return offsets[a + 1] - offsets[a] > offsets[b + 1] - offsets[b];
+    });
+
+    std::vector<bool> taken(slot_count, false);
+    std::vector<uint32_t> placed;
+    for (uint32_t bucket : order) {
+        const uint32_t begin = offsets[bucket];
+        const uint32_t end = offsets[bucket + 1];
+        if (begin == end) {
+            break;
+        }
+
+        // Подбор смещения, при котором все ключи корзины попадают в разные свободные слоты
+        uint32_t displacement = 1;
+        for (;; ++displacement) {
+            if (displacement == MAX_DISPLACEMENT) {
+                throw std::runtime_error("Не удалось построить perfect hash для правил по ключу");
+            }
+            placed.clear();
+            bool fits = true;
+            for (uint32_t m = begin; m < end && fits; ++m) {
+                const uint32_t slot = fast_range(hash(entries[members[m]].first, displacement), slot_count);
+                fits = !taken[slot] && std::find(placed.begin(), placed.end(), slot) == placed.end();
+                placed.push_back(slot);
+            }
+            if (fits) {
+                break;
+            }
+        }
+
+        displacements_[bucket] = displacement;
+        for (uint32_t m = begin; m < end; ++m) {
+            const auto& [key, target] = entries[members[m]];
+            const uint32_t slot = placed[m - begin];
+            taken[slot] = true;
+            slots_[slot] = Slot{key, target};
+        }
+    }
+}
+
+std::shared_ptr<const KeyRouteMap> compile_key_routes(const std::vector<KeyRule>& rules, size_t targets) {
+    if (rules.empty()) {
+        return nullptr;
+    }
+    return std::make_shared<const KeyRouteMap>(rules, targets);
+}
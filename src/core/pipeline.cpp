@@ -0,0 +1,642 @@
+#include "pipeline.hpp"
+#include <iostream>
+#include <string>
+
+// Период проверки дренирования очередей
+constexpr std::chrono::milliseconds DRAIN_POLL_INTERVAL{10};
+
+Pipeline::Pipeline(const SystemConfig& config)
+    : config_(config)
+    , stats_(config.total_producers(), config.total_processors(), config.strategies.count)
+    , shm_seen_pushed_(config.total_producers(), 0)
+{
+    // Количество потоков-процессоров с учетом резерва эластичного масштабирования
+    const uint32_t total_processors = config_.total_processors();
+
+    // Порядок проверяется только для типов, где он требуется
+    for (const auto& rule : config_.stage2_rules) {
+        stats_.order_exempt_types[rule.msg_type] = !rule.ordering_required;
+    }
+
+    // Счетчики производительности потоков компонентов (опционально)
+    if (config_.perf_counters.enabled) {
+        perf_counters_ = std::make_unique<PerfStageCounters>(config_.perf_counters.include_kernel);
+    }
+
+    // Журнал доставленных сообщений (опционально)
+    if (config_.journal.enabled) {
+        journal_ = std::make_unique<JournalWriter>(config_.journal);
+    }
+
+    // Временной ряд заполнения всех ребер конвейера (опционально)
+    if (config_.queue_sampler.enabled) {
+        queue_sampler_ = std::make_unique<QueueSampler>(config_.queue_sampler);
+    }
+
+    // Кольцевой режим: вместо очередей сообщений - общие кольца и очереди ссылок
+    if (config_.runtime.transport == PipelineTransport::SharedRing) {
+        ring_ = std::make_unique<RingPipeline>(config_, stats_);
+        ring_->set_journal(journal_.get());
+        if (queue_sampler_) {
+            ring_->add_sampler_edges(*queue_sampler_);
+        }
+        return;
+    }
+
+    // Слитный режим: маршрутизация в потоках производителей и процессоров
+    if (config_.runtime.topology == PipelineTopology::Fused) {
+        fused_ = std::make_unique<FusedPipeline>(config_, stats_);
+        fused_->set_journal(journal_.get());
+        if (queue_sampler_) {
+            fused_->add_sampler_edges(*queue_sampler_);
+        }
+        return;
+    }
+
+    // ========== Создание очередей ==========
+
+    const auto queues_start = std::chrono::steady_clock::now();
+
+    // Арена очередей (queue_memory): одно резервирование под все очереди конвейера
+    if (config_.queue_memory.backing != QueueBacking::Heap) {
+        const size_t producer_queues = config_.shm.enabled ? 0 : config_.total_producers();
+        queue_arena_ = QueueArena::create(config_.queue_memory.backing,
+            producer_queues * QueueArena::footprint(sizeof(ProducerQueue))
+            + 2 * total_processors * QueueArena::footprint(sizeof(ProcessorQueue))
+            + config_.strategies.count * QueueArena::footprint(sizeof(StrategyQueue)));
+    }
+
+    // Ядро потребителя очереди для prefault: известно только для корутин с привязкой
+    // (компоненты распределяются по планировщикам round-robin в порядке конвейера, см. start_coroutines)
+    const size_t producer_components = config_.replay.enabled ? 0 : config_.producers.count;
+    auto consumer_core = [this](size_t component) -> int {
+        if (config_.runtime.mode != RuntimeMode::Coroutines || !config_.runtime.pin) {
+            return -1;
+        }
+        return static_cast<int>(config_.runtime.first_core + component % config_.runtime.schedulers);
+    };
+    const size_t stage1_component = producer_components;
+    const size_t stage2_component = stage1_component + 1 + total_processors;
+
+    // Очереди от производителей к Stage1 Router
+    // В режиме shm очереди размещаются в разделяемой памяти, доступной внешним процессам
+    if (config_.shm.enabled) {
+        shm_queues_ = ShmProducerQueues::create(config_.shm.name, config_.total_producers());
+    }
+
+    for (size_t i = 0; i < config_.total_producers(); ++i) {
+        producer_queues_.push_back(shm_queues_
+            ? shm_queues_->shared_queue(static_cast<uint32_t>(i))
+            : make_queue<ProducerQueue>(consumer_core(stage1_component))
+        );
+    }
+
+    // Очереди от Stage1 Router к процессорам
+    for (size_t i = 0; i < total_processors; ++i) {
+        stage1_to_processor_queues_.push_back(make_queue<ProcessorQueue>(consumer_core(stage1_component + 1 + i)));
+    }
+
+    // Очереди от процессоров к Stage2 Router
+    for (size_t i = 0; i < total_processors; ++i) {
+        processor_to_stage2_queues_.push_back(make_queue<ProcessorQueue>(consumer_core(stage2_component)));
+    }
+
+    // Очереди от Stage2 Router к стратегиям
+    for (size_t i = 0; i < config_.strategies.count; ++i) {
+        stage2_to_strategy_queues_.push_back(make_queue<StrategyQueue>(consumer_core(stage2_component + 1 + i)));
+    }
+
+    if (queue_arena_ && config_.queue_memory.prefault) {
+        queue_arena_->prefault();
+    }
+    queue_setup_ns_ = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - queues_start).count());
+
+    // Кольца multicast: одно на каждый различный набор получателей
+    const auto groups = multicast_groups(config_.stage2_rules);
+    for (const auto& group : groups) {
+        multicast_rings_.push_back(std::make_shared<MulticastRing>(group.size()));
+    }
+
+    // Ребра конвейера в сэмплере
+    if (queue_sampler_) {
+        for (size_t i = 0; i < producer_queues_.size(); ++i) {
+            queue_sampler_->add_edge("prod" + std::to_string(i) + "->stage1", producer_queues_[i]);
+        }
+        for (size_t i = 0; i < total_processors; ++i) {
+            queue_sampler_->add_edge("stage1->proc" + std::to_string(i), stage1_to_processor_queues_[i]);
+        }
+        for (size_t i = 0; i < total_processors; ++i) {
+            queue_sampler_->add_edge("proc" + std::to_string(i) + "->stage2", processor_to_stage2_queues_[i]);
+        }
+        for (size_t i = 0; i < config_.strategies.count; ++i) {
+            queue_sampler_->add_edge("stage2->strat" + std::to_string(i), stage2_to_strategy_queues_[i]);
+        }
+        for (size_t i = 0; i < multicast_rings_.size(); ++i) {
+            queue_sampler_->add_edge("stage2->mcast" + std::to_string(i), multicast_rings_[i]);
+        }
+    }
+
+    // ========== Создание компонентов ==========
+
+    // Производители (в режиме воспроизведения их заменяет JournalReplayer)
+    if (config_.replay.enabled) {
+        replayer_ = std::make_unique<JournalReplayer>(config_.replay, producer_queues_, stats_);
+    }
+    for (size_t i = 0; i < (replayer_ ? 0 : config_.producers.count); ++i) {
+        producers_.push_back(std::make_unique<Producer>(
+            static_cast<uint8_t>(i),
+            config_.producers,
+            producer_queues_[i],
+            stats_
+        ));
+    }
+
+    // Процессоры
+    for (size_t i = 0; i < total_processors; ++i) {
+        processors_.push_back(std::make_unique<Processor>(
+            static_cast<uint8_t>(i),
+            config_.processors,
+            stage1_to_processor_queues_[i],
+            processor_to_stage2_queues_[i],
+            stats_
+        ));
+    }
+
+    // Стратегии
+    for (size_t i = 0; i < config_.strategies.count; ++i) {
+        strategies_.push_back(std::make_unique<Strategy>(
+            static_cast<uint8_t>(i),
+            config_.strategies,
+            stage2_to_strategy_queues_[i],
+            stats_
+        ));
+    }
+
+    // Подписка стратегий на кольца своих групп; первый получатель ведет учет доставки
+    for (size_t g = 0; g < groups.size(); ++g) {
+        for (size_t reader = 0; reader < groups[g].size(); ++reader) {
+            strategies_[groups[g][reader]]->add_multicast(multicast_rings_[g], reader, reader == 0);
+        }
+    }
+
+    // Журнал доставленных сообщений (опционально)
+    if (journal_) {
+        for (auto& strategy : strategies_) {
+            strategy->set_journal(journal_.get());
+        }
+    }
+
+    // Роутеры
+    stage1_router_ = std::make_unique<Stage1Router>(
+        config_.stage1_rules,
+        producer_queues_,
+        stage1_to_processor_queues_
+    );
+
+    // Контроль допуска в Stage1 (опционально)
+    if (config_.admission.enabled) {
+        admission_ = std::make_unique<AdmissionControl>(config_.admission, stats_);
+        stage1_router_->set_admission(admission_.get());
+    }
+
+    stage2_router_ = std::make_unique<Stage2Router>(
+        config_.stage2_rules,
+        processor_to_stage2_queues_,
+        stage2_to_strategy_queues_,
+        multicast_rings_
+    );
+
+    // Маршрутизация по routing_key (опционально, вместо правил по типу)
+    stage1_router_->set_key_routes(compile_key_routes(config_.stage1_key_rules, config_.processors.count));
+    stage2_router_->set_key_routes(compile_key_routes(config_.stage2_key_rules, config_.strategies.count));
+
+    // Адаптивные пакеты роутеров и процессоров (опционально)
+    if (config_.batching.enabled) {
+        stage1_router_->set_batching(config_.batching);
+        stage2_router_->set_batching(config_.batching);
+        for (auto& processor : processors_) {
+            processor->set_batching(config_.batching);
+        }
+    }
+
+    // Контроллер эластичного масштабирования (опционально)
+    if (config_.elastic.enabled) {
+        elastic_controller_ = std::make_unique<ElasticController>(
+            config_,
+            *stage1_router_,
+            processors_,
+            stage1_to_processor_queues_
+        );
+    }
+
+    // Сторож остановок процессоров (опционально)
+    if (config_.watchdog.enabled) {
+        watchdog_ = std::make_unique<StallWatchdog>(
+            config_,
+            *stage1_router_,
+            processors_,
+            stage1_to_processor_queues_
+        );
+        if (config_.watchdog.inject_processor >= 0) {
+            processors_[static_cast<size_t>(config_.watchdog.inject_processor)]->set_stall_injection(
+                config_.watchdog.inject_every_ms, config_.watchdog.inject_pause_us);
+        }
+    }
+}
+
+Pipeline::~Pipeline() {
+    stop();
+}
+
+template<typename Body>
+void Pipeline::spawn(const char* stage, Body body) {
+    threads_.emplace_back([this, stage, body]() {
+        if (perf_counters_) {
+            perf_counters_->attach_current_thread(stage);
+        }
+        body();
+    });
+}
+
+void Pipeline::start() {
+    // Запуск воспроизведения журнала
+    if (replayer_) {
+        spawn("producer", [this]() {
+            replayer_->run(producers_running_);
+        });
+    }
+
+    if (ring_) {
+        start_shared_ring();
+    } else if (fused_) {
+        start_fused();
+    } else if (config_.runtime.mode == RuntimeMode::Threads) {
+        start_threads();
+    } else {
+        start_coroutines();
+    }
+
+    // Запуск контроллера масштабирования
+    if (elastic_controller_) {
+        threads_.emplace_back([this]() {
+            elastic_controller_->run(running_);
+        });
+    }
+
+    // Запуск сторожа остановок
+    if (watchdog_) {
+        threads_.emplace_back([this]() {
+            watchdog_->run(running_);
+        });
+    }
+
+    // Запуск сэмплера очередей
+    if (queue_sampler_) {
+        threads_.emplace_back([this]() {
+            queue_sampler_->run(running_);
+        });
+    }
+
+    // Запуск потока журнала
+    if (journal_) {
+        journal_thread_ = std::thread([this]() {
+            journal_->run(journal_running_);
+        });
+    }
+}
+
+void Pipeline::start_threads() {
+    // Запуск производителей
+    for (auto& producer : producers_) {
+        spawn("producer", [this, &producer]() {
+            producer->run(producers_running_, config_.duration_secs);
+        });
+    }
+
+    // Запуск Stage1 Router
+    spawn("stage1", [this]() {
+        stage1_router_->run(running_);
+    });
+
+    // Запуск процессоров
+    for (auto& processor : processors_) {
+        spawn("processor", [this, &processor]() {
+            processor->run(running_);
+        });
+    }
+
+    // Запуск Stage2 Router
+    spawn("stage2", [this]() {
+        stage2_router_->run(running_);
+    });
+
+    // Запуск стратегий
+    for (auto& strategy : strategies_) {
+        spawn("strategy", [this, &strategy]() {
+            strategy->run(running_);
+        });
+    }
+}
+
+void Pipeline::start_shared_ring() {
+    for (size_t i = 0; i < ring_->producers(); ++i) {
+        spawn("producer", [this, i]() {
+            ring_->run_producer(i, producers_running_, config_.duration_secs);
+        });
+    }
+
+    spawn("stage1", [this]() {
+        ring_->run_stage1(running_);
+    });
+
+    for (size_t i = 0; i < ring_->processors(); ++i) {
+        spawn("processor", [this, i]() {
+            ring_->run_processor(i, running_);
+        });
+    }
+
+    spawn("stage2", [this]() {
+        ring_->run_stage2(running_);
+    });
+
+    for (size_t i = 0; i < ring_->strategies(); ++i) {
+        spawn("strategy", [this, i]() {
+            ring_->run_strategy(i, running_);
+        });
+    }
+}
+
+void Pipeline::start_fused() {
+    for (size_t i = 0; i < fused_->producers(); ++i) {
+        spawn("producer", [this, i]() {
+            fused_->run_producer(i, producers_running_, config_.duration_secs);
+        });
+    }
+
+    for (size_t i = 0; i < fused_->processors(); ++i) {
+        spawn("processor", [this, i]() {
+            fused_->run_processor(i, running_);
+        });
+    }
+
+    for (size_t i = 0; i < fused_->strategies(); ++i) {
+        spawn("strategy", [this, i]() {
+            fused_->run_strategy(i, running_);
+        });
+    }
+}
+
+void Pipeline::start_coroutines() {
+    for (uint32_t i = 0; i < config_.runtime.schedulers; ++i) {
+        int core = config_.runtime.pin ? static_cast<int>(config_.runtime.first_core + i) : -1;
+        schedulers_.push_back(std::make_unique<CoroScheduler>(i, core, config_.runtime.batch));
+    }
+
+    // Компоненты распределяются по планировщикам round-robin в порядке конвейера
+    size_t next_scheduler = 0;
+    auto pick_scheduler = [&]() -> CoroScheduler& {
+        return *schedulers_[next_scheduler++ % schedulers_.size()];
+    };
+
+    for (auto& producer : producers_) {
+        CoroScheduler& scheduler = pick_scheduler();
+        scheduler.spawn(producer->run_coro(scheduler, producers_running_, config_.duration_secs));
+    }
+    {
+        CoroScheduler& scheduler = pick_scheduler();
+        scheduler.spawn(stage1_router_->run_coro(scheduler, running_));
+    }
+    for (auto& processor : processors_) {
+        CoroScheduler& scheduler = pick_scheduler();
+        scheduler.spawn(processor->run_coro(scheduler, running_));
+    }
+    {
+        CoroScheduler& scheduler = pick_scheduler();
+        scheduler.spawn(stage2_router_->run_coro(scheduler, running_));
+    }
+    for (auto& strategy : strategies_) {
+        CoroScheduler& scheduler = pick_scheduler();
+        scheduler.spawn(strategy->run_coro(scheduler, running_));
+    }
+
+    // Планировщик исполняет компоненты разных стадий - счетчики общие на поток
+    for (auto& scheduler : schedulers_) {
+        spawn("scheduler", [this, &scheduler]() {
+            scheduler->run(running_);
+        });
+    }
+}
+
+void Pipeline::stop_producers() {
+    producers_running_.store(false, std::memory_order_release);
+}
+
+bool Pipeline::drained() {
+    if (shm_queues_) {
+        sync_shm_producers();
+    }
+
+    const StatsCounters totals = stats_.counters();
+    const uint64_t produced = totals[StatsField::Produced];
+    const uint64_t delivered = totals[StatsField::Delivered]
+                             + totals[StatsField::Rejected]
+                             + totals[StatsField::Shed];
+    if (produced != delivered) {
+        return false;
+    }
+
+    // Первый получатель группы мог опередить остальных
+    for (const auto& ring : multicast_rings_) {
+        if (!ring->empty()) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool Pipeline::drain(std::chrono::milliseconds timeout) {
+    const auto deadline = std::chrono::steady_clock::now() + timeout;
+    while (!drained()) {
+        if (std::chrono::steady_clock::now() >= deadline) {
+            return false;
+        }
+        std::this_thread::sleep_for(DRAIN_POLL_INTERVAL);
+    }
+    return true;
+}
+
+void Pipeline::stop() {
+    producers_running_.store(false, std::memory_order_release);
+    running_.store(false, std::memory_order_release);
+
+    for (auto& thread : threads_) {
+        if (thread.joinable()) {
+            thread.join();
+        }
+    }
+    threads_.clear();
+
+    journal_running_.store(false, std::memory_order_release);
+    if (journal_thread_.joinable()) {
+        journal_thread_.join();
+    }
+}
+
+void Pipeline::update_queue_depths() {
+    if (ring_) {
+        ring_->update_queue_depths();
+        return;
+    }
+    if (fused_) {
+        fused_->update_queue_depths();
+        return;
+    }
+    for (size_t i = 0; i < stage1_to_processor_queues_.size(); ++i) {
+        stats_.stage1_queue_depths[i]->store(
+            stage1_to_processor_queues_[i]->size(),
+            std::memory_order_relaxed
+        );
+    }
+    for (size_t i = 0; i < stage2_to_strategy_queues_.size(); ++i) {
+        stats_.stage2_queue_depths[i]->store(
+            stage2_to_strategy_queues_[i]->size(),
+            std::memory_order_relaxed
+        );
+    }
+}
+
+uint32_t Pipeline::sync_shm_producers() {
+    if (!shm_queues_) {
+        return 0;
+    }
+
+    const uint64_t timeout_ns = config_.shm.peer_timeout_ms * 1'000'000ULL;
+    uint32_t alive = 0;
+
+    for (uint32_t i = config_.producers.count; i < config_.total_producers(); ++i) {
+        uint64_t pushed = shm_queues_->peer(i).pushed.load(std::memory_order_relaxed);
+        if (pushed > shm_seen_pushed_[i]) {
+            stats_.count(StatsField::Produced, pushed - shm_seen_pushed_[i]);
+            stats_.dimensions.record_produced(static_cast<uint8_t>(i), pushed - shm_seen_pushed_[i]);
+            shm_seen_pushed_[i] = pushed;
+        }
+
+        if (shm_queues_->peer_alive(i, timeout_ns)) {
+            ++alive;
+        }
+    }
+    return alive;
+}
+
+size_t Pipeline::transport_bytes_per_message() const {
+    if (ring_) {
+        return RingPipeline::transport_bytes_per_message();
+    }
+    if (fused_) {
+        return FusedPipeline::transport_bytes_per_message();
+    }
+    // Четыре ребра, на каждом сообщение записывается в очередь и читается из нее
+    return 4 * 2 * sizeof(Message);
+}
+
+std::map<std::string, uint64_t> Pipeline::stage_messages() const {
+    const StatsCounters totals = stats_.counters();
+    const uint64_t produced = totals[StatsField::Produced];
+    const uint64_t processed = totals[StatsField::Processed];
+    const uint64_t delivered = totals[StatsField::Delivered];
+    return {
+        {"producer", produced},
+        {"stage1", produced},
+        {"processor", processed},
+        {"stage2", processed},
+        {"strategy", delivered},
+        {"scheduler", delivered}
+    };
+}
+
+void Pipeline::print_current_state() {
+    if (elastic_controller_) {
+        elastic_controller_->print_current_state();
+    }
+    if (watchdog_) {
+        watchdog_->print_current_state();
+    }
+    if (shm_queues_) {
+        uint32_t alive = sync_shm_producers();
+        std::cout << "        SHM producers: живых " << alive
+                  << "/" << config_.shm.external_producers << std::endl;
+    }
+}
+
+void Pipeline::print_batching_report() const {
+    std::cout << "Адаптивные пакеты (цель " << config_.batching.target_latency_us << " мкс, "
+              << config_.batching.min_batch << ".." << config_.batching.max_batch << "):" << std::endl;
+    AdaptiveBatch::print_header();
+
+    auto controllers_of = [](const std::vector<AdaptiveBatch>& batching) {
+        std::vector<const AdaptiveBatch*> controllers;
+        for (const AdaptiveBatch& batch : batching) {
+            controllers.push_back(&batch);
+        }
+        return controllers;
+    };
+    AdaptiveBatch::print_row("stage1", controllers_of(stage1_router_->batching()));
+    for (const auto& processor : processors_) {
+        AdaptiveBatch::print_row("processor " + std::to_string(processor->id()), {&processor->batching()});
+    }
+    AdaptiveBatch::print_row("stage2", controllers_of(stage2_router_->batching()));
+    std::cout << std::endl;
+}
+
+void Pipeline::print_reports(double duration_secs) const {
+    if (!config_.statistics.dimensions_output.empty()) {
+        stats_.dimensions.export_json(config_.statistics.dimensions_output, config_.scenario, duration_secs);
+    }
+    if (queue_arena_) {
+        std::cout << "Создание очередей: " << static_cast<double>(queue_setup_ns_) / 1e6 << " мс" << std::endl;
+        queue_arena_->print_report();
+    }
+    if (ring_) {
+        ring_->print_report();
+    }
+    if (fused_) {
+        fused_->print_report();
+    }
+    if (admission_) {
+        admission_->print_report();
+    }
+    if (config_.batching.enabled) {
+        print_batching_report();
+    }
+    if (elastic_controller_) {
+        elastic_controller_->print_report();
+    }
+    if (watchdog_) {
+        watchdog_->print_report();
+    }
+    if (journal_) {
+        journal_->print_report(duration_secs);
+    }
+    if (!schedulers_.empty()) {
+        std::cout << "Кооперативные планировщики:" << std::endl;
+        for (const auto& scheduler : schedulers_) {
+            scheduler->print_report();
+        }
+        std::cout << std::endl;
+    }
+    if (queue_sampler_) {
+        queue_sampler_->export_series();
+        queue_sampler_->print_report();
+    }
+    if (perf_counters_) {
+        perf_counters_->print_report(
+            {"producer", "stage1", "processor", "stage2", "strategy", "scheduler"},
+            stage_messages()
+        );
+    }
+    if (replayer_) {
+        std::cout << "Воспроизведено из журнала: " << replayer_->messages_replayed()
+                  << " сообщений (" << config_.replay.directory << ")" << std::endl << std::endl;
+    }
+}
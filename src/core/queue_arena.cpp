@@ -0,0 +1,219 @@
+#include "queue_arena.hpp"
+#include "cpu_affinity.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <stdexcept>
+#include <thread>
+#include <sys/mman.h>
+#include <unistd.h>
+
+namespace {
+
+size_t page_size() {
+    return static_cast<size_t>(sysconf(_SC_PAGESIZE));
+}
+
+double to_mb(size_t bytes) {
+    return static_cast<double>(bytes) / (1024.0 * 1024.0);
+}
+
+/**
+ * Выделение страниц диапазона записью: MADV_POPULATE_WRITE (Linux 5.14+),
+ * иначе чтение-запись байта каждой страницы (содержимое и индексы очереди сохраняются)
+ */
+void populate(uint8_t* begin, size_t length) {
+#ifdef MADV_POPULATE_WRITE
+    if (madvise(begin, length, MADV_POPULATE_WRITE) == 0) {
+        return;
+    }
+#endif
+    const size_t page = page_size();
+    for (size_t offset = 0; offset < length; offset += page) {
+        volatile uint8_t* byte = begin + offset;
+        *byte = *byte;
+    }
+}
+
+} // namespace
+
+const char* queue_backing_name(QueueBacking backing) {
+    switch (backing) {
+        case QueueBacking::Heap:    return "heap";
+        case QueueBacking::Mmap:    return "mmap";
+        case QueueBacking::Thp:     return "thp";
+        case QueueBacking::HugeTlb: return "hugetlb";
+    }
+    return "unknown";
+}
+
+QueueBacking queue_backing_from_name(const std::string& name) {
+    for (QueueBacking backing : {QueueBacking::Heap, QueueBacking::Mmap, QueueBacking::Thp, QueueBacking::HugeTlb}) {
+        if (name == queue_backing_name(backing)) {
+            return backing;
+        }
+    }
+    throw std::runtime_error("Неизвестное размещение queue_memory.backing: " + name);
+}
+
+size_t resident_set_bytes() {
+    std::ifstream statm("/proc/self/statm");
+    size_t total_pages = 0;
+    size_t resident_pages = 0;
+    if (!(statm >> total_pages >> resident_pages)) {
+        return 0;
+    }
+    return resident_pages * page_size();
+}
+
+QueueArena::QueueArena(QueueBacking requested, QueueBacking backing, void* base, size_t size)
+    : requested_(requested)
+    , backing_(backing)
+    , base_(static_cast<uint8_t*>(base))
+    , size_(size)
+{
+}
+
+QueueArena::~QueueArena() {
+    munmap(base_, size_);
+}
+
+std::shared_ptr<QueueArena> QueueArena::create(QueueBacking backing, size_t bytes) {
+    const size_t size = footprint(std::max<size_t>(bytes, 1));
+    const int flags = MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE;
+
+    const QueueBacking requested = backing;
+    if (backing == QueueBacking::HugeTlb) {
+        // Без MAP_NORESERVE: huge pages резервируются из пула сразу, иначе при пустом
+        // пуле mmap успешен, а первая запись завершается SIGBUS
+        void* base = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        if (base != MAP_FAILED) {
+            return std::shared_ptr<QueueArena>(new QueueArena(requested, backing, base, size));
+        }
+        std::cerr << "Предупреждение: MAP_HUGETLB недоступен (" << std::strerror(errno)
+                  << "), очереди размещаются в transparent huge pages" << std::endl;
+        backing = QueueBacking::Thp;
+    }
+
+    // Резерв с запасом: начало арены выравнивается по huge page, излишки возвращаются
+    const size_t reserve = size + HUGE_PAGE_SIZE;
+    void* raw = mmap(nullptr, reserve, PROT_READ | PROT_WRITE, flags, -1, 0);
+    if (raw == MAP_FAILED) {
+        throw std::runtime_error(std::string("Не удалось зарезервировать арену очередей: ") + std::strerror(errno));
+    }
+    const uintptr_t start = reinterpret_cast<uintptr_t>(raw);
+    const uintptr_t aligned = (start + HUGE_PAGE_SIZE - 1) & ~(HUGE_PAGE_SIZE - 1);
+    const size_t head = aligned - start;
+    if (head > 0) {
+        munmap(raw, head);
+    }
+    if (reserve - head - size > 0) {
+        munmap(reinterpret_cast<void*>(aligned + size), reserve - head - size);
+    }
+
+    // Политика THP выставляется явно: mmap не получает huge pages и при THP "always"
+    void* base = reinterpret_cast<void*>(aligned);
+    madvise(base, size, backing == QueueBacking::Thp ? MADV_HUGEPAGE : MADV_NOHUGEPAGE);
+
+    return std::shared_ptr<QueueArena>(new QueueArena(requested, backing, base, size));
+}
+
+void* QueueArena::allocate(size_t bytes, int consumer_core) {
+    const size_t block = footprint(bytes);
+    if (used_ + block > size_) {
+        throw std::runtime_error("Арена очередей исчерпана: требуется " + std::to_string(used_ + block)
+                                 + " байт из " + std::to_string(size_));
+    }
+    blocks_.push_back({used_, bytes, consumer_core});
+    void* address = base_ + used_;
+    used_ += block;
+    return address;
+}
+
+void QueueArena::prefault() {
+    const auto start = std::chrono::steady_clock::now();
+    const size_t page = page_size();
+
+    std::vector<std::thread> workers;
+    workers.reserve(blocks_.size());
+    for (const Block& block : blocks_) {
+        workers.emplace_back([this, block, page]() {
+            if (block.core >= 0) {
+                pin_current_thread(static_cast<uint32_t>(block.core));
+            }
+            populate(base_ + block.offset, (block.bytes + page - 1) / page * page);
+        });
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+
+    prefault_ns_ = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - start).count());
+    prefaulted_ = true;
+}
+
+size_t QueueArena::resident_bytes() const {
+    const size_t page = page_size();
+    std::vector<unsigned char> pages((size_ + page - 1) / page);
+    if (mincore(base_, size_, pages.data()) != 0) {
+        return 0;
+    }
+    const size_t resident = static_cast<size_t>(std::count_if(pages.begin(), pages.end(),
+                                                              [](unsigned char p) { return (p & 1) != 0; }));
+    return resident * page;
+}
+
+size_t QueueArena::huge_page_bytes() const {
+    std::ifstream smaps("/proc/self/smaps");
+    const uintptr_t low = reinterpret_cast<uintptr_t>(base_);
+    const uintptr_t high = low + size_;
+
+    std::string line;
+    bool inside = false;
+    size_t kb_total = 0;
+    while (std::getline(smaps, line)) {
+        unsigned long start = 0;
+        unsigned long end = 0;
+        // Заголовок области: "начало-конец права ..."; строки полей ("Имя:  N kB") не разбираются как диапазон
+        if (std::sscanf(line.c_str(), "%lx-%lx ", &start, &end) == 2) {
+            inside = start < high && end > low;
+            continue;
+        }
+        if (!inside) {
+            continue;
+        }
+        size_t kb = 0;
+        if (std::sscanf(line.c_str(), "AnonHugePages: %zu kB", &kb) == 1
+            || std::sscanf(line.c_str(), "Private_Hugetlb: %zu kB", &kb) == 1) {
+            kb_total += kb;
+        }
+    }
+    return kb_total * 1024;
+}
+
+void QueueArena::print_report() const {
+    std::cout << "Память очередей (queue_memory):" << std::endl;
+    std::cout << "  Размещение:           " << queue_backing_name(backing_);
+    if (requested_ != backing_) {
+        std::cout << " (запрошено " << queue_backing_name(requested_) << ")";
+    }
+    std::cout << std::endl;
+
+    std::cout << std::fixed << std::setprecision(1);
+    std::cout << "  Резерв / блоков:      " << to_mb(size_) << " МБ / " << blocks_.size() << std::endl;
+    std::cout << "  Резидентно:           " << to_mb(resident_bytes()) << " МБ (huge pages "
+              << to_mb(huge_page_bytes()) << " МБ)" << std::endl;
+    if (prefaulted_) {
+        std::cout << "  Prefault:             " << std::setprecision(2)
+                  << static_cast<double>(prefault_ns_) / 1e6 << " мс" << std::endl;
+    } else {
+        std::cout << "  Prefault:             нет (страницы по первой записи)" << std::endl;
+    }
+    std::cout << std::defaultfloat << std::endl;
+}
@@ -0,0 +1,268 @@
+#include "ring_pipeline.hpp"
+#include "timer.hpp"
+#include "flight_recorder.hpp"
+#include <iostream>
+#include <string>
+
+RingPipeline::RingPipeline(const SystemConfig& config, SystemStatistics& stats)
+    : stats_(stats)
+    , stage1_cursors_(config.producers.count, 0)
+    , routes_(config.stage1_rules, config.stage2_rules, config.processors.count, config.strategies.count,
+              compile_key_routes(config.stage1_key_rules, config.processors.count),
+              compile_key_routes(config.stage2_key_rules, config.strategies.count))
+    , processor_work_(config.processors.processing_times_ns, 100)
+    , strategy_times_ns_(config.strategies.count, 100) // По умолчанию
+    , max_batch_(config.strategies.max_batch)
+{
+    // Общие кольца: по одному на производителя
+    for (size_t i = 0; i < config.producers.count; ++i) {
+        rings_.push_back(std::make_shared<Ring>());
+        producers_.push_back(std::make_unique<Producer>(
+            static_cast<uint8_t>(i),
+            config.producers,
+            nullptr,
+            stats_
+        ));
+    }
+
+    // Очереди ссылок Stage1 -> процессоры -> Stage2 -> стратегии
+    for (size_t i = 0; i < config.processors.count; ++i) {
+        processor_inputs_.push_back(std::make_shared<RefQueue>());
+        processor_outputs_.push_back(std::make_shared<RefQueue>());
+    }
+    for (size_t i = 0; i < config.strategies.count; ++i) {
+        strategy_inputs_.push_back(std::make_shared<RefQueue>());
+    }
+
+    for (const auto& [id, ns] : config.strategies.processing_times_ns) {
+        if (id < strategy_times_ns_.size()) {
+            strategy_times_ns_[id] = ns;
+        }
+    }
+}
+
+void RingPipeline::push_ref(RefQueue& queue, SlotRef ref, [[maybe_unused]] uint16_t lane) {
+    if (!queue.try_push(ref)) {
+        FR_EVENT(PushRetryBegin, lane, 0);
+        do {
+            // Если очередь полная, активно ждем
+            __builtin_ia32_pause();
+        } while (!queue.try_push(ref));
+        FR_EVENT(PushRetryEnd, lane, 0);
+    }
+}
+
+void RingPipeline::run_producer(size_t index, std::atomic<bool>& running, uint32_t duration_secs) {
+    Ring& ring = *rings_[index];
+    producers_[index]->run_with(running, duration_secs, [&ring](const Message& msg) {
+        return ring.try_publish(msg);
+    });
+}
+
+void RingPipeline::run_stage1(std::atomic<bool>& running) {
+    FR_THREAD("stage1", 0);
+    bool idle = false;
+
+    while (running.load(std::memory_order_relaxed)) {
+        bool processed_any = false;
+
+        // Барьер Stage1: по одному опубликованному слоту из каждого кольца
+        for (size_t r = 0; r < rings_.size(); ++r) {
+            const uint64_t sequence = stage1_cursors_[r];
+            if (sequence == rings_[r]->published()) {
+                continue;
+            }
+
+            Message& msg = rings_[r]->slot(sequence);
+            msg.stage1_entry_ns = Message::get_timestamp_ns();
+            FR_EVENT(Pop, r, 1);
+
+            const uint8_t processor_id = routes_.select_processor(msg);
+            FR_EVENT(Route, processor_id, msg.msg_type);
+
+            // Поля слота записываются до передачи ссылки: дальше слот принадлежит процессору
+            msg.stage1_exit_ns = Message::get_timestamp_ns();
+            push_ref(*processor_inputs_[processor_id], SlotRef::make(static_cast<uint8_t>(r), sequence),
+                     processor_id);
+            stage1_cursors_[r] = sequence + 1;
+            processed_any = true;
+        }
+
+        if (!processed_any) {
+            if (!idle) {
+                FR_EVENT(Idle, 0, 0);
+                idle = true;
+            }
+            __builtin_ia32_pause();
+        } else {
+            idle = false;
+        }
+    }
+}
+
+void RingPipeline::run_processor(size_t index, std::atomic<bool>& running) {
+    FR_THREAD("processor", index);
+    RefQueue& input = *processor_inputs_[index];
+    RefQueue& output = *processor_outputs_[index];
+    const uint8_t id = static_cast<uint8_t>(index);
+    bool idle = false;
+
+    while (running.load(std::memory_order_relaxed)) {
+        SlotRef ref;
+        if (!input.try_pop(ref)) {
+            if (!idle) {
+                FR_EVENT(Idle, index, 0);
+                idle = true;
+            }
+            __builtin_ia32_pause();
+            continue;
+        }
+        idle = false;
+        FR_EVENT(Pop, index, 1);
+
+        // Обработка прямо в слоте кольца
+        Ring& ring = *rings_[ref.ring()];
+        Message& msg = ring.slot(ref.sequence());
+        msg.processing_entry_ns = Message::get_timestamp_ns();
+        msg.processor_id = id;
+
+        if (!invoke_handler(processor_work_, msg)) {
+            // Отклоненное сообщение дальше не идет - слот освобождается здесь
+            stats_.count(StatsField::Rejected, 1);
+            ring.complete(ref.sequence());
+            continue;
+        }
+
+        const uint64_t exit_ns = Message::get_timestamp_ns();
+        msg.processing_exit_ns = exit_ns;
+        msg.processing_ts_ns = exit_ns;
+
+        push_ref(output, ref, static_cast<uint16_t>(index));
+        stats_.count(StatsField::Processed, 1);
+    }
+}
+
+void RingPipeline::run_stage2(std::atomic<bool>& running) {
+    FR_THREAD("stage2", 0);
+    bool idle = false;
+
+    while (running.load(std::memory_order_relaxed)) {
+        bool processed_any = false;
+
+        for (size_t q = 0; q < processor_outputs_.size(); ++q) {
+            SlotRef ref;
+            if (processor_outputs_[q]->try_pop(ref)) {
+                FR_EVENT(Pop, q, 1);
+                Message& msg = rings_[ref.ring()]->slot(ref.sequence());
+                msg.stage2_entry_ns = Message::get_timestamp_ns();
+                const uint8_t strategy_id = routes_.select_strategy(msg);
+                FR_EVENT(Route, strategy_id, msg.msg_type);
+
+                msg.stage2_exit_ns = Message::get_timestamp_ns();
+                push_ref(*strategy_inputs_[strategy_id], ref, strategy_id);
+                processed_any = true;
+            }
+        }
+
+        if (!processed_any) {
+            if (!idle) {
+                FR_EVENT(Idle, 0, 0);
+                idle = true;
+            }
+            __builtin_ia32_pause();
+        } else {
+            idle = false;
+        }
+    }
+}
+
+void RingPipeline::run_strategy(size_t index, std::atomic<bool>& running) {
+    FR_THREAD("strategy", index);
+    RefQueue& input = *strategy_inputs_[index];
+    const uint64_t processing_time_ns = strategy_times_ns_[index];
+    const uint8_t id = static_cast<uint8_t>(index);
+
+    // Указатели на слоты пакета: учет порядка ведется без копирования сообщений
+    std::vector<const Message*> batch(max_batch_);
+    bool idle = false;
+
+    while (running.load(std::memory_order_relaxed)) {
+        std::span<SlotRef> refs = input.peek(max_batch_);
+        if (refs.empty()) {
+            if (!idle) {
+                FR_EVENT(Idle, index, 0);
+                idle = true;
+            }
+            __builtin_ia32_pause();
+            continue;
+        }
+        idle = false;
+        FR_EVENT(Pop, index, refs.size());
+
+        // Сообщения пакета получены одновременно
+        const uint64_t entry_ns = Message::get_timestamp_ns();
+        for (size_t i = 0; i < refs.size(); ++i) {
+            Message& msg = rings_[refs[i].ring()]->slot(refs[i].sequence());
+            msg.strategy_entry_ns = entry_ns;
+            batch[i] = &msg;
+        }
+
+        // Имитация времени обработки за весь пакет (как Strategy::on_batch)
+        if (processing_time_ns > 0) {
+            Timer::busy_wait_ns(processing_time_ns * refs.size());
+        }
+
+        for (size_t i = 0; i < refs.size(); ++i) {
+            const Message& msg = *batch[i];
+            if (journal_) {
+                journal_->append(msg, id);
+            }
+            stats_.record_message_latencies(msg);
+            FR_CHECK_LATENCY(msg.strategy_entry_ns - msg.timestamp_ns);
+        }
+        const std::span<const Message* const> delivered(batch.data(), refs.size());
+        stats_.track_batch_order(delivered);
+        stats_.dimensions.record_delivered(delivered);
+        stats_.count(StatsField::Delivered, refs.size());
+
+        // Слоты больше не нужны - производитель может их переиспользовать
+        for (const SlotRef& ref : refs) {
+            rings_[ref.ring()]->complete(ref.sequence());
+        }
+        input.release(refs.size());
+    }
+}
+
+void RingPipeline::add_sampler_edges(QueueSampler& sampler) const {
+    for (size_t i = 0; i < rings_.size(); ++i) {
+        sampler.add_edge("prod" + std::to_string(i) + "->ring", rings_[i]);
+    }
+    for (size_t i = 0; i < processor_inputs_.size(); ++i) {
+        sampler.add_edge("stage1->proc" + std::to_string(i), processor_inputs_[i]);
+    }
+    for (size_t i = 0; i < processor_outputs_.size(); ++i) {
+        sampler.add_edge("proc" + std::to_string(i) + "->stage2", processor_outputs_[i]);
+    }
+    for (size_t i = 0; i < strategy_inputs_.size(); ++i) {
+        sampler.add_edge("stage2->strat" + std::to_string(i), strategy_inputs_[i]);
+    }
+}
+
+void RingPipeline::update_queue_depths() {
+    for (size_t i = 0; i < processor_inputs_.size(); ++i) {
+        stats_.stage1_queue_depths[i]->store(processor_inputs_[i]->size(), std::memory_order_relaxed);
+    }
+    for (size_t i = 0; i < strategy_inputs_.size(); ++i) {
+        stats_.stage2_queue_depths[i]->store(strategy_inputs_[i]->size(), std::memory_order_relaxed);
+    }
+}
+
+void RingPipeline::print_report() const {
+    std::cout << "Общие кольца (shared_ring, " << SHARED_RING_SIZE << " слотов, "
+              << transport_bytes_per_message() << " байт транспорта на сообщение):" << std::endl;
+    for (size_t i = 0; i < rings_.size(); ++i) {
+        std::cout << "  prod" << i << ": макс. занято " << rings_[i]->high_watermark()
+                  << ", переполнений " << rings_[i]->full_events() << std::endl;
+    }
+    std::cout << std::endl;
+}
@@ -0,0 +1,121 @@
+#include "shm_region.hpp"
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+std::runtime_error shm_error(const std::string& what, const std::string& name) {
+    return std::runtime_error(what + " (" + name + "): " + std::strerror(errno));
+}
+
+void* map_fd(int fd, size_t size, const std::string& name) {
+    void* data = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) {
+        throw shm_error("Не удалось отобразить разделяемую память", name);
+    }
+    return data;
+}
+
+/**
+ * pid владельца существующей области (0, если область меньше заголовка)
+ */
+int32_t read_owner_pid(const std::string& name, size_t offset) {
+    int fd = shm_open(name.c_str(), O_RDONLY, 0600);
+    if (fd < 0) {
+        throw shm_error("Не удалось открыть существующую разделяемую память", name);
+    }
+
+    int32_t pid = 0;
+    struct stat st;
+    if (fstat(fd, &st) == 0 && static_cast<size_t>(st.st_size) >= offset + sizeof(pid) &&
+        pread(fd, &pid, sizeof(pid), static_cast<off_t>(offset)) != static_cast<ssize_t>(sizeof(pid))) {
+        pid = 0;
+    }
+    close(fd);
+    return pid;
+}
+
+} // namespace
+
+ShmRegion::ShmRegion(std::string name, void* data, size_t size, bool owner)
+    : name_(std::move(name)), data_(data), size_(size), owner_(owner) {}
+
+ShmRegion::~ShmRegion() {
+    munmap(data_, size_);
+    if (owner_ && !name_.empty()) {
+        shm_unlink(name_.c_str());
+    }
+}
+
+std::shared_ptr<ShmRegion> ShmRegion::create(const std::string& name, size_t size,
+                                             size_t owner_pid_offset) {
+    int fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+
+    // Имя осталось от упавшего создателя: удаляем его, если владелец мертв
+    if (fd < 0 && errno == EEXIST && owner_pid_offset != NO_OWNER_PID) {
+        const int32_t pid = read_owner_pid(name, owner_pid_offset);
+        if (pid <= 0 || kill(pid, 0) == 0 || errno != ESRCH) {
+            throw std::runtime_error("Разделяемая память (" + name + ") уже используется процессом " +
+                                     (pid > 0 ? std::to_string(pid) : std::string("с неизвестным pid")));
+        }
+        shm_unlink(name.c_str());
+        fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+    }
+    if (fd < 0) {
+        throw shm_error("Не удалось создать разделяемую память", name);
+    }
+
+    if (ftruncate(fd, static_cast<off_t>(size)) != 0) {
+        close(fd);
+        shm_unlink(name.c_str());
+        throw shm_error("Не удалось задать размер разделяемой памяти", name);
+    }
+
+    void* data = nullptr;
+    try {
+        data = map_fd(fd, size, name);
+    } catch (...) {
+        shm_unlink(name.c_str());
+        throw;
+    }
+    return std::shared_ptr<ShmRegion>(new ShmRegion(name, data, size, true));
+}
+
+std::shared_ptr<ShmRegion> ShmRegion::create_anonymous(size_t size) {
+    int fd = memfd_create("router_shm", MFD_CLOEXEC);
+    if (fd < 0) {
+        throw shm_error("Не удалось создать memfd", "memfd");
+    }
+
+    if (ftruncate(fd, static_cast<off_t>(size)) != 0) {
+        close(fd);
+        throw shm_error("Не удалось задать размер memfd", "memfd");
+    }
+
+    void* data = map_fd(fd, size, "memfd");
+    return std::shared_ptr<ShmRegion>(new ShmRegion("", data, size, true));
+}
+
+std::shared_ptr<ShmRegion> ShmRegion::attach(const std::string& name) {
+    int fd = shm_open(name.c_str(), O_RDWR, 0600);
+    if (fd < 0) {
+        throw shm_error("Не удалось открыть разделяемую память", name);
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        close(fd);
+        throw shm_error("Не удалось получить размер разделяемой памяти", name);
+    }
+
+    size_t size = static_cast<size_t>(st.st_size);
+    void* data = map_fd(fd, size, name);
+    return std::shared_ptr<ShmRegion>(new ShmRegion(name, data, size, false));
+}
@@ -12,9 +12,16 @@ std::string format_number(uint64_t num) {
 }
 
 void SystemStatistics::print_current_stats(double elapsed_secs) const {
-    uint64_t produced = messages_produced.load(std::memory_order_relaxed);
-    uint64_t processed = messages_processed.load(std::memory_order_relaxed);
-    uint64_t delivered = messages_delivered.load(std::memory_order_relaxed);
+    // Один снимок блоков на всю строку: счетчики, скорости и задержки согласованы
+    const StatsCounters current = counters();
+    const StatsCounters delta = current.since(last_interval_);
+    const double period = elapsed_secs - last_elapsed_;
+    last_interval_ = current;
+    last_elapsed_ = elapsed_secs;
+
+    uint64_t produced = current[StatsField::Produced];
+    uint64_t processed = current[StatsField::Processed];
+    uint64_t delivered = current[StatsField::Delivered];
     uint64_t lost = messages_lost.load(std::memory_order_relaxed);
 
     // Преобразование в миллионы
@@ -28,6 +35,21 @@ void SystemStatistics::print_current_stats(double elapsed_secs) const {
               << "Доставлено: " << del_m << "M | "
               << "Потеряно: " << lost << std::endl;
 
+    // Точные приращения с прошлого снимка
+    if (period > 0.0) {
+        auto rate = [period](uint64_t count) { return static_cast<double>(count) / period / 1e6; };
+        std::cout << "        За период (M/s) - произведено: " << rate(delta[StatsField::Produced])
+                  << " | обработано: " << rate(delta[StatsField::Processed])
+                  << " | доставлено: " << rate(delta[StatsField::Delivered]);
+        if (delta[StatsField::Rejected] > 0) {
+            std::cout << " | отклонено: " << rate(delta[StatsField::Rejected]);
+        }
+        if (delta[StatsField::Shed] > 0) {
+            std::cout << " | сброшено: " << rate(delta[StatsField::Shed]);
+        }
+        std::cout << std::endl;
+    }
+
     // Глубины очередей Stage1
     std::cout << "        Stage1 Queues: [";
     for (size_t i = 0; i < stage1_queue_depths.size(); ++i) {
@@ -44,17 +66,17 @@ void SystemStatistics::print_current_stats(double elapsed_secs) const {
     }
     std::cout << "]" << std::endl;
 
-    // Задержки (если есть данные)
-    {
-        std::lock_guard<std::mutex> lock(latency_mutex);
-        if (!total_latencies.latencies.empty()) {
-            std::cout << "        Задержки(μs) - "
-                      << "Stage1: " << std::setprecision(2) << stage1_latencies.p50() << " | "
-                      << "Processing: " << processing_latencies.p50() << " | "
-                      << "Stage2: " << stage2_latencies.p50() << " | "
-                      << "Total: " << total_latencies.p50() << std::endl;
-        }
+    // Средние задержки выборки за период (суммы из блоков, без latency_mutex)
+    if (delta[StatsField::LatencySamples] > 0) {
+        std::cout << "        Задержки(μs, среднее за период) - "
+                  << "Stage1: " << std::setprecision(2) << delta.mean_us(StatsField::Stage1Ns) << " | "
+                  << "Processing: " << delta.mean_us(StatsField::ProcessingNs) << " | "
+                  << "Stage2: " << delta.mean_us(StatsField::Stage2Ns) << " | "
+                  << "Total: " << delta.mean_us(StatsField::TotalNs) << std::endl;
     }
+
+    // Пропускная способность и p99 за период по типам и производителям
+    dimensions.print_interval(elapsed_secs);
 }
 
 void SystemStatistics::print_final_report(const std::string& scenario, double duration_secs) const {
@@ -65,9 +87,10 @@ void SystemStatistics::print_final_report(const std::string& scenario, double du
     std::cout << std::endl;
 
     // Статистика сообщений
-    uint64_t produced = messages_produced.load(std::memory_order_relaxed);
-    uint64_t processed = messages_processed.load(std::memory_order_relaxed);
-    uint64_t delivered = messages_delivered.load(std::memory_order_relaxed);
+    const StatsCounters totals = counters();
+    uint64_t produced = totals[StatsField::Produced];
+    uint64_t processed = totals[StatsField::Processed];
+    uint64_t delivered = totals[StatsField::Delivered];
     uint64_t lost = messages_lost.load(std::memory_order_relaxed);
 
     std::cout << "Статистика сообщений:" << std::endl;
@@ -75,6 +98,18 @@ void SystemStatistics::print_final_report(const std::string& scenario, double du
     std::cout << "  Всего обработано:   " << std::setw(15) << format_number(processed) << std::endl;
     std::cout << "  Всего доставлено:   " << std::setw(15) << format_number(delivered) << std::endl;
     std::cout << "  Потеряно:           " << std::setw(15) << format_number(lost) << std::endl;
+    uint64_t rejected = totals[StatsField::Rejected];
+    if (rejected > 0) {
+        std::cout << "  Отклонено:          " << std::setw(15) << format_number(rejected) << std::endl;
+    }
+    uint64_t shed = totals[StatsField::Shed];
+    if (shed > 0) {
+        std::cout << "  Сброшено допуском:  " << std::setw(15) << format_number(shed) << std::endl;
+    }
+    uint64_t multicast = totals[StatsField::Multicast];
+    if (multicast > 0) {
+        std::cout << "  Multicast-доставок: " << std::setw(15) << format_number(multicast) << std::endl;
+    }
     std::cout << std::endl;
 
     // Пропускная способность
@@ -104,11 +139,17 @@ void SystemStatistics::print_final_report(const std::string& scenario, double du
             print_latency_row("Stage1", stage1_latencies);
             print_latency_row("Process", processing_latencies);
             print_latency_row("Stage2", stage2_latencies);
+            print_latency_row("Deliver", delivery_latencies);
             print_latency_row("Total", total_latencies);
             std::cout << std::endl;
+
+            print_latency_breakdown();
         }
     }
 
+    // Разбивка по типам сообщений и производителям
+    dimensions.print_report(duration_secs);
+
     // Проверка порядка
     std::cout << "Проверка порядка сообщений:" << std::endl;
     for (size_t i = 0; i < producer_order_trackers.size(); ++i) {
@@ -127,8 +168,68 @@ void SystemStatistics::print_final_report(const std::string& scenario, double du
     }
     std::cout << std::endl;
 
+    std::cout << "Снимки статистики: блоков потоков " << workers.blocks()
+              << ", повторов чтения seqlock " << workers.read_retries() << std::endl;
+    std::cout << std::endl;
+
     // Результат теста
     bool passed = validate();
     std::cout << "Результат теста: " << (passed ? "PASSED ✓" : "FAILED ✗") << std::endl;
     std::cout << std::endl;
 }
+
+void SystemStatistics::print_latency_breakdown() const {
+    struct Segment {
+        const char* name;
+        const LatencyStats& stats;
+        bool queue;
+    };
+    const Segment segments[] = {
+        {"Q prod->S1",  producer_queue_dwell,  true},
+        {"Stage1",      stage1_latencies,      false},
+        {"Q S1->proc",  processor_queue_dwell, true},
+        {"Process",     processing_latencies,  false},
+        {"Q proc->S2",  stage2_queue_dwell,    true},
+        {"Stage2",      stage2_latencies,      false},
+        {"Q S2->strat", delivery_latencies,    true},
+    };
+
+    double mean_sum = 0.0;
+    for (const auto& segment : segments) {
+        mean_sum += segment.stats.mean();
+    }
+
+    std::cout << "Разбивка задержки до стратегии по участкам (микросекунды):" << std::endl;
+    std::cout << "  Участок         среднее       p50       p99     p99.9    доля" << std::endl;
+
+    const Segment* worst_queue = nullptr;
+    for (const auto& segment : segments) {
+        const double share = mean_sum > 0.0 ? segment.stats.mean() / mean_sum * 100.0 : 0.0;
+        std::cout << "  " << std::setw(12) << std::left << segment.name
+                  << std::right << std::fixed << std::setprecision(2)
+                  << std::setw(11) << segment.stats.mean()
+                  << std::setw(10) << segment.stats.p50()
+                  << std::setw(10) << segment.stats.p99()
+                  << std::setw(10) << segment.stats.p999()
+                  << std::setw(7) << std::setprecision(1) << share << "%"
+                  << std::endl;
+
+        if (segment.queue && (!worst_queue || segment.stats.p99() > worst_queue->stats.p99())) {
+            worst_queue = &segment;
+        }
+    }
+
+    std::cout << "  " << std::setw(12) << std::left << "Total" << std::right
+              << std::setprecision(2)
+              << std::setw(11) << delivered_latencies.mean()
+              << std::setw(10) << delivered_latencies.p50()
+              << std::setw(10) << delivered_latencies.p99()
+              << std::setw(10) << delivered_latencies.p999()
+              << std::endl;
+
+    if (worst_queue && worst_queue->stats.p99() > 0.0) {
+        std::cout << "  Наибольшее ожидание p99 в очереди: " << worst_queue->name
+                  << " (" << worst_queue->stats.p99() << " мкс)" << std::endl;
+    }
+    std::cout << std::endl;
+}
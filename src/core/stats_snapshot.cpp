@@ -0,0 +1,38 @@
+#include "stats_snapshot.hpp"
+
+namespace {
+
+std::atomic<uint64_t> next_stats_blocks_id{1};
+
+} // namespace
+
+StatsBlocks::StatsBlocks()
+    : id_(next_stats_blocks_id.fetch_add(1, std::memory_order_relaxed))
+{
+}
+
+StatsBlock* StatsBlocks::add_block() {
+    std::lock_guard<std::mutex> lock(blocks_mutex_);
+    blocks_.push_back(std::make_unique<StatsBlock>());
+    return blocks_.back().get();
+}
+
+StatsCounters StatsBlocks::snapshot() const {
+    StatsCounters total;
+    uint64_t retries = 0;
+    std::lock_guard<std::mutex> lock(blocks_mutex_);
+    for (const auto& block : blocks_) {
+        StatsCounters counters;
+        retries += block->read(counters);
+        total.add(counters);
+    }
+    if (retries > 0) {
+        retries_.fetch_add(retries, std::memory_order_relaxed);
+    }
+    return total;
+}
+
+size_t StatsBlocks::blocks() const {
+    std::lock_guard<std::mutex> lock(blocks_mutex_);
+    return blocks_.size();
+}
@@ -0,0 +1,482 @@
+#include "topology_tuner.hpp"
+#include "cpu_affinity.hpp"
+#include "pipeline.hpp"
+#include "statistics.hpp"
+#include <nlohmann/json.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <numeric>
+#include <optional>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+
+using json = nlohmann::json;
+
+// Время по умолчанию для типов и стратегий без записи в конфигурации (как у Processor и Strategy)
+constexpr uint64_t TUNE_DEFAULT_PROCESSING_NS = 100;
+
+// Доля цели по пропускной способности, которую проба может недобрать и считаться успешной
+constexpr double TUNE_RATE_TOLERANCE = 0.02;
+
+// Окон пробы до первой проверки досрочной остановки
+constexpr uint32_t TUNE_MIN_WINDOWS = 3;
+
+// Наибольшее число процессоров, которое пропускает SystemConfig::validate
+constexpr uint32_t TUNE_MAX_PROCESSORS = 16;
+
+// Прирост пропускной способности, ниже которого шаг числа процессоров считается без улучшения
+constexpr double TUNE_PLATEAU_GAIN = 0.03;
+
+namespace {
+
+std::string format_rate(double per_second) {
+    std::ostringstream out;
+    out << std::fixed;
+    if (per_second >= 1e6) {
+        out << std::setprecision(2) << per_second / 1e6 << "M";
+    } else if (per_second >= 1e3) {
+        out << std::setprecision(1) << per_second / 1e3 << "k";
+    } else {
+        out << std::setprecision(0) << per_second;
+    }
+    return out.str();
+}
+
+uint64_t time_or_default(const std::unordered_map<uint8_t, uint64_t>& times, uint8_t id) {
+    auto it = times.find(id);
+    return it != times.end() ? it->second : TUNE_DEFAULT_PROCESSING_NS;
+}
+
+/**
+ * Индексы по возрастанию нагрузки (при равенстве - меньший номер)
+ */
+std::vector<uint32_t> least_loaded(const std::vector<double>& loads) {
+    std::vector<uint32_t> order(loads.size());
+    std::iota(order.begin(), order.end(), 0u);
+    std::stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) { return loads[a] < loads[b]; });
+    return order;
+}
+
+} // namespace
+
+TopologyTuner::TopologyTuner(const std::string& config_file, const TuneOptions& options)
+    : options_(options)
+{
+    std::ifstream file(config_file);
+    if (!file.is_open()) {
+        throw std::runtime_error("Не удалось открыть файл конфигурации: " + config_file);
+    }
+    std::stringstream text;
+    text << file.rdbuf();
+    base_json_ = text.str();
+    base_ = SystemConfig::load_from_string(base_json_);
+
+    if (!base_.stage1_key_rules.empty() || !base_.stage2_key_rules.empty()) {
+        throw std::runtime_error("--tune перебирает stage1_rules/stage2_rules; правила по routing_key не поддерживаются");
+    }
+    if (base_.replay.enabled || base_.shm.enabled) {
+        throw std::runtime_error("--tune требует внутренних производителей (без replay и shm)");
+    }
+
+    if (base_.admission.divert_processor >= 0) {
+        min_processors_ = std::max(min_processors_, static_cast<uint32_t>(base_.admission.divert_processor) + 1);
+    }
+    if (base_.watchdog.enabled && base_.watchdog.inject_processor >= 0) {
+        min_processors_ = std::max(min_processors_, static_cast<uint32_t>(base_.watchdog.inject_processor) + 1);
+    }
+
+    // SystemConfig::validate: processors.count + elastic.standby_count <= 16
+    const uint32_t limit = TUNE_MAX_PROCESSORS - (base_.elastic.enabled ? base_.elastic.standby_count : 0);
+    max_processors_ = options_.max_processors > 0 ? options_.max_processors : 2 * base_.processors.count;
+    max_processors_ = std::min(std::max(max_processors_, min_processors_), limit);
+}
+
+std::vector<TuneCandidate> TopologyTuner::candidates(uint32_t processors) const {
+    json base = json::parse(base_json_);
+    if (options_.target_rate > 0.0) {
+        base["producers"]["messages_per_sec"] = static_cast<uint64_t>(
+            std::ceil(options_.target_rate / static_cast<double>(base_.producers.count)));
+    }
+    base["processors"]["count"] = processors;
+
+    // Нагрузка типа на процессор и стратегию - доля в потоке на время обработки
+    double weight_sum = 0.0;
+    for (const auto& [type, weight] : base_.producers.distribution) {
+        weight_sum += weight;
+    }
+    std::map<uint8_t, double> shares;
+    for (const auto& [type, weight] : base_.producers.distribution) {
+        if (weight > 0.0 && weight_sum > 0.0) {
+            shares[type] = weight / weight_sum;
+        }
+    }
+
+    std::map<uint8_t, const Stage2Rule*> stage2;
+    for (const Stage2Rule& rule : base_.stage2_rules) {
+        stage2[rule.msg_type] = &rule;
+    }
+    auto ordered = [&](uint8_t type) {
+        auto it = stage2.find(type);
+        return it == stage2.end() || it->second->ordering_required;
+    };
+
+    std::vector<std::pair<uint8_t, double>> types;
+    double total = 0.0;
+    for (const auto& [type, share] : shares) {
+        const double load = share * static_cast<double>(time_or_default(base_.processors.processing_times_ns, type));
+        types.emplace_back(type, load);
+        total += load;
+    }
+    std::stable_sort(types.begin(), types.end(), [](const auto& a, const auto& b) { return a.second > b.second; });
+
+    // Stage1: жадная раскладка по наименее загруженным процессорам (LPT)
+    auto stage1_rules = [&](bool spread) {
+        std::vector<double> loads(processors, 0.0);
+        const double fair = total / static_cast<double>(processors);
+        json rules = json::array();
+        for (const auto& [type, load] : types) {
+            std::vector<uint32_t> order = least_loaded(loads);
+            uint32_t parts = 1;
+            if (spread && !ordered(type) && fair > 0.0 && load > fair) {
+                parts = std::min(processors, static_cast<uint32_t>(std::ceil(load / fair)));
+            }
+            std::vector<uint32_t> targets(order.begin(), order.begin() + parts);
+            std::sort(targets.begin(), targets.end());
+            for (uint32_t target : targets) {
+                loads[target] += load / static_cast<double>(parts);
+            }
+            rules.push_back({{"msg_type", type}, {"processors", targets}});
+        }
+        // Типы с правилами, но без потока - по умолчанию роутера
+        for (const Stage1Rule& rule : base_.stage1_rules) {
+            if (shares.count(rule.msg_type) == 0) {
+                rules.push_back({{"msg_type", rule.msg_type}, {"processors", json::array({rule.msg_type % processors})}});
+            }
+        }
+        return rules;
+    };
+
+    // Stage2: multicast-правила неизменны, остальные типы - стратегии с наименьшей итоговой нагрузкой
+    auto balanced_stage2 = [&]() {
+        const uint32_t strategies = base_.strategies.count;
+        std::vector<double> loads(strategies, 0.0);
+        auto strategy_ns = [&](uint32_t s) {
+            return static_cast<double>(time_or_default(base_.strategies.processing_times_ns, static_cast<uint8_t>(s)));
+        };
+        std::vector<std::pair<uint8_t, double>> movable;
+        for (const auto& [type, share] : shares) {
+            auto it = stage2.find(type);
+            if (it == stage2.end()) {
+                continue;
+            }
+            if (!it->second->multicast.empty()) {
+                for (uint8_t s : it->second->multicast) {
+                    loads[s] += share * strategy_ns(s);
+                }
+            } else {
+                movable.emplace_back(type, share);
+            }
+        }
+        std::stable_sort(movable.begin(), movable.end(), [](const auto& a, const auto& b) { return a.second > b.second; });
+
+        std::map<uint8_t, uint32_t> assigned;
+        for (const auto& [type, share] : movable) {
+            uint32_t best = 0;
+            for (uint32_t s = 1; s < strategies; ++s) {
+                if (loads[s] + share * strategy_ns(s) < loads[best] + share * strategy_ns(best)) {
+                    best = s;
+                }
+            }
+            loads[best] += share * strategy_ns(best);
+            assigned[type] = best;
+        }
+
+        json rules = base["stage2_rules"];
+        for (json& rule : rules) {
+            auto it = assigned.find(rule.value("msg_type", 0));
+            if (it != assigned.end()) {
+                rule["strategy"] = it->second;
+            }
+        }
+        return rules;
+    };
+
+    std::vector<TuneCandidate> result;
+    std::vector<std::string> seen;
+    for (bool spread : {false, true}) {
+        for (bool balanced : {false, true}) {
+            if (balanced && !base.contains("stage2_rules")) {
+                continue;
+            }
+            json candidate = base;
+            candidate["stage1_rules"] = stage1_rules(spread);
+            if (balanced) {
+                candidate["stage2_rules"] = balanced_stage2();
+            }
+            std::string text = candidate.dump(4);
+            if (std::find(seen.begin(), seen.end(), text) != seen.end()) {
+                continue;
+            }
+            seen.push_back(text);
+            result.push_back({"p" + std::to_string(processors) + (spread ? "/spread" : "/packed")
+                                  + (balanced ? "/balanced" : "/config"),
+                              processors, std::move(text)});
+        }
+    }
+    return result;
+}
+
+uint32_t TopologyTuner::pipeline_threads(const SystemConfig& config) const {
+    if (config.runtime.mode == RuntimeMode::Coroutines) {
+        return config.runtime.schedulers;
+    }
+    const bool routers = config.runtime.topology != PipelineTopology::Fused;
+    return config.producers.count + config.total_processors() + config.strategies.count + (routers ? 2 : 0);
+}
+
+TrialResult TopologyTuner::trial(const TuneCandidate& candidate, double best_rate) const {
+    TrialResult result;
+    result.name = candidate.name;
+    result.processors = candidate.processors;
+
+    SystemConfig config = SystemConfig::load_from_string(candidate.json);
+    // Производители работают до явной остановки; пробы не пишут отчетов
+    config.duration_secs = 24 * 3600;
+    config.statistics.dimensions_output.clear();
+    config.queue_sampler.enabled = false;
+
+    Pipeline pipeline(config);
+    SystemStatistics& stats = pipeline.stats();
+    pipeline.start();
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(options_.warmup_ms));
+    stats.clear_latencies();
+
+    auto current_p99 = [&stats]() {
+        std::lock_guard<std::mutex> lock(stats.latency_mutex);
+        return stats.delivered_latencies.p99();
+    };
+
+    const uint64_t before = stats.counters()[StatsField::Delivered];
+    const auto start = std::chrono::steady_clock::now();
+    const double bar = options_.target_rate > 0.0 ? options_.target_rate : best_rate;
+    const uint32_t windows = std::max(1u, options_.trial_ms / std::max(options_.window_ms, 1u));
+
+    double elapsed = 0.0;
+    uint64_t delivered = 0;
+    for (uint32_t window = 1; window <= windows; ++window) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(options_.window_ms));
+        elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        delivered = stats.counters()[StatsField::Delivered] - before;
+
+        // Досрочная остановка: кандидат уже явно не дотягивает до цели или лучшего
+        if (window >= TUNE_MIN_WINDOWS && window < windows) {
+            const double rate = static_cast<double>(delivered) / elapsed;
+            if ((bar > 0.0 && rate < (1.0 - options_.stop_margin) * bar)
+                || (options_.slo_p99_us > 0.0 && current_p99() > 2.0 * options_.slo_p99_us)) {
+                result.stopped_early = true;
+                break;
+            }
+        }
+    }
+
+    result.msgs_per_sec = elapsed > 0.0 ? static_cast<double>(delivered) / elapsed : 0.0;
+    result.p99_us = current_p99();
+    result.measured_ms = static_cast<uint32_t>(elapsed * 1000.0);
+
+    pipeline.stop_producers();
+    result.drained = pipeline.drain(std::chrono::milliseconds(5000));
+    pipeline.stop();
+    result.order_violations = stats.total_order_violations();
+
+    result.meets = !result.stopped_early && result.order_violations == 0
+        && (options_.target_rate > 0.0 || options_.slo_p99_us > 0.0)
+        && (options_.target_rate <= 0.0 || result.msgs_per_sec >= (1.0 - TUNE_RATE_TOLERANCE) * options_.target_rate)
+        && (options_.slo_p99_us <= 0.0 || result.p99_us <= options_.slo_p99_us);
+    return result;
+}
+
+bool TopologyTuner::better(const TrialResult& a, const TrialResult& b) const {
+    if (a.meets != b.meets) {
+        return a.meets;
+    }
+    if (a.meets) {
+        // Цель достигнута обоими: меньше процессоров, затем меньше p99
+        if (a.processors != b.processors) {
+            return a.processors < b.processors;
+        }
+        return a.p99_us < b.p99_us;
+    }
+    if ((a.order_violations == 0) != (b.order_violations == 0)) {
+        return a.order_violations == 0;
+    }
+    // Разница пропускной способности в пределах погрешности пробы решается по p99
+    const double scale = std::max(a.msgs_per_sec, b.msgs_per_sec);
+    if (std::abs(a.msgs_per_sec - b.msgs_per_sec) > TUNE_RATE_TOLERANCE * scale) {
+        return a.msgs_per_sec > b.msgs_per_sec;
+    }
+    return a.p99_us < b.p99_us;
+}
+
+bool TopologyTuner::run() {
+    uint32_t cores = available_cores();
+    if (options_.cores > 0) {
+        // Все пробы на одном наборе ядер: потоки конвейера наследуют привязку управляющего потока
+        std::vector<uint32_t> allowed = allowed_cores();
+        if (allowed.size() > options_.cores) {
+            allowed.resize(options_.cores);
+        }
+        if (pin_current_thread(allowed)) {
+            cores = static_cast<uint32_t>(allowed.size());
+        } else {
+            std::cerr << "Предупреждение: не удалось привязать пробы к " << options_.cores << " ядрам" << std::endl;
+        }
+    }
+
+    std::cout << "=== ПОДБОР ТОПОЛОГИИ ===" << std::endl;
+    std::cout << "Сценарий: " << base_.scenario << std::endl;
+    std::cout << "Цель: ";
+    if (options_.target_rate > 0.0) {
+        std::cout << format_rate(options_.target_rate) << " msg/s (производителям "
+                  << format_rate(std::ceil(options_.target_rate / static_cast<double>(base_.producers.count)))
+                  << " msg/s каждому)";
+    } else {
+        std::cout << "наибольшая пропускная способность";
+    }
+    if (options_.slo_p99_us > 0.0) {
+        std::cout << ", p99 <= " << options_.slo_p99_us << " мкс";
+    }
+    std::cout << std::endl;
+    std::cout << "Проба: прогрев " << options_.warmup_ms << " мс + " << options_.trial_ms << " мс, ядер " << cores
+              << ", процессоров " << min_processors_ << ".." << max_processors_ << std::endl;
+    std::cout << std::endl;
+
+    std::cout << "  " << std::left << std::setw(26) << "candidate" << std::right
+              << std::setw(8) << "threads" << std::setw(10) << "msg/s" << std::setw(10) << "p99_us"
+              << std::setw(8) << "ms" << "  result" << std::endl;
+
+    std::vector<TrialResult> results;
+    std::vector<TuneCandidate> tried;
+    size_t best = 0;
+    size_t oversubscribed = 0;
+
+    // Кандидат, не прошедший проверку конфигурации, пропускается и не прерывает перебор
+    auto run_candidate = [&](const TuneCandidate& candidate) -> std::optional<TrialResult> {
+        uint32_t threads = 0;
+        try {
+            threads = pipeline_threads(SystemConfig::load_from_string(candidate.json));
+        } catch (const std::runtime_error& e) {
+            std::cout << "  " << std::left << std::setw(26) << candidate.name << std::right
+                      << "  пропущен: " << e.what() << std::endl;
+            return std::nullopt;
+        }
+        if (threads > cores) {
+            ++oversubscribed;
+        }
+        const double best_rate = results.empty() ? 0.0 : results[best].msgs_per_sec;
+        TrialResult result = trial(candidate, best_rate);
+
+        const char* verdict = result.meets ? "цель ✓"
+            : result.stopped_early ? "остановлена"
+            : result.order_violations > 0 ? "порядок ✗" : "-";
+        std::cout << "  " << std::left << std::setw(26) << result.name << std::right
+                  << std::setw(8) << threads << std::setw(10) << format_rate(result.msgs_per_sec)
+                  << std::fixed << std::setprecision(1) << std::setw(10) << result.p99_us
+                  << std::setw(8) << result.measured_ms << "  " << verdict << std::defaultfloat << std::endl;
+
+        results.push_back(result);
+        tried.push_back(candidate);
+        if (results.size() == 1 || better(results.back(), results[best])) {
+            best = results.size() - 1;
+        }
+        return results.back();
+    };
+
+    // Исходная раскладка (с темпом цели) - точка отсчета
+    TuneCandidate original{"original", base_.processors.count, ""};
+    {
+        json base = json::parse(base_json_);
+        if (options_.target_rate > 0.0) {
+            base["producers"]["messages_per_sec"] = static_cast<uint64_t>(
+                std::ceil(options_.target_rate / static_cast<double>(base_.producers.count)));
+        }
+        original.json = base.dump(4);
+    }
+    run_candidate(original);
+
+    double previous_rate = 0.0;
+    uint32_t flat_steps = 0;
+    for (uint32_t processors = min_processors_; processors <= max_processors_; ++processors) {
+        bool met = false;
+        double step_rate = 0.0;
+        for (const TuneCandidate& candidate : candidates(processors)) {
+            const std::optional<TrialResult> result = run_candidate(candidate);
+            if (!result) {
+                continue;
+            }
+            met = met || result->meets;
+            step_rate = std::max(step_rate, result->msgs_per_sec);
+        }
+        // Больше процессоров не нужно: цель достигнута с этим числом
+        if (met) {
+            break;
+        }
+        flat_steps = step_rate > previous_rate * (1.0 + TUNE_PLATEAU_GAIN) ? 0 : flat_steps + 1;
+        previous_rate = std::max(previous_rate, step_rate);
+        if (flat_steps >= 2) {
+            std::cout << "  (пропускная способность не растет два шага подряд - перебор остановлен)" << std::endl;
+            break;
+        }
+    }
+    std::cout << std::endl;
+
+    if (results.empty()) {
+        throw std::runtime_error("Ни один кандидат не прошел проверку конфигурации");
+    }
+    const TrialResult& winner = results[best];
+    const bool has_goal = options_.target_rate > 0.0 || options_.slo_p99_us > 0.0;
+    std::cout << "Лучший кандидат: " << winner.name << " - " << format_rate(winner.msgs_per_sec)
+              << " msg/s, p99 " << std::fixed << std::setprecision(1) << winner.p99_us << " мкс"
+              << std::defaultfloat << " (проб: " << results.size() << ")" << std::endl;
+    if (oversubscribed > 0) {
+        std::cout << "Предупреждение: в " << oversubscribed << " пробах потоков конвейера больше, чем ядер ("
+                  << cores << ") - потоки делят ядра, темп таких кандидатов занижен" << std::endl;
+    }
+
+    json output = json::parse(tried[best].json);
+    output["tuning"] = {
+        {"candidate", winner.name},
+        {"msgs_per_sec", winner.msgs_per_sec},
+        {"p99_us", winner.p99_us},
+        {"target_rate", options_.target_rate},
+        {"slo_p99_us", options_.slo_p99_us},
+        {"met", winner.meets},
+        {"trials", results.size()},
+        {"trial_ms", options_.trial_ms},
+        {"cores", cores}
+    };
+    const std::filesystem::path path(options_.output);
+    if (path.has_parent_path()) {
+        std::filesystem::create_directories(path.parent_path());
+    }
+    std::ofstream out(path);
+    if (!out.is_open()) {
+        throw std::runtime_error("Не удалось записать конфигурацию: " + options_.output);
+    }
+    out << output.dump(4) << std::endl;
+    std::cout << "Конфигурация записана: " << options_.output << std::endl;
+    std::cout << std::endl;
+
+    const bool ok = !has_goal || winner.meets;
+    std::cout << "Результат подбора: " << (!has_goal ? "ГОТОВО ✓" : ok ? "ЦЕЛЬ ДОСТИГНУТА ✓" : "ЦЕЛЬ НЕ ДОСТИГНУТА ✗")
+              << std::endl;
+    std::cout << std::endl;
+    return ok;
+}
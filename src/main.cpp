@@ -1,10 +1,8 @@
 #include "config.hpp"
-#include "message.hpp"
-#include "statistics.hpp"
-#include "producer.hpp"
-#include "processor.hpp"
-#include "strategy.hpp"
-#include "router.hpp"
+#include "pipeline.hpp"
+#include "capacity_planner.hpp"
+#include "flight_recorder.hpp"
+#include "topology_tuner.hpp"
 #include "timer.hpp"
 
 #include <iostream>
@@ -14,6 +12,7 @@
 #include <atomic>
 #include <csignal>
 #include <cstdlib>
+#include <string_view>
 
 // Глобальный флаг для остановки системы
 std::atomic<bool> g_running{true};
@@ -22,6 +21,92 @@ void signal_handler(int signal) {
     if (signal == SIGINT || signal == SIGTERM) {
         std::cout << "\n Получен сигнал завершения. Остановка системы..." << std::endl;
         g_running.store(false, std::memory_order_release);
+    } else if (signal == SIGUSR1) {
+        // Заморозка бортового самописца; экспорт выполняет поток мониторинга
+        FlightRecorder::freeze(FreezeReason::Signal);
+    }
+}
+
+/**
+ * Режим планирования: router_test --plan <config.json> [--simulate_ms=N] [--router_ns=N] [--cores=N]
+ * Конвейер не запускается; код возврата 0 - конфигурация успевает
+ */
+int run_plan(int argc, char* argv[]) {
+    PlanOptions options;
+    std::string config_file;
+    for (int i = 2; i < argc; ++i) {
+        const std::string_view arg = argv[i];
+        if (arg.rfind("--simulate_ms=", 0) == 0) {
+            options.simulate_ms = static_cast<uint32_t>(std::stoul(std::string(arg.substr(14))));
+        } else if (arg.rfind("--cores=", 0) == 0) {
+            options.cores = static_cast<uint32_t>(std::stoul(std::string(arg.substr(8))));
+        } else if (arg.rfind("--router_ns=", 0) == 0) {
+            options.router_ns = std::stoull(std::string(arg.substr(12)));
+        } else if (config_file.empty() && arg.rfind("--", 0) != 0) {
+            config_file = arg;
+        } else {
+            std::cerr << "Неизвестный аргумент: " << arg << std::endl;
+            return 1;
+        }
+    }
+    if (config_file.empty()) {
+        std::cerr << "Использование: " << argv[0]
+                  << " --plan <config.json> [--simulate_ms=N] [--router_ns=N] [--cores=N]" << std::endl;
+        return 1;
+    }
+
+    try {
+        SystemConfig config = SystemConfig::load_from_file(config_file);
+        CapacityPlanner planner(config, options);
+        return planner.report() ? 0 : 1;
+    } catch (const std::exception& e) {
+        std::cerr << "Ошибка: " << e.what() << std::endl;
+        return 1;
+    }
+}
+
+/**
+ * Режим подбора топологии: router_test --tune <config.json> [--target_rate=N] [--slo_p99_us=N] ...
+ * Кандидаты запускаются на настоящем конвейере; код возврата 0 - цель достигнута
+ */
+int run_tune(int argc, char* argv[]) {
+    TuneOptions options;
+    std::string config_file;
+    for (int i = 2; i < argc; ++i) {
+        const std::string_view arg = argv[i];
+        if (arg.rfind("--target_rate=", 0) == 0) {
+            options.target_rate = std::stod(std::string(arg.substr(14)));
+        } else if (arg.rfind("--slo_p99_us=", 0) == 0) {
+            options.slo_p99_us = std::stod(std::string(arg.substr(13)));
+        } else if (arg.rfind("--trial_ms=", 0) == 0) {
+            options.trial_ms = static_cast<uint32_t>(std::stoul(std::string(arg.substr(11))));
+        } else if (arg.rfind("--warmup_ms=", 0) == 0) {
+            options.warmup_ms = static_cast<uint32_t>(std::stoul(std::string(arg.substr(12))));
+        } else if (arg.rfind("--max_processors=", 0) == 0) {
+            options.max_processors = static_cast<uint32_t>(std::stoul(std::string(arg.substr(17))));
+        } else if (arg.rfind("--cores=", 0) == 0) {
+            options.cores = static_cast<uint32_t>(std::stoul(std::string(arg.substr(8))));
+        } else if (arg.rfind("--output=", 0) == 0) {
+            options.output = std::string(arg.substr(9));
+        } else if (config_file.empty() && arg.rfind("--", 0) != 0) {
+            config_file = arg;
+        } else {
+            std::cerr << "Неизвестный аргумент: " << arg << std::endl;
+            return 1;
+        }
+    }
+    if (config_file.empty()) {
+        std::cerr << "Использование: " << argv[0] << " --tune <config.json> [--target_rate=N] [--slo_p99_us=N]"
+                  << " [--trial_ms=N] [--warmup_ms=N] [--max_processors=N] [--cores=N] [--output=file]" << std::endl;
+        return 1;
+    }
+
+    try {
+        TopologyTuner tuner(config_file, options);
+        return tuner.run() ? 0 : 1;
+    } catch (const std::exception& e) {
+        std::cerr << "Ошибка: " << e.what() << std::endl;
+        return 1;
     }
 }
 
@@ -29,13 +114,25 @@ int main(int argc, char* argv[]) {
     // Установка обработчика сигналов
     std::signal(SIGINT, signal_handler);
     std::signal(SIGTERM, signal_handler);
+    std::signal(SIGUSR1, signal_handler);
 
     // Проверка аргументов
     if (argc < 2) {
         std::cerr << "Использование: " << argv[0] << " <config.json>" << std::endl;
+        std::cerr << "               " << argv[0]
+                  << " --plan <config.json> [--simulate_ms=N] [--router_ns=N] [--cores=N]" << std::endl;
+        std::cerr << "               " << argv[0]
+                  << " --tune <config.json> [--target_rate=N] [--slo_p99_us=N] [--trial_ms=N]" << std::endl;
         return 1;
     }
 
+    if (std::string_view(argv[1]) == "--plan") {
+        return run_plan(argc, argv);
+    }
+    if (std::string_view(argv[1]) == "--tune") {
+        return run_tune(argc, argv);
+    }
+
     std::string config_file = argv[1];
 
     try {
@@ -43,140 +140,39 @@ int main(int argc, char* argv[]) {
         std::cout << "Загрузка конфигурации из: " << config_file << std::endl;
         SystemConfig config = SystemConfig::load_from_file(config_file);
         std::cout << "Конфигурация загружена успешно" << std::endl;
+
+        // Бортовой самописец настраивается до запуска потоков
+        FlightRecorder::instance().configure(config.flight_recorder);
         std::cout << "Сценарий: " << config.scenario << std::endl;
         std::cout << "Длительность: " << config.duration_secs << " секунд" << std::endl;
         std::cout << std::endl;
 
-        // Инициализация статистики
-        SystemStatistics stats(
-            config.producers.count,
-            config.processors.count,
-            config.strategies.count
-        );
-
-        // ========== Создание очередей ==========
-
-        // Очереди от производителей к Stage1 Router
-        std::vector<std::shared_ptr<SPSCQueue<Message, PRODUCER_QUEUE_SIZE>>> producer_queues;
-        for (size_t i = 0; i < config.producers.count; ++i) {
-            producer_queues.push_back(
-                std::make_shared<SPSCQueue<Message, PRODUCER_QUEUE_SIZE>>()
-            );
-        }
-
-        // Очереди от Stage1 Router к процессорам
-        std::vector<std::shared_ptr<SPSCQueue<Message, PROCESSOR_QUEUE_SIZE>>> stage1_to_processor_queues;
-        for (size_t i = 0; i < config.processors.count; ++i) {
-            stage1_to_processor_queues.push_back(
-                std::make_shared<SPSCQueue<Message, PROCESSOR_QUEUE_SIZE>>()
-            );
-        }
-
-        // Очереди от процессоров к Stage2 Router
-        std::vector<std::shared_ptr<SPSCQueue<Message, PROCESSOR_QUEUE_SIZE>>> processor_to_stage2_queues;
-        for (size_t i = 0; i < config.processors.count; ++i) {
-            processor_to_stage2_queues.push_back(
-                std::make_shared<SPSCQueue<Message, PROCESSOR_QUEUE_SIZE>>()
-            );
-        }
-
-        // Очереди от Stage2 Router к стратегиям
-        std::vector<std::shared_ptr<SPSCQueue<Message, STRATEGY_QUEUE_SIZE>>> stage2_to_strategy_queues;
-        for (size_t i = 0; i < config.strategies.count; ++i) {
-            stage2_to_strategy_queues.push_back(
-                std::make_shared<SPSCQueue<Message, STRATEGY_QUEUE_SIZE>>()
-            );
-        }
-
-        // ========== Создание компонентов ==========
-
-        // Производители
-        std::vector<std::unique_ptr<Producer>> producers;
-        for (size_t i = 0; i < config.producers.count; ++i) {
-            producers.push_back(std::make_unique<Producer>(
-                static_cast<uint8_t>(i),
-                config.producers,
-                producer_queues[i],
-                stats
-            ));
-        }
-
-        // Процессоры
-        std::vector<std::unique_ptr<Processor>> processors;
-        for (size_t i = 0; i < config.processors.count; ++i) {
-            processors.push_back(std::make_unique<Processor>(
-                static_cast<uint8_t>(i),
-                config.processors,
-                stage1_to_processor_queues[i],
-                processor_to_stage2_queues[i],
-                stats
-            ));
-        }
-
-        // Стратегии
-        std::vector<std::unique_ptr<Strategy>> strategies;
-        for (size_t i = 0; i < config.strategies.count; ++i) {
-            strategies.push_back(std::make_unique<Strategy>(
-                static_cast<uint8_t>(i),
-                config.strategies,
-                stage2_to_strategy_queues[i],
-                stats
-            ));
-        }
-
-        // Роутеры
-        Stage1Router stage1_router(
-            config.stage1_rules,
-            producer_queues,
-            stage1_to_processor_queues
-        );
-
-        Stage2Router stage2_router(
-            config.stage2_rules,
-            processor_to_stage2_queues,
-            stage2_to_strategy_queues
-        );
+        // Сборка конвейера: очереди, компоненты, журнал, масштабирование
+        Pipeline pipeline(config);
+        SystemStatistics& stats = pipeline.stats();
 
         // ========== Запуск потоков ==========
 
         std::cout << "Запуск системы..." << std::endl;
         std::cout << "  Producers: " << config.producers.count << std::endl;
-        std::cout << "  Processors: " << config.processors.count << std::endl;
-        std::cout << "  Strategies: " << config.strategies.count << std::endl;
+        std::cout << "  Processors: " << config.processors.count;
+        if (config.elastic.enabled) {
+            std::cout << " (+" << config.elastic.standby_count << " резервных)";
+        }
         std::cout << std::endl;
-
-        std::vector<std::thread> threads;
-
-        // Запуск производителей
-        for (auto& producer : producers) {
-            threads.emplace_back([&producer, &g_running, duration = config.duration_secs]() {
-                producer->run(g_running, duration);
-            });
+        std::cout << "  Strategies: " << config.strategies.count << std::endl;
+        if (config.runtime.mode == RuntimeMode::Coroutines) {
+            std::cout << "  Runtime: coroutines, планировщиков " << config.runtime.schedulers
+                      << ", batch " << config.runtime.batch << std::endl;
         }
-
-        // Запуск Stage1 Router
-        threads.emplace_back([&stage1_router, &g_running]() {
-            stage1_router.run(g_running);
-        });
-
-        // Запуск процессоров
-        for (auto& processor : processors) {
-            threads.emplace_back([&processor, &g_running]() {
-                processor->run(g_running);
-            });
+        if (config.shm.enabled) {
+            std::cout << "  Внешние producers (shm " << config.shm.name << "): слоты "
+                      << config.producers.count << ".." << (config.total_producers() - 1)
+                      << std::endl;
         }
+        std::cout << std::endl;
 
-        // Запуск Stage2 Router
-        threads.emplace_back([&stage2_router, &g_running]() {
-            stage2_router.run(g_running);
-        });
-
-        // Запуск стратегий
-        for (auto& strategy : strategies) {
-            threads.emplace_back([&strategy, &g_running]() {
-                strategy->run(g_running);
-            });
-        }
+        pipeline.start();
 
         // ========== Мониторинг ==========
 
@@ -188,45 +184,38 @@ int main(int argc, char* argv[]) {
             std::this_thread::sleep_for(std::chrono::seconds(1));
             seconds_elapsed++;
 
-            // Обновление глубин очередей
-            for (size_t i = 0; i < stage1_to_processor_queues.size(); ++i) {
-                stats.stage1_queue_depths[i]->store(
-                    stage1_to_processor_queues[i]->size(),
-                    std::memory_order_relaxed
-                );
-            }
-            for (size_t i = 0; i < stage2_to_strategy_queues.size(); ++i) {
-                stats.stage2_queue_depths[i]->store(
-                    stage2_to_strategy_queues[i]->size(),
-                    std::memory_order_relaxed
-                );
-            }
-
             // Вывод текущей статистики
+            pipeline.update_queue_depths();
             stats.print_current_stats(global_timer.elapsed_seconds());
+            pipeline.print_current_state();
+
+            // Самописец заморожен сигналом или порогом задержки
+            if (FlightRecorder::frozen()) {
+                FlightRecorder::instance().export_once();
+            }
         }
 
-        // Остановка системы
+        // Остановка системы: сначала производители, остальные компоненты дренируют очереди
         std::cout << "\nОстановка системы..." << std::endl;
         g_running.store(false, std::memory_order_release);
+        pipeline.stop_producers();
 
         // Ждем пока все сообщения будут обработаны (максимум 60 секунд)
-        // Делаем это ДО join потоков, чтобы они продолжали дренировать очереди
         std::cout << "Ожидание обработки оставшихся сообщений..." << std::endl;
         bool all_processed = false;
         for (int i = 0; i < 120; ++i) {
-            std::this_thread::sleep_for(std::chrono::milliseconds(500));
-
-            uint64_t produced = stats.messages_produced.load(std::memory_order_relaxed);
-            uint64_t delivered = stats.messages_delivered.load(std::memory_order_relaxed);
-
-            if (produced == delivered) {
+            if (pipeline.drain(std::chrono::milliseconds(500))) {
                 std::cout << "Все сообщения обработаны." << std::endl;
                 all_processed = true;
                 break;
             }
 
             if (i % 4 == 0) {  // Каждые 2 секунды
+                const StatsCounters totals = stats.counters();
+                uint64_t produced = totals[StatsField::Produced];
+                uint64_t delivered = totals[StatsField::Delivered]
+                                   + totals[StatsField::Rejected]
+                                   + totals[StatsField::Shed];
                 std::cout << "  Ожидание... (произведено: " << produced
                           << ", доставлено: " << delivered << ")" << std::endl;
             }
@@ -237,17 +226,18 @@ int main(int argc, char* argv[]) {
         }
 
         // Ожидание завершения всех потоков
-        for (auto& thread : threads) {
-            if (thread.joinable()) {
-                thread.join();
-            }
-        }
+        pipeline.stop();
 
         double final_duration = global_timer.elapsed_seconds();
 
+        // Трасса последних событий перед остановкой (если не выгружена раньше)
+        FlightRecorder::freeze(FreezeReason::Shutdown);
+        FlightRecorder::instance().export_once();
+
         // ========== Финальный отчет ==========
 
         stats.print_final_report(config.scenario, final_duration);
+        pipeline.print_reports(final_duration);
 
         return stats.validate() ? 0 : 1;
 
@@ -0,0 +1,108 @@
+#include "config.hpp"
+#include "producer.hpp"
+#include "shm_queue.hpp"
+#include "statistics.hpp"
+#include "timer.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <iostream>
+#include <string>
+#include <thread>
+
+/**
+ * shm_producer - внешний процесс-производитель
+ *
+ * Подключается к области shm, созданной router_test (секция "shm" конфигурации),
+ * и пишет сообщения напрямую в свою очередь. Горячий путь - обычный Producer::run
+ * поверх SPSCQueue в разделяемой памяти; heartbeat обновляется отдельным потоком.
+ *
+ * Использование: shm_producer <config.json> <slot>
+ */
+
+std::atomic<bool> g_running{true};
+
+void signal_handler(int signal) {
+    if (signal == SIGINT || signal == SIGTERM) {
+        g_running.store(false, std::memory_order_release);
+    }
+}
+
+int main(int argc, char* argv[]) {
+    std::signal(SIGINT, signal_handler);
+    std::signal(SIGTERM, signal_handler);
+
+    if (argc < 3) {
+        std::cerr << "Использование: " << argv[0] << " <config.json> <slot>" << std::endl;
+        return 1;
+    }
+
+    try {
+        SystemConfig config = SystemConfig::load_from_file(argv[1]);
+        const uint32_t slot = static_cast<uint32_t>(std::stoul(argv[2]));
+
+        if (!config.shm.enabled) {
+            std::cerr << "Ошибка: в конфигурации не включена секция shm" << std::endl;
+            return 1;
+        }
+        if (slot < config.producers.count || slot >= config.total_producers()) {
+            std::cerr << "Ошибка: слот должен быть в диапазоне " << config.producers.count
+                      << ".." << (config.total_producers() - 1) << std::endl;
+            return 1;
+        }
+
+        auto shm_queues = ShmQueueSet<SPSCQueue<Message, PRODUCER_QUEUE_SIZE>>::attach(config.shm.name);
+        shm_queues->attach_peer(slot);
+
+        // Сообщения, учтенные предыдущим (упавшим) владельцем слота
+        const uint64_t pushed_base = shm_queues->peer(slot).pushed.load(std::memory_order_relaxed);
+
+        // Нумерация продолжает предшественника: трекер порядка роутера видит один производитель
+        // на слот. pushed обновляется раз в 1 мс, поэтому берется и последнее сообщение в очереди
+        uint64_t first_sequence = pushed_base;
+        Message last;
+        if (shm_queues->queue(slot).last_pushed(last)) {
+            first_sequence = std::max(first_sequence, last.sequence_number + 1);
+        }
+
+        std::cout << "Подключено к " << config.shm.name << ", слот " << slot
+                  << ", pid " << getpid() << ", первый seq " << first_sequence << std::endl;
+
+        // Локальная статистика процесса (нужна Producer'у для счетчика отправленных)
+        SystemStatistics stats(config.total_producers(), 0, 0);
+        Producer producer(
+            static_cast<uint8_t>(slot),
+            config.producers,
+            shm_queues->shared_queue(slot),
+            stats,
+            first_sequence
+        );
+
+        std::thread worker([&producer, duration = config.duration_secs]() {
+            producer.run(g_running, duration);
+            g_running.store(false, std::memory_order_release);
+        });
+
+        // Heartbeat и счетчик отправленных сообщений вне горячего пути
+        while (g_running.load(std::memory_order_acquire)) {
+            shm_queues->heartbeat(slot, first_sequence +
+                stats.counters()[StatsField::Produced]);
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+
+        worker.join();
+
+        uint64_t produced = stats.counters()[StatsField::Produced];
+        shm_queues->heartbeat(slot, first_sequence + produced);
+        shm_queues->finish_peer(slot);
+
+        std::cout << "Отправлено сообщений: " << produced << std::endl;
+        return 0;
+
+    } catch (const std::exception& e) {
+        std::cerr << "Ошибка: " << e.what() << std::endl;
+        return 1;
+    }
+}
@@ -0,0 +1,113 @@
+#include "cpu_affinity.hpp"
+#include <fstream>
+#include <string>
+#include <thread>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/resource.h>
+#include <unistd.h>
+
+bool pin_current_thread(uint32_t core) {
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(core, &set);
+    return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+}
+
+bool pin_current_thread(const std::vector<uint32_t>& cores) {
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (uint32_t core : cores) {
+        CPU_SET(core, &set);
+    }
+    return !cores.empty() && pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+}
+
+uint32_t available_cores() {
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    if (sched_getaffinity(0, sizeof(set), &set) == 0) {
+        return static_cast<uint32_t>(CPU_COUNT(&set));
+    }
+    return std::thread::hardware_concurrency();
+}
+
+bool set_current_thread_low_priority() {
+    // В Linux nice применяется к отдельному потоку по его tid
+    return setpriority(PRIO_PROCESS, static_cast<id_t>(gettid()), 19) == 0;
+}
+
+std::vector<uint32_t> allowed_cores() {
+    std::vector<uint32_t> cores;
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    if (sched_getaffinity(0, sizeof(set), &set) == 0) {
+        for (uint32_t core = 0; core < CPU_SETSIZE; ++core) {
+            if (CPU_ISSET(core, &set)) {
+                cores.push_back(core);
+            }
+        }
+    }
+    return cores;
+}
+
+namespace {
+
+std::string read_topology(uint32_t core, const std::string& file) {
+    std::ifstream in("/sys/devices/system/cpu/cpu" + std::to_string(core) + "/" + file);
+    std::string value;
+    std::getline(in, value);
+    return value;
+}
+
+/**
+ * Проверка вхождения ядра в список вида "0-3,8,10-11"
+ */
+bool cpu_list_contains(const std::string& list, uint32_t core) {
+    size_t begin = 0;
+    while (begin < list.size()) {
+        size_t end = list.find(',', begin);
+        if (end == std::string::npos) {
+            end = list.size();
+        }
+        const std::string range = list.substr(begin, end - begin);
+        const size_t dash = range.find('-');
+        const uint32_t first = static_cast<uint32_t>(std::stoul(range.substr(0, dash)));
+        const uint32_t last = dash == std::string::npos
+            ? first : static_cast<uint32_t>(std::stoul(range.substr(dash + 1)));
+        if (core >= first && core <= last) {
+            return true;
+        }
+        begin = end + 1;
+    }
+    return false;
+}
+
+} // namespace
+
+CoreRelation core_relation(uint32_t a, uint32_t b) {
+    if (a == b) {
+        return CoreRelation::Same;
+    }
+    if (cpu_list_contains(read_topology(a, "topology/thread_siblings_list"), b)) {
+        return CoreRelation::SmtSibling;
+    }
+    if (cpu_list_contains(read_topology(a, "cache/index3/shared_cpu_list"), b)) {
+        return CoreRelation::SharedL3;
+    }
+    if (read_topology(a, "topology/physical_package_id") == read_topology(b, "topology/physical_package_id")) {
+        return CoreRelation::SameSocket;
+    }
+    return CoreRelation::CrossSocket;
+}
+
+const char* core_relation_name(CoreRelation relation) {
+    switch (relation) {
+        case CoreRelation::Same:        return "same";
+        case CoreRelation::SmtSibling:  return "smt";
+        case CoreRelation::SharedL3:    return "l3";
+        case CoreRelation::SameSocket:  return "socket";
+        case CoreRelation::CrossSocket: return "cross_socket";
+    }
+    return "unknown";
+}
@@ -0,0 +1,277 @@
+#include "perf_counters.hpp"
+#include <cerrno>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace {
+
+struct PerfEventSpec {
+    uint32_t type;
+    uint64_t config;
+    const char* name;
+};
+
+// Порядок совпадает с enum PerfEvent
+constexpr PerfEventSpec PERF_EVENT_SPECS[PERF_EVENT_COUNT] = {
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES, "cycles"},
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS, "instructions"},
+    {PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_L1D
+                         | (PERF_COUNT_HW_CACHE_OP_READ << 8)
+                         | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16), "l1d_misses"},
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES, "llc_misses"},
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES, "branch_misses"},
+    {PERF_TYPE_SOFTWARE, PERF_COUNT_SW_CONTEXT_SWITCHES, "context_switches"},
+};
+
+constexpr uint64_t GROUP_READ_FORMAT = PERF_FORMAT_GROUP | PERF_FORMAT_ID
+                                     | PERF_FORMAT_TOTAL_TIME_ENABLED
+                                     | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+int perf_event_open(const PerfEventSpec& spec, bool include_kernel, int group_fd, uint64_t read_format) {
+    perf_event_attr attr;
+    std::memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = spec.type;
+    attr.config = spec.config;
+    attr.read_format = read_format;
+    // Переключения контекста происходят в ядре - для программных событий режим не фильтруется
+    attr.exclude_kernel = (include_kernel || spec.type == PERF_TYPE_SOFTWARE) ? 0 : 1;
+    attr.exclude_hv = 1;
+
+    // pid = 0, cpu = -1: вызывающий поток на любом ядре
+    return static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, group_fd, PERF_FLAG_FD_CLOEXEC));
+}
+
+// Поправка на мультиплексирование: событие считалось только часть времени
+uint64_t scale(uint64_t value, uint64_t time_enabled, uint64_t time_running) {
+    if (time_running == 0 || time_running >= time_enabled) {
+        return value;
+    }
+    return static_cast<uint64_t>(static_cast<double>(value) * time_enabled / time_running);
+}
+
+}  // namespace
+
+const char* perf_event_name(PerfEvent event) {
+    return event < PERF_EVENT_COUNT ? PERF_EVENT_SPECS[event].name : "unknown";
+}
+
+PerfCounts& PerfCounts::operator+=(const PerfCounts& other) {
+    for (size_t i = 0; i < PERF_EVENT_COUNT; ++i) {
+        values[i] += other.values[i];
+        valid[i] = valid[i] || other.valid[i];
+    }
+    return *this;
+}
+
+PerfCounts PerfCounts::operator-(const PerfCounts& other) const {
+    PerfCounts result = *this;
+    for (size_t i = 0; i < PERF_EVENT_COUNT; ++i) {
+        result.values[i] = values[i] >= other.values[i] ? values[i] - other.values[i] : 0;
+    }
+    return result;
+}
+
+bool PerfCounts::any_valid() const {
+    for (bool v : valid) {
+        if (v) return true;
+    }
+    return false;
+}
+
+PerfCounterGroup::PerfCounterGroup() {
+    fds_.fill(-1);
+}
+
+PerfCounterGroup::~PerfCounterGroup() {
+    close_all();
+}
+
+bool PerfCounterGroup::open(bool include_kernel) {
+    close_all();
+
+    bool opened = false;
+    for (size_t i = 0; i < PERF_EVENT_COUNT; ++i) {
+        const PerfEventSpec& spec = PERF_EVENT_SPECS[i];
+        const bool hardware = spec.type != PERF_TYPE_SOFTWARE;
+
+        // Первое открытое аппаратное событие становится лидером группы
+        const int group_fd = hardware ? leader_fd_ : -1;
+        const uint64_t read_format = hardware ? GROUP_READ_FORMAT
+            : PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+        const int fd = perf_event_open(spec, include_kernel, group_fd, read_format);
+        if (fd < 0) {
+            if (error_.empty()) {
+                error_ = std::string(spec.name) + ": " + std::strerror(errno);
+            }
+            continue;
+        }
+
+        fds_[i] = fd;
+        opened = true;
+        if (hardware) {
+            if (leader_fd_ < 0) {
+                leader_fd_ = fd;
+            }
+            if (ioctl(fd, PERF_EVENT_IOC_ID, &ids_[i]) != 0) {
+                ids_[i] = 0;
+            }
+        }
+    }
+    return opened;
+}
+
+PerfCounts PerfCounterGroup::read() const {
+    PerfCounts counts;
+
+    // Аппаратная группа читается одним вызовом: {nr, enabled, running, {value, id}[nr]}
+    if (leader_fd_ >= 0) {
+        uint64_t buffer[3 + 2 * PERF_EVENT_COUNT] = {};
+        if (::read(leader_fd_, buffer, sizeof(buffer)) > 0) {
+            const uint64_t nr = buffer[0];
+            for (uint64_t n = 0; n < nr && n < PERF_EVENT_COUNT; ++n) {
+                const uint64_t value = buffer[3 + 2 * n];
+                const uint64_t id = buffer[3 + 2 * n + 1];
+                for (size_t i = 0; i < PERF_EVENT_COUNT; ++i) {
+                    if (fds_[i] >= 0 && ids_[i] == id) {
+                        counts.values[i] = scale(value, buffer[1], buffer[2]);
+                        counts.valid[i] = true;
+                    }
+                }
+            }
+        }
+    }
+
+    // Программные события читаются по отдельности: {value, enabled, running}
+    for (size_t i = 0; i < PERF_EVENT_COUNT; ++i) {
+        if (fds_[i] < 0 || PERF_EVENT_SPECS[i].type != PERF_TYPE_SOFTWARE) {
+            continue;
+        }
+        uint64_t buffer[3] = {};
+        if (::read(fds_[i], buffer, sizeof(buffer)) == static_cast<ssize_t>(sizeof(buffer))) {
+            counts.values[i] = scale(buffer[0], buffer[1], buffer[2]);
+            counts.valid[i] = true;
+        }
+    }
+    return counts;
+}
+
+void PerfCounterGroup::close_all() {
+    // Члены группы закрываются раньше лидера
+    for (size_t i = PERF_EVENT_COUNT; i-- > 0;) {
+        if (fds_[i] >= 0 && fds_[i] != leader_fd_) {
+            close(fds_[i]);
+        }
+        fds_[i] = -1;
+    }
+    if (leader_fd_ >= 0) {
+        close(leader_fd_);
+        leader_fd_ = -1;
+    }
+    ids_.fill(0);
+}
+
+PerfStageCounters::PerfStageCounters(bool include_kernel)
+    : include_kernel_(include_kernel)
+{
+}
+
+void PerfStageCounters::attach_current_thread(const std::string& stage) {
+    auto group = std::make_unique<PerfCounterGroup>();
+    const bool opened = group->open(include_kernel_);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (error_.empty() && !group->error().empty()) {
+        error_ = group->error();
+    }
+    if (opened) {
+        groups_.emplace_back(stage, std::move(group));
+    }
+}
+
+std::map<std::string, PerfCounts> PerfStageCounters::snapshot() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::map<std::string, PerfCounts> result;
+    for (const auto& [stage, group] : groups_) {
+        result[stage] += group->read();
+    }
+    return result;
+}
+
+PerfCounts PerfStageCounters::total() const {
+    PerfCounts result;
+    for (const auto& [stage, counts] : snapshot()) {
+        result += counts;
+    }
+    return result;
+}
+
+void PerfStageCounters::print_report(const std::vector<std::string>& stage_order,
+                                     const std::map<std::string, uint64_t>& messages) const {
+    const auto stages = snapshot();
+
+    std::cout << "Счетчики производительности (perf_event_open):" << std::endl;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!error_.empty()) {
+            std::cout << "  Недоступны события (" << error_ << ") - они помечены как n/a" << std::endl;
+        }
+    }
+    if (stages.empty()) {
+        std::cout << "  Ни одно событие не открыто" << std::endl << std::endl;
+        return;
+    }
+
+    auto print_value = [](const PerfCounts& counts, PerfEvent event, double divisor, int width) {
+        if (!counts.valid[event] || divisor <= 0.0) {
+            std::cout << std::setw(width) << "n/a";
+        } else {
+            std::cout << std::setw(width) << static_cast<double>(counts.values[event]) / divisor;
+        }
+    };
+
+    std::cout << "  На 1M сообщений стадии:" << std::endl;
+    std::cout << "  " << std::left << std::setw(12) << "Stage" << std::right
+              << std::setw(14) << "messages" << std::setw(14) << "cycles"
+              << std::setw(14) << "instructions" << std::setw(8) << "IPC"
+              << std::setw(12) << "L1D miss" << std::setw(12) << "LLC miss"
+              << std::setw(12) << "br. miss" << std::setw(10) << "ctx sw" << std::endl;
+
+    for (const auto& stage : stage_order) {
+        auto it = stages.find(stage);
+        if (it == stages.end()) {
+            continue;
+        }
+        const PerfCounts& counts = it->second;
+        auto msg_it = messages.find(stage);
+        const uint64_t stage_messages = msg_it != messages.end() ? msg_it->second : 0;
+        const double per_million = static_cast<double>(stage_messages) / 1e6;
+
+        std::cout << "  " << std::left << std::setw(12) << stage << std::right
+                  << std::setw(14) << stage_messages << std::fixed << std::setprecision(0);
+        print_value(counts, PERF_CYCLES, per_million, 14);
+        print_value(counts, PERF_INSTRUCTIONS, per_million, 14);
+
+        std::cout << std::setprecision(2);
+        if (counts.valid[PERF_CYCLES] && counts.valid[PERF_INSTRUCTIONS] && counts.values[PERF_CYCLES] > 0) {
+            std::cout << std::setw(8) << static_cast<double>(counts.values[PERF_INSTRUCTIONS])
+                                         / static_cast<double>(counts.values[PERF_CYCLES]);
+        } else {
+            std::cout << std::setw(8) << "n/a";
+        }
+
+        std::cout << std::setprecision(0);
+        print_value(counts, PERF_L1D_MISSES, per_million, 12);
+        print_value(counts, PERF_LLC_MISSES, per_million, 12);
+        print_value(counts, PERF_BRANCH_MISSES, per_million, 12);
+        print_value(counts, PERF_CONTEXT_SWITCHES, per_million, 10);
+        std::cout << std::endl;
+    }
+    std::cout << std::endl;
+}